@@ -377,6 +377,21 @@ u64 GetSize(FILE* f) {
     return size;
 }
 
+s64 GetModificationTime(const std::string& filename) {
+    struct stat buf;
+#ifdef _WIN32
+    if (_wstat64(Common::UTF8ToUTF16W(filename).c_str(), &buf) == 0)
+#else
+    if (stat(filename.c_str(), &buf) == 0)
+#endif
+    {
+        return static_cast<s64>(buf.st_mtime);
+    }
+
+    LOG_TRACE(Common_Filesystem, "Stat failed {}: {}", filename, GetLastErrorMsg());
+    return 0;
+}
+
 // creates an empty file filename, returns true on success
 bool CreateEmptyFile(const std::string& filename) {
     LOG_TRACE(Common_Filesystem, "{}", filename);
@@ -561,6 +576,30 @@ std::string GetCurrentDir() {
     return strDir;
 }
 
+std::string GetTempDir() {
+#ifdef _WIN32
+    std::array<wchar_t, MAX_PATH + 1> path;
+    const DWORD length = GetTempPathW(static_cast<DWORD>(path.size()), path.data());
+    if (length != 0 && length <= path.size()) {
+        std::string dir = Common::UTF16ToUTF8(std::wstring(path.data(), length));
+        dir.pop_back();
+        return dir;
+    }
+    LOG_ERROR(Common_Filesystem, "GetTempPath failed: {}", GetLastErrorMsg());
+    return GetCurrentDir();
+#else
+    const char* dir = std::getenv("TMPDIR");
+    if (dir == nullptr || dir[0] == '\0') {
+        return "/tmp";
+    }
+    std::string result = dir;
+    if (result.size() > 1 && result.back() == '/') {
+        result.pop_back();
+    }
+    return result;
+#endif
+}
+
 // Sets the current directory to the given directory
 bool SetCurrentDir(const std::string& directory) {
 #ifdef _WIN32
@@ -59,6 +59,9 @@ u64 GetSize(const int fd);
 // Overloaded GetSize, accepts FILE*
 u64 GetSize(FILE* f);
 
+// Returns the last modification time of filename in seconds since the epoch, 0 on failure
+s64 GetModificationTime(const std::string& filename);
+
 // Returns true if successful, or path already exists.
 bool CreateDir(const std::string& filename);
 
@@ -119,6 +122,9 @@ bool DeleteDirRecursively(const std::string& directory, unsigned int recursion =
 // Returns the current directory
 std::string GetCurrentDir();
 
+// Returns the directory for temporary files of the system, without a trailing separator
+std::string GetTempDir();
+
 // Create directory and copy contents (does not overwrite existing files)
 void CopyDir(const std::string& source_path, const std::string& dest_path);
 
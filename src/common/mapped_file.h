@@ -0,0 +1,43 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * A read-only view of a whole file on the host, mapped into memory. Pages are only read from disk
+ * as they are first touched, so mapping large files is cheap.
+ */
+class MappedFile final : NonCopyable {
+public:
+    /// Maps the file at the given path. The mapping is invalid if it could not be created.
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    /// Returns whether the file could be mapped. Empty files are never mapped.
+    bool IsValid() const {
+        return data != nullptr;
+    }
+
+    /// Returns a pointer to the contents of the file, or nullptr if the mapping is invalid.
+    const u8* Data() const {
+        return data;
+    }
+
+    /// Returns the size of the mapped file in bytes.
+    std::size_t Size() const {
+        return size;
+    }
+
+private:
+    const u8* data = nullptr;
+    std::size_t size = 0;
+};
+
+} // namespace Common
@@ -0,0 +1,119 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include "common/thread_pool.h"
+
+namespace Common {
+
+ThreadPool::ThreadPool(std::size_t num_threads) {
+    threads.reserve(num_threads);
+    for (std::size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back([this] { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    task_available.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::ParallelFor(std::size_t count, const std::function<void(std::size_t)>& func) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1 || threads.empty()) {
+        for (std::size_t index = 0; index < count; ++index) {
+            func(index);
+        }
+        return;
+    }
+
+    // Helpers may start after every index has been handed out and this call has returned, so the
+    // state they share is reference counted. `func` is only used while indices remain, which
+    // guarantees this call is still waiting.
+    struct State {
+        const std::function<void(std::size_t)>* func;
+        std::size_t count;
+        std::atomic<std::size_t> next{0};
+        std::size_t done = 0;
+        std::mutex mutex;
+        std::condition_variable all_done;
+    };
+    const auto state = std::make_shared<State>();
+    state->func = &func;
+    state->count = count;
+
+    const auto run = [](State& state) {
+        std::size_t completed = 0;
+        for (std::size_t index = state.next++; index < state.count; index = state.next++) {
+            (*state.func)(index);
+            ++completed;
+        }
+        if (completed == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.done += completed;
+        if (state.done == state.count) {
+            state.all_done.notify_all();
+        }
+    };
+
+    const std::size_t num_helpers = std::min(threads.size(), count - 1);
+    for (std::size_t i = 0; i < num_helpers; ++i) {
+        Push([state, run] { run(*state); });
+    }
+    run(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->all_done.wait(lock, [&] { return state->done == state->count; });
+}
+
+std::size_t ThreadPool::HelperThreadCount() {
+    const std::size_t num_cores = std::thread::hardware_concurrency();
+    return num_cores > 1 ? num_cores - 1 : 0;
+}
+
+void ThreadPool::Push(std::function<void()> task) {
+    if (threads.empty()) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(std::move(task));
+    }
+    task_available.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            task_available.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
+
+ThreadPool& GetSharedThreadPool() {
+    static ThreadPool pool(ThreadPool::HelperThreadCount());
+    return pool;
+}
+
+} // namespace Common
@@ -0,0 +1,76 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Common {
+
+/**
+ * A fixed set of worker threads running queued tasks in submission order. Tasks still queued when
+ * the pool is destroyed are run before its threads exit.
+ */
+class ThreadPool final {
+public:
+    /// Creates a pool with the given number of workers. Without workers, tasks run inline.
+    explicit ThreadPool(std::size_t num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Returns the number of worker threads of the pool.
+    std::size_t NumThreads() const {
+        return threads.size();
+    }
+
+    /// Queues a task, returning a future to its result.
+    template <typename Func>
+    auto Submit(Func&& func) -> std::future<std::invoke_result_t<std::decay_t<Func>>> {
+        using Result = std::invoke_result_t<std::decay_t<Func>>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+        auto future = task->get_future();
+        Push([task] { (*task)(); });
+        return future;
+    }
+
+    /**
+     * Calls `func` once for every index in [0, count) and returns when all calls are done. The
+     * calling thread takes part in the work, so this may be called from a task of the pool itself.
+     * Indices are handed out in increasing order, but calls may run concurrently.
+     */
+    void ParallelFor(std::size_t count, const std::function<void(std::size_t)>& func);
+
+    /// Returns the number of workers to use for a pool whose creator also takes part in the work.
+    static std::size_t HelperThreadCount();
+
+private:
+    void Push(std::function<void()> task);
+    void WorkerLoop();
+
+    std::vector<std::thread> threads;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable task_available;
+    bool stopping = false;
+};
+
+/**
+ * Returns the pool shared by the parallel work of the whole emulator, which has a worker for every
+ * host core but the calling thread's. Its users must not create pools of their own, as concurrent
+ * pools would oversubscribe the host.
+ */
+ThreadPool& GetSharedThreadPool();
+
+} // namespace Common
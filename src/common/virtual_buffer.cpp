@@ -0,0 +1,50 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "common/assert.h"
+#include "common/virtual_buffer.h"
+
+namespace Common {
+
+void* AllocateMemoryPages(std::size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+
+#ifdef _WIN32
+    void* base{VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE)};
+#else
+    void* base{mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)};
+
+    if (base == MAP_FAILED) {
+        base = nullptr;
+    }
+#endif
+
+    ASSERT_MSG(base != nullptr, "Failed to allocate {} bytes of memory pages", size);
+
+    return base;
+}
+
+void FreeMemoryPages(void* base, std::size_t size) {
+    if (base == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    const bool success = VirtualFree(base, 0, MEM_RELEASE) != 0;
+#else
+    const bool success = munmap(base, size) == 0;
+#endif
+
+    ASSERT_MSG(success, "Failed to free {} bytes of memory pages", size);
+}
+
+} // namespace Common
@@ -0,0 +1,94 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+namespace Common {
+
+/**
+ * Allocates zero-initialized memory directly from the host virtual memory manager. Physical
+ * memory is only committed by the host as pages are first touched, so large mostly-unused
+ * allocations are cheap both to create and to keep around.
+ *
+ * @param size Size of the allocation in bytes.
+ * @returns Pointer to the allocation, or nullptr on failure.
+ */
+void* AllocateMemoryPages(std::size_t size);
+
+/**
+ * Releases memory previously allocated with AllocateMemoryPages.
+ *
+ * @param base Pointer returned by AllocateMemoryPages, may be nullptr.
+ * @param size Size that was passed to AllocateMemoryPages.
+ */
+void FreeMemoryPages(void* base, std::size_t size);
+
+/**
+ * Fixed-size array backed by AllocateMemoryPages. Unlike std::vector, creating or resizing it
+ * doesn't touch the memory, which makes it suitable for huge sparse tables that are mostly zero.
+ * Resizing discards the previous contents.
+ */
+template <typename T>
+class VirtualBuffer final {
+public:
+    constexpr VirtualBuffer() = default;
+
+    explicit VirtualBuffer(std::size_t count) : alloc_size{count * sizeof(T)} {
+        base_ptr = static_cast<T*>(AllocateMemoryPages(alloc_size));
+    }
+
+    ~VirtualBuffer() {
+        FreeMemoryPages(base_ptr, alloc_size);
+    }
+
+    VirtualBuffer(const VirtualBuffer&) = delete;
+    VirtualBuffer& operator=(const VirtualBuffer&) = delete;
+
+    VirtualBuffer(VirtualBuffer&& other) noexcept
+        : alloc_size{std::exchange(other.alloc_size, 0)}, base_ptr{std::exchange(other.base_ptr,
+                                                                                 nullptr)} {}
+
+    VirtualBuffer& operator=(VirtualBuffer&& other) noexcept {
+        FreeMemoryPages(base_ptr, alloc_size);
+        alloc_size = std::exchange(other.alloc_size, 0);
+        base_ptr = std::exchange(other.base_ptr, nullptr);
+        return *this;
+    }
+
+    void resize(std::size_t count) {
+        FreeMemoryPages(base_ptr, alloc_size);
+
+        alloc_size = count * sizeof(T);
+        base_ptr = static_cast<T*>(AllocateMemoryPages(alloc_size));
+    }
+
+    T& operator[](std::size_t index) {
+        return base_ptr[index];
+    }
+
+    const T& operator[](std::size_t index) const {
+        return base_ptr[index];
+    }
+
+    T* data() {
+        return base_ptr;
+    }
+
+    const T* data() const {
+        return base_ptr;
+    }
+
+    std::size_t size() const {
+        return alloc_size / sizeof(T);
+    }
+
+private:
+    std::size_t alloc_size{};
+    T* base_ptr{};
+};
+
+} // namespace Common
@@ -126,6 +126,8 @@ static CPUCaps Detect() {
                 caps.bmi1 = true;
             if ((cpu_id[1] >> 8) & 1)
                 caps.bmi2 = true;
+            if ((cpu_id[1] >> 29) & 1)
+                caps.sha = true;
         }
     }
 
@@ -198,6 +200,8 @@ std::string GetCPUCapsString() {
         sum += ", FMA";
     if (caps.aes)
         sum += ", AES";
+    if (caps.sha)
+        sum += ", SHA";
     if (caps.movbe)
         sum += ", MOVBE";
     if (caps.long_mode)
@@ -35,6 +35,7 @@ struct CPUCaps {
     bool fma;
     bool fma4;
     bool aes;
+    bool sha;
 
     // Support for the FXSAVE and FXRSTOR instructions
     bool fxsave_fxrstor;
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <map>
 #include <memory>
@@ -17,6 +18,7 @@
 #include "core/file_sys/mode.h"
 #include "core/file_sys/vfs_concat.h"
 #include "core/file_sys/vfs_real.h"
+#include "core/frontend/emu_window.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/kernel.h"
@@ -151,12 +153,23 @@ struct System::Impl {
         Service::Init(service_manager, *virtual_filesystem);
         GDBStub::Init();
 
+        const bool use_async_gpu = Settings::values.use_asynchronous_gpu_emulation;
+        if (use_async_gpu) {
+            // The renderer is initialized here, but used from the GPU thread from then on
+            emu_window.MakeCurrent();
+        }
+
         renderer = VideoCore::CreateRenderer(emu_window);
         if (!renderer->Init()) {
             return ResultStatus::ErrorVideoCore;
         }
 
-        gpu_core = std::make_unique<Tegra::GPU>(renderer->Rasterizer());
+        if (use_async_gpu) {
+            // Release the context so that the GPU thread can acquire it
+            emu_window.DoneCurrent();
+        }
+
+        gpu_core = std::make_unique<Tegra::GPU>(*renderer, use_async_gpu);
 
         // Create threads for CPU cores 1-3, and build thread_to_cpu map
         // CPU core 0 is run on the main thread
@@ -178,6 +191,18 @@ struct System::Impl {
         return ResultStatus::Success;
     }
 
+    /// Logs the progress of loading the disk resources of the title, roughly every 10%
+    static void LogDiskResourceLoad(VideoCore::LoadCallbackStage stage, std::size_t value,
+                                    std::size_t total) {
+        if (stage != VideoCore::LoadCallbackStage::Build) {
+            return;
+        }
+        const std::size_t step = std::max<std::size_t>(total / 10, 1);
+        if (value % step == 0) {
+            LOG_INFO(Core, "Building cached shaders: {}/{}", value, total);
+        }
+    }
+
     ResultStatus Load(Frontend::EmuWindow& emu_window, const std::string& filepath) {
         app_loader = Loader::GetLoader(GetGameFileFromPath(virtual_filesystem, filepath));
 
@@ -211,6 +236,11 @@ struct System::Impl {
             return static_cast<ResultStatus>(static_cast<u32>(ResultStatus::ErrorLoader) +
                                              static_cast<u32>(load_result));
         }
+
+        // Build the shaders the title used in previous runs before it starts, rather than when it
+        // first draws with them
+        gpu_core->LoadDiskResources(kernel.CurrentProcess()->GetTitleID(), LogDiskResourceLoad);
+
         status = ResultStatus::Success;
         return status;
     }
@@ -225,13 +255,18 @@ struct System::Impl {
         Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_Frametime",
                              perf_results.frametime * 1000.0);
 
-        // Shutdown emulation session
+        // Shutdown emulation session, stopping the GPU thread first if there is one
+        const bool is_async_gpu = gpu_core && gpu_core->IsAsync();
+        gpu_core.reset();
+        if (is_async_gpu) {
+            // Take the context back from the GPU thread to destroy the renderer's resources
+            renderer->GetRenderWindow().MakeCurrent();
+        }
         renderer.reset();
         GDBStub::Shutdown();
         Service::Shutdown();
         service_manager.reset();
         telemetry_session.reset();
-        gpu_core.reset();
 
         // Close all CPU/threading state
         cpu_barrier->NotifyEnd();
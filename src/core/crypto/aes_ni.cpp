@@ -0,0 +1,253 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <utility>
+#include <wmmintrin.h>
+#include "common/swap.h"
+#include "core/crypto/aes_ni.h"
+
+namespace Core::Crypto::AESNI {
+namespace {
+
+constexpr std::size_t NUM_ROUNDS = 10;
+constexpr std::size_t PIPELINE_DEPTH = 8;
+
+__m128i Load(const u8* data) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+void Store(u8* data, __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(data), value);
+}
+
+template <int round_constant>
+__m128i ExpandRound(__m128i key) {
+    __m128i assist = _mm_aeskeygenassist_si128(key, round_constant);
+    assist = _mm_shuffle_epi32(assist, 0xFF);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+
+struct RoundKeys {
+    explicit RoundKeys(const KeySchedule& schedule) {
+        for (std::size_t i = 0; i <= NUM_ROUNDS; ++i) {
+            keys[i] = Load(schedule.round_keys[i].data());
+        }
+    }
+
+    __m128i keys[NUM_ROUNDS + 1];
+};
+
+template <bool decrypt>
+__m128i Round(__m128i block, __m128i key) {
+    return decrypt ? _mm_aesdec_si128(block, key) : _mm_aesenc_si128(block, key);
+}
+
+template <bool decrypt>
+__m128i LastRound(__m128i block, __m128i key) {
+    return decrypt ? _mm_aesdeclast_si128(block, key) : _mm_aesenclast_si128(block, key);
+}
+
+/// Runs one middle round on all the blocks.
+template <bool decrypt, std::size_t... indices>
+void RoundAll(__m128i key, __m128i* blocks, std::index_sequence<indices...>) {
+    ((blocks[indices] = Round<decrypt>(blocks[indices], key)), ...);
+}
+
+template <bool decrypt, std::size_t... indices, std::size_t... rounds>
+void Rounds(const RoundKeys& keys, __m128i* blocks, std::index_sequence<indices...> sequence,
+            std::index_sequence<rounds...>) {
+    ((blocks[indices] = _mm_xor_si128(blocks[indices], keys.keys[0])), ...);
+    (RoundAll<decrypt>(keys.keys[rounds + 1], blocks, sequence), ...);
+    ((blocks[indices] = LastRound<decrypt>(blocks[indices], keys.keys[NUM_ROUNDS])), ...);
+}
+
+/**
+ * Runs all the rounds on a group of blocks, interleaving them to fill the pipeline. Blocks and
+ * rounds are expanded from index sequences so that the blocks can live in registers.
+ */
+template <bool decrypt, std::size_t... indices>
+void Rounds(const RoundKeys& keys, __m128i* blocks, std::index_sequence<indices...> sequence) {
+    Rounds<decrypt>(keys, blocks, sequence, std::make_index_sequence<NUM_ROUNDS - 1>{});
+}
+
+template <bool decrypt, std::size_t... indices>
+void ECBBlocks(const RoundKeys& keys, const u8* src, u8* dest,
+               std::index_sequence<indices...> sequence) {
+    __m128i blocks[] = {Load(src + indices * 16)...};
+    Rounds<decrypt>(keys, blocks, sequence);
+    (Store(dest + indices * 16, blocks[indices]), ...);
+}
+
+template <bool decrypt>
+void ECB(const KeySchedule& schedule, const u8* src, std::size_t num_blocks, u8* dest) {
+    const RoundKeys keys(schedule);
+    std::size_t block = 0;
+    for (; block + PIPELINE_DEPTH <= num_blocks; block += PIPELINE_DEPTH) {
+        ECBBlocks<decrypt>(keys, src + block * 16, dest + block * 16,
+                           std::make_index_sequence<PIPELINE_DEPTH>{});
+    }
+    for (; block < num_blocks; ++block) {
+        ECBBlocks<decrypt>(keys, src + block * 16, dest + block * 16,
+                           std::make_index_sequence<1>{});
+    }
+}
+
+/// 128 bit big endian counter of CTR mode.
+struct Counter {
+    /// Returns the current counter block and increments the counter.
+    __m128i Next() {
+        const __m128i block = _mm_set_epi64x(static_cast<s64>(Common::swap64(low)),
+                                             static_cast<s64>(Common::swap64(high)));
+        if (++low == 0) {
+            ++high;
+        }
+        return block;
+    }
+
+    u64 high;
+    u64 low;
+};
+
+template <std::size_t... indices>
+void CTRBlocks(const RoundKeys& keys, Counter& counter, const u8* src, u8* dest,
+               std::index_sequence<indices...> sequence) {
+    // Braced initializers are evaluated in order, so the counter values are sequential.
+    __m128i blocks[] = {(static_cast<void>(indices), counter.Next())...};
+    Rounds<false>(keys, blocks, sequence);
+    (Store(dest + indices * 16, _mm_xor_si128(Load(src + indices * 16), blocks[indices])), ...);
+}
+
+/// 128 bit little endian tweak of XTS mode, multiplied by x in GF(2^128) between blocks.
+struct Tweak {
+    /// Returns the current tweak and advances to the one of the next block.
+    __m128i Next() {
+        const __m128i tweak = _mm_set_epi64x(static_cast<s64>(high), static_cast<s64>(low));
+        const u64 carry = high >> 63;
+        high = (high << 1) | (low >> 63);
+        low = (low << 1) ^ (carry * 0x87);
+        return tweak;
+    }
+
+    u64 low;
+    u64 high;
+};
+
+template <bool decrypt, std::size_t... indices>
+void XTSBlocks(const RoundKeys& keys, Tweak& tweak, const u8* src, u8* dest,
+               std::index_sequence<indices...> sequence) {
+    const __m128i tweaks[] = {(static_cast<void>(indices), tweak.Next())...};
+    __m128i blocks[] = {_mm_xor_si128(Load(src + indices * 16), tweaks[indices])...};
+    Rounds<decrypt>(keys, blocks, sequence);
+    (Store(dest + indices * 16, _mm_xor_si128(blocks[indices], tweaks[indices])), ...);
+}
+
+template <bool decrypt>
+void XTS(const KeySchedule& data_schedule, const KeySchedule& tweak_schedule, const u8* tweak_data,
+         const u8* src, std::size_t size, u8* dest) {
+    const RoundKeys data_keys(data_schedule);
+    const RoundKeys tweak_keys(tweak_schedule);
+
+    __m128i encrypted_tweak[] = {Load(tweak_data)};
+    Rounds<false>(tweak_keys, encrypted_tweak, std::make_index_sequence<1>{});
+    Tweak tweak;
+    std::memcpy(&tweak.low, encrypted_tweak, sizeof(u64));
+    std::memcpy(&tweak.high, reinterpret_cast<const u8*>(encrypted_tweak) + sizeof(u64),
+                sizeof(u64));
+
+    const std::size_t num_blocks = size / 16;
+    std::size_t block = 0;
+    for (; block + PIPELINE_DEPTH <= num_blocks; block += PIPELINE_DEPTH) {
+        XTSBlocks<decrypt>(data_keys, tweak, src + block * 16, dest + block * 16,
+                           std::make_index_sequence<PIPELINE_DEPTH>{});
+    }
+    for (; block < num_blocks; ++block) {
+        XTSBlocks<decrypt>(data_keys, tweak, src + block * 16, dest + block * 16,
+                           std::make_index_sequence<1>{});
+    }
+}
+
+} // Anonymous namespace
+
+void ExpandKey(const u8* key, KeySchedule& encryption, KeySchedule& decryption) {
+    __m128i keys[NUM_ROUNDS + 1];
+    keys[0] = Load(key);
+    keys[1] = ExpandRound<0x01>(keys[0]);
+    keys[2] = ExpandRound<0x02>(keys[1]);
+    keys[3] = ExpandRound<0x04>(keys[2]);
+    keys[4] = ExpandRound<0x08>(keys[3]);
+    keys[5] = ExpandRound<0x10>(keys[4]);
+    keys[6] = ExpandRound<0x20>(keys[5]);
+    keys[7] = ExpandRound<0x40>(keys[6]);
+    keys[8] = ExpandRound<0x80>(keys[7]);
+    keys[9] = ExpandRound<0x1B>(keys[8]);
+    keys[10] = ExpandRound<0x36>(keys[9]);
+
+    // The equivalent inverse cipher uses the encryption keys in reverse, with InvMixColumns
+    // applied to all but the first and last ones.
+    for (std::size_t i = 0; i <= NUM_ROUNDS; ++i) {
+        Store(encryption.round_keys[i].data(), keys[i]);
+        const bool outer = i == 0 || i == NUM_ROUNDS;
+        Store(decryption.round_keys[NUM_ROUNDS - i].data(),
+              outer ? keys[i] : _mm_aesimc_si128(keys[i]));
+    }
+}
+
+void CTRTranscode(const KeySchedule& schedule, u8* counter_data, const u8* src, std::size_t size,
+                  u8* dest) {
+    const RoundKeys keys(schedule);
+    Counter counter;
+    std::memcpy(&counter.high, counter_data, sizeof(u64));
+    std::memcpy(&counter.low, counter_data + sizeof(u64), sizeof(u64));
+    counter.high = Common::swap64(counter.high);
+    counter.low = Common::swap64(counter.low);
+
+    const std::size_t num_blocks = size / 16;
+    std::size_t block = 0;
+    for (; block + PIPELINE_DEPTH <= num_blocks; block += PIPELINE_DEPTH) {
+        CTRBlocks(keys, counter, src + block * 16, dest + block * 16,
+                  std::make_index_sequence<PIPELINE_DEPTH>{});
+    }
+    for (; block < num_blocks; ++block) {
+        CTRBlocks(keys, counter, src + block * 16, dest + block * 16,
+                  std::make_index_sequence<1>{});
+    }
+
+    // A trailing partial block uses the start of the next keystream block.
+    const std::size_t remainder = size % 16;
+    if (remainder != 0) {
+        u8 block_data[16]{};
+        std::memcpy(block_data, src + num_blocks * 16, remainder);
+        CTRBlocks(keys, counter, block_data, block_data, std::make_index_sequence<1>{});
+        std::memcpy(dest + num_blocks * 16, block_data, remainder);
+    }
+
+    counter.high = Common::swap64(counter.high);
+    counter.low = Common::swap64(counter.low);
+    std::memcpy(counter_data, &counter.high, sizeof(u64));
+    std::memcpy(counter_data + sizeof(u64), &counter.low, sizeof(u64));
+}
+
+void ECBTranscode(const KeySchedule& key, bool decrypt, const u8* src, std::size_t num_blocks,
+                  u8* dest) {
+    if (decrypt) {
+        ECB<true>(key, src, num_blocks, dest);
+    } else {
+        ECB<false>(key, src, num_blocks, dest);
+    }
+}
+
+void XTSTranscode(const KeySchedule& data_key, const KeySchedule& tweak_key, bool decrypt,
+                  const u8* tweak, const u8* src, std::size_t size, u8* dest) {
+    if (decrypt) {
+        XTS<true>(data_key, tweak_key, tweak, src, size, dest);
+    } else {
+        XTS<false>(data_key, tweak_key, tweak, src, size, dest);
+    }
+}
+
+} // namespace Core::Crypto::AESNI
@@ -0,0 +1,47 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "common/common_types.h"
+
+/**
+ * AES-128 implemented with the AES-NI instructions. This file is built with AES-NI enabled, so
+ * callers must check for support at runtime before calling any of these functions. Up to eight
+ * blocks are kept in flight to hide the latency of the round instructions.
+ */
+namespace Core::Crypto::AESNI {
+
+/// Expanded round keys of an AES-128 key, for either encryption or decryption.
+struct alignas(16) KeySchedule {
+    std::array<std::array<u8, 16>, 11> round_keys;
+};
+
+/// Expands a 16 byte key into its encryption and decryption round keys.
+void ExpandKey(const u8* key, KeySchedule& encryption, KeySchedule& decryption);
+
+/**
+ * Encrypts or decrypts data in CTR mode.
+ * @param key Encryption round keys
+ * @param counter Big endian counter block, incremented once for every started block
+ */
+void CTRTranscode(const KeySchedule& key, u8* counter, const u8* src, std::size_t size, u8* dest);
+
+/// Encrypts or decrypts whole blocks in ECB mode with the given round keys.
+void ECBTranscode(const KeySchedule& key, bool decrypt, const u8* src, std::size_t num_blocks,
+                  u8* dest);
+
+/**
+ * Encrypts or decrypts a data unit in XTS mode, as defined by IEEE 1619.
+ * @param data_key Round keys of the data key, for the direction of the operation
+ * @param tweak_key Encryption round keys of the tweak key
+ * @param tweak The 16 byte tweak of the data unit
+ * @param size Size of the data unit, a multiple of 16
+ */
+void XTSTranscode(const KeySchedule& data_key, const KeySchedule& tweak_key, bool decrypt,
+                  const u8* tweak, const u8* src, std::size_t size, u8* dest);
+
+} // namespace Core::Crypto::AESNI
@@ -2,12 +2,20 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <mbedtls/cipher.h>
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "core/crypto/aes_util.h"
 #include "core/crypto/key_manager.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#include "core/crypto/aes_ni.h"
+#endif
+
 namespace Core::Crypto {
 namespace {
 std::vector<u8> CalculateNintendoTweak(std::size_t sector_id) {
@@ -34,10 +42,69 @@ static_assert(static_cast<std::size_t>(Mode::XTS) ==
 struct CipherContext {
     mbedtls_cipher_context_t encryption_context;
     mbedtls_cipher_context_t decryption_context;
+
+#ifdef ARCHITECTURE_x86_64
+    // The mbedtls contexts are still used for the few inputs AES-NI code doesn't handle.
+    bool use_aes_ni = false;
+    Mode mode;
+    AESNI::KeySchedule encryption_key;
+    AESNI::KeySchedule decryption_key;
+    // Encryption keys of the second half of XTS keys
+    AESNI::KeySchedule tweak_key;
+    // IVs of both directions, advanced separately in CTR mode like the mbedtls contexts do
+    std::array<std::array<u8, 16>, 2> iv{};
+#endif
 };
 
+#ifdef ARCHITECTURE_x86_64
+namespace {
+bool IsAESNICompatible(Mode mode, std::size_t key_size) {
+    switch (mode) {
+    case Mode::CTR:
+    case Mode::ECB:
+        return key_size == 0x10;
+    case Mode::XTS:
+        return key_size == 0x20;
+    }
+    return false;
+}
+
+/// Transcodes with AES-NI, returns false if the input has to go through mbedtls.
+bool TranscodeAESNI(CipherContext& ctx, const u8* src, std::size_t size, u8* dest, Op op) {
+    const bool decrypt = op == Op::Decrypt;
+    const AESNI::KeySchedule& key = decrypt ? ctx.decryption_key : ctx.encryption_key;
+    switch (ctx.mode) {
+    case Mode::CTR:
+        AESNI::CTRTranscode(ctx.encryption_key, ctx.iv[decrypt].data(), src, size, dest);
+        return true;
+    case Mode::ECB: {
+        const std::size_t whole_blocks = size / 16;
+        const std::size_t remainder = size % 16;
+        AESNI::ECBTranscode(key, decrypt, src, whole_blocks, dest);
+        if (remainder != 0) {
+            // Trailing bytes are transcoded as a zero padded block, as with mbedtls below
+            std::array<u8, 16> block{};
+            std::memcpy(block.data(), src + whole_blocks * 16, remainder);
+            AESNI::ECBTranscode(key, decrypt, block.data(), 1, block.data());
+            std::memcpy(dest + whole_blocks * 16, block.data(), remainder);
+        }
+        return true;
+    }
+    case Mode::XTS:
+        // Ciphertext stealing is left to mbedtls
+        if (size < 16 || size % 16 != 0) {
+            return false;
+        }
+        AESNI::XTSTranscode(key, ctx.tweak_key, decrypt, ctx.iv[decrypt].data(), src, size, dest);
+        return true;
+    }
+    return false;
+}
+} // Anonymous namespace
+#endif
+
 template <typename Key, std::size_t KeySize>
-Crypto::AESCipher<Key, KeySize>::AESCipher(Key key, Mode mode)
+Crypto::AESCipher<Key, KeySize>::AESCipher(Key key, Mode mode, Backend backend)
     : ctx(std::make_unique<CipherContext>()) {
     mbedtls_cipher_init(&ctx->encryption_context);
     mbedtls_cipher_init(&ctx->decryption_context);
@@ -55,6 +122,19 @@ Crypto::AESCipher<Key, KeySize>::AESCipher(Key key, Mode mode)
     ASSERT(
         !mbedtls_cipher_setkey(&ctx->decryption_context, key.data(), KeySize * 8, MBEDTLS_DECRYPT));
     //"Failed to set key on mbedtls ciphers.");
+
+#ifdef ARCHITECTURE_x86_64
+    ctx->use_aes_ni = backend == Backend::Default && Common::GetCPUCaps().aes &&
+                      IsAESNICompatible(mode, KeySize);
+    if (ctx->use_aes_ni) {
+        ctx->mode = mode;
+        AESNI::ExpandKey(key.data(), ctx->encryption_key, ctx->decryption_key);
+        if (mode == Mode::XTS) {
+            AESNI::KeySchedule unused;
+            AESNI::ExpandKey(key.data() + 0x10, ctx->tweak_key, unused);
+        }
+    }
+#endif
 }
 
 template <typename Key, std::size_t KeySize>
@@ -68,10 +148,25 @@ void AESCipher<Key, KeySize>::SetIV(std::vector<u8> iv) {
     ASSERT_MSG((mbedtls_cipher_set_iv(&ctx->encryption_context, iv.data(), iv.size()) ||
                 mbedtls_cipher_set_iv(&ctx->decryption_context, iv.data(), iv.size())) == 0,
                "Failed to set IV on mbedtls ciphers.");
+
+#ifdef ARCHITECTURE_x86_64
+    if (ctx->use_aes_ni) {
+        for (auto& direction_iv : ctx->iv) {
+            direction_iv.fill(0);
+            std::memcpy(direction_iv.data(), iv.data(), std::min(iv.size(), direction_iv.size()));
+        }
+    }
+#endif
 }
 
 template <typename Key, std::size_t KeySize>
 void AESCipher<Key, KeySize>::Transcode(const u8* src, std::size_t size, u8* dest, Op op) const {
+#ifdef ARCHITECTURE_x86_64
+    if (ctx->use_aes_ni && TranscodeAESNI(*ctx, src, size, dest, op)) {
+        return;
+    }
+#endif
+
     auto* const context = op == Op::Encrypt ? &ctx->encryption_context : &ctx->decryption_context;
 
     mbedtls_cipher_reset(context);
@@ -118,6 +213,24 @@ void AESCipher<Key, KeySize>::XTSTranscode(const u8* src, std::size_t size, u8*
                                            std::size_t sector_id, std::size_t sector_size, Op op) {
     ASSERT_MSG(size % sector_size == 0, "XTS decryption size must be a multiple of sector size.");
 
+#ifdef ARCHITECTURE_x86_64
+    if (ctx->use_aes_ni && sector_size >= 16 && sector_size % 16 == 0) {
+        const bool decrypt = op == Op::Decrypt;
+        const auto& key = decrypt ? ctx->decryption_key : ctx->encryption_key;
+        for (std::size_t i = 0; i < size; i += sector_size) {
+            std::array<u8, 16> tweak{};
+            std::size_t tweak_sector = sector_id++;
+            for (std::size_t j = tweak.size(); j-- > 0;) {
+                tweak[j] = tweak_sector & 0xFF;
+                tweak_sector >>= 8;
+            }
+            AESNI::XTSTranscode(key, ctx->tweak_key, decrypt, tweak.data(), src + i, sector_size,
+                                dest + i);
+        }
+        return;
+    }
+#endif
+
     for (std::size_t i = 0; i < size; i += sector_size) {
         SetIV(CalculateNintendoTweak(sector_id++));
         Transcode<u8, u8>(src + i, sector_size, dest + i, op);
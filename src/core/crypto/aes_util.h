@@ -25,13 +25,21 @@ enum class Op {
     Decrypt,
 };
 
+/// Implementations a cipher can run on
+enum class Backend {
+    /// Fastest implementation supported by the host, mbedtls if no other one is
+    Default,
+    /// mbedtls, supported everywhere
+    MbedTLS,
+};
+
 template <typename Key, std::size_t KeySize = sizeof(Key)>
 class AESCipher {
     static_assert(std::is_same_v<Key, std::array<u8, KeySize>>, "Key must be std::array of u8.");
     static_assert(KeySize == 0x10 || KeySize == 0x20, "KeySize must be 128 or 256.");
 
 public:
-    AESCipher(Key key, Mode mode);
+    AESCipher(Key key, Mode mode, Backend backend = Backend::Default);
 
     ~AESCipher();
 
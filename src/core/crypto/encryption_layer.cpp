@@ -2,11 +2,210 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "common/assert.h"
 #include "core/crypto/encryption_layer.h"
 
 namespace Core::Crypto {
+namespace {
 
-EncryptionLayer::EncryptionLayer(FileSys::VirtualFile base_) : base(std::move(base_)) {}
+/// Least recently used blocks of decrypted data of all the layers.
+class DecryptedBlockCache {
+public:
+    /// Copies part of a cached block, returns false if the block isn't cached.
+    bool Copy(u64 layer, std::size_t block, u8* data, std::size_t offset, std::size_t length,
+              std::size_t& copied) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto iter = index.find(Key{layer, block});
+        if (iter == index.end()) {
+            ++stats.misses;
+            return false;
+        }
+        ++stats.hits;
+        entries.splice(entries.begin(), entries, iter->second);
+
+        const std::vector<u8>& contents = iter->second->contents;
+        copied = offset < contents.size() ? std::min(length, contents.size() - offset) : 0;
+        std::memcpy(data, contents.data() + offset, copied);
+        return true;
+    }
+
+    bool Contains(u64 layer, std::size_t block) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return index.count(Key{layer, block}) != 0;
+    }
+
+    void Insert(u64 layer, std::size_t block, std::vector<u8> contents) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const Key key{layer, block};
+        if (index.count(key) != 0 || max_blocks == 0) {
+            return;
+        }
+        entries.push_front(Entry{key, std::move(contents)});
+        index.emplace(key, entries.begin());
+        Shrink();
+    }
+
+    /// Evicts every block of the given layer.
+    void Invalidate(u64 layer) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto iter = entries.begin(); iter != entries.end();) {
+            if (iter->key.layer == layer) {
+                index.erase(iter->key);
+                iter = entries.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+
+    void Configure(std::size_t max_size, std::size_t read_ahead_) {
+        std::lock_guard<std::mutex> lock(mutex);
+        max_blocks = max_size / EncryptionLayer::CACHE_BLOCK_SIZE;
+        read_ahead = std::max<std::size_t>(read_ahead_, 1);
+        Shrink();
+    }
+
+    std::size_t ReadAhead() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return max_blocks == 0 ? 1 : read_ahead;
+    }
+
+    EncryptionLayer::CacheStats Stats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+private:
+    struct Key {
+        u64 layer;
+        std::size_t block;
+
+        bool operator==(const Key& other) const {
+            return layer == other.layer && block == other.block;
+        }
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const {
+            return std::hash<u64>{}(key.layer * 0x9E3779B97F4A7C15ULL ^ key.block);
+        }
+    };
+
+    struct Entry {
+        Key key;
+        std::vector<u8> contents;
+    };
+
+    void Shrink() {
+        while (entries.size() > max_blocks) {
+            index.erase(entries.back().key);
+            entries.pop_back();
+        }
+    }
+
+    std::mutex mutex;
+    std::list<Entry> entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+    std::size_t max_blocks =
+        EncryptionLayer::DEFAULT_CACHE_SIZE / EncryptionLayer::CACHE_BLOCK_SIZE;
+    std::size_t read_ahead = EncryptionLayer::DEFAULT_READ_AHEAD;
+    EncryptionLayer::CacheStats stats{};
+};
+
+DecryptedBlockCache& GetCache() {
+    static DecryptedBlockCache cache;
+    return cache;
+}
+
+std::atomic<u64> next_cache_id{0};
+
+} // Anonymous namespace
+
+EncryptionLayer::EncryptionLayer(FileSys::VirtualFile base_)
+    : base(std::move(base_)), cache_id(next_cache_id++) {}
+
+EncryptionLayer::~EncryptionLayer() {
+    InvalidateCache();
+}
+
+std::size_t EncryptionLayer::Read(u8* data, std::size_t length, std::size_t offset) const {
+    const std::size_t size = GetSize();
+    if (offset >= size) {
+        return 0;
+    }
+    length = std::min(length, size - offset);
+
+    auto& cache = GetCache();
+    std::size_t read = 0;
+    while (read < length) {
+        const std::size_t position = offset + read;
+        const std::size_t block = position / CACHE_BLOCK_SIZE;
+        const std::size_t block_offset = position % CACHE_BLOCK_SIZE;
+        const std::size_t remaining = length - read;
+
+        std::size_t copied = 0;
+        if (cache.Copy(cache_id, block, data + read, block_offset, remaining, copied)) {
+            if (copied == 0) {
+                break;
+            }
+            read += copied;
+            continue;
+        }
+
+        // Whole blocks that are not cached are decrypted straight into the buffer. Large reads
+        // are usually not repeated, so they don't go through the cache.
+        if (block_offset == 0 && remaining >= CACHE_BLOCK_SIZE) {
+            std::size_t num_blocks = 1;
+            while ((num_blocks + 1) * CACHE_BLOCK_SIZE <= remaining &&
+                   !cache.Contains(cache_id, block + num_blocks)) {
+                ++num_blocks;
+            }
+            const std::size_t decrypted = ReadBlocks(data + read, num_blocks * CACHE_BLOCK_SIZE,
+                                                     block * CACHE_BLOCK_SIZE);
+            read += decrypted;
+            if (decrypted < num_blocks * CACHE_BLOCK_SIZE) {
+                break;
+            }
+            continue;
+        }
+
+        // Small reads decrypt the block they need along with the following ones into the cache,
+        // as they are likely to be followed by reads of the same region.
+        const std::size_t read_ahead = cache.ReadAhead();
+        std::size_t consumed = 0;
+        for (std::size_t i = 0; i < read_ahead; ++i) {
+            const std::size_t ahead_offset = (block + i) * CACHE_BLOCK_SIZE;
+            if (ahead_offset >= size || (i != 0 && cache.Contains(cache_id, block + i))) {
+                break;
+            }
+            std::vector<u8> contents(CACHE_BLOCK_SIZE);
+            contents.resize(ReadBlocks(contents.data(), CACHE_BLOCK_SIZE, ahead_offset));
+            if (i == 0) {
+                consumed = block_offset < contents.size()
+                               ? std::min(remaining, contents.size() - block_offset)
+                               : 0;
+                std::memcpy(data + read, contents.data() + block_offset, consumed);
+            }
+            const bool end_of_file = contents.size() < CACHE_BLOCK_SIZE;
+            cache.Insert(cache_id, block + i, std::move(contents));
+            if (end_of_file) {
+                break;
+            }
+        }
+        if (consumed == 0) {
+            break;
+        }
+        read += consumed;
+    }
+    return read;
+}
 
 std::string EncryptionLayer::GetName() const {
     return base->GetName();
@@ -39,4 +238,17 @@ std::size_t EncryptionLayer::Write(const u8* data, std::size_t length, std::size
 bool EncryptionLayer::Rename(std::string_view name) {
     return base->Rename(name);
 }
+
+void EncryptionLayer::InvalidateCache() {
+    GetCache().Invalidate(cache_id);
+}
+
+void EncryptionLayer::ConfigureCache(std::size_t max_size, std::size_t read_ahead) {
+    GetCache().Configure(max_size, read_ahead);
+}
+
+EncryptionLayer::CacheStats EncryptionLayer::GetCacheStats() {
+    return GetCache().Stats();
+}
+
 } // namespace Core::Crypto
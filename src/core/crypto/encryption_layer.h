@@ -11,11 +11,28 @@ namespace Core::Crypto {
 
 // Basically non-functional class that implements all of the methods that are irrelevant to an
 // EncryptionLayer. Reduces duplicate code.
+//
+// Reads go through a cache of decrypted blocks shared by all layers, so that many small reads of
+// the same region are only decrypted once. Subclasses only have to decrypt whole blocks.
 class EncryptionLayer : public FileSys::VfsFile {
 public:
+    /// Size of the blocks stored in the cache, a multiple of the block size of every cipher mode.
+    static constexpr std::size_t CACHE_BLOCK_SIZE = 0x4000;
+    /// Default maximum amount of decrypted data kept in the cache, in bytes
+    static constexpr std::size_t DEFAULT_CACHE_SIZE = 0x1000000;
+    /// Default number of blocks decrypted when a read misses the cache
+    static constexpr std::size_t DEFAULT_READ_AHEAD = 4;
+
+    /// Counters of the decrypted block cache
+    struct CacheStats {
+        u64 hits;
+        u64 misses;
+    };
+
     explicit EncryptionLayer(FileSys::VirtualFile base);
+    ~EncryptionLayer() override;
 
-    std::size_t Read(u8* data, std::size_t length, std::size_t offset) const override = 0;
+    std::size_t Read(u8* data, std::size_t length, std::size_t offset) const final;
 
     std::string GetName() const override;
     std::size_t GetSize() const override;
@@ -26,8 +43,35 @@ public:
     std::size_t Write(const u8* data, std::size_t length, std::size_t offset) override;
     bool Rename(std::string_view name) override;
 
+    /**
+     * Configures the decrypted block cache shared by all layers, evicting blocks if it shrinks.
+     * @param max_size Maximum amount of decrypted data kept in the cache, in bytes
+     * @param read_ahead Number of blocks decrypted when a read misses the cache, at least 1
+     */
+    static void ConfigureCache(std::size_t max_size, std::size_t read_ahead);
+
+    /// Returns the counters of the decrypted block cache.
+    static CacheStats GetCacheStats();
+
 protected:
+    /**
+     * Reads and decrypts data of the base file directly into the given buffer.
+     * @param data Buffer to write the decrypted data to
+     * @param length Number of bytes to read, a multiple of CACHE_BLOCK_SIZE
+     * @param offset Offset to read from, a multiple of CACHE_BLOCK_SIZE
+     * @returns The number of bytes read, only less than length at the end of the file
+     */
+    virtual std::size_t ReadBlocks(u8* data, std::size_t length, std::size_t offset) const = 0;
+
+    /// Evicts the blocks of this layer from the cache, to be called when decryption parameters
+    /// change.
+    void InvalidateCache();
+
     FileSys::VirtualFile base;
+
+private:
+    /// Identifies the blocks of this layer in the cache, never reused by another layer.
+    u64 cache_id;
 };
 
 } // namespace Core::Crypto
@@ -6,9 +6,11 @@
 #include <array>
 #include <bitset>
 #include <cctype>
+#include <cstring>
 #include <fstream>
 #include <locale>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <string_view>
 #include <tuple>
@@ -24,6 +26,7 @@
 #include "common/logging/log.h"
 #include "core/crypto/aes_util.h"
 #include "core/crypto/key_manager.h"
+#include "core/crypto/key_search.h"
 #include "core/crypto/partition_data_manager.h"
 #include "core/file_sys/content_archive.h"
 #include "core/file_sys/nca_metadata.h"
@@ -550,9 +553,17 @@ Key256 KeyManager::GetBISKey(u8 partition_id) const {
     return out;
 }
 
+/**
+ * Serializes the writes to the autogenerated key files, as games are scanned on several threads and
+ * every KeyManager appends to the same files.
+ */
+static std::mutex key_file_mutex;
+
 template <size_t Size>
 void KeyManager::WriteKeyToFile(KeyCategory category, std::string_view keyname,
                                 const std::array<u8, Size>& key) {
+    std::lock_guard<std::mutex> lock(key_file_mutex);
+
     const std::string yuzu_keys_dir = FileUtil::GetUserPath(FileUtil::UserPath::KeysDir);
     std::string filename = "title.keys_autogenerated";
     if (category == KeyCategory::Standard)
@@ -572,6 +583,7 @@ void KeyManager::WriteKeyToFile(KeyCategory category, std::string_view keyname,
     }
 
     file << fmt::format("\n{} = {}", keyname, Common::HexArrayToString(key));
+    file.close();
     AttemptLoadKeyFile(yuzu_keys_dir, yuzu_keys_dir, filename, category == KeyCategory::Title);
 }
 
@@ -811,8 +823,15 @@ void KeyManager::DeriveETicket(PartitionDataManager& data) {
 
     const auto bytes = main->ReadAllBytes();
 
-    const auto eticket_kek = FindKeyFromHex16(bytes, eticket_source_hashes[0]);
-    const auto eticket_kekek = FindKeyFromHex16(bytes, eticket_source_hashes[1]);
+    // Both sources are searched for in a single pass over the binary.
+    const auto eticket_sources = FindKeysFromHashes(
+        bytes, {{eticket_source_hashes[0], 0x10}, {eticket_source_hashes[1], 0x10}});
+    Key128 eticket_kek{};
+    Key128 eticket_kekek{};
+    if (!eticket_sources[0].empty())
+        std::memcpy(eticket_kek.data(), eticket_sources[0].data(), eticket_kek.size());
+    if (!eticket_sources[1].empty())
+        std::memcpy(eticket_kekek.data(), eticket_sources[1].data(), eticket_kekek.size());
 
     const auto seed3 = data.GetRSAKekSeed3();
     const auto mask0 = data.GetRSAKekMask0();
@@ -0,0 +1,205 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <utility>
+#include "common/assert.h"
+#include "common/thread_pool.h"
+#include "core/crypto/aes_util.h"
+#include "core/crypto/key_search.h"
+#include "core/crypto/sha256_block.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#endif
+
+namespace Core::Crypto {
+namespace {
+
+/// Number of windows hashed by each task, the windows of a binary are split into these chunks.
+constexpr std::size_t WINDOWS_PER_CHUNK = 0x4000;
+
+constexpr std::size_t NOT_FOUND = std::numeric_limits<std::size_t>::max();
+
+using DigestWords = std::array<u32, 8>;
+
+SHA256::HashMessagesFunction GetHashFunction() {
+#ifdef ARCHITECTURE_x86_64
+    const auto& caps = Common::GetCPUCaps();
+    if (caps.sha && caps.sse4_1) {
+        return SHA256::HashMessagesSHANI;
+    }
+    if (caps.avx2) {
+        return SHA256::HashMessagesAVX2;
+    }
+#endif
+    return SHA256::HashMessagesGeneric;
+}
+
+/// Hashes messages with the fastest implementation supported by the host.
+void HashMessages(const u8* data, std::size_t stride, std::size_t count, std::size_t length,
+                  u32* digests) {
+    static const SHA256::HashMessagesFunction hash_messages = GetHashFunction();
+    const std::size_t hashed = hash_messages(data, stride, count, length, digests);
+    SHA256::HashMessagesGeneric(data + hashed * stride, stride, count - hashed, length,
+                                digests + hashed * 8);
+}
+
+/// Looks up digests among the hashes searched for, which are sorted by their words.
+class HashLookup {
+public:
+    void Add(const SHA256Hash& hash, std::size_t index) {
+        DigestWords words;
+        for (std::size_t i = 0; i < words.size(); ++i) {
+            words[i] = (static_cast<u32>(hash[i * 4]) << 24) |
+                       (static_cast<u32>(hash[i * 4 + 1]) << 16) |
+                       (static_cast<u32>(hash[i * 4 + 2]) << 8) | static_cast<u32>(hash[i * 4 + 3]);
+        }
+        const auto entry = std::make_pair(words, index);
+        entries.insert(std::upper_bound(entries.begin(), entries.end(), entry), entry);
+    }
+
+    /// Calls func with the index of every hash equal to the digest.
+    template <typename Func>
+    void ForEachMatch(const u32* digest, Func&& func) const {
+        // Nearly every digest differs from all hashes in the first word already.
+        const u32 first_word = digest[0];
+        auto iter = std::lower_bound(
+            entries.begin(), entries.end(), first_word,
+            [](const auto& entry, u32 word) { return entry.first[0] < word; });
+        for (; iter != entries.end() && iter->first[0] == first_word; ++iter) {
+            if (std::equal(iter->first.begin(), iter->first.end(), digest)) {
+                func(iter->second);
+            }
+        }
+    }
+
+private:
+    std::vector<std::pair<DigestWords, std::size_t>> entries;
+};
+
+/// Keeps the lowest offset each target is found at, shared by the tasks of a search.
+class SearchResults {
+public:
+    explicit SearchResults(std::size_t num_targets) : offsets(num_targets, NOT_FOUND) {}
+
+    /**
+     * Records a match. If it is the lowest offset of the target so far, calls on_lowest while
+     * still holding the lock, so that data kept along with the offset stays consistent with it.
+     */
+    template <typename Func>
+    void Report(std::size_t target, std::size_t offset, Func&& on_lowest) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (offset < offsets[target]) {
+            offsets[target] = offset;
+            on_lowest();
+        }
+    }
+
+    std::size_t GetOffset(std::size_t target) const {
+        return offsets[target];
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::size_t> offsets;
+};
+
+} // Anonymous namespace
+
+std::vector<std::vector<u8>> FindKeysFromHashes(const std::vector<u8>& binary,
+                                                const std::vector<KeySearchTarget>& targets) {
+    std::vector<std::vector<u8>> out(targets.size());
+
+    // Every key size has its own windows, looked up among the targets of that size.
+    std::map<std::size_t, HashLookup> lookups;
+    for (std::size_t i = 0; i < targets.size(); ++i) {
+        const std::size_t size = targets[i].size;
+        ASSERT(size % 4 == 0 && size <= SHA256::MAX_MESSAGE_SIZE);
+        if (size != 0 && size <= binary.size()) {
+            lookups[size].Add(targets[i].hash, i);
+        }
+    }
+    if (lookups.empty()) {
+        return out;
+    }
+
+    SearchResults results(targets.size());
+    const std::size_t max_windows = binary.size() - lookups.begin()->first + 1;
+    const std::size_t num_chunks = (max_windows + WINDOWS_PER_CHUNK - 1) / WINDOWS_PER_CHUNK;
+    Common::GetSharedThreadPool().ParallelFor(num_chunks, [&](std::size_t chunk) {
+        const std::size_t begin = chunk * WINDOWS_PER_CHUNK;
+        std::vector<u32> digests(WINDOWS_PER_CHUNK * 8);
+        for (const auto& [size, lookup] : lookups) {
+            const std::size_t num_windows = binary.size() - size + 1;
+            if (begin >= num_windows) {
+                continue;
+            }
+
+            const std::size_t count = std::min(WINDOWS_PER_CHUNK, num_windows - begin);
+            HashMessages(binary.data() + begin, 1, count, size, digests.data());
+            for (std::size_t i = 0; i < count; ++i) {
+                lookup.ForEachMatch(&digests[i * 8], [&](std::size_t target) {
+                    results.Report(target, begin + i, [] {});
+                });
+            }
+        }
+    });
+
+    for (std::size_t i = 0; i < targets.size(); ++i) {
+        const std::size_t offset = results.GetOffset(i);
+        if (offset != NOT_FOUND) {
+            out[i].assign(binary.begin() + offset, binary.begin() + offset + targets[i].size);
+        }
+    }
+    return out;
+}
+
+std::vector<Key128> FindEncryptedKeysFromHashes(const std::vector<u8>& binary, const Key128& key,
+                                                const std::vector<SHA256Hash>& hashes) {
+    std::vector<Key128> out(hashes.size());
+    if (binary.size() < sizeof(Key128) || hashes.empty()) {
+        return out;
+    }
+
+    HashLookup lookup;
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        lookup.Add(hashes[i], i);
+    }
+
+    SearchResults results(hashes.size());
+    const std::size_t num_windows = binary.size() - sizeof(Key128) + 1;
+    const std::size_t num_chunks = (num_windows + WINDOWS_PER_CHUNK - 1) / WINDOWS_PER_CHUNK;
+    Common::GetSharedThreadPool().ParallelFor(num_chunks, [&](std::size_t chunk) {
+        const std::size_t begin = chunk * WINDOWS_PER_CHUNK;
+        const std::size_t count = std::min(WINDOWS_PER_CHUNK, num_windows - begin);
+
+        // The windows overlap, they are laid out as separate blocks to be decrypted in one go.
+        std::vector<u8> blocks(count * sizeof(Key128));
+        for (std::size_t i = 0; i < count; ++i) {
+            std::memcpy(&blocks[i * sizeof(Key128)], &binary[begin + i], sizeof(Key128));
+        }
+        AESCipher<Key128> cipher(key, Mode::ECB);
+        cipher.Transcode(blocks.data(), blocks.size(), blocks.data(), Op::Decrypt);
+
+        std::vector<u32> digests(count * 8);
+        HashMessages(blocks.data(), sizeof(Key128), count, sizeof(Key128), digests.data());
+        for (std::size_t i = 0; i < count; ++i) {
+            lookup.ForEachMatch(&digests[i * 8], [&](std::size_t index) {
+                results.Report(index, begin + i, [&] {
+                    std::memcpy(out[index].data(), &blocks[i * sizeof(Key128)], sizeof(Key128));
+                });
+            });
+        }
+    });
+
+    return out;
+}
+
+} // namespace Core::Crypto
@@ -0,0 +1,41 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+#include "core/crypto/key_manager.h"
+
+namespace Core::Crypto {
+
+/// A key to look for in a binary, known by the SHA-256 hash of its contents.
+struct KeySearchTarget {
+    SHA256Hash hash;
+    /// Size of the key in bytes, a multiple of 4 up to 52.
+    std::size_t size;
+};
+
+/**
+ * Searches a binary for keys by hashing the window of each key size at every offset of it. All
+ * targets are searched for in a single pass, which is split across threads and hashes several
+ * windows at once with the SHA extensions or AVX2 when the host supports them.
+ *
+ * @returns The keys in the order of the targets, taken from the lowest offset they are found at.
+ * Keys that weren't found are left empty.
+ */
+std::vector<std::vector<u8>> FindKeysFromHashes(const std::vector<u8>& binary,
+                                                const std::vector<KeySearchTarget>& targets);
+
+/**
+ * Searches a binary for 16 byte keys stored encrypted in AES-ECB mode, by decrypting the window
+ * at every offset with the given key and hashing the result. Searches like FindKeysFromHashes.
+ *
+ * @returns The decrypted keys in the order of the hashes, zero for keys that weren't found.
+ */
+std::vector<Key128> FindEncryptedKeysFromHashes(const std::vector<u8>& binary, const Key128& key,
+                                                const std::vector<SHA256Hash>& hashes);
+
+} // namespace Core::Crypto
@@ -11,7 +11,6 @@
 #include <array>
 #include <cctype>
 #include <cstring>
-#include <mbedtls/sha256.h>
 #include "common/assert.h"
 #include "common/common_funcs.h"
 #include "common/common_types.h"
@@ -20,6 +19,7 @@
 #include "common/string_util.h"
 #include "common/swap.h"
 #include "core/crypto/key_manager.h"
+#include "core/crypto/key_search.h"
 #include "core/crypto/partition_data_manager.h"
 #include "core/crypto/xts_encryption_layer.h"
 #include "core/file_sys/vfs.h"
@@ -240,53 +240,45 @@ static u8 CalculateMaxKeyblobSourceHash() {
 
 const u8 PartitionDataManager::MAX_KEYBLOB_SOURCE_HASH = CalculateMaxKeyblobSourceHash();
 
-template <size_t key_size = 0x10>
-std::array<u8, key_size> FindKeyFromHex(const std::vector<u8>& binary,
-                                        const std::array<u8, 0x20>& hash) {
-    if (binary.size() < key_size)
-        return {};
-
-    std::array<u8, 0x20> temp{};
-    for (size_t i = 0; i < binary.size() - key_size; ++i) {
-        mbedtls_sha256(binary.data() + i, key_size, temp.data(), 0);
-
-        if (temp != hash)
-            continue;
-
-        std::array<u8, key_size> out{};
-        std::memcpy(out.data(), binary.data() + i, key_size);
-        return out;
-    }
-
-    return {};
-}
-
-std::array<u8, 16> FindKeyFromHex16(const std::vector<u8>& binary, std::array<u8, 32> hash) {
-    return FindKeyFromHex<0x10>(binary, hash);
-}
-
-static std::array<Key128, 0x20> FindEncryptedMasterKeyFromHex(const std::vector<u8>& binary,
-                                                              const Key128& key) {
-    if (binary.size() < 0x10)
-        return {};
-
-    SHA256Hash temp{};
-    Key128 dec_temp{};
-    std::array<Key128, 0x20> out{};
-    AESCipher<Key128> cipher(key, Mode::ECB);
-    for (size_t i = 0; i < binary.size() - 0x10; ++i) {
-        cipher.Transcode(binary.data() + i, dec_temp.size(), dec_temp.data(), Op::Decrypt);
-        mbedtls_sha256(dec_temp.data(), dec_temp.size(), temp.data(), 0);
-
-        for (size_t k = 0; k < out.size(); ++k) {
-            if (temp == master_key_hashes[k]) {
-                out[k] = dec_temp;
-                break;
-            }
-        }
-    }
+/// A source key known to be in a binary, by its index in source_hashes
+struct SourceKey {
+    std::size_t index;
+    std::size_t size;
+};
 
-    return out;
+constexpr std::array<SourceKey, 5> secure_monitor_source_keys{{
+    {2, 0x10},
+    {3, 0x10},
+    {5, 0x10},
+    {14, 0x10},
+    {15, 0x10},
+}};
+
+constexpr std::array<SourceKey, 2> package1_source_keys{{
+    {0, 0x10},
+    {1, 0x10},
+}};
+
+constexpr std::array<SourceKey, 8> package2_fs_source_keys{{
+    {6, 0x10},
+    {7, 0x10},
+    {8, 0x10},
+    {9, 0x10},
+    {10, 0x20},
+    {11, 0x20},
+    {12, 0x10},
+    {13, 0x20},
+}};
+
+constexpr std::array<SourceKey, 1> package2_spl_source_keys{{
+    {4, 0x10},
+}};
+
+template <std::size_t size>
+static void AddSearchTargets(std::vector<KeySearchTarget>& targets,
+                             const std::array<SourceKey, size>& keys) {
+    for (const auto& key : keys)
+        targets.push_back({source_hashes[key.index], key.size});
 }
 
 FileSys::VirtualFile FindFileInDirWithNames(const FileSys::VirtualDir& dir,
@@ -324,6 +316,43 @@ PartitionDataManager::PartitionDataManager(const FileSys::VirtualDir& sysdata_di
 
 PartitionDataManager::~PartitionDataManager() = default;
 
+template <std::size_t key_size>
+std::array<u8, key_size> PartitionDataManager::FindKey(const std::vector<u8>& binary,
+                                                       const SHA256Hash& hash) const {
+    std::lock_guard<std::mutex> lock(found_keys_mutex);
+
+    auto binary_keys = found_keys.find(&binary);
+    if (binary_keys == found_keys.end()) {
+        std::vector<KeySearchTarget> targets;
+        if (&binary == &secure_monitor_bytes) {
+            AddSearchTargets(targets, secure_monitor_source_keys);
+        } else if (&binary == &package1_decrypted_bytes) {
+            AddSearchTargets(targets, package1_source_keys);
+            for (const auto& keyblob_source_hash : keyblob_source_hashes) {
+                if (keyblob_source_hash != SHA256Hash{})
+                    targets.push_back({keyblob_source_hash, 0x10});
+            }
+        } else if (std::any_of(package2_fs.begin(), package2_fs.end(),
+                               [&binary](const auto& fs) { return &fs == &binary; })) {
+            AddSearchTargets(targets, package2_fs_source_keys);
+        } else {
+            AddSearchTargets(targets, package2_spl_source_keys);
+        }
+
+        const auto keys = FindKeysFromHashes(binary, targets);
+        std::map<SHA256Hash, std::vector<u8>> found;
+        for (std::size_t i = 0; i < targets.size(); ++i)
+            found.emplace(targets[i].hash, keys[i]);
+        binary_keys = found_keys.emplace(&binary, std::move(found)).first;
+    }
+
+    std::array<u8, key_size> out{};
+    const auto key = binary_keys->second.find(hash);
+    if (key != binary_keys->second.end() && key->second.size() == key_size)
+        std::memcpy(out.data(), key->second.data(), key_size);
+    return out;
+}
+
 bool PartitionDataManager::HasBoot0() const {
     return boot0 != nullptr;
 }
@@ -354,28 +383,32 @@ std::vector<u8> PartitionDataManager::GetSecureMonitor() const {
 }
 
 std::array<u8, 16> PartitionDataManager::GetPackage2KeySource() const {
-    return FindKeyFromHex(secure_monitor_bytes, source_hashes[2]);
+    return FindKey<0x10>(secure_monitor_bytes, source_hashes[2]);
 }
 
 std::array<u8, 16> PartitionDataManager::GetAESKekGenerationSource() const {
-    return FindKeyFromHex(secure_monitor_bytes, source_hashes[3]);
+    return FindKey<0x10>(secure_monitor_bytes, source_hashes[3]);
 }
 
 std::array<u8, 16> PartitionDataManager::GetTitlekekSource() const {
-    return FindKeyFromHex(secure_monitor_bytes, source_hashes[5]);
+    return FindKey<0x10>(secure_monitor_bytes, source_hashes[5]);
 }
 
 std::array<std::array<u8, 16>, 32> PartitionDataManager::GetTZMasterKeys(
     std::array<u8, 0x10> master_key) const {
-    return FindEncryptedMasterKeyFromHex(secure_monitor_bytes, master_key);
+    const std::vector<SHA256Hash> hashes(master_key_hashes.begin(), master_key_hashes.end());
+    const auto keys = FindEncryptedKeysFromHashes(secure_monitor_bytes, master_key, hashes);
+    std::array<Key128, 0x20> out{};
+    std::copy(keys.begin(), keys.end(), out.begin());
+    return out;
 }
 
 std::array<u8, 16> PartitionDataManager::GetRSAKekSeed3() const {
-    return FindKeyFromHex(secure_monitor_bytes, source_hashes[14]);
+    return FindKey<0x10>(secure_monitor_bytes, source_hashes[14]);
 }
 
 std::array<u8, 16> PartitionDataManager::GetRSAKekMask0() const {
-    return FindKeyFromHex(secure_monitor_bytes, source_hashes[15]);
+    return FindKey<0x10>(secure_monitor_bytes, source_hashes[15]);
 }
 
 std::vector<u8> PartitionDataManager::GetPackage1Decrypted() const {
@@ -383,11 +416,11 @@ std::vector<u8> PartitionDataManager::GetPackage1Decrypted() const {
 }
 
 std::array<u8, 16> PartitionDataManager::GetMasterKeySource() const {
-    return FindKeyFromHex(package1_decrypted_bytes, source_hashes[1]);
+    return FindKey<0x10>(package1_decrypted_bytes, source_hashes[1]);
 }
 
 std::array<u8, 16> PartitionDataManager::GetKeyblobMACKeySource() const {
-    return FindKeyFromHex(package1_decrypted_bytes, source_hashes[0]);
+    return FindKey<0x10>(package1_decrypted_bytes, source_hashes[0]);
 }
 
 std::array<u8, 16> PartitionDataManager::GetKeyblobKeySource(std::size_t revision) const {
@@ -396,7 +429,7 @@ std::array<u8, 16> PartitionDataManager::GetKeyblobKeySource(std::size_t revisio
                     "No keyblob source hash for crypto revision {:02X}! Cannot derive keys...",
                     revision);
     }
-    return FindKeyFromHex(package1_decrypted_bytes, keyblob_source_hashes[revision]);
+    return FindKey<0x10>(package1_decrypted_bytes, keyblob_source_hashes[revision]);
 }
 
 bool PartitionDataManager::HasFuses() const {
@@ -449,6 +482,13 @@ bool AttemptDecrypt(const std::array<u8, 16>& key, Package2Header& header) {
 
 void PartitionDataManager::DecryptPackage2(const std::array<Key128, 0x20>& package2_keys,
                                            Package2Type type) {
+    {
+        // Keys found in the previous contents of the binaries would be stale.
+        std::lock_guard<std::mutex> lock(found_keys_mutex);
+        found_keys.erase(&package2_fs[static_cast<size_t>(type)]);
+        found_keys.erase(&package2_spl[static_cast<size_t>(type)]);
+    }
+
     FileSys::VirtualFile file = std::make_shared<FileSys::OffsetVfsFile>(
         package2[static_cast<size_t>(type)],
         package2[static_cast<size_t>(type)]->GetSize() - 0x4000, 0x4000);
@@ -531,35 +571,35 @@ const std::vector<u8>& PartitionDataManager::GetPackage2FSDecompressed(Package2T
 }
 
 std::array<u8, 16> PartitionDataManager::GetKeyAreaKeyApplicationSource(Package2Type type) const {
-    return FindKeyFromHex(package2_fs.at(static_cast<size_t>(type)), source_hashes[6]);
+    return FindKey<0x10>(package2_fs.at(static_cast<size_t>(type)), source_hashes[6]);
 }
 
 std::array<u8, 16> PartitionDataManager::GetKeyAreaKeyOceanSource(Package2Type type) const {
-    return FindKeyFromHex(package2_fs.at(static_cast<size_t>(type)), source_hashes[7]);
+    return FindKey<0x10>(package2_fs.at(static_cast<size_t>(type)), source_hashes[7]);
 }
 
 std::array<u8, 16> PartitionDataManager::GetKeyAreaKeySystemSource(Package2Type type) const {
-    return FindKeyFromHex(package2_fs.at(static_cast<size_t>(type)), source_hashes[8]);
+    return FindKey<0x10>(package2_fs.at(static_cast<size_t>(type)), source_hashes[8]);
 }
 
 std::array<u8, 16> PartitionDataManager::GetSDKekSource(Package2Type type) const {
-    return FindKeyFromHex(package2_fs.at(static_cast<size_t>(type)), source_hashes[9]);
+    return FindKey<0x10>(package2_fs.at(static_cast<size_t>(type)), source_hashes[9]);
 }
 
 std::array<u8, 32> PartitionDataManager::GetSDSaveKeySource(Package2Type type) const {
-    return FindKeyFromHex<0x20>(package2_fs.at(static_cast<size_t>(type)), source_hashes[10]);
+    return FindKey<0x20>(package2_fs.at(static_cast<size_t>(type)), source_hashes[10]);
 }
 
 std::array<u8, 32> PartitionDataManager::GetSDNCAKeySource(Package2Type type) const {
-    return FindKeyFromHex<0x20>(package2_fs.at(static_cast<size_t>(type)), source_hashes[11]);
+    return FindKey<0x20>(package2_fs.at(static_cast<size_t>(type)), source_hashes[11]);
 }
 
 std::array<u8, 16> PartitionDataManager::GetHeaderKekSource(Package2Type type) const {
-    return FindKeyFromHex(package2_fs.at(static_cast<size_t>(type)), source_hashes[12]);
+    return FindKey<0x10>(package2_fs.at(static_cast<size_t>(type)), source_hashes[12]);
 }
 
 std::array<u8, 32> PartitionDataManager::GetHeaderKeySource(Package2Type type) const {
-    return FindKeyFromHex<0x20>(package2_fs.at(static_cast<size_t>(type)), source_hashes[13]);
+    return FindKey<0x20>(package2_fs.at(static_cast<size_t>(type)), source_hashes[13]);
 }
 
 const std::vector<u8>& PartitionDataManager::GetPackage2SPLDecompressed(Package2Type type) const {
@@ -567,7 +607,7 @@ const std::vector<u8>& PartitionDataManager::GetPackage2SPLDecompressed(Package2
 }
 
 std::array<u8, 16> PartitionDataManager::GetAESKeyGenerationSource(Package2Type type) const {
-    return FindKeyFromHex(package2_spl.at(static_cast<size_t>(type)), source_hashes[4]);
+    return FindKey<0x10>(package2_spl.at(static_cast<size_t>(type)), source_hashes[4]);
 }
 
 bool PartitionDataManager::HasProdInfo() const {
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <array>
+#include <map>
+#include <mutex>
 #include <vector>
 #include "common/common_types.h"
 #include "core/file_sys/vfs_types.h"
@@ -87,6 +90,15 @@ public:
     std::array<u8, 0x240> GetETicketExtendedKek() const;
 
 private:
+    using SHA256Hash = std::array<u8, 0x20>;
+
+    /**
+     * Returns the key with the given hash from one of the binaries below. Each binary is searched
+     * for all keys known to be in it at once, when the first of them is requested.
+     */
+    template <std::size_t key_size>
+    std::array<u8, key_size> FindKey(const std::vector<u8>& binary, const SHA256Hash& hash) const;
+
     FileSys::VirtualFile boot0;
     FileSys::VirtualFile fuses;
     FileSys::VirtualFile kfuses;
@@ -102,8 +114,10 @@ private:
     std::vector<u8> package1_decrypted_bytes;
     std::array<std::vector<u8>, 6> package2_fs;
     std::array<std::vector<u8>, 6> package2_spl;
-};
 
-std::array<u8, 0x10> FindKeyFromHex16(const std::vector<u8>& binary, std::array<u8, 0x20> hash);
+    // Keys found in each of the binaries above by their hashes
+    mutable std::mutex found_keys_mutex;
+    mutable std::map<const std::vector<u8>*, std::map<SHA256Hash, std::vector<u8>>> found_keys;
+};
 
 } // namespace Core::Crypto
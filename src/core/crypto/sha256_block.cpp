@@ -0,0 +1,69 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "core/crypto/sha256_block.h"
+
+namespace Core::Crypto::SHA256 {
+namespace {
+
+constexpr u32 RotateRight(u32 value, u32 shift) {
+    return (value >> shift) | (value << (32 - shift));
+}
+
+u32 ReadBigEndian(const u8* data) {
+    return (static_cast<u32>(data[0]) << 24) | (static_cast<u32>(data[1]) << 16) |
+           (static_cast<u32>(data[2]) << 8) | static_cast<u32>(data[3]);
+}
+
+} // Anonymous namespace
+
+std::size_t HashMessagesGeneric(const u8* data, std::size_t stride, std::size_t count,
+                                std::size_t length, u32* digests) {
+    const std::size_t num_words = length / 4;
+    for (std::size_t i = 0; i < count; ++i) {
+        const u8* const message = data + i * stride;
+
+        // The padded message is the message itself, a set bit, zeros and the size in bits.
+        std::array<u32, 64> w{};
+        for (std::size_t j = 0; j < num_words; ++j) {
+            w[j] = ReadBigEndian(message + j * 4);
+        }
+        w[num_words] = 0x80000000;
+        w[15] = static_cast<u32>(length * 8);
+        for (std::size_t j = 16; j < w.size(); ++j) {
+            const u32 w15 = w[j - 15];
+            const u32 w2 = w[j - 2];
+            const u32 s0 = RotateRight(w15, 7) ^ RotateRight(w15, 18) ^ (w15 >> 3);
+            const u32 s1 = RotateRight(w2, 17) ^ RotateRight(w2, 19) ^ (w2 >> 10);
+            w[j] = w[j - 16] + s0 + w[j - 7] + s1;
+        }
+
+        auto [a, b, c, d, e, f, g, h] = INITIAL_STATE;
+        for (std::size_t j = 0; j < w.size(); ++j) {
+            const u32 s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+            const u32 choice = (e & f) ^ (~e & g);
+            const u32 temp1 = h + s1 + choice + ROUND_CONSTANTS[j] + w[j];
+            const u32 s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+            const u32 majority = (a & b) ^ (a & c) ^ (b & c);
+            const u32 temp2 = s0 + majority;
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        const std::array<u32, 8> state{a, b, c, d, e, f, g, h};
+        for (std::size_t j = 0; j < state.size(); ++j) {
+            digests[i * 8 + j] = INITIAL_STATE[j] + state[j];
+        }
+    }
+    return count;
+}
+
+} // namespace Core::Crypto::SHA256
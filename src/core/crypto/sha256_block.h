@@ -0,0 +1,57 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "common/common_types.h"
+
+/**
+ * SHA-256 of many short messages, each of which fits a single block once padded. Used to find
+ * keys by their hashes, where every window of a binary is a candidate key. Messages are
+ * `length` bytes long, a multiple of 4 no larger than MAX_MESSAGE_SIZE, and message i starts at
+ * `data + i * stride`. Digests are stored as their 8 words in host byte order.
+ */
+namespace Core::Crypto::SHA256 {
+
+constexpr std::size_t MAX_MESSAGE_SIZE = 52;
+
+constexpr std::array<u32, 8> INITIAL_STATE{
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+};
+
+constexpr std::array<u32, 64> ROUND_CONSTANTS{
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+/**
+ * Hashes messages with the instruction set of an implementation.
+ * @returns The number of messages hashed, which may leave a remainder for SIMD implementations.
+ */
+using HashMessagesFunction = std::size_t (*)(const u8* data, std::size_t stride, std::size_t count,
+                                             std::size_t length, u32* digests);
+
+/// Hashes all messages in portable code.
+std::size_t HashMessagesGeneric(const u8* data, std::size_t stride, std::size_t count,
+                                std::size_t length, u32* digests);
+
+#ifdef ARCHITECTURE_x86_64
+/// Hashes all messages with the SHA extensions. Requires SHA and SSE4.1 support.
+std::size_t HashMessagesSHANI(const u8* data, std::size_t stride, std::size_t count,
+                              std::size_t length, u32* digests);
+
+/// Hashes groups of 8 messages at once in the lanes of AVX2 registers. Requires AVX2 support.
+std::size_t HashMessagesAVX2(const u8* data, std::size_t stride, std::size_t count,
+                             std::size_t length, u32* digests);
+#endif
+
+} // namespace Core::Crypto::SHA256
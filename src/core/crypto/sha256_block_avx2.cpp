@@ -0,0 +1,106 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <immintrin.h>
+#include "core/crypto/sha256_block.h"
+
+namespace Core::Crypto::SHA256 {
+namespace {
+
+constexpr std::size_t NUM_LANES = 8;
+
+template <int shift>
+__m256i RotateRight(__m256i value) {
+    return _mm256_or_si256(_mm256_srli_epi32(value, shift), _mm256_slli_epi32(value, 32 - shift));
+}
+
+__m256i Add(__m256i a, __m256i b) {
+    return _mm256_add_epi32(a, b);
+}
+
+__m256i Xor(__m256i a, __m256i b, __m256i c) {
+    return _mm256_xor_si256(_mm256_xor_si256(a, b), c);
+}
+
+} // Anonymous namespace
+
+std::size_t HashMessagesAVX2(const u8* data, std::size_t stride, std::size_t count,
+                             std::size_t length, u32* digests) {
+    const std::size_t num_words = length / 4;
+    const int lane_stride = static_cast<int>(stride);
+    const __m256i offsets =
+        _mm256_setr_epi32(0, lane_stride, lane_stride * 2, lane_stride * 3, lane_stride * 4,
+                          lane_stride * 5, lane_stride * 6, lane_stride * 7);
+    const __m256i byte_swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13,
+                                               12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14,
+                                               13, 12);
+
+    std::size_t i = 0;
+    for (; i + NUM_LANES <= count; i += NUM_LANES) {
+        // Lane k of each vector belongs to message i + k. Gathers read exactly the message bytes.
+        const u8* const messages = data + i * stride;
+        __m256i w[64];
+        for (std::size_t j = 0; j < num_words; ++j) {
+            const __m256i word = _mm256_i32gather_epi32(
+                reinterpret_cast<const int*>(messages + j * 4), offsets, 1);
+            w[j] = _mm256_shuffle_epi8(word, byte_swap);
+        }
+        w[num_words] = _mm256_set1_epi32(static_cast<int>(0x80000000));
+        for (std::size_t j = num_words + 1; j < 15; ++j) {
+            w[j] = _mm256_setzero_si256();
+        }
+        w[15] = _mm256_set1_epi32(static_cast<int>(length * 8));
+        for (std::size_t j = 16; j < 64; ++j) {
+            const __m256i s0 = Xor(RotateRight<7>(w[j - 15]), RotateRight<18>(w[j - 15]),
+                                   _mm256_srli_epi32(w[j - 15], 3));
+            const __m256i s1 = Xor(RotateRight<17>(w[j - 2]), RotateRight<19>(w[j - 2]),
+                                   _mm256_srli_epi32(w[j - 2], 10));
+            w[j] = Add(Add(w[j - 16], s0), Add(w[j - 7], s1));
+        }
+
+        __m256i state[8];
+        for (std::size_t j = 0; j < 8; ++j) {
+            state[j] = _mm256_set1_epi32(static_cast<int>(INITIAL_STATE[j]));
+        }
+        __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+        __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+        for (std::size_t j = 0; j < 64; ++j) {
+            const __m256i s1 = Xor(RotateRight<6>(e), RotateRight<11>(e), RotateRight<25>(e));
+            const __m256i choice =
+                _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            const __m256i constant = _mm256_set1_epi32(static_cast<int>(ROUND_CONSTANTS[j]));
+            const __m256i temp1 = Add(Add(h, s1), Add(Add(choice, constant), w[j]));
+            const __m256i s0 = Xor(RotateRight<2>(a), RotateRight<13>(a), RotateRight<22>(a));
+            const __m256i majority =
+                Xor(_mm256_and_si256(a, b), _mm256_and_si256(a, c), _mm256_and_si256(b, c));
+            const __m256i temp2 = Add(s0, majority);
+
+            h = g;
+            g = f;
+            f = e;
+            e = Add(d, temp1);
+            d = c;
+            c = b;
+            b = a;
+            a = Add(temp1, temp2);
+        }
+
+        // Transposes the lanes into the digest of each message.
+        alignas(32) std::array<std::array<u32, NUM_LANES>, 8> words;
+        const __m256i result[8]{a, b, c, d, e, f, g, h};
+        for (std::size_t j = 0; j < 8; ++j) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(words[j].data()),
+                               Add(result[j], state[j]));
+        }
+        for (std::size_t lane = 0; lane < NUM_LANES; ++lane) {
+            for (std::size_t j = 0; j < words.size(); ++j) {
+                digests[(i + lane) * 8 + j] = words[j][lane];
+            }
+        }
+    }
+    return i;
+}
+
+} // namespace Core::Crypto::SHA256
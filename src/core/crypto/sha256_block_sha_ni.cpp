@@ -0,0 +1,91 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <utility>
+#include <immintrin.h>
+#include "core/crypto/sha256_block.h"
+
+namespace Core::Crypto::SHA256 {
+namespace {
+
+__m128i Load(const u32* words) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(words));
+}
+
+/**
+ * Runs the four rounds of a group on the state, kept in the ABEF/CDGH layout of the SHA
+ * instructions, while extending the message schedule for the following groups. The schedule
+ * lives in four registers indexed by group, rotating through them.
+ */
+template <std::size_t group>
+void RoundGroup(__m128i& abef, __m128i& cdgh, __m128i (&schedule)[4]) {
+    constexpr std::size_t current = group % 4;
+    constexpr std::size_t previous = (group + 3) % 4;
+    constexpr std::size_t next = (group + 1) % 4;
+
+    __m128i message = _mm_add_epi32(schedule[current], Load(&ROUND_CONSTANTS[group * 4]));
+    cdgh = _mm_sha256rnds2_epu32(cdgh, abef, message);
+    if constexpr (group >= 3 && group <= 14) {
+        const __m128i words = _mm_alignr_epi8(schedule[current], schedule[previous], 4);
+        schedule[next] = _mm_add_epi32(schedule[next], words);
+        schedule[next] = _mm_sha256msg2_epu32(schedule[next], schedule[current]);
+    }
+    message = _mm_shuffle_epi32(message, 0x0E);
+    abef = _mm_sha256rnds2_epu32(abef, cdgh, message);
+    if constexpr (group >= 1 && group <= 12) {
+        schedule[previous] = _mm_sha256msg1_epu32(schedule[previous], schedule[current]);
+    }
+}
+
+template <std::size_t... groups>
+void Rounds(__m128i& abef, __m128i& cdgh, __m128i (&schedule)[4],
+            std::index_sequence<groups...>) {
+    (RoundGroup<groups>(abef, cdgh, schedule), ...);
+}
+
+u32 ReadBigEndian(const u8* data) {
+    return (static_cast<u32>(data[0]) << 24) | (static_cast<u32>(data[1]) << 16) |
+           (static_cast<u32>(data[2]) << 8) | static_cast<u32>(data[3]);
+}
+
+} // Anonymous namespace
+
+std::size_t HashMessagesSHANI(const u8* data, std::size_t stride, std::size_t count,
+                              std::size_t length, u32* digests) {
+    // Converts the initial state from DCBA/HGFE to the ABEF/CDGH layout.
+    const __m128i dcba = _mm_shuffle_epi32(Load(&INITIAL_STATE[0]), 0xB1);
+    const __m128i efgh = _mm_shuffle_epi32(Load(&INITIAL_STATE[4]), 0x1B);
+    const __m128i initial_abef = _mm_alignr_epi8(dcba, efgh, 8);
+    const __m128i initial_cdgh = _mm_blend_epi16(efgh, dcba, 0xF0);
+
+    const std::size_t num_words = length / 4;
+    for (std::size_t i = 0; i < count; ++i) {
+        const u8* const message = data + i * stride;
+
+        alignas(16) std::array<u32, 16> block{};
+        for (std::size_t j = 0; j < num_words; ++j) {
+            block[j] = ReadBigEndian(message + j * 4);
+        }
+        block[num_words] = 0x80000000;
+        block[15] = static_cast<u32>(length * 8);
+
+        __m128i schedule[4]{Load(&block[0]), Load(&block[4]), Load(&block[8]), Load(&block[12])};
+        __m128i abef = initial_abef;
+        __m128i cdgh = initial_cdgh;
+        Rounds(abef, cdgh, schedule, std::make_index_sequence<16>{});
+        abef = _mm_add_epi32(abef, initial_abef);
+        cdgh = _mm_add_epi32(cdgh, initial_cdgh);
+
+        // Converts the state back to the ABCD/EFGH order of the digest.
+        const __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+        const __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+        u32* const digest = digests + i * 8;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(digest), _mm_blend_epi16(feba, dchg, 0xF0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(digest + 4), _mm_alignr_epi8(dchg, feba, 8));
+    }
+    return count;
+}
+
+} // namespace Core::Crypto::SHA256
@@ -15,7 +15,8 @@ class XTSEncryptionLayer : public EncryptionLayer {
 public:
     XTSEncryptionLayer(FileSys::VirtualFile base, Key256 key);
 
-    std::size_t Read(u8* data, std::size_t length, std::size_t offset) const override;
+protected:
+    std::size_t ReadBlocks(u8* data, std::size_t length, std::size_t offset) const override;
 
 private:
     // Must be mutable as operations modify cipher contexts.
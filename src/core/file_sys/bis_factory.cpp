@@ -8,12 +8,18 @@
 
 namespace FileSys {
 
-BISFactory::BISFactory(VirtualDir nand_root_, VirtualDir load_root_)
+static VirtualFile IdentityParser(const VirtualFile& file, const NcaID& id) {
+    return file;
+}
+
+BISFactory::BISFactory(VirtualDir nand_root_, VirtualDir load_root_, TitleMetadataIndex* index)
     : nand_root(std::move(nand_root_)), load_root(std::move(load_root_)),
       sysnand_cache(std::make_unique<RegisteredCache>(
-          GetOrCreateDirectoryRelative(nand_root, "/system/Contents/registered"))),
+          GetOrCreateDirectoryRelative(nand_root, "/system/Contents/registered"), IdentityParser,
+          index)),
       usrnand_cache(std::make_unique<RegisteredCache>(
-          GetOrCreateDirectoryRelative(nand_root, "/user/Contents/registered"))) {}
+          GetOrCreateDirectoryRelative(nand_root, "/user/Contents/registered"), IdentityParser,
+          index)) {}
 
 BISFactory::~BISFactory() = default;
 
@@ -11,13 +11,15 @@
 namespace FileSys {
 
 class RegisteredCache;
+class TitleMetadataIndex;
 
 /// File system interface to the Built-In Storage
 /// This is currently missing accessors to BIS partitions, but seemed like a good place for the NAND
 /// registered caches.
 class BISFactory {
 public:
-    explicit BISFactory(VirtualDir nand_root, VirtualDir load_root);
+    explicit BISFactory(VirtualDir nand_root, VirtualDir load_root,
+                        TitleMetadataIndex* index = nullptr);
     ~BISFactory();
 
     RegisteredCache* GetSystemNANDContents() const;
@@ -23,12 +23,11 @@
  */
 
 #include <cstring>
+#include <utility>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "core/file_sys/fsmitm_romfsbuild.h"
-#include "core/file_sys/ips_layer.h"
 #include "core/file_sys/vfs.h"
-#include "core/file_sys/vfs_vector.h"
 
 namespace FileSys {
 
@@ -94,10 +93,10 @@ struct RomFSBuildFileContext {
     u64 size = 0;
     std::shared_ptr<RomFSBuildDirectoryContext> parent;
     std::shared_ptr<RomFSBuildFileContext> sibling;
-    VirtualFile source;
 };
 
-static u32 romfs_calc_path_hash(u32 parent, std::string path, u32 start, std::size_t path_len) {
+static u32 romfs_calc_path_hash(u32 parent, const std::string& path, u32 start,
+                                std::size_t path_len) {
     u32 hash = parent ^ 123456789;
     for (u32 i = 0; i < path_len; i++) {
         hash = (hash >> 5) | (hash << 27);
@@ -124,69 +123,68 @@ static u64 romfs_get_hash_table_count(u64 num_entries) {
     return count;
 }
 
-void RomFSBuildContext::VisitDirectory(VirtualDir root_romfs, VirtualDir ext,
+void RomFSBuildContext::VisitDirectory(const VirtualDir& dir, const VirtualDir& ext,
                                        std::shared_ptr<RomFSBuildDirectoryContext> parent) {
-    std::vector<std::shared_ptr<RomFSBuildDirectoryContext>> child_dirs;
-
-    VirtualDir dir;
-
-    if (parent->path_len == 0)
-        dir = root_romfs;
-    else
-        dir = root_romfs->GetDirectoryRelative(parent->path);
-
-    const auto entries = dir->GetEntries();
-
-    for (const auto& kv : entries) {
-        if (kv.second == VfsEntryType::Directory) {
-            const auto child = std::make_shared<RomFSBuildDirectoryContext>();
-            // Set child's path.
-            child->cur_path_ofs = parent->path_len + 1;
-            child->path_len = child->cur_path_ofs + static_cast<u32>(kv.first.size());
-            child->path = parent->path + "/" + kv.first;
-
-            if (ext != nullptr && ext->GetFileRelative(child->path + ".stub") != nullptr)
-                continue;
-
-            // Sanity check on path_len
-            ASSERT(child->path_len < FS_MAX_PATH);
-
-            if (AddDirectory(parent, child)) {
-                child_dirs.push_back(child);
-            }
-        } else {
-            const auto child = std::make_shared<RomFSBuildFileContext>();
-            // Set child's path.
-            child->cur_path_ofs = parent->path_len + 1;
-            child->path_len = child->cur_path_ofs + static_cast<u32>(kv.first.size());
-            child->path = parent->path + "/" + kv.first;
-
-            if (ext != nullptr && ext->GetFileRelative(child->path + ".stub") != nullptr)
-                continue;
-
-            // Sanity check on path_len
-            ASSERT(child->path_len < FS_MAX_PATH);
+    // The extension directory mirrors the tree being visited, it's listed once per directory
+    // instead of looking up stubs by path, which would walk every layer from the root each time.
+    std::map<std::string, VfsEntryType, std::less<>> ext_entries;
+    if (ext != nullptr)
+        ext_entries = ext->GetEntries();
+
+    const auto is_stubbed = [&ext_entries](const std::string& name) {
+        const auto stub = ext_entries.find(name + ".stub");
+        return stub != ext_entries.end() && stub->second == VfsEntryType::File;
+    };
+
+    std::vector<std::pair<std::shared_ptr<RomFSBuildDirectoryContext>, VirtualDir>> child_dirs;
+
+    for (auto& subdir : dir->GetSubdirectories()) {
+        const auto name = subdir->GetName();
+        const auto child = std::make_shared<RomFSBuildDirectoryContext>();
+        // Set child's path.
+        child->cur_path_ofs = parent->path_len + 1;
+        child->path_len = child->cur_path_ofs + static_cast<u32>(name.size());
+        child->path = parent->path + "/" + name;
+
+        if (is_stubbed(name))
+            continue;
+
+        // Sanity check on path_len
+        ASSERT(child->path_len < FS_MAX_PATH);
+
+        if (AddDirectory(parent, child)) {
+            child_dirs.emplace_back(child, std::move(subdir));
+        }
+    }
 
-            child->source = root_romfs->GetFileRelative(child->path);
+    for (const auto& file : dir->GetFiles()) {
+        const auto name = file->GetName();
+        const auto child = std::make_shared<RomFSBuildFileContext>();
+        // Set child's path.
+        child->cur_path_ofs = parent->path_len + 1;
+        child->path_len = child->cur_path_ofs + static_cast<u32>(name.size());
+        child->path = parent->path + "/" + name;
 
-            if (ext != nullptr) {
-                const auto ips = ext->GetFileRelative(child->path + ".ips");
+        // A directory of a layer takes precedence over a file of the same name in another one.
+        if (is_stubbed(name) || directories.find(child->path) != directories.end())
+            continue;
 
-                if (ips != nullptr) {
-                    auto patched = PatchIPS(child->source, ips);
-                    if (patched != nullptr)
-                        child->source = std::move(patched);
-                }
-            }
+        // Sanity check on path_len
+        ASSERT(child->path_len < FS_MAX_PATH);
 
-            child->size = child->source->GetSize();
+        // IPS patches don't change the size of the file, they are only applied once it's read.
+        child->size = file->GetSize();
 
-            AddFile(parent, child);
-        }
+        AddFile(parent, child);
     }
 
-    for (auto& child : child_dirs) {
-        this->VisitDirectory(root_romfs, ext, child);
+    for (const auto& [child, child_dir] : child_dirs) {
+        VirtualDir child_ext;
+        const auto ext_entry = ext_entries.find(child_dir->GetName());
+        if (ext_entry != ext_entries.end() && ext_entry->second == VfsEntryType::Directory)
+            child_ext = ext->GetSubdirectory(ext_entry->first);
+
+        this->VisitDirectory(child_dir, child_ext, child);
     }
 }
 
@@ -238,7 +236,7 @@ RomFSBuildContext::RomFSBuildContext(VirtualDir base_, VirtualDir ext_)
 
 RomFSBuildContext::~RomFSBuildContext() = default;
 
-std::map<u64, VirtualFile> RomFSBuildContext::Build() {
+RomFSLayout RomFSBuildContext::Build() {
     const u64 dir_hash_table_entry_count = romfs_get_hash_table_count(num_dirs);
     const u64 file_hash_table_entry_count = romfs_get_hash_table_count(num_files);
     dir_hash_table_size = 4 * dir_hash_table_entry_count;
@@ -292,7 +290,8 @@ std::map<u64, VirtualFile> RomFSBuildContext::Build() {
         cur_dir->parent->child = cur_dir;
     }
 
-    std::map<u64, VirtualFile> out;
+    RomFSLayout out{};
+    out.files.reserve(files.size());
 
     // Populate file tables.
     for (const auto& it : files) {
@@ -313,7 +312,8 @@ std::map<u64, VirtualFile> RomFSBuildContext::Build() {
 
         cur_entry.name_size = name_size;
 
-        out.emplace(cur_file->offset + ROMFS_FILEPARTITION_OFS, cur_file->source);
+        out.files.push_back(
+            {cur_file->offset + ROMFS_FILEPARTITION_OFS, cur_file->size, cur_file->path});
         std::memcpy(file_table.data() + cur_file->entry_offset, &cur_entry, sizeof(RomFSFileEntry));
         std::memset(file_table.data() + cur_file->entry_offset + sizeof(RomFSFileEntry), 0,
                     Common::AlignUp(cur_entry.name_size, 4));
@@ -361,9 +361,8 @@ std::map<u64, VirtualFile> RomFSBuildContext::Build() {
     header.file_hash_table_ofs = header.dir_table_ofs + header.dir_table_size;
     header.file_table_ofs = header.file_hash_table_ofs + header.file_hash_table_size;
 
-    std::vector<u8> header_data(sizeof(RomFSHeader));
-    std::memcpy(header_data.data(), &header, header_data.size());
-    out.emplace(0, std::make_shared<VectorVfsFile>(std::move(header_data)));
+    out.header.resize(sizeof(RomFSHeader));
+    std::memcpy(out.header.data(), &header, out.header.size());
 
     std::vector<u8> metadata(file_hash_table_size + file_table_size + dir_hash_table_size +
                              dir_table_size);
@@ -376,7 +375,8 @@ std::map<u64, VirtualFile> RomFSBuildContext::Build() {
                 file_hash_table.size() * sizeof(u32));
     index += file_hash_table.size() * sizeof(u32);
     std::memcpy(metadata.data() + index, file_table.data(), file_table.size());
-    out.emplace(header.dir_hash_table_ofs, std::make_shared<VectorVfsFile>(std::move(metadata)));
+    out.metadata_offset = header.dir_hash_table_ofs;
+    out.metadata = std::move(metadata);
 
     return out;
 }
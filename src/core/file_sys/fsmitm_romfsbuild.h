@@ -27,6 +27,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 #include <boost/detail/container_fwd.hpp>
 #include "common/common_types.h"
 #include "core/file_sys/vfs.h"
@@ -38,13 +39,29 @@ struct RomFSBuildFileContext;
 struct RomFSDirectoryEntry;
 struct RomFSFileEntry;
 
+// The header and metadata tables of a RomFS, along with where the data of each file goes.
+struct RomFSLayout {
+    struct File {
+        // Offset of the data of the file within the RomFS
+        u64 offset;
+        u64 size;
+        // Path of the file relative to the directory the RomFS is built from
+        std::string path;
+    };
+
+    std::vector<u8> header;
+    u64 metadata_offset;
+    std::vector<u8> metadata;
+    std::vector<File> files;
+};
+
 class RomFSBuildContext {
 public:
     explicit RomFSBuildContext(VirtualDir base, VirtualDir ext = nullptr);
     ~RomFSBuildContext();
 
-    // This finalizes the context.
-    std::map<u64, VirtualFile> Build();
+    // This finalizes the context. The files aren't read, only their sizes are known at this point.
+    RomFSLayout Build();
 
 private:
     VirtualDir base;
@@ -60,7 +77,7 @@ private:
     u64 file_hash_table_size = 0;
     u64 file_partition_size = 0;
 
-    void VisitDirectory(VirtualDir filesys, VirtualDir ext,
+    void VisitDirectory(const VirtualDir& dir, const VirtualDir& ext,
                         std::shared_ptr<RomFSBuildDirectoryContext> parent);
 
     bool AddDirectory(std::shared_ptr<RomFSBuildDirectoryContext> parent_dir_ctx,
@@ -5,174 +5,206 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstring>
+#include <limits>
 
 #include "common/assert.h"
 #include "core/crypto/aes_util.h"
 #include "core/file_sys/nca_patch.h"
 
 namespace FileSys {
+namespace {
+
+/// Appends an entry to a table of entries sorted by address, merging it with the last entry if
+/// that one ends up empty or already covers it.
+template <typename Entry, typename ContinuesFunc>
+void AppendEntry(std::vector<Entry>& entries, const Entry& entry, ContinuesFunc&& continues) {
+    if (!entries.empty()) {
+        if (entries.back().address_patch == entry.address_patch) {
+            entries.back() = entry;
+            return;
+        }
+        if (continues(entries.back(), entry))
+            return;
+    }
+    entries.push_back(entry);
+}
+
+/**
+ * Returns the index of the entry covering the offset in a table built by AppendEntry. The entries
+ * at and after the cursor are tried first, sequential reads rarely need the binary search.
+ */
+template <typename Entry>
+std::size_t FindEntry(const std::vector<Entry>& entries, std::atomic<std::size_t>& cursor,
+                      u64 offset) {
+    const std::size_t last = entries.size() - 2;
+    const std::size_t hint = cursor.load(std::memory_order_relaxed);
+    for (std::size_t i = hint; i <= std::min(hint + 1, last); ++i) {
+        if (entries[i].address_patch <= offset && offset < entries[i + 1].address_patch) {
+            if (i != hint)
+                cursor.store(i, std::memory_order_relaxed);
+            return i;
+        }
+    }
+
+    const auto iter = std::upper_bound(
+        entries.begin(), entries.end(), offset,
+        [](u64 value, const Entry& entry) { return value < entry.address_patch; });
+    const std::size_t index =
+        std::min<std::size_t>(iter == entries.begin() ? 0 : iter - entries.begin() - 1, last);
+    cursor.store(index, std::memory_order_relaxed);
+    return index;
+}
+
+} // Anonymous namespace
 
 BKTR::BKTR(VirtualFile base_romfs_, VirtualFile bktr_romfs_, RelocationBlock relocation_,
-           std::vector<RelocationBucket> relocation_buckets_, SubsectionBlock subsection_,
-           std::vector<SubsectionBucket> subsection_buckets_, bool is_encrypted_,
+           std::vector<RelocationBucket> relocation_buckets, SubsectionBlock subsection,
+           std::vector<SubsectionBucket> subsection_buckets, bool is_encrypted_,
            Core::Crypto::Key128 key_, u64 base_offset_, u64 ivfc_offset_,
            std::array<u8, 8> section_ctr_)
-    : relocation(relocation_), relocation_buckets(std::move(relocation_buckets_)),
-      subsection(subsection_), subsection_buckets(std::move(subsection_buckets_)),
-      base_romfs(std::move(base_romfs_)), bktr_romfs(std::move(bktr_romfs_)),
-      encrypted(is_encrypted_), key(key_), base_offset(base_offset_), ivfc_offset(ivfc_offset_),
-      section_ctr(section_ctr_) {
-    for (std::size_t i = 0; i < relocation.number_buckets - 1; ++i) {
-        relocation_buckets[i].entries.push_back({relocation.base_offsets[i + 1], 0, 0});
+    : relocation(relocation_), base_romfs(std::move(base_romfs_)),
+      bktr_romfs(std::move(bktr_romfs_)), encrypted(is_encrypted_), key(key_),
+      base_offset(base_offset_), ivfc_offset(ivfc_offset_), section_ctr(section_ctr_) {
+    // Relocations continue each other if they read on from the same source.
+    const auto relocation_continues = [](const RelocationEntry& last, const RelocationEntry& next) {
+        return last.from_patch == next.from_patch &&
+               next.address_source - last.address_source == next.address_patch - last.address_patch;
+    };
+    for (std::size_t i = 0; i < relocation_buckets.size(); ++i) {
+        for (const auto& entry : relocation_buckets[i].entries)
+            AppendEntry(relocation_entries, entry, relocation_continues);
+
+        // Each bucket ends where the next one starts.
+        if (i + 1 < std::min<std::size_t>(relocation.number_buckets, relocation_buckets.size())) {
+            AppendEntry(relocation_entries, {relocation.base_offsets[i + 1], 0, 0},
+                        relocation_continues);
+        }
     }
-
-    for (std::size_t i = 0; i < subsection.number_buckets - 1; ++i) {
-        subsection_buckets[i].entries.push_back({subsection_buckets[i + 1].entries[0].address_patch,
-                                                 {0},
-                                                 subsection_buckets[i + 1].entries[0].ctr});
+    relocation_entries.push_back({relocation.size, 0, 0});
+
+    // The AES counter is derived from the offset, subsections with the same counter value are one
+    // stream.
+    const auto subsection_continues = [](const SubsectionEntry& last, const SubsectionEntry& next) {
+        return last.ctr == next.ctr;
+    };
+    for (const auto& bucket : subsection_buckets) {
+        for (const auto& entry : bucket.entries)
+            AppendEntry(subsection_entries, entry, subsection_continues);
     }
+    subsection_entries.push_back({std::numeric_limits<u64>::max(), {0}, 0});
 
-    relocation_buckets.back().entries.push_back({relocation.size, 0, 0});
+    ASSERT_MSG(relocation_entries.size() > 1 && subsection_entries.size() > 1,
+               "BKTR relocation or subsection table is empty.");
 }
 
 BKTR::~BKTR() = default;
 
 std::size_t BKTR::Read(u8* data, std::size_t length, std::size_t offset) const {
     // Read out of bounds.
-    if (offset >= relocation.size)
+    if (offset >= relocation.size || length == 0)
         return 0;
-    const auto relocation = GetRelocationEntry(offset);
-    const auto section_offset = offset - relocation.address_patch + relocation.address_source;
-    const auto bktr_read = relocation.from_patch;
-
-    const auto next_relocation = GetNextRelocationEntry(offset);
-
-    if (offset + length > next_relocation.address_patch) {
-        const u64 partition = next_relocation.address_patch - offset;
-        return Read(data, partition, offset) +
-               Read(data + partition, length - partition, offset + partition);
-    }
-
-    if (!bktr_read) {
-        ASSERT_MSG(section_offset >= ivfc_offset, "Offset calculation negative.");
-        return base_romfs->Read(data, length, section_offset - ivfc_offset);
-    }
-
-    if (!encrypted) {
-        return bktr_romfs->Read(data, length, section_offset);
-    }
-
-    const auto subsection = GetSubsectionEntry(section_offset);
-    Core::Crypto::AESCipher<Core::Crypto::Key128> cipher(key, Core::Crypto::Mode::CTR);
-
-    // Calculate AES IV
-    std::vector<u8> iv(16);
-    auto subsection_ctr = subsection.ctr;
-    auto offset_iv = section_offset + base_offset;
-    for (std::size_t i = 0; i < section_ctr.size(); ++i)
-        iv[i] = section_ctr[0x8 - i - 1];
-    offset_iv >>= 4;
-    for (std::size_t i = 0; i < sizeof(u64); ++i) {
-        iv[0xF - i] = static_cast<u8>(offset_iv & 0xFF);
-        offset_iv >>= 8;
-    }
-    for (std::size_t i = 0; i < sizeof(u32); ++i) {
-        iv[0x7 - i] = static_cast<u8>(subsection_ctr & 0xFF);
-        subsection_ctr >>= 8;
-    }
-    cipher.SetIV(iv);
-
-    const auto next_subsection = GetNextSubsectionEntry(section_offset);
-
-    if (section_offset + length > next_subsection.address_patch) {
-        const u64 partition = next_subsection.address_patch - section_offset;
-        return Read(data, partition, offset) +
-               Read(data + partition, length - partition, offset + partition);
-    }
-
-    const auto block_offset = section_offset & 0xF;
-    if (block_offset != 0) {
-        auto block = bktr_romfs->ReadBytes(0x10, section_offset & ~0xF);
-        cipher.Transcode(block.data(), block.size(), block.data(), Core::Crypto::Op::Decrypt);
-        if (length + block_offset < 0x10) {
-            std::memcpy(data, block.data() + block_offset, std::min(length, block.size()));
-            return std::min(length, block.size());
+    length = std::min<std::size_t>(length, relocation.size - offset);
+
+    std::size_t read = 0;
+    std::size_t index = FindEntry(relocation_entries, relocation_cursor, offset);
+    while (true) {
+        const auto& entry = relocation_entries[index];
+        const u64 patch_offset = offset + read;
+        const u64 section_offset = patch_offset - entry.address_patch + entry.address_source;
+        const u64 entry_end = relocation_entries[index + 1].address_patch;
+        const std::size_t entry_length =
+            static_cast<std::size_t>(std::min<u64>(length - read, entry_end - patch_offset));
+
+        std::size_t entry_read;
+        if (!entry.from_patch) {
+            ASSERT_MSG(section_offset >= ivfc_offset, "Offset calculation negative.");
+            entry_read = base_romfs->Read(data + read, entry_length, section_offset - ivfc_offset);
+        } else if (!encrypted) {
+            entry_read = bktr_romfs->Read(data + read, entry_length, section_offset);
+        } else {
+            entry_read = ReadEncryptedPatch(data + read, entry_length, section_offset);
         }
 
-        const auto read = 0x10 - block_offset;
-        std::memcpy(data, block.data() + block_offset, read);
-        return read + Read(data + read, length - read, offset + read);
+        read += entry_read;
+        if (read == length || entry_read != entry_length)
+            break;
+        ++index;
     }
 
-    const auto raw_read = bktr_romfs->Read(data, length, section_offset);
-    cipher.Transcode(data, raw_read, data, Core::Crypto::Op::Decrypt);
-    return raw_read;
+    relocation_cursor.store(index, std::memory_order_relaxed);
+    return read;
 }
 
-template <bool Subsection, typename BlockType, typename BucketType>
-std::pair<std::size_t, std::size_t> BKTR::SearchBucketEntry(u64 offset, BlockType block,
-                                                            BucketType buckets) const {
-    if constexpr (Subsection) {
-        const auto last_bucket = buckets[block.number_buckets - 1];
-        if (offset >= last_bucket.entries[last_bucket.number_entries].address_patch)
-            return {block.number_buckets - 1, last_bucket.number_entries};
-    } else {
-        ASSERT_MSG(offset <= block.size, "Offset is out of bounds in BKTR relocation block.");
+std::size_t BKTR::ReadEncryptedPatch(u8* data, std::size_t length, u64 section_offset) const {
+    // The read starts at the beginning of an AES block, an unaligned start goes through a buffer.
+    const u64 aligned_offset = section_offset & ~u64{0xF};
+    const std::size_t skip = static_cast<std::size_t>(section_offset - aligned_offset);
+    std::vector<u8> buffer;
+    u8* raw = data;
+    if (skip != 0) {
+        buffer.resize(length + skip);
+        raw = buffer.data();
     }
 
-    std::size_t bucket_id = std::count_if(
-        block.base_offsets.begin() + 1, block.base_offsets.begin() + block.number_buckets,
-        [&offset](u64 base_offset) { return base_offset <= offset; });
-
-    const auto bucket = buckets[bucket_id];
-
-    if (bucket.number_entries == 1)
-        return {bucket_id, 0};
-
-    std::size_t low = 0;
-    std::size_t mid = 0;
-    std::size_t high = bucket.number_entries - 1;
-    while (low <= high) {
-        mid = (low + high) / 2;
-        if (bucket.entries[mid].address_patch > offset) {
-            high = mid - 1;
-        } else {
-            if (mid == bucket.number_entries - 1 ||
-                bucket.entries[mid + 1].address_patch > offset) {
-                return {bucket_id, mid};
-            }
+    const std::size_t raw_read = bktr_romfs->Read(raw, length + skip, aligned_offset);
+    if (raw_read <= skip)
+        return 0;
+    const u64 end_offset = aligned_offset + raw_read;
 
-            low = mid + 1;
+    Core::Crypto::AESCipher<Core::Crypto::Key128> cipher(key, Core::Crypto::Mode::CTR);
+    const auto decrypt = [this, &cipher](u8* block_data, std::size_t size, u64 offset, u32 ctr) {
+        // Calculate AES IV
+        std::vector<u8> iv(16);
+        auto offset_iv = offset + base_offset;
+        for (std::size_t i = 0; i < section_ctr.size(); ++i)
+            iv[i] = section_ctr[0x8 - i - 1];
+        offset_iv >>= 4;
+        for (std::size_t i = 0; i < sizeof(u64); ++i) {
+            iv[0xF - i] = static_cast<u8>(offset_iv & 0xFF);
+            offset_iv >>= 8;
+        }
+        for (std::size_t i = 0; i < sizeof(u32); ++i) {
+            iv[0x7 - i] = static_cast<u8>(ctr & 0xFF);
+            ctr >>= 8;
+        }
+        cipher.SetIV(iv);
+        cipher.Transcode(block_data, size, block_data, Core::Crypto::Op::Decrypt);
+    };
+
+    // Subsections are decrypted from the last to the first. A block shared with the previous
+    // subsection is then decrypted from a copy while it's still encrypted in the buffer.
+    std::size_t index = FindEntry(subsection_entries, subsection_cursor, end_offset - 1);
+    while (true) {
+        const auto& entry = subsection_entries[index];
+        const bool is_first = index == 0 || entry.address_patch <= aligned_offset;
+        u64 begin = is_first ? aligned_offset : entry.address_patch;
+        const u64 end = std::min<u64>(subsection_entries[index + 1].address_patch, end_offset);
+
+        const u64 block_begin = begin & ~u64{0xF};
+        if (block_begin != begin) {
+            const std::size_t block_skip = static_cast<std::size_t>(begin - block_begin);
+            const std::size_t block_size =
+                static_cast<std::size_t>(std::min<u64>(block_begin + 0x10, end) - block_begin);
+            std::array<u8, 0x10> block;
+            std::memcpy(block.data(), raw + (block_begin - aligned_offset), block_size);
+            decrypt(block.data(), block_size, block_begin, entry.ctr);
+            std::memcpy(raw + (begin - aligned_offset), block.data() + block_skip,
+                        block_size - block_skip);
+            begin = block_begin + block_size;
+        }
+        if (begin < end) {
+            decrypt(raw + (begin - aligned_offset), static_cast<std::size_t>(end - begin), begin,
+                    entry.ctr);
         }
-    }
-
-    UNREACHABLE_MSG("Offset could not be found in BKTR block.");
-}
-
-RelocationEntry BKTR::GetRelocationEntry(u64 offset) const {
-    const auto res = SearchBucketEntry<false>(offset, relocation, relocation_buckets);
-    return relocation_buckets[res.first].entries[res.second];
-}
-
-RelocationEntry BKTR::GetNextRelocationEntry(u64 offset) const {
-    const auto res = SearchBucketEntry<false>(offset, relocation, relocation_buckets);
-    const auto bucket = relocation_buckets[res.first];
-    if (res.second + 1 < bucket.entries.size())
-        return bucket.entries[res.second + 1];
-    return relocation_buckets[res.first + 1].entries[0];
-}
 
-SubsectionEntry BKTR::GetSubsectionEntry(u64 offset) const {
-    const auto res = SearchBucketEntry<true>(offset, subsection, subsection_buckets);
-    return subsection_buckets[res.first].entries[res.second];
-}
+        if (is_first)
+            break;
+        --index;
+    }
 
-SubsectionEntry BKTR::GetNextSubsectionEntry(u64 offset) const {
-    const auto res = SearchBucketEntry<true>(offset, subsection, subsection_buckets);
-    const auto bucket = subsection_buckets[res.first];
-    if (res.second + 1 < bucket.entries.size())
-        return bucket.entries[res.second + 1];
-    return subsection_buckets[res.first + 1].entries[0];
+    if (skip != 0)
+        std::memcpy(data, buffer.data() + skip, raw_read - skip);
+    return raw_read - skip;
 }
 
 std::string BKTR::GetName() const {
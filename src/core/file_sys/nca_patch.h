@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -117,20 +118,20 @@ public:
     bool Rename(std::string_view name) override;
 
 private:
-    template <bool Subsection, typename BlockType, typename BucketType>
-    std::pair<std::size_t, std::size_t> SearchBucketEntry(u64 offset, BlockType block,
-                                                          BucketType buckets) const;
+    // Reads from the BKTR romfs at once and decrypts every subsection the range spans.
+    std::size_t ReadEncryptedPatch(u8* data, std::size_t length, u64 section_offset) const;
 
-    RelocationEntry GetRelocationEntry(u64 offset) const;
-    RelocationEntry GetNextRelocationEntry(u64 offset) const;
+    RelocationBlock relocation;
 
-    SubsectionEntry GetSubsectionEntry(u64 offset) const;
-    SubsectionEntry GetNextSubsectionEntry(u64 offset) const;
+    // Entries of all the buckets, built once. Every entry covers the addresses up to the next one
+    // and adjacent entries that continue each other are merged, so reads are only split where the
+    // source or the counter really changes. The last entry only marks the end.
+    std::vector<RelocationEntry> relocation_entries;
+    std::vector<SubsectionEntry> subsection_entries;
 
-    RelocationBlock relocation;
-    std::vector<RelocationBucket> relocation_buckets;
-    SubsectionBlock subsection;
-    std::vector<SubsectionBucket> subsection_buckets;
+    // Entries found by the last lookup, sequential reads mostly hit them or the ones after them.
+    mutable std::atomic<std::size_t> relocation_cursor{0};
+    mutable std::atomic<std::size_t> subsection_cursor{0};
 
     // Should be the raw base romfs, decrypted.
     VirtualFile base_romfs;
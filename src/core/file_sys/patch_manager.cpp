@@ -6,7 +6,13 @@
 #include <array>
 #include <cstddef>
 #include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
 #include "common/hex_util.h"
 #include "common/logging/log.h"
 #include "core/file_sys/content_archive.h"
@@ -166,6 +172,61 @@ bool PatchManager::HasNSOPatch(const std::array<u8, 32>& build_id_) const {
     return !CollectPatches(patch_dirs, build_id).empty();
 }
 
+namespace {
+/// What a LayeredFS stamp records of each file and directory in the mod directories
+struct LayeredFSStampEntry {
+    std::string path;
+    s64 modification_time;
+    /// Size of a file, 0 for directories
+    u64 size;
+
+    bool operator<(const LayeredFSStampEntry& other) const {
+        return path < other.path;
+    }
+};
+} // Anonymous namespace
+
+static void AppendStampEntries(const std::string& path, std::vector<LayeredFSStampEntry>& out) {
+    FileUtil::ForeachDirectoryEntry(
+        nullptr, path,
+        [&out](u64* entries_out, const std::string& directory, const std::string& filename) {
+            const auto full_path = directory + DIR_SEP + filename;
+            const bool is_directory = FileUtil::IsDirectory(full_path);
+            out.push_back({full_path, FileUtil::GetModificationTime(full_path),
+                           is_directory ? 0 : FileUtil::GetSize(full_path)});
+            if (is_directory)
+                AppendStampEntries(full_path, out);
+            return true;
+        });
+}
+
+// Identifies a base RomFS along with the mods layered on top of it by the paths, modification
+// times and sizes of everything in the mod directories. Sizes catch files replaced without their
+// modification time changing, such as when a copy preserves it. Returns boost::none if the mods
+// aren't stored on the host.
+static boost::optional<u64> GetLayeredFSStamp(u64 base_hash, const std::vector<VirtualDir>& dirs) {
+    std::vector<LayeredFSStampEntry> entries;
+    for (const auto& dir : dirs) {
+        const auto path = dir->GetFullPath();
+        const s64 time = FileUtil::GetModificationTime(path);
+        if (time == 0)
+            return boost::none;
+
+        entries.push_back({path, time, 0});
+        AppendStampEntries(path, entries);
+    }
+    std::sort(entries.begin(), entries.end());
+
+    std::string stamp_data(reinterpret_cast<const char*>(&base_hash), sizeof(base_hash));
+    for (const auto& entry : entries) {
+        stamp_data.append(entry.path.c_str(), entry.path.size() + 1);
+        stamp_data.append(reinterpret_cast<const char*>(&entry.modification_time),
+                          sizeof(entry.modification_time));
+        stamp_data.append(reinterpret_cast<const char*>(&entry.size), sizeof(entry.size));
+    }
+    return Common::ComputeHash64(stamp_data.data(), stamp_data.size());
+}
+
 static void ApplyLayeredFS(VirtualFile& romfs, u64 title_id, ContentRecordType type) {
     const auto load_dir = Service::FileSystem::GetModificationLoadRoot(title_id);
     if ((type != ContentRecordType::Program && type != ContentRecordType::Data) ||
@@ -173,8 +234,8 @@ static void ApplyLayeredFS(VirtualFile& romfs, u64 title_id, ContentRecordType t
         return;
     }
 
-    auto extracted = ExtractRomFS(romfs);
-    if (extracted == nullptr) {
+    const auto base_hash = HashRomFSMetadata(romfs);
+    if (base_hash == boost::none) {
         return;
     }
 
@@ -195,16 +256,37 @@ static void ApplyLayeredFS(VirtualFile& romfs, u64 title_id, ContentRecordType t
         if (ext_dir != nullptr)
             layers_ext.push_back(std::move(ext_dir));
     }
-    layers.push_back(std::move(extracted));
-
-    auto layered = LayeredVfsDirectory::MakeLayeredDirectory(std::move(layers));
-    if (layered == nullptr) {
+    if (layers.empty() && layers_ext.empty()) {
         return;
     }
 
-    auto layered_ext = LayeredVfsDirectory::MakeLayeredDirectory(std::move(layers_ext));
+    auto mod_dirs = layers;
+    mod_dirs.insert(mod_dirs.end(), layers_ext.begin(), layers_ext.end());
+    const auto stamp = GetLayeredFSStamp(*base_hash, mod_dirs);
+
+    // Extracting the base RomFS is deferred until the layout has to be built or a file is read,
+    // neither happens when the layout is cached and the game only reads a few files.
+    RomFSSourceOpener open_sources = [romfs, layers, layers_ext]() mutable {
+        auto extracted = ExtractRomFS(romfs);
+        if (extracted == nullptr)
+            return std::pair<VirtualDir, VirtualDir>{};
+
+        layers.push_back(std::move(extracted));
+        return std::make_pair(LayeredVfsDirectory::MakeLayeredDirectory(std::move(layers)),
+                              LayeredVfsDirectory::MakeLayeredDirectory(std::move(layers_ext)));
+    };
+
+    VirtualFile packed;
+    if (stamp != boost::none) {
+        const auto cache_path = FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) +
+                                fmt::format("layeredfs/{:016X}_{:02X}.bin", title_id,
+                                            static_cast<u8>(type));
+        packed = CreateRomFS(std::move(open_sources), cache_path, *stamp, romfs->GetName());
+    } else {
+        auto [layered, layered_ext] = open_sources();
+        packed = CreateRomFS(std::move(layered), std::move(layered_ext));
+    }
 
-    auto packed = CreateRomFS(std::move(layered), std::move(layered_ext));
     if (packed == nullptr) {
         return;
     }
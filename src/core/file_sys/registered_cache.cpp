@@ -15,7 +15,9 @@
 #include "core/file_sys/nca_metadata.h"
 #include "core/file_sys/registered_cache.h"
 #include "core/file_sys/submission_package.h"
+#include "core/file_sys/title_metadata_index.h"
 #include "core/file_sys/vfs_concat.h"
+#include "core/file_sys/vfs_vector.h"
 #include "core/loader/loader.h"
 
 namespace FileSys {
@@ -225,22 +227,24 @@ void RegisteredCache::ProcessFiles(const std::vector<NcaID>& ids) {
 
         if (file == nullptr)
             continue;
-        const auto nca = std::make_shared<NCA>(parser(file, id));
-        if (nca->GetStatus() != Loader::ResultStatus::Success ||
-            nca->GetType() != NCAContentType::Meta) {
-            continue;
-        }
-
-        const auto section0 = nca->GetSubdirectories()[0];
 
-        for (const auto& section0_file : section0->GetFiles()) {
-            if (section0_file->GetExtension() != "cnmt")
+        // Files that didn't change since they were indexed don't need to be decrypted again.
+        auto entry = index == nullptr ? boost::none : index->FindNCA(file);
+        if (entry == boost::none) {
+            const NCA nca(parser(file, id));
+            if (nca.GetStatus() != Loader::ResultStatus::Success)
                 continue;
 
-            meta.insert_or_assign(nca->GetTitleId(), CNMT(section0_file));
-            meta_id.insert_or_assign(nca->GetTitleId(), id);
-            break;
+            entry = MakeIndexedNCA(nca);
+            if (index != nullptr)
+                index->AddNCA(file, *entry);
         }
+
+        if (entry->type != NCAContentType::Meta || entry->cnmt.empty())
+            continue;
+
+        meta.insert_or_assign(entry->title_id, CNMT(std::make_shared<VectorVfsFile>(entry->cnmt)));
+        meta_id.insert_or_assign(entry->title_id, id);
     }
 }
 
@@ -264,10 +268,13 @@ void RegisteredCache::Refresh() {
     const auto ids = AccumulateFiles();
     ProcessFiles(ids);
     AccumulateYuzuMeta();
+    if (index != nullptr)
+        index->Save();
 }
 
-RegisteredCache::RegisteredCache(VirtualDir dir_, RegisteredCacheParsingFunction parsing_function)
-    : dir(std::move(dir_)), parser(std::move(parsing_function)) {
+RegisteredCache::RegisteredCache(VirtualDir dir_, RegisteredCacheParsingFunction parsing_function,
+                                 TitleMetadataIndex* index_)
+    : dir(std::move(dir_)), parser(std::move(parsing_function)), index(index_) {
     Refresh();
 }
 
@@ -18,6 +18,7 @@ namespace FileSys {
 class CNMT;
 class NCA;
 class NSP;
+class TitleMetadataIndex;
 class XCI;
 
 enum class ContentRecordType : u8;
@@ -73,10 +74,11 @@ class RegisteredCache {
 public:
     // Parsing function defines the conversion from raw file to NCA. If there are other steps
     // besides creating the NCA from the file (e.g. NAX0 on SD Card), that should go in a custom
-    // parsing function.
+    // parsing function. The metadata of NCAs is looked up in and added to the index, if any.
     explicit RegisteredCache(VirtualDir dir,
                              RegisteredCacheParsingFunction parsing_function =
-                                 [](const VirtualFile& file, const NcaID& id) { return file; });
+                                 [](const VirtualFile& file, const NcaID& id) { return file; },
+                             TitleMetadataIndex* index = nullptr);
     ~RegisteredCache();
 
     void Refresh();
@@ -135,6 +137,7 @@ private:
 
     VirtualDir dir;
     RegisteredCacheParsingFunction parser;
+    TitleMetadataIndex* index;
     // maps tid -> NcaID of meta
     boost::container::flat_map<u64, NcaID> meta_id;
     // maps tid -> meta
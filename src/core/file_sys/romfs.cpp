@@ -2,12 +2,21 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <type_traits>
 #include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
 #include "common/swap.h"
 #include "core/file_sys/fsmitm_romfsbuild.h"
+#include "core/file_sys/ips_layer.h"
 #include "core/file_sys/romfs.h"
 #include "core/file_sys/vfs.h"
 #include "core/file_sys/vfs_concat.h"
+#include "core/file_sys/vfs_lazy.h"
 #include "core/file_sys/vfs_offset.h"
 #include "core/file_sys/vfs_vector.h"
 
@@ -15,6 +24,10 @@ namespace FileSys {
 
 constexpr u32 ROMFS_ENTRY_EMPTY = 0xFFFFFFFF;
 
+constexpr u32 LAYOUT_CACHE_MAGIC = Common::MakeMagic('Y', 'R', 'F', 'L');
+// Bumped whenever the layout of the cache file changes
+constexpr u32 LAYOUT_CACHE_VERSION = 1;
+
 struct TableLocation {
     u64_le offset;
     u64_le size;
@@ -129,12 +142,214 @@ VirtualDir ExtractRomFS(VirtualFile file, RomFSExtractionType type) {
     return out;
 }
 
+namespace {
+
+// Opens the directories a RomFS is built from the first time one of its files is read, or the
+// layout has to be built.
+class RomFSSources {
+public:
+    explicit RomFSSources(RomFSSourceOpener open) : open(std::move(open)) {}
+
+    const std::pair<VirtualDir, VirtualDir>& Get() {
+        std::call_once(open_flag, [this] {
+            dirs = open();
+            open = nullptr;
+        });
+        return dirs;
+    }
+
+private:
+    RomFSSourceOpener open;
+    std::once_flag open_flag;
+    std::pair<VirtualDir, VirtualDir> dirs;
+};
+
+template <typename T>
+void WriteCacheValue(std::vector<u8>& out, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>, "Value must be trivially copyable");
+    const std::size_t offset = out.size();
+    out.resize(offset + sizeof(T));
+    std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+bool ReadCacheValue(const std::vector<u8>& data, std::size_t& offset, T& value) {
+    static_assert(std::is_trivially_copyable_v<T>, "Value must be trivially copyable");
+    if (data.size() - offset < sizeof(T))
+        return false;
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+template <typename Container>
+bool ReadCacheBytes(const std::vector<u8>& data, std::size_t& offset, Container& bytes) {
+    u64 size{};
+    if (!ReadCacheValue(data, offset, size) || data.size() - offset < size)
+        return false;
+    bytes.assign(data.begin() + offset, data.begin() + offset + size);
+    offset += size;
+    return true;
+}
+
+} // Anonymous namespace
+
+static boost::optional<RomFSLayout> LoadRomFSLayout(const std::string& path, u64 stamp) {
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen())
+        return boost::none;
+
+    std::vector<u8> data(file.GetSize());
+    if (file.ReadBytes(data.data(), data.size()) != data.size())
+        return boost::none;
+
+    std::size_t offset = 0;
+    u32 magic{};
+    u32 version{};
+    u64 cached_stamp{};
+    if (!ReadCacheValue(data, offset, magic) || !ReadCacheValue(data, offset, version) ||
+        !ReadCacheValue(data, offset, cached_stamp) || magic != LAYOUT_CACHE_MAGIC ||
+        version != LAYOUT_CACHE_VERSION || cached_stamp != stamp) {
+        return boost::none;
+    }
+
+    RomFSLayout layout{};
+    u64 num_files{};
+    if (!ReadCacheBytes(data, offset, layout.header) ||
+        !ReadCacheValue(data, offset, layout.metadata_offset) ||
+        !ReadCacheBytes(data, offset, layout.metadata) ||
+        !ReadCacheValue(data, offset, num_files) || num_files > data.size()) {
+        LOG_WARNING(Service_FS, "RomFS layout cache {} is invalid, ignoring it", path);
+        return boost::none;
+    }
+
+    layout.files.resize(num_files);
+    for (auto& entry : layout.files) {
+        if (!ReadCacheValue(data, offset, entry.offset) ||
+            !ReadCacheValue(data, offset, entry.size) ||
+            !ReadCacheBytes(data, offset, entry.path)) {
+            LOG_WARNING(Service_FS, "RomFS layout cache {} is truncated, ignoring it", path);
+            return boost::none;
+        }
+    }
+
+    return layout;
+}
+
+static void SaveRomFSLayout(const std::string& path, u64 stamp, const RomFSLayout& layout) {
+    std::vector<u8> data;
+    WriteCacheValue(data, LAYOUT_CACHE_MAGIC);
+    WriteCacheValue(data, LAYOUT_CACHE_VERSION);
+    WriteCacheValue(data, stamp);
+    WriteCacheValue(data, static_cast<u64>(layout.header.size()));
+    data.insert(data.end(), layout.header.begin(), layout.header.end());
+    WriteCacheValue(data, layout.metadata_offset);
+    WriteCacheValue(data, static_cast<u64>(layout.metadata.size()));
+    data.insert(data.end(), layout.metadata.begin(), layout.metadata.end());
+    WriteCacheValue(data, static_cast<u64>(layout.files.size()));
+    for (const auto& entry : layout.files) {
+        WriteCacheValue(data, entry.offset);
+        WriteCacheValue(data, entry.size);
+        WriteCacheValue(data, static_cast<u64>(entry.path.size()));
+        data.insert(data.end(), entry.path.begin(), entry.path.end());
+    }
+
+    FileUtil::CreateFullPath(path);
+    FileUtil::IOFile file(path, "wb");
+    if (!file.IsOpen() || file.WriteBytes(data.data(), data.size()) != data.size())
+        LOG_ERROR(Service_FS, "Failed to write the RomFS layout cache to {}", path);
+}
+
+static VirtualFile OpenRomFSSourceFile(const VirtualDir& dir, const VirtualDir& ext,
+                                       const std::string& path) {
+    if (dir == nullptr)
+        return nullptr;
+
+    auto file = dir->GetFileRelative(path);
+    if (file == nullptr || ext == nullptr)
+        return file;
+
+    const auto ips = ext->GetFileRelative(path + ".ips");
+    if (ips != nullptr) {
+        auto patched = PatchIPS(file, ips);
+        if (patched != nullptr)
+            return patched;
+    }
+
+    return file;
+}
+
+static VirtualFile MakeRomFSFile(RomFSLayout layout, std::shared_ptr<RomFSSources> sources,
+                                 std::string name) {
+    std::map<u64, VirtualFile> parts;
+    for (auto& entry : layout.files) {
+        // Empty files have no data and may start where the next file does.
+        if (entry.size == 0)
+            continue;
+
+        auto file_name = entry.path.substr(entry.path.rfind('/') + 1);
+        parts.emplace(entry.offset,
+                      std::make_shared<LazyVfsFile>(
+                          [sources, path = std::move(entry.path)] {
+                              const auto& [dir, ext] = sources->Get();
+                              return OpenRomFSSourceFile(dir, ext, path);
+                          },
+                          entry.size, std::move(file_name)));
+    }
+
+    parts.emplace(0, std::make_shared<VectorVfsFile>(std::move(layout.header)));
+    parts.emplace(layout.metadata_offset,
+                  std::make_shared<VectorVfsFile>(std::move(layout.metadata)));
+    return ConcatenatedVfsFile::MakeConcatenatedFile(0, std::move(parts), std::move(name));
+}
+
 VirtualFile CreateRomFS(VirtualDir dir, VirtualDir ext) {
     if (dir == nullptr)
         return nullptr;
 
     RomFSBuildContext ctx{dir, ext};
-    return ConcatenatedVfsFile::MakeConcatenatedFile(0, ctx.Build(), dir->GetName());
+    auto layout = ctx.Build();
+    auto name = dir->GetName();
+    auto sources = std::make_shared<RomFSSources>(
+        [dir = std::move(dir), ext = std::move(ext)] { return std::make_pair(dir, ext); });
+    return MakeRomFSFile(std::move(layout), std::move(sources), std::move(name));
+}
+
+VirtualFile CreateRomFS(RomFSSourceOpener open, const std::string& cache_path, u64 stamp,
+                        std::string name) {
+    auto sources = std::make_shared<RomFSSources>(std::move(open));
+    auto layout = LoadRomFSLayout(cache_path, stamp);
+    if (layout == boost::none) {
+        const auto& [dir, ext] = sources->Get();
+        if (dir == nullptr)
+            return nullptr;
+
+        RomFSBuildContext ctx{dir, ext};
+        layout = ctx.Build();
+        SaveRomFSLayout(cache_path, stamp, *layout);
+    }
+
+    return MakeRomFSFile(std::move(*layout), std::move(sources), std::move(name));
+}
+
+boost::optional<u64> HashRomFSMetadata(const VirtualFile& file) {
+    RomFSHeader header{};
+    if (file == nullptr || file->ReadObject(&header) != sizeof(RomFSHeader) ||
+        header.header_size != sizeof(RomFSHeader)) {
+        return boost::none;
+    }
+
+    std::vector<u8> metadata(sizeof(RomFSHeader));
+    std::memcpy(metadata.data(), &header, sizeof(RomFSHeader));
+    for (const auto& table : {header.directory_hash, header.directory_meta, header.file_hash,
+                              header.file_meta}) {
+        const auto bytes = file->ReadBytes(table.size, table.offset);
+        if (bytes.size() != table.size)
+            return boost::none;
+        metadata.insert(metadata.end(), bytes.begin(), bytes.end());
+    }
+
+    return Common::ComputeHash64(metadata.data(), metadata.size());
 }
 
 } // namespace FileSys
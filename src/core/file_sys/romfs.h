@@ -5,7 +5,11 @@
 #pragma once
 
 #include <array>
+#include <functional>
 #include <map>
+#include <string>
+#include <utility>
+#include <boost/optional.hpp>
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/swap.h"
@@ -42,8 +46,31 @@ enum class RomFSExtractionType {
 VirtualDir ExtractRomFS(VirtualFile file,
                         RomFSExtractionType type = RomFSExtractionType::Truncated);
 
-// Converts a VFS filesystem into a RomFS binary
+// Converts a VFS filesystem into a RomFS binary. Only the metadata is built up front, each file is
+// opened, and patched with the IPS patch of the same path in ext, once the RomFS is read where it
+// lies.
 // Returns nullptr on failure
 VirtualFile CreateRomFS(VirtualDir dir, VirtualDir ext = nullptr);
 
+// Opens the directory and extension directory a RomFS is built from.
+using RomFSSourceOpener = std::function<std::pair<VirtualDir, VirtualDir>()>;
+
+/**
+ * Converts a VFS filesystem into a RomFS binary like CreateRomFS, keeping the layout of the RomFS
+ * in a cache file on the host. As long as the stamp of the sources stays the same, the cached
+ * layout is used instead of walking the directories, which are then only opened once a file is
+ * read.
+ * @param open Opens the directories to build the RomFS from
+ * @param cache_path Path of the cache file
+ * @param stamp Identifies the contents of the directories, the cache is rebuilt when it changes
+ * @param name Name of the RomFS file
+ * @return The RomFS, or nullptr on failure
+ */
+VirtualFile CreateRomFS(RomFSSourceOpener open, const std::string& cache_path, u64 stamp,
+                        std::string name = "");
+
+// Returns a hash of the header and metadata tables of a RomFS binary, which describe the names and
+// sizes of its files, or boost::none if the file isn't a RomFS.
+boost::optional<u64> HashRomFSMetadata(const VirtualFile& file);
+
 } // namespace FileSys
@@ -9,12 +9,13 @@
 
 namespace FileSys {
 
-SDMCFactory::SDMCFactory(VirtualDir dir_)
+SDMCFactory::SDMCFactory(VirtualDir dir_, TitleMetadataIndex* index)
     : dir(std::move(dir_)), contents(std::make_unique<RegisteredCache>(
                                 GetOrCreateDirectoryRelative(dir, "/Nintendo/Contents/registered"),
                                 [](const VirtualFile& file, const NcaID& id) {
                                     return NAX{file, id}.GetDecrypted();
-                                })) {}
+                                },
+                                index)) {}
 
 SDMCFactory::~SDMCFactory() = default;
 
@@ -11,11 +11,12 @@
 namespace FileSys {
 
 class RegisteredCache;
+class TitleMetadataIndex;
 
 /// File system interface to the SDCard archive
 class SDMCFactory {
 public:
-    explicit SDMCFactory(VirtualDir dir);
+    explicit SDMCFactory(VirtualDir dir, TitleMetadataIndex* index = nullptr);
     ~SDMCFactory();
 
     ResultVal<VirtualDir> Open();
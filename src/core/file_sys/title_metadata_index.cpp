@@ -0,0 +1,297 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include "common/common_funcs.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/file_sys/content_archive.h"
+#include "core/file_sys/title_metadata_index.h"
+
+namespace FileSys {
+
+constexpr u32 INDEX_MAGIC = Common::MakeMagic('Y', 'T', 'M', 'I');
+
+namespace {
+
+/// Appends values to a buffer in the layout of the index file
+class IndexWriter {
+public:
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Value must be trivially copyable");
+        const std::size_t offset = data.size();
+        data.resize(offset + sizeof(T));
+        std::memcpy(data.data() + offset, &value, sizeof(T));
+    }
+
+    void WriteBytes(const u8* bytes, std::size_t size) {
+        Write(static_cast<u32>(size));
+        data.insert(data.end(), bytes, bytes + size);
+    }
+
+    void WriteBytes(const std::vector<u8>& bytes) {
+        WriteBytes(bytes.data(), bytes.size());
+    }
+
+    void WriteString(const std::string& string) {
+        WriteBytes(reinterpret_cast<const u8*>(string.data()), string.size());
+    }
+
+    const std::vector<u8>& GetData() const {
+        return data;
+    }
+
+private:
+    std::vector<u8> data;
+};
+
+/// Reads values back from an index file, each read fails once the data is exhausted
+class IndexReader {
+public:
+    explicit IndexReader(const std::vector<u8>& data) : data(data) {}
+
+    template <typename T>
+    bool Read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Value must be trivially copyable");
+        if (data.size() - offset < sizeof(T))
+            return false;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    bool ReadBytes(std::vector<u8>& bytes) {
+        u32 size;
+        if (!Read(size) || data.size() - offset < size)
+            return false;
+        bytes.assign(data.begin() + offset, data.begin() + offset + size);
+        offset += size;
+        return true;
+    }
+
+    bool ReadString(std::string& string) {
+        u32 size;
+        if (!Read(size) || data.size() - offset < size)
+            return false;
+        string.assign(reinterpret_cast<const char*>(data.data()) + offset, size);
+        offset += size;
+        return true;
+    }
+
+    bool IsAtEnd() const {
+        return offset == data.size();
+    }
+
+private:
+    const std::vector<u8>& data;
+    std::size_t offset = 0;
+};
+
+} // Anonymous namespace
+
+IndexedNCA MakeIndexedNCA(const NCA& nca) {
+    IndexedNCA entry{nca.GetTitleId(), nca.GetType(), {}};
+    if (entry.type != NCAContentType::Meta || nca.GetSubdirectories().empty())
+        return entry;
+
+    for (const auto& file : nca.GetSubdirectories()[0]->GetFiles()) {
+        if (file->GetExtension() == "cnmt") {
+            entry.cnmt = file->ReadAllBytes();
+            break;
+        }
+    }
+    return entry;
+}
+
+TitleMetadataIndex::TitleMetadataIndex(std::string path) : path(std::move(path)) {
+    Load();
+}
+
+TitleMetadataIndex::~TitleMetadataIndex() = default;
+
+boost::optional<IndexedNCA> TitleMetadataIndex::FindNCA(const VirtualFile& file) const {
+    return Find(ncas, file);
+}
+
+void TitleMetadataIndex::AddNCA(const VirtualFile& file, IndexedNCA nca) {
+    const auto stamp = GetStamp(file);
+    if (stamp == boost::none)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ncas.insert_or_assign(stamp->first, Entry<IndexedNCA>{stamp->second, std::move(nca)});
+    dirty = true;
+}
+
+boost::optional<IndexedGame> TitleMetadataIndex::FindGame(const VirtualFile& file) const {
+    return Find(games, file);
+}
+
+void TitleMetadataIndex::AddGame(const VirtualFile& file, IndexedGame game) {
+    const auto stamp = GetStamp(file);
+    if (stamp == boost::none)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    games.insert_or_assign(stamp->first, Entry<IndexedGame>{stamp->second, std::move(game)});
+    dirty = true;
+}
+
+void TitleMetadataIndex::Save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!dirty)
+        return;
+
+    // Entries of files that were deleted would otherwise accumulate forever.
+    const auto remove_missing = [](auto& entries) {
+        for (auto iter = entries.begin(); iter != entries.end();) {
+            if (FileUtil::GetModificationTime(iter->first) == 0)
+                iter = entries.erase(iter);
+            else
+                ++iter;
+        }
+    };
+    remove_missing(ncas);
+    remove_missing(games);
+
+    IndexWriter writer;
+    writer.Write(INDEX_MAGIC);
+    writer.Write(VERSION);
+    writer.Write(static_cast<u32>(ncas.size()));
+    writer.Write(static_cast<u32>(games.size()));
+
+    for (const auto& [file_path, entry] : ncas) {
+        writer.WriteString(file_path);
+        writer.Write(entry.stamp);
+        writer.Write(entry.value.title_id);
+        writer.Write(entry.value.type);
+        writer.WriteBytes(entry.value.cnmt);
+    }
+
+    for (const auto& [file_path, entry] : games) {
+        writer.WriteString(file_path);
+        writer.Write(entry.stamp);
+        writer.Write(entry.value.program_id);
+        writer.Write(static_cast<u32>(entry.value.file_type));
+        writer.WriteString(entry.value.name);
+        writer.WriteBytes(entry.value.icon);
+        writer.Write(static_cast<u8>(entry.value.romfs_updatable));
+        writer.Write(static_cast<u8>(entry.value.has_packed_update));
+        writer.Write(entry.value.update_version);
+    }
+
+    const auto& data = writer.GetData();
+    FileUtil::CreateFullPath(path);
+    FileUtil::IOFile file(path, "wb");
+    if (!file.IsOpen() || file.WriteBytes(data.data(), data.size()) != data.size()) {
+        LOG_ERROR(Service_FS, "Failed to write the title metadata index to {}", path);
+        return;
+    }
+    dirty = false;
+}
+
+boost::optional<std::pair<std::string, TitleMetadataIndex::FileStamp>>
+TitleMetadataIndex::GetStamp(const VirtualFile& file) {
+    if (file == nullptr)
+        return boost::none;
+
+    std::string file_path = file->GetFullPath();
+    const s64 modification_time = FileUtil::GetModificationTime(file_path);
+    if (modification_time == 0)
+        return boost::none;
+
+    return std::make_pair(std::move(file_path),
+                          FileStamp{static_cast<u64>(file->GetSize()), modification_time});
+}
+
+template <typename T>
+boost::optional<T> TitleMetadataIndex::Find(const std::map<std::string, Entry<T>>& entries,
+                                            const VirtualFile& file) const {
+    const auto stamp = GetStamp(file);
+    if (stamp == boost::none)
+        return boost::none;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto iter = entries.find(stamp->first);
+    if (iter == entries.end() || iter->second.stamp.size != stamp->second.size ||
+        iter->second.stamp.modification_time != stamp->second.modification_time) {
+        return boost::none;
+    }
+    return iter->second.value;
+}
+
+void TitleMetadataIndex::Load() {
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen())
+        return;
+
+    std::vector<u8> data(file.GetSize());
+    if (file.ReadBytes(data.data(), data.size()) != data.size())
+        return;
+
+    IndexReader reader(data);
+    u32 magic{};
+    u32 version{};
+    u32 num_ncas{};
+    u32 num_games{};
+    if (!reader.Read(magic) || magic != INDEX_MAGIC || !reader.Read(version)) {
+        LOG_WARNING(Service_FS, "Title metadata index {} is invalid, ignoring it", path);
+        return;
+    }
+    if (version != VERSION) {
+        LOG_INFO(Service_FS, "Title metadata index {} is outdated, rebuilding it", path);
+        return;
+    }
+    if (!reader.Read(num_ncas) || !reader.Read(num_games)) {
+        LOG_WARNING(Service_FS, "Title metadata index {} is invalid, ignoring it", path);
+        return;
+    }
+
+    std::map<std::string, Entry<IndexedNCA>> loaded_ncas;
+    for (u32 i = 0; i < num_ncas; ++i) {
+        std::string file_path;
+        Entry<IndexedNCA> entry{};
+        if (!reader.ReadString(file_path) || !reader.Read(entry.stamp) ||
+            !reader.Read(entry.value.title_id) || !reader.Read(entry.value.type) ||
+            !reader.ReadBytes(entry.value.cnmt)) {
+            LOG_WARNING(Service_FS, "Title metadata index {} is truncated, ignoring it", path);
+            return;
+        }
+        loaded_ncas.insert_or_assign(std::move(file_path), std::move(entry));
+    }
+
+    std::map<std::string, Entry<IndexedGame>> loaded_games;
+    for (u32 i = 0; i < num_games; ++i) {
+        std::string file_path;
+        Entry<IndexedGame> entry{};
+        u32 file_type{};
+        u8 romfs_updatable{};
+        u8 has_packed_update{};
+        if (!reader.ReadString(file_path) || !reader.Read(entry.stamp) ||
+            !reader.Read(entry.value.program_id) || !reader.Read(file_type) ||
+            !reader.ReadString(entry.value.name) || !reader.ReadBytes(entry.value.icon) ||
+            !reader.Read(romfs_updatable) || !reader.Read(has_packed_update) ||
+            !reader.Read(entry.value.update_version)) {
+            LOG_WARNING(Service_FS, "Title metadata index {} is truncated, ignoring it", path);
+            return;
+        }
+        entry.value.file_type = static_cast<Loader::FileType>(file_type);
+        entry.value.romfs_updatable = romfs_updatable != 0;
+        entry.value.has_packed_update = has_packed_update != 0;
+        loaded_games.insert_or_assign(std::move(file_path), std::move(entry));
+    }
+
+    if (!reader.IsAtEnd()) {
+        LOG_WARNING(Service_FS, "Title metadata index {} is invalid, ignoring it", path);
+        return;
+    }
+
+    ncas = std::move(loaded_ncas);
+    games = std::move(loaded_games);
+}
+
+} // namespace FileSys
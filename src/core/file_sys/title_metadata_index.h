@@ -0,0 +1,108 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/optional.hpp>
+#include "common/common_types.h"
+#include "core/file_sys/vfs.h"
+
+namespace Loader {
+enum class FileType;
+}
+
+namespace FileSys {
+
+class NCA;
+
+enum class NCAContentType : u8;
+
+/// Header fields of an NCA, along with the CNMT of meta NCAs
+struct IndexedNCA {
+    u64 title_id;
+    NCAContentType type;
+    /// Serialized CNMT, empty unless the NCA is a meta NCA
+    std::vector<u8> cnmt;
+};
+
+/// Collects the metadata to index of an NCA that was parsed successfully.
+IndexedNCA MakeIndexedNCA(const NCA& nca);
+
+/// What the game list displays of a game file
+struct IndexedGame {
+    u64 program_id;
+    Loader::FileType file_type;
+    std::string name;
+    std::vector<u8> icon;
+    bool romfs_updatable;
+    /// Whether the file contains an update along with the base game
+    bool has_packed_update;
+    /**
+     * Version of the update installed when the name and icon were read, or 0 if there was none.
+     * They are taken from the control data of the update when there is one.
+     */
+    u32 update_version;
+};
+
+/**
+ * On-disk index of metadata parsed from content files. Entries are keyed by the path of the file
+ * and only returned while its size and modification time are unchanged, so files that weren't
+ * touched since the last scan can be listed without being decrypted and parsed again.
+ *
+ * Only files backed by a real file on the host can be indexed. All members are thread-safe.
+ */
+class TitleMetadataIndex {
+public:
+    /// Bumped whenever the layout of the file or the meaning of an entry changes
+    static constexpr u32 VERSION = 1;
+
+    /// Loads the index from the given file, an index that is missing or outdated starts empty.
+    explicit TitleMetadataIndex(std::string path);
+    ~TitleMetadataIndex();
+
+    boost::optional<IndexedNCA> FindNCA(const VirtualFile& file) const;
+    void AddNCA(const VirtualFile& file, IndexedNCA nca);
+
+    boost::optional<IndexedGame> FindGame(const VirtualFile& file) const;
+    void AddGame(const VirtualFile& file, IndexedGame game);
+
+    /// Writes the index back to disk if it changed, dropping entries of files that were removed.
+    void Save();
+
+private:
+    /// Identifies a version of a file on the host
+    struct FileStamp {
+        u64 size;
+        s64 modification_time;
+    };
+
+    template <typename T>
+    struct Entry {
+        FileStamp stamp;
+        T value;
+    };
+
+    /// Returns the host path and stamp of the file, or none if it isn't backed by a host file.
+    static boost::optional<std::pair<std::string, FileStamp>> GetStamp(const VirtualFile& file);
+
+    template <typename T>
+    boost::optional<T> Find(const std::map<std::string, Entry<T>>& entries,
+                            const VirtualFile& file) const;
+
+    void Load();
+
+    std::string path;
+
+    mutable std::mutex mutex;
+    std::map<std::string, Entry<IndexedNCA>> ncas;
+    std::map<std::string, Entry<IndexedGame>> games;
+    bool dirty = false;
+};
+
+} // namespace FileSys
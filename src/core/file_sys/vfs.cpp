@@ -176,6 +176,10 @@ boost::optional<u8> VfsFile::ReadByte(std::size_t offset) const {
     return boost::none;
 }
 
+ReadOnlySpan VfsFile::ReadSpan(std::size_t length, std::size_t offset) const {
+    return {};
+}
+
 std::vector<u8> VfsFile::ReadBytes(std::size_t size, std::size_t offset) const {
     std::vector<u8> out(size);
     std::size_t read_size = Read(out.data(), size, offset);
@@ -75,6 +75,13 @@ protected:
     VirtualDir root;
 };
 
+// A read-only view of contiguous file contents, as returned by VfsFile::ReadSpan. An empty span
+// means the file can't hand out views of the requested range.
+struct ReadOnlySpan {
+    const u8* data = nullptr;
+    std::size_t size = 0;
+};
+
 // A class representing a file in an abstract filesystem.
 class VfsFile : NonCopyable {
 public:
@@ -103,6 +110,12 @@ public:
     // into file. Returns number of bytes successfully written.
     virtual std::size_t Write(const u8* data, std::size_t length, std::size_t offset = 0) = 0;
 
+    // Returns a view of length bytes starting at offset into the file without copying them,
+    // trimmed to the end of the file. Files that don't keep their contents in memory return an
+    // empty span and have to be read with Read instead. The view stays valid as long as the file
+    // isn't written to or resized and a reference to it is held.
+    virtual ReadOnlySpan ReadSpan(std::size_t length, std::size_t offset = 0) const;
+
     // Reads exactly one byte at the offset provided, returning boost::none on error.
     virtual boost::optional<u8> ReadByte(std::size_t offset = 0) const;
     // Reads size bytes starting at offset in file into a vector.
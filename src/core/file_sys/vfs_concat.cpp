@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <iterator>
 #include <utility>
 
 #include "common/assert.h"
@@ -107,25 +108,48 @@ bool ConcatenatedVfsFile::IsReadable() const {
 }
 
 std::size_t ConcatenatedVfsFile::Read(u8* data, std::size_t length, std::size_t offset) const {
-    auto entry = --files.end();
-    for (auto iter = files.begin(); iter != files.end(); ++iter) {
-        if (iter->first > offset) {
-            entry = --iter;
+    auto entry = files.upper_bound(offset);
+    if (entry == files.begin())
+        return 0;
+    --entry;
+
+    // Built RomFS are made of thousands of parts, reads continue through the following parts
+    // instead of searching for each of them again.
+    std::size_t read = 0;
+    for (; entry != files.end() && read < length; ++entry) {
+        const std::size_t part_offset = offset + read - entry->first;
+        const std::size_t part_size = entry->second->GetSize();
+        if (part_offset >= part_size)
+            break;
+
+        const std::size_t part_length = std::min(length - read, part_size - part_offset);
+        const std::size_t part_read = entry->second->Read(data + read, part_length, part_offset);
+        read += part_read;
+        if (part_read != part_length)
             break;
-        }
     }
 
-    if (entry->first + entry->second->GetSize() <= offset)
-        return 0;
+    return read;
+}
 
-    const auto read_in =
-        std::min<u64>(entry->first + entry->second->GetSize() - offset, entry->second->GetSize());
-    if (length > read_in) {
-        return entry->second->Read(data, read_in, offset - entry->first) +
-               Read(data + read_in, length - read_in, offset + read_in);
-    }
+ReadOnlySpan ConcatenatedVfsFile::ReadSpan(std::size_t length, std::size_t offset) const {
+    auto entry = files.upper_bound(offset);
+    if (entry == files.begin())
+        return {};
+    --entry;
+
+    const std::size_t part_offset = offset - entry->first;
+    const std::size_t part_size = entry->second->GetSize();
+    if (part_offset >= part_size)
+        return {};
+
+    // Only ranges within a single part are contiguous, reads past the end of the last part are
+    // trimmed like any other read.
+    const bool is_last_part = std::next(entry) == files.end();
+    if (!is_last_part && length > part_size - part_offset)
+        return {};
 
-    return entry->second->Read(data, std::min<u64>(read_in, length), offset - entry->first);
+    return entry->second->ReadSpan(length, part_offset);
 }
 
 std::size_t ConcatenatedVfsFile::Write(const u8* data, std::size_t length, std::size_t offset) {
@@ -2,7 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
 #include <utility>
 #include "core/file_sys/vfs_layered.h"
 
@@ -59,13 +61,11 @@ std::string LayeredVfsDirectory::GetFullPath() const {
 
 std::vector<std::shared_ptr<VfsFile>> LayeredVfsDirectory::GetFiles() const {
     std::vector<VirtualFile> out;
+    std::set<std::string, std::less<>> names;
     for (const auto& layer : dirs) {
-        for (const auto& file : layer->GetFiles()) {
-            if (std::find_if(out.begin(), out.end(), [&file](const VirtualFile& comp) {
-                    return comp->GetName() == file->GetName();
-                }) == out.end()) {
-                out.push_back(file);
-            }
+        for (auto& file : layer->GetFiles()) {
+            if (names.insert(file->GetName()).second)
+                out.push_back(std::move(file));
         }
     }
 
@@ -73,18 +73,24 @@ std::vector<std::shared_ptr<VfsFile>> LayeredVfsDirectory::GetFiles() const {
 }
 
 std::vector<std::shared_ptr<VfsDirectory>> LayeredVfsDirectory::GetSubdirectories() const {
+    // Subdirectories are layered from the listings of each layer, opening them by name would have
+    // every layer look each of them up again.
     std::vector<std::string> names;
+    std::map<std::string, std::vector<VirtualDir>, std::less<>> layers;
     for (const auto& layer : dirs) {
-        for (const auto& sd : layer->GetSubdirectories()) {
-            if (std::find(names.begin(), names.end(), sd->GetName()) == names.end())
-                names.push_back(sd->GetName());
+        for (auto& sd : layer->GetSubdirectories()) {
+            auto name = sd->GetName();
+            auto& subdir_layers = layers[name];
+            if (subdir_layers.empty())
+                names.push_back(std::move(name));
+            subdir_layers.push_back(std::move(sd));
         }
     }
 
     std::vector<VirtualDir> out;
     out.reserve(names.size());
     for (const auto& subdir : names)
-        out.push_back(GetSubdirectory(subdir));
+        out.push_back(MakeLayeredDirectory(std::move(layers[subdir])));
 
     return out;
 }
@@ -0,0 +1,84 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <utility>
+
+#include "core/file_sys/vfs_lazy.h"
+
+namespace FileSys {
+
+LazyVfsFile::LazyVfsFile(Opener open_, std::size_t size_, std::string name_, VirtualDir parent_)
+    : open(std::move(open_)), size(size_), name(std::move(name_)), parent(std::move(parent_)) {}
+
+LazyVfsFile::~LazyVfsFile() = default;
+
+std::string LazyVfsFile::GetName() const {
+    return name;
+}
+
+std::size_t LazyVfsFile::GetSize() const {
+    return size;
+}
+
+bool LazyVfsFile::Resize(std::size_t new_size) {
+    return false;
+}
+
+std::shared_ptr<VfsDirectory> LazyVfsFile::GetContainingDirectory() const {
+    return parent;
+}
+
+bool LazyVfsFile::IsWritable() const {
+    return false;
+}
+
+bool LazyVfsFile::IsReadable() const {
+    return true;
+}
+
+std::size_t LazyVfsFile::Read(u8* data, std::size_t length, std::size_t offset) const {
+    if (offset >= size)
+        return 0;
+
+    const auto& backing = GetFile();
+    if (backing == nullptr)
+        return 0;
+    return backing->Read(data, std::min(length, size - offset), offset);
+}
+
+std::size_t LazyVfsFile::Write(const u8* data, std::size_t length, std::size_t offset) {
+    return 0;
+}
+
+ReadOnlySpan LazyVfsFile::ReadSpan(std::size_t length, std::size_t offset) const {
+    if (offset >= size)
+        return {};
+
+    const auto& backing = GetFile();
+    if (backing == nullptr)
+        return {};
+    return backing->ReadSpan(std::min(length, size - offset), offset);
+}
+
+bool LazyVfsFile::Rename(std::string_view name_) {
+    name = name_;
+    return true;
+}
+
+bool LazyVfsFile::IsOpen() const {
+    return is_open;
+}
+
+const VirtualFile& LazyVfsFile::GetFile() const {
+    std::call_once(open_flag, [this] {
+        file = open();
+        // The opener may hold on to large objects, like the directories it opens the file from.
+        open = nullptr;
+        is_open = true;
+    });
+    return file;
+}
+
+} // namespace FileSys
@@ -0,0 +1,54 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+#include "core/file_sys/vfs.h"
+
+namespace FileSys {
+
+// A read-only VfsFile of a known size whose contents are only opened the first time they are read,
+// for files that are expensive to open or patch but may never be read at all. Reads are trimmed to
+// the size given, a file that fails to open reads as empty.
+class LazyVfsFile : public VfsFile {
+public:
+    using Opener = std::function<VirtualFile()>;
+
+    LazyVfsFile(Opener open, std::size_t size, std::string name = "", VirtualDir parent = nullptr);
+    ~LazyVfsFile() override;
+
+    std::string GetName() const override;
+    std::size_t GetSize() const override;
+    bool Resize(std::size_t new_size) override;
+    std::shared_ptr<VfsDirectory> GetContainingDirectory() const override;
+    bool IsWritable() const override;
+    bool IsReadable() const override;
+    std::size_t Read(u8* data, std::size_t length, std::size_t offset) const override;
+    std::size_t Write(const u8* data, std::size_t length, std::size_t offset) override;
+    ReadOnlySpan ReadSpan(std::size_t length, std::size_t offset) const override;
+    bool Rename(std::string_view name) override;
+
+    /// Whether the file was opened already.
+    bool IsOpen() const;
+
+private:
+    const VirtualFile& GetFile() const;
+
+    mutable Opener open;
+    std::size_t size;
+    std::string name;
+    VirtualDir parent;
+
+    mutable std::once_flag open_flag;
+    mutable VirtualFile file;
+    mutable std::atomic_bool is_open{false};
+};
+
+} // namespace FileSys
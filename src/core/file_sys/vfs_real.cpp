@@ -4,12 +4,14 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <iterator>
 #include <utility>
 #include "common/assert.h"
 #include "common/common_paths.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/mapped_file.h"
 #include "core/file_sys/vfs_real.h"
 
 namespace FileSys {
@@ -66,6 +68,7 @@ VfsEntryType RealVfsFilesystem::GetEntryType(std::string_view path_) const {
 
 VirtualFile RealVfsFilesystem::OpenFile(std::string_view path_, Mode perms) {
     const auto path = FileUtil::SanitizePath(path_, FileUtil::DirectorySeparator::PlatformDefault);
+    std::lock_guard<std::mutex> lock(cache_mutex);
     if (cache.find(path) != cache.end()) {
         auto weak = cache[path];
         if (!weak.expired()) {
@@ -116,13 +119,16 @@ VirtualFile RealVfsFilesystem::MoveFile(std::string_view old_path_, std::string_
         FileUtil::IsDirectory(old_path) || !FileUtil::Rename(old_path, new_path))
         return nullptr;
 
-    if (cache.find(old_path) != cache.end()) {
-        auto cached = cache[old_path];
-        if (!cached.expired()) {
-            auto file = cached.lock();
-            file->Open(new_path, "r+b");
-            cache.erase(old_path);
-            cache[new_path] = file;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        if (cache.find(old_path) != cache.end()) {
+            auto cached = cache[old_path];
+            if (!cached.expired()) {
+                auto file = cached.lock();
+                file->Open(new_path, "r+b");
+                cache.erase(old_path);
+                cache[new_path] = file;
+            }
         }
     }
     return OpenFile(new_path, Mode::ReadWrite);
@@ -130,6 +136,7 @@ VirtualFile RealVfsFilesystem::MoveFile(std::string_view old_path_, std::string_
 
 bool RealVfsFilesystem::DeleteFile(std::string_view path_) {
     const auto path = FileUtil::SanitizePath(path_, FileUtil::DirectorySeparator::PlatformDefault);
+    std::lock_guard<std::mutex> lock(cache_mutex);
     if (cache.find(path) != cache.end()) {
         if (!cache[path].expired())
             cache[path].lock()->Close();
@@ -179,6 +186,7 @@ VirtualDir RealVfsFilesystem::MoveDirectory(std::string_view old_path_,
         FileUtil::IsDirectory(old_path) || !FileUtil::Rename(old_path, new_path))
         return nullptr;
 
+    std::lock_guard<std::mutex> lock(cache_mutex);
     for (auto& kv : cache) {
         // Path in cache starts with old_path
         if (kv.first.rfind(old_path, 0) == 0) {
@@ -202,6 +210,7 @@ VirtualDir RealVfsFilesystem::MoveDirectory(std::string_view old_path_,
 
 bool RealVfsFilesystem::DeleteDirectory(std::string_view path_) {
     const auto path = FileUtil::SanitizePath(path_, FileUtil::DirectorySeparator::PlatformDefault);
+    std::lock_guard<std::mutex> lock(cache_mutex);
     for (auto& kv : cache) {
         // Path in cache starts with old_path
         if (kv.first.rfind(path, 0) == 0) {
@@ -248,6 +257,12 @@ bool RealVfsFile::IsReadable() const {
 }
 
 std::size_t RealVfsFile::Read(u8* data, std::size_t length, std::size_t offset) const {
+    const ReadOnlySpan span = ReadSpan(length, offset);
+    if (span.data != nullptr) {
+        std::memcpy(data, span.data, span.size);
+        return span.size;
+    }
+
     if (!backing->Seek(offset, SEEK_SET))
         return 0;
     return backing->ReadBytes(data, length);
@@ -259,6 +274,13 @@ std::size_t RealVfsFile::Write(const u8* data, std::size_t length, std::size_t o
     return backing->WriteBytes(data, length);
 }
 
+ReadOnlySpan RealVfsFile::ReadSpan(std::size_t length, std::size_t offset) const {
+    const Common::MappedFile* const mapped = GetMapping();
+    if (mapped == nullptr || offset >= mapped->Size())
+        return {};
+    return {mapped->Data() + offset, std::min(length, mapped->Size() - offset)};
+}
+
 bool RealVfsFile::Rename(std::string_view name) {
     return base.MoveFile(path, parent_path + DIR_SEP + std::string(name)) != nullptr;
 }
@@ -267,6 +289,19 @@ bool RealVfsFile::Close() {
     return backing->Close();
 }
 
+const Common::MappedFile* RealVfsFile::GetMapping() const {
+    // Writable files may be resized at any time, which would invalidate views into the mapping.
+    if (perms != Mode::Read)
+        return nullptr;
+
+    std::call_once(mapping_flag, [this] {
+        auto mapped = std::make_unique<Common::MappedFile>(path);
+        if (mapped->IsValid())
+            mapping = std::move(mapped);
+    });
+    return mapping.get();
+}
+
 // TODO(DarkLordZach): MSVC would not let me combine the following two functions using 'if
 // constexpr' because there is a compile error in the branch not used.
 
@@ -4,11 +4,17 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <string_view>
 #include <boost/container/flat_map.hpp>
 #include "core/file_sys/mode.h"
 #include "core/file_sys/vfs.h"
 
+namespace Common {
+class MappedFile;
+}
+
 namespace FileUtil {
 class IOFile;
 }
@@ -36,10 +42,14 @@ public:
     bool DeleteDirectory(std::string_view path) override;
 
 private:
+    // Files may be opened from several threads at once, e.g. while scanning for games.
+    std::mutex cache_mutex;
     boost::container::flat_map<std::string, std::weak_ptr<FileUtil::IOFile>> cache;
 };
 
-// An implmentation of VfsFile that represents a file on the user's computer.
+// An implmentation of VfsFile that represents a file on the user's computer. Files opened as
+// read-only are mapped in memory on first access, so they can be read from without seeking and
+// hand out views of their contents through ReadSpan.
 class RealVfsFile : public VfsFile {
     friend class RealVfsDirectory;
     friend class RealVfsFilesystem;
@@ -55,6 +65,7 @@ public:
     bool IsReadable() const override;
     std::size_t Read(u8* data, std::size_t length, std::size_t offset) const override;
     std::size_t Write(const u8* data, std::size_t length, std::size_t offset) override;
+    ReadOnlySpan ReadSpan(std::size_t length, std::size_t offset) const override;
     bool Rename(std::string_view name) override;
 
 private:
@@ -63,6 +74,10 @@ private:
 
     bool Close();
 
+    // Returns the memory mapping of the file, creating it on first use. Returns nullptr if the
+    // file is writable or couldn't be mapped.
+    const Common::MappedFile* GetMapping() const;
+
     RealVfsFilesystem& base;
     std::shared_ptr<FileUtil::IOFile> backing;
     std::string path;
@@ -70,6 +85,9 @@ private:
     std::vector<std::string> path_components;
     std::vector<std::string> parent_components;
     Mode perms;
+
+    mutable std::once_flag mapping_flag;
+    mutable std::unique_ptr<Common::MappedFile> mapping;
 };
 
 // An implementation of VfsDirectory that represents a directory on the user's computer.
@@ -12,6 +12,21 @@
 
 namespace Core::Frontend {
 
+/**
+ * A graphics context sharing its objects with the one of an EmuWindow, for threads other than the
+ * rendering one to create objects with, e.g. to build shaders in the background.
+ */
+class GraphicsContext {
+public:
+    virtual ~GraphicsContext() = default;
+
+    /// Makes the context current for the caller thread
+    virtual void MakeCurrent() = 0;
+
+    /// Releases the context from the caller thread
+    virtual void DoneCurrent() = 0;
+};
+
 /**
  * Abstraction class used to provide an interface between emulation code and the frontend
  * (e.g. SDL, QGLWidget, GLFW, etc...).
@@ -52,6 +67,15 @@ public:
     /// Releases (dunno if this is the "right" word) the GLFW context from the caller thread
     virtual void DoneCurrent() = 0;
 
+    /**
+     * Creates a graphics context sharing its objects with the one of the window. This must be
+     * called from the thread the context of the window is current on, which it remains on.
+     * @returns The new context, or nullptr if the frontend doesn't support shared contexts
+     */
+    virtual std::unique_ptr<GraphicsContext> CreateSharedContext() const {
+        return nullptr;
+    }
+
     /**
      * Signal that a touch pressed event has occurred (e.g. mouse click pressed)
      * @param framebuffer_x Framebuffer x-coordinate that was pressed
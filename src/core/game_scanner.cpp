@@ -0,0 +1,345 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/string_util.h"
+#include "core/file_sys/content_archive.h"
+#include "core/file_sys/control_metadata.h"
+#include "core/file_sys/mode.h"
+#include "core/file_sys/nca_metadata.h"
+#include "core/file_sys/patch_manager.h"
+#include "core/file_sys/registered_cache.h"
+#include "core/file_sys/vfs.h"
+#include "core/game_scanner.h"
+#include "core/hle/service/filesystem/filesystem.h"
+#include "core/loader/loader.h"
+
+namespace Core {
+namespace {
+
+void GetMetadataFromControlNCA(const FileSys::PatchManager& patch_manager, const FileSys::NCA& nca,
+                               std::vector<u8>& icon, std::string& name) {
+    auto [nacp, icon_file] = patch_manager.ParseControlNCA(nca);
+    if (icon_file != nullptr)
+        icon = icon_file->ReadAllBytes();
+    if (nacp != nullptr)
+        name = nacp->GetApplicationName();
+}
+
+bool HasSupportedFileExtension(const std::string& file_name) {
+    const std::string extension =
+        Common::ToLower(std::string(FileUtil::GetExtensionFromFilename(file_name)));
+    return std::find(GameScanner::SUPPORTED_FILE_EXTENSIONS.begin(),
+                     GameScanner::SUPPORTED_FILE_EXTENSIONS.end(),
+                     extension) != GameScanner::SUPPORTED_FILE_EXTENSIONS.end();
+}
+
+bool IsExtractedNCAMain(const std::string& file_name) {
+    return file_name == "main";
+}
+
+u32 GetInstalledUpdateVersion(const FileSys::RegisteredCacheUnion& installed, u64 program_id) {
+    return installed.GetEntryVersion(FileSys::GetUpdateTitleID(program_id)).value_or(0);
+}
+
+/// Reads the fields of a game that don't depend on where its name and icon come from
+FileSys::IndexedGame ReadGameFromLoader(Loader::AppLoader& loader) {
+    FileSys::IndexedGame game{};
+    loader.ReadProgramId(game.program_id);
+    game.file_type = loader.GetFileType();
+    game.romfs_updatable = loader.IsRomFSUpdatable();
+
+    FileSys::VirtualFile update_raw;
+    game.has_packed_update =
+        loader.ReadUpdateRaw(update_raw) == Loader::ResultStatus::Success && update_raw != nullptr;
+    return game;
+}
+
+/**
+ * Looks the game up in the index. Entries are only used while the same update is installed, the
+ * name and icon are read from it.
+ */
+boost::optional<FileSys::IndexedGame> FindIndexedGame(
+    const FileSys::TitleMetadataIndex* index, const FileSys::RegisteredCacheUnion& installed,
+    const FileSys::VirtualFile& file) {
+    if (index == nullptr)
+        return boost::none;
+
+    const auto game = index->FindGame(file);
+    if (game == boost::none ||
+        game->update_version != GetInstalledUpdateVersion(installed, game->program_id)) {
+        return boost::none;
+    }
+    return game;
+}
+
+/// Opens the update packed along with the game, only games that have one need to be parsed
+FileSys::VirtualFile ReadPackedUpdate(const FileSys::IndexedGame& game,
+                                      std::unique_ptr<Loader::AppLoader>& loader,
+                                      const FileSys::VirtualFile& file) {
+    if (!game.has_packed_update)
+        return nullptr;
+
+    if (loader == nullptr)
+        loader = Loader::GetLoader(file);
+    FileSys::VirtualFile update_raw;
+    if (loader != nullptr)
+        loader->ReadUpdateRaw(update_raw);
+    return update_raw;
+}
+
+ScannedGame MakeScannedGame(std::string path, u64 size, FileSys::IndexedGame metadata,
+                            std::unique_ptr<Loader::AppLoader>& loader,
+                            const FileSys::VirtualFile& file, bool updatable) {
+    const FileSys::PatchManager patch{metadata.program_id};
+    const auto update_raw = ReadPackedUpdate(metadata, loader, file);
+    auto patch_versions = patch.GetPatchVersionNames(update_raw);
+    if (!updatable)
+        patch_versions.erase("Update");
+    return {std::move(path), size, std::move(metadata), std::move(patch_versions)};
+}
+
+} // Anonymous namespace
+
+GameScanner::GameScanner(FileSys::VirtualFilesystem vfs_, std::size_t num_workers)
+    : vfs(std::move(vfs_)), pool(num_workers),
+      max_pending(std::max<std::size_t>(num_workers, 1) * 4) {}
+
+GameScanner::~GameScanner() {
+    Cancel();
+}
+
+void GameScanner::ScanInstalledTitles(const GameCallback& callback) {
+    index = Service::FileSystem::GetTitleMetadataIndex();
+    const auto installed = Service::FileSystem::GetUnionContents();
+    const auto installed_games = installed->ListEntriesFilter(FileSys::TitleType::Application,
+                                                              FileSys::ContentRecordType::Program);
+
+    for (const auto& game : installed_games) {
+        if (stop_processing)
+            break;
+        Submit([this, &installed, game] { return ReadInstalledTitle(*installed, game); },
+               callback);
+    }
+    Report(callback, true);
+
+    if (index != nullptr)
+        index->Save();
+}
+
+void GameScanner::ScanDirectory(const std::string& dir_path, unsigned int recursion,
+                                const GameCallback& callback,
+                                const DirectoryCallback& directory_callback) {
+    index = Service::FileSystem::GetTitleMetadataIndex();
+    const auto installed = Service::FileSystem::GetUnionContents();
+    FillControlMap(dir_path);
+    AddDirectoryEntries(*installed, dir_path, recursion, callback, directory_callback);
+    Report(callback, true);
+    nca_control_map.clear();
+
+    if (index != nullptr)
+        index->Save();
+}
+
+void GameScanner::Cancel() {
+    stop_processing = true;
+}
+
+std::size_t GameScanner::DefaultNumWorkers() {
+    return std::max<std::size_t>(std::thread::hardware_concurrency(), 4);
+}
+
+void GameScanner::Submit(ScanTask task, const GameCallback& callback) {
+    // Only the oldest file is waited on, the games found after it are reported in order anyway.
+    if (pending.size() >= max_pending)
+        pending.front().wait();
+    Report(callback, false);
+
+    auto game = pool.Submit([this, task = std::move(task)] {
+        return stop_processing ? boost::optional<ScannedGame>{} : task();
+    });
+    pending.push_back(std::move(game));
+}
+
+void GameScanner::Report(const GameCallback& callback, bool wait) {
+    while (!pending.empty()) {
+        auto& front = pending.front();
+        if (!wait && front.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return;
+
+        auto game = front.get();
+        pending.pop_front();
+        if (game != boost::none && !stop_processing)
+            callback(std::move(*game));
+    }
+}
+
+void GameScanner::FillControlMap(const std::string& dir_path) {
+    std::vector<std::string> nca_paths;
+    const auto nca_control_callback = [this, &nca_paths](
+                                          u64* num_entries_out, const std::string& directory,
+                                          const std::string& virtual_name) -> bool {
+        std::string physical_name = directory + DIR_SEP + virtual_name;
+
+        if (stop_processing)
+            return false; // Breaks the callback loop.
+
+        if (!FileUtil::IsDirectory(physical_name) &&
+            FileUtil::GetExtensionFromFilename(virtual_name) == "nca") {
+            nca_paths.push_back(std::move(physical_name));
+        }
+        return true;
+    };
+
+    FileUtil::ForeachDirectoryEntry(nullptr, dir_path, nca_control_callback);
+
+    std::vector<std::pair<u64, FileSys::VirtualFile>> controls(nca_paths.size());
+    pool.ParallelFor(nca_paths.size(), [this, &nca_paths, &controls](std::size_t i) {
+        if (stop_processing)
+            return;
+
+        auto file = vfs->OpenFile(nca_paths[i], FileSys::Mode::Read);
+        auto entry = index == nullptr ? boost::none : index->FindNCA(file);
+        if (entry == boost::none) {
+            const FileSys::NCA nca(file);
+            if (nca.GetStatus() != Loader::ResultStatus::Success)
+                return;
+
+            entry = FileSys::MakeIndexedNCA(nca);
+            if (index != nullptr)
+                index->AddNCA(file, *entry);
+        }
+
+        // The NCA is only parsed again if a game without metadata of its own needs it.
+        if (entry->type == FileSys::NCAContentType::Control)
+            controls[i] = {entry->title_id, std::move(file)};
+    });
+
+    // Later files take precedence, as when the directory was scanned serially.
+    for (auto& [title_id, file] : controls) {
+        if (file != nullptr)
+            nca_control_map.insert_or_assign(title_id, std::move(file));
+    }
+}
+
+void GameScanner::AddDirectoryEntries(const FileSys::RegisteredCacheUnion& installed,
+                                      const std::string& dir_path, unsigned int recursion,
+                                      const GameCallback& callback,
+                                      const DirectoryCallback& directory_callback) {
+    const auto directory_entry_callback = [&](u64* num_entries_out, const std::string& directory,
+                                              const std::string& virtual_name) -> bool {
+        std::string physical_name = directory + DIR_SEP + virtual_name;
+
+        if (stop_processing)
+            return false; // Breaks the callback loop.
+
+        bool is_dir = FileUtil::IsDirectory(physical_name);
+        if (!is_dir &&
+            (HasSupportedFileExtension(virtual_name) || IsExtractedNCAMain(virtual_name))) {
+            const auto read_game = [this, &installed, physical_name] {
+                return ReadGameFile(installed, physical_name);
+            };
+            Submit(read_game, callback);
+        } else if (is_dir && recursion > 0) {
+            if (directory_callback)
+                directory_callback(physical_name);
+            AddDirectoryEntries(installed, physical_name, recursion - 1, callback,
+                                directory_callback);
+        }
+
+        return true;
+    };
+
+    FileUtil::ForeachDirectoryEntry(nullptr, dir_path, directory_entry_callback);
+}
+
+boost::optional<ScannedGame> GameScanner::ReadInstalledTitle(
+    const FileSys::RegisteredCacheUnion& installed,
+    const FileSys::RegisteredCacheEntry& entry) const {
+    const auto file = installed.GetEntryUnparsed(entry);
+    if (file == nullptr)
+        return boost::none;
+
+    std::unique_ptr<Loader::AppLoader> loader;
+    auto metadata = FindIndexedGame(index, installed, file);
+    if (metadata == boost::none) {
+        loader = Loader::GetLoader(file);
+        if (!loader)
+            return boost::none;
+
+        metadata = ReadGameFromLoader(*loader);
+        const FileSys::PatchManager patch{metadata->program_id};
+        const auto control =
+            installed.GetEntry(entry.title_id, FileSys::ContentRecordType::Control);
+        if (control != nullptr)
+            GetMetadataFromControlNCA(patch, *control, metadata->icon, metadata->name);
+
+        metadata->update_version = GetInstalledUpdateVersion(installed, metadata->program_id);
+        if (index != nullptr)
+            index->AddGame(file, *metadata);
+    }
+
+    return MakeScannedGame(file->GetFullPath(), file->GetSize(), std::move(*metadata), loader,
+                           file, true);
+}
+
+boost::optional<ScannedGame> GameScanner::ReadGameFile(
+    const FileSys::RegisteredCacheUnion& installed, const std::string& physical_name) const {
+    const auto file = vfs->OpenFile(physical_name, FileSys::Mode::Read);
+    if (file == nullptr)
+        return boost::none;
+
+    std::unique_ptr<Loader::AppLoader> loader;
+    auto metadata = FindIndexedGame(index, installed, file);
+    if (metadata == boost::none) {
+        loader = Loader::GetLoader(file);
+        if (!loader)
+            return boost::none;
+
+        metadata = ReadGameFromLoader(*loader);
+        const auto res1 = loader->ReadIcon(metadata->icon);
+        metadata->name = " ";
+        const auto res3 = loader->ReadTitle(metadata->name);
+        metadata->update_version = GetInstalledUpdateVersion(installed, metadata->program_id);
+
+        u64 program_id = 0;
+        const auto res2 = loader->ReadProgramId(program_id);
+        if (res1 != Loader::ResultStatus::Success && res3 != Loader::ResultStatus::Success &&
+            res2 == Loader::ResultStatus::Success) {
+            // Use from metadata pool. The game then depends on other files, it isn't indexed.
+            const auto control = GetControlNCA(program_id);
+            if (control != nullptr) {
+                const FileSys::PatchManager patch{program_id};
+                GetMetadataFromControlNCA(patch, *control, metadata->icon, metadata->name);
+            }
+        } else if (index != nullptr) {
+            index->AddGame(file, *metadata);
+        }
+    }
+
+    const bool updatable = metadata->romfs_updatable;
+    return MakeScannedGame(physical_name, FileUtil::GetSize(physical_name), std::move(*metadata),
+                           loader, file, updatable);
+}
+
+std::unique_ptr<FileSys::NCA> GameScanner::GetControlNCA(u64 title_id) const {
+    // Installed titles take precedence over the NCAs found in the scanned directory.
+    auto installed = Service::FileSystem::GetUnionContents()->GetEntry(
+        title_id, FileSys::ContentRecordType::Control);
+    if (installed != nullptr)
+        return installed;
+
+    const auto iter = nca_control_map.find(title_id);
+    if (iter == nca_control_map.end())
+        return nullptr;
+    return std::make_unique<FileSys::NCA>(iter->second);
+}
+
+} // namespace Core
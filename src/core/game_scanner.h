@@ -0,0 +1,123 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <boost/optional.hpp>
+#include "common/common_types.h"
+#include "common/thread_pool.h"
+#include "core/file_sys/title_metadata_index.h"
+#include "core/file_sys/vfs_types.h"
+
+namespace FileSys {
+class NCA;
+class RegisteredCacheUnion;
+struct RegisteredCacheEntry;
+} // namespace FileSys
+
+namespace Core {
+
+/// A game found by the GameScanner
+struct ScannedGame {
+    /// Path of the game file on the host
+    std::string path;
+    u64 size;
+    FileSys::IndexedGame metadata;
+    /// Names and versions of the patches applied to the game, as returned by the PatchManager
+    std::map<std::string, std::string, std::less<>> patch_versions;
+};
+
+/**
+ * Finds the games installed to the emulated NAND and SD card or stored in a directory of the host
+ * and reads what frontends display of them. Files are opened and parsed by a pool of workers, with
+ * a bounded number of files in flight, while results are handed back on the calling thread in the
+ * order the files were found as soon as they are ready.
+ *
+ * The filesystem factories have to be created before scanning.
+ */
+class GameScanner {
+public:
+    using GameCallback = std::function<void(ScannedGame)>;
+    using DirectoryCallback = std::function<void(const std::string&)>;
+
+    /// Extensions of the files that are considered games when scanning a directory
+    static constexpr std::array<const char*, 5> SUPPORTED_FILE_EXTENSIONS{"nso", "nro", "nca",
+                                                                          "xci", "nsp"};
+
+    /**
+     * Creates a scanner with the given number of workers. Without workers, the files are parsed
+     * on the calling thread.
+     */
+    explicit GameScanner(FileSys::VirtualFilesystem vfs,
+                         std::size_t num_workers = DefaultNumWorkers());
+    ~GameScanner();
+
+    /// Reports the applications installed to the emulated NAND and SD card.
+    void ScanInstalledTitles(const GameCallback& callback);
+
+    /**
+     * Reports the games stored in a directory of the host.
+     * @param dir_path Directory to scan
+     * @param recursion Depth of subdirectories to scan as well
+     * @param callback Called with every game found
+     * @param directory_callback Called with every subdirectory that is scanned
+     */
+    void ScanDirectory(const std::string& dir_path, unsigned int recursion,
+                       const GameCallback& callback,
+                       const DirectoryCallback& directory_callback = {});
+
+    /// Stops the running scan as soon as possible, no games are reported anymore. Thread-safe.
+    void Cancel();
+
+    /**
+     * Returns the number of workers scanners use by default. Scanning mostly waits on storage,
+     * which may be a network share, so there are more workers than cores on small machines.
+     */
+    static std::size_t DefaultNumWorkers();
+
+private:
+    using ScanTask = std::function<boost::optional<ScannedGame>()>;
+
+    /// Queues a task on the pool, reporting finished games while too many files are in flight.
+    void Submit(ScanTask task, const GameCallback& callback);
+
+    /// Reports the games of the queued tasks that finished in order, or of all of them if `wait`.
+    void Report(const GameCallback& callback, bool wait);
+
+    void FillControlMap(const std::string& dir_path);
+    void AddDirectoryEntries(const FileSys::RegisteredCacheUnion& installed,
+                             const std::string& dir_path, unsigned int recursion,
+                             const GameCallback& callback,
+                             const DirectoryCallback& directory_callback);
+
+    boost::optional<ScannedGame> ReadInstalledTitle(
+        const FileSys::RegisteredCacheUnion& installed,
+        const FileSys::RegisteredCacheEntry& entry) const;
+    boost::optional<ScannedGame> ReadGameFile(const FileSys::RegisteredCacheUnion& installed,
+                                              const std::string& physical_name) const;
+    std::unique_ptr<FileSys::NCA> GetControlNCA(u64 title_id) const;
+
+    FileSys::VirtualFilesystem vfs;
+    /// Index of the metadata read by previous scans, fetched when a scan starts
+    FileSys::TitleMetadataIndex* index = nullptr;
+    std::atomic_bool stop_processing{false};
+
+    Common::ThreadPool pool;
+    std::size_t max_pending;
+    std::deque<std::future<boost::optional<ScannedGame>>> pending;
+
+    /// Control NCAs of the scanned directory, by title ID
+    std::map<u64, FileSys::VirtualFile> nca_control_map;
+};
+
+} // namespace Core
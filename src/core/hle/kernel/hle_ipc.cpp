@@ -292,26 +292,41 @@ std::vector<u8> HLERequestContext::ReadBuffer(int buffer_index) const {
 
 std::size_t HLERequestContext::WriteBuffer(const void* buffer, std::size_t size,
                                            int buffer_index) const {
+    size = ClampWriteSize(size, buffer_index);
     if (size == 0) {
-        LOG_WARNING(Core, "skip empty buffer write");
         return 0;
     }
 
-    const bool is_buffer_b{BufferDescriptorB().size() && BufferDescriptorB()[buffer_index].Size()};
-    const std::size_t buffer_size{GetWriteBufferSize(buffer_index)};
-    if (size > buffer_size) {
-        LOG_CRITICAL(Core, "size ({:016X}) is greater than buffer_size ({:016X})", size,
-                     buffer_size);
-        size = buffer_size; // TODO(bunnei): This needs to be HW tested
+    Memory::WriteBlock(GetWriteBufferAddress(buffer_index), buffer, size);
+    return size;
+}
+
+std::size_t HLERequestContext::WriteBufferDirect(std::size_t size, const DirectWriteFunction& write,
+                                                 int buffer_index) const {
+    size = ClampWriteSize(size, buffer_index);
+    if (size == 0) {
+        return 0;
     }
 
-    if (is_buffer_b) {
-        Memory::WriteBlock(BufferDescriptorB()[buffer_index].Address(), buffer, size);
-    } else {
-        Memory::WriteBlock(BufferDescriptorC()[buffer_index].Address(), buffer, size);
+    const VAddr address{GetWriteBufferAddress(buffer_index)};
+    std::size_t written{};
+    while (written < size) {
+        std::size_t run_size{};
+        u8* const dest{Memory::GetWritePointer(address + written, size - written, run_size)};
+        if (dest == nullptr) {
+            LOG_ERROR(Core, "Unmapped buffer write @ 0x{:016X} (buffer address = 0x{:016X})",
+                      address + written, address);
+            break;
+        }
+
+        const std::size_t run_written{write(dest, run_size, written)};
+        written += run_written;
+        if (run_written < run_size) {
+            break;
+        }
     }
 
-    return size;
+    return written;
 }
 
 std::size_t HLERequestContext::GetReadBufferSize(int buffer_index) const {
@@ -326,6 +341,27 @@ std::size_t HLERequestContext::GetWriteBufferSize(int buffer_index) const {
                        : BufferDescriptorC()[buffer_index].Size();
 }
 
+VAddr HLERequestContext::GetWriteBufferAddress(int buffer_index) const {
+    const bool is_buffer_b{BufferDescriptorB().size() && BufferDescriptorB()[buffer_index].Size()};
+    return is_buffer_b ? BufferDescriptorB()[buffer_index].Address()
+                       : BufferDescriptorC()[buffer_index].Address();
+}
+
+std::size_t HLERequestContext::ClampWriteSize(std::size_t size, int buffer_index) const {
+    if (size == 0) {
+        LOG_WARNING(Core, "skip empty buffer write");
+        return 0;
+    }
+
+    const std::size_t buffer_size{GetWriteBufferSize(buffer_index)};
+    if (size > buffer_size) {
+        LOG_CRITICAL(Core, "size ({:016X}) is greater than buffer_size ({:016X})", size,
+                     buffer_size);
+        size = buffer_size; // TODO(bunnei): This needs to be HW tested
+    }
+    return size;
+}
+
 std::string HLERequestContext::Description() const {
     if (!command_header) {
         return "No command header available";
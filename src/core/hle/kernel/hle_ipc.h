@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <functional>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -191,6 +192,30 @@ public:
                            buffer_index);
     }
 
+    /**
+     * Function writing part of a buffer in place, as used by WriteBufferDirect.
+     * @param dest   Host memory backing the part of the buffer.
+     * @param size   Size of the part in bytes.
+     * @param offset Offset of the part from the start of the buffer.
+     * @returns The number of bytes written to dest.
+     */
+    using DirectWriteFunction =
+        std::function<std::size_t(u8* dest, std::size_t size, std::size_t offset)>;
+
+    /**
+     * Helper function to write a buffer using the appropriate buffer descriptor, directly into the
+     * guest memory backing it instead of copying from an intermediate buffer. The memory is passed
+     * to `write` in parts that are contiguous in host memory, writing stops at the first part that
+     * isn't written entirely.
+     *
+     * @param size         The number of bytes to write.
+     * @param write        Function writing each part of the buffer.
+     * @param buffer_index The buffer in particular to write to.
+     * @returns The number of bytes written.
+     */
+    std::size_t WriteBufferDirect(std::size_t size, const DirectWriteFunction& write,
+                                  int buffer_index = 0) const;
+
     /// Helper function to get the size of the input buffer
     std::size_t GetReadBufferSize(int buffer_index = 0) const;
 
@@ -256,6 +281,12 @@ public:
 private:
     void ParseCommandBuffer(const HandleTable& handle_table, u32_le* src_cmdbuf, bool incoming);
 
+    /// Gets the address of the output buffer
+    VAddr GetWriteBufferAddress(int buffer_index) const;
+
+    /// Clamps the size of a write to the size of the output buffer
+    std::size_t ClampWriteSize(std::size_t size, int buffer_index) const;
+
     std::array<u32, IPC::COMMAND_BUFFER_LENGTH> cmd_buf;
     SharedPtr<Kernel::ServerSession> server_session;
     // TODO(yuriks): Check common usage of this and optimize size accordingly
@@ -13,6 +13,9 @@ namespace HLE {
  * modify the HLE kernel state. Note: Any operation that directly or indirectly reads from or writes
  * to the emulated memory is not protected by this mutex, and should be avoided in any threads other
  * than the CPU thread.
+ *
+ * The GPU thread must never acquire it, as CPU threads wait on the GPU thread while holding it. The
+ * guest memory accesses of the GPU thread are synchronized with the page table by Memory instead.
  */
 extern std::recursive_mutex g_hle_lock;
 } // namespace HLE
@@ -14,6 +14,7 @@
 #include "core/file_sys/romfs_factory.h"
 #include "core/file_sys/savedata_factory.h"
 #include "core/file_sys/sdmc_factory.h"
+#include "core/file_sys/title_metadata_index.h"
 #include "core/file_sys/vfs.h"
 #include "core/file_sys/vfs_offset.h"
 #include "core/hle/service/filesystem/filesystem.h"
@@ -235,6 +236,7 @@ static std::unique_ptr<FileSys::RomFSFactory> romfs_factory;
 static std::unique_ptr<FileSys::SaveDataFactory> save_data_factory;
 static std::unique_ptr<FileSys::SDMCFactory> sdmc_factory;
 static std::unique_ptr<FileSys::BISFactory> bis_factory;
+static std::unique_ptr<FileSys::TitleMetadataIndex> title_metadata_index;
 
 ResultCode RegisterRomFS(std::unique_ptr<FileSys::RomFSFactory>&& factory) {
     ASSERT_MSG(romfs_factory == nullptr, "Tried to register a second RomFS");
@@ -320,8 +322,14 @@ ResultVal<FileSys::VirtualDir> OpenSDMC() {
 }
 
 std::unique_ptr<FileSys::RegisteredCacheUnion> GetUnionContents() {
-    return std::make_unique<FileSys::RegisteredCacheUnion>(std::vector<FileSys::RegisteredCache*>{
-        GetSystemNANDContents(), GetUserNANDContents(), GetSDMCContents()});
+    // Contents of factories that weren't created yet are left out, e.g. when scanning for games
+    // without running a game.
+    std::vector<FileSys::RegisteredCache*> caches;
+    for (auto* const cache : {GetSystemNANDContents(), GetUserNANDContents(), GetSDMCContents()}) {
+        if (cache != nullptr)
+            caches.push_back(cache);
+    }
+    return std::make_unique<FileSys::RegisteredCacheUnion>(std::move(caches));
 }
 
 FileSys::RegisteredCache* GetSystemNANDContents() {
@@ -351,6 +359,10 @@ FileSys::RegisteredCache* GetSDMCContents() {
     return sdmc_factory->GetSDMCContents();
 }
 
+FileSys::TitleMetadataIndex* GetTitleMetadataIndex() {
+    return title_metadata_index.get();
+}
+
 FileSys::VirtualDir GetModificationLoadRoot(u64 title_id) {
     LOG_TRACE(Service_FS, "Opening mod load root for tid={:016X}", title_id);
 
@@ -374,12 +386,22 @@ void CreateFactories(FileSys::VfsFilesystem& vfs, bool overwrite) {
     auto load_directory = vfs.OpenDirectory(FileUtil::GetUserPath(FileUtil::UserPath::LoadDir),
                                             FileSys::Mode::ReadWrite);
 
-    if (bis_factory == nullptr)
-        bis_factory = std::make_unique<FileSys::BISFactory>(nand_directory, load_directory);
+    // The index outlives the factories, it stays valid for the files that didn't change.
+    if (title_metadata_index == nullptr) {
+        title_metadata_index = std::make_unique<FileSys::TitleMetadataIndex>(
+            FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) + "title_metadata.bin");
+    }
+
+    if (bis_factory == nullptr) {
+        bis_factory = std::make_unique<FileSys::BISFactory>(nand_directory, load_directory,
+                                                            title_metadata_index.get());
+    }
     if (save_data_factory == nullptr)
         save_data_factory = std::make_unique<FileSys::SaveDataFactory>(std::move(nand_directory));
-    if (sdmc_factory == nullptr)
-        sdmc_factory = std::make_unique<FileSys::SDMCFactory>(std::move(sd_directory));
+    if (sdmc_factory == nullptr) {
+        sdmc_factory = std::make_unique<FileSys::SDMCFactory>(std::move(sd_directory),
+                                                              title_metadata_index.get());
+    }
 }
 
 void InstallInterfaces(SM::ServiceManager& service_manager, FileSys::VfsFilesystem& vfs) {
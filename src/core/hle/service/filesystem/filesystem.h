@@ -17,6 +17,7 @@ class RegisteredCacheUnion;
 class RomFSFactory;
 class SaveDataFactory;
 class SDMCFactory;
+class TitleMetadataIndex;
 
 enum class ContentRecordType : u8;
 enum class Mode : u32;
@@ -53,6 +54,9 @@ FileSys::RegisteredCache* GetSystemNANDContents();
 FileSys::RegisteredCache* GetUserNANDContents();
 FileSys::RegisteredCache* GetSDMCContents();
 
+// Index of the metadata of installed titles and game files, null until the factories are created.
+FileSys::TitleMetadataIndex* GetTitleMetadataIndex();
+
 FileSys::VirtualDir GetModificationLoadRoot(u64 title_id);
 
 // Creates the SaveData, SDMC, and BIS Factories. Should be called once and before any function
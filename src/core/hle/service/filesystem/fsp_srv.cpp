@@ -38,6 +38,28 @@ enum class FileSystemType : u8 {
     ApplicationPackage = 7,
 };
 
+/**
+ * Reads length bytes of a file starting at offset into the output buffer of a request. Files that
+ * can hand out views of their contents are copied into guest memory from there, other files, such
+ * as encrypted ones, are read and decrypted straight into the guest memory of the buffer. Neither
+ * goes through an intermediate buffer.
+ * @returns The number of bytes read from the file
+ */
+static std::size_t ReadFileToBuffer(Kernel::HLERequestContext& ctx,
+                                    const FileSys::VirtualFile& file, std::size_t length,
+                                    std::size_t offset) {
+    const FileSys::ReadOnlySpan span = file->ReadSpan(length, offset);
+    if (span.data != nullptr) {
+        ctx.WriteBuffer(span.data, span.size);
+        return span.size;
+    }
+
+    return ctx.WriteBufferDirect(
+        length, [&file, offset](u8* dest, std::size_t size, std::size_t buffer_offset) {
+            return file->Read(dest, size, offset + buffer_offset);
+        });
+}
+
 class IStorage final : public ServiceFramework<IStorage> {
 public:
     explicit IStorage(FileSys::VirtualFile backend_)
@@ -71,10 +93,8 @@ private:
             return;
         }
 
-        // Read the data from the Storage backend
-        std::vector<u8> output = backend->ReadBytes(length, offset);
-        // Write the data to memory
-        ctx.WriteBuffer(output);
+        // Read the data from the Storage backend into memory
+        ReadFileToBuffer(ctx, backend, length, offset);
 
         IPC::ResponseBuilder rb{ctx, 2};
         rb.Push(RESULT_SUCCESS);
@@ -116,15 +136,12 @@ private:
             return;
         }
 
-        // Read the data from the Storage backend
-        std::vector<u8> output = backend->ReadBytes(length, offset);
-
-        // Write the data to memory
-        ctx.WriteBuffer(output);
+        // Read the data from the Storage backend into memory
+        const std::size_t read_size = ReadFileToBuffer(ctx, backend, length, offset);
 
         IPC::ResponseBuilder rb{ctx, 4};
         rb.Push(RESULT_SUCCESS);
-        rb.Push(static_cast<u64>(output.size()));
+        rb.Push(static_cast<u64>(read_size));
     }
 
     void Write(Kernel::HLERequestContext& ctx) {
@@ -10,9 +10,8 @@
 #include "core/core.h"
 #include "core/hle/service/nvdrv/devices/nvhost_as_gpu.h"
 #include "core/hle/service/nvdrv/devices/nvmap.h"
+#include "video_core/gpu.h"
 #include "video_core/memory_manager.h"
-#include "video_core/rasterizer_interface.h"
-#include "video_core/renderer_base.h"
 
 namespace Service::Nvidia::Devices {
 namespace NvErrCodes {
@@ -171,17 +170,21 @@ u32 nvhost_as_gpu::UnmapBuffer(const std::vector<u8>& input, std::vector<u8>& ou
         return 0;
     }
 
+    // Copy the mapping rather than keeping the iterator across the flush, which waits on the GPU
+    // thread.
+    const BufferMapping mapping = itr->second;
+
     auto& system_instance = Core::System::GetInstance();
 
     // Remove this memory region from the rasterizer cache.
     auto& gpu = system_instance.GPU();
     auto cpu_addr = gpu.MemoryManager().GpuToCpuAddress(params.offset);
     ASSERT(cpu_addr);
-    system_instance.Renderer().Rasterizer().FlushAndInvalidateRegion(*cpu_addr, itr->second.size);
+    system_instance.GPU().FlushAndInvalidateRegion(*cpu_addr, mapping.size);
 
-    params.offset = gpu.MemoryManager().UnmapBuffer(params.offset, itr->second.size);
+    params.offset = gpu.MemoryManager().UnmapBuffer(params.offset, mapping.size);
 
-    buffer_mappings.erase(itr->second.offset);
+    buffer_mappings.erase(mapping.offset);
 
     std::memcpy(output.data(), &params, output.size());
     return 0;
@@ -2,8 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include <cinttypes>
 #include <cstring>
+#include <future>
+#include <optional>
+#include <utility>
+#include <vector>
 #include "common/common_funcs.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -133,9 +138,11 @@ ResultStatus AppLoader_DeconstructedRomDirectory::Load(Kernel::Process& process)
     process.LoadFromMetadata(metadata);
     const FileSys::PatchManager pm(metadata.GetTitleID());
 
-    // Load NSO modules
-    const VAddr base_address = process.VMManager().GetCodeRegionBaseAddress();
-    VAddr next_load_addr = base_address;
+    // Load NSO modules. Each module is decompressed in the background while the next one is read,
+    // they are then patched and loaded in order as their load address depends on the previous one.
+    const auto load_start = std::chrono::steady_clock::now();
+    std::vector<std::pair<const char*, std::future<std::optional<NSOImage>>>> modules;
+    std::vector<std::chrono::microseconds> read_times;
     for (const auto& module : {"rtld", "main", "subsdk0", "subsdk1", "subsdk2", "subsdk3",
                                "subsdk4", "subsdk5", "subsdk6", "subsdk7", "sdk"}) {
         const FileSys::VirtualFile module_file = dir->GetFile(module);
@@ -143,19 +150,41 @@ ResultStatus AppLoader_DeconstructedRomDirectory::Load(Kernel::Process& process)
             continue;
         }
 
-        const VAddr load_addr = next_load_addr;
+        const auto read_start = std::chrono::steady_clock::now();
         const bool should_pass_arguments = std::strcmp(module, "rtld") == 0;
+        modules.emplace_back(module,
+                             AppLoader_NSO::ReadModule(*module_file, should_pass_arguments));
+        read_times.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - read_start));
+    }
+
+    const VAddr base_address = process.VMManager().GetCodeRegionBaseAddress();
+    VAddr next_load_addr = base_address;
+    for (std::size_t i = 0; i < modules.size(); ++i) {
+        const auto module = modules[i].first;
+        auto image = modules[i].second.get();
+        if (!image) {
+            return ResultStatus::ErrorLoadingNSO;
+        }
+
+        const auto decompression_time = image->decompression_time;
+        const VAddr load_addr = next_load_addr;
         const auto tentative_next_load_addr =
-            AppLoader_NSO::LoadModule(*module_file, load_addr, should_pass_arguments, pm);
+            AppLoader_NSO::LoadModule(std::move(*image), load_addr, pm);
         if (!tentative_next_load_addr) {
             return ResultStatus::ErrorLoadingNSO;
         }
 
         next_load_addr = *tentative_next_load_addr;
-        LOG_DEBUG(Loader, "loaded module {} @ 0x{:X}", module, load_addr);
+        LOG_DEBUG(Loader, "loaded module {} @ 0x{:X}, read in {} us, decompressed in {} us", module,
+                  load_addr, read_times[i].count(), decompression_time.count());
         // Register module with GDBStub
         GDBStub::RegisterModule(module, load_addr, next_load_addr - 1, false);
     }
+    LOG_INFO(Loader, "Loaded {} modules in {} ms", modules.size(),
+             std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::steady_clock::now() - load_start)
+                 .count());
 
     process.Run(base_address, metadata.GetMainThreadPriority(), metadata.GetMainThreadStackSize());
 
@@ -137,9 +137,24 @@ bool AppLoader_NRO::LoadNro(const FileSys::VfsFile& file, VAddr load_base) {
         return {};
     }
 
-    // Build program image
-    std::vector<u8> program_image = file.ReadBytes(PageAlignSize(nro_header.file_size));
-    if (program_image.size() != PageAlignSize(nro_header.file_size)) {
+    // Read MOD header
+    ModHeader mod_header{};
+    // Default .bss to NRO header bss size if MOD0 section doesn't exist
+    u32 bss_size{PageAlignSize(nro_header.bss_size)};
+    file.ReadObject(&mod_header, nro_header.module_header_offset);
+    const bool has_mod_header{mod_header.magic == Common::MakeMagic('M', 'O', 'D', '0')};
+    if (has_mod_header) {
+        // Resize program image to include .bss section and page align each section
+        bss_size = PageAlignSize(mod_header.bss_end_offset - mod_header.bss_start_offset);
+    }
+
+    // Build program image, which is sized for the arguments and .bss up front so that it's read
+    // straight into its final buffer
+    const bool pass_arguments = !Settings::values.program_args.empty();
+    const std::size_t file_image_size = PageAlignSize(nro_header.file_size);
+    std::vector<u8> program_image(
+        file_image_size + (pass_arguments ? NSO_ARGUMENT_DATA_ALLOCATION_SIZE : 0) + bss_size);
+    if (file.Read(program_image.data(), file_image_size) != file_image_size) {
         return {};
     }
 
@@ -150,32 +165,17 @@ bool AppLoader_NRO::LoadNro(const FileSys::VfsFile& file, VAddr load_base) {
         codeset.segments[i].size = PageAlignSize(nro_header.segments[i].size);
     }
 
-    if (!Settings::values.program_args.empty()) {
+    if (pass_arguments) {
         const auto arg_data = Settings::values.program_args;
         codeset.DataSegment().size += NSO_ARGUMENT_DATA_ALLOCATION_SIZE;
         NSOArgumentHeader args_header{
             NSO_ARGUMENT_DATA_ALLOCATION_SIZE, static_cast<u32_le>(arg_data.size()), {}};
-        const auto end_offset = program_image.size();
-        program_image.resize(static_cast<u32>(program_image.size()) +
-                             NSO_ARGUMENT_DATA_ALLOCATION_SIZE);
-        std::memcpy(program_image.data() + end_offset, &args_header, sizeof(NSOArgumentHeader));
-        std::memcpy(program_image.data() + end_offset + sizeof(NSOArgumentHeader), arg_data.data(),
-                    arg_data.size());
-    }
-
-    // Read MOD header
-    ModHeader mod_header{};
-    // Default .bss to NRO header bss size if MOD0 section doesn't exist
-    u32 bss_size{PageAlignSize(nro_header.bss_size)};
-    std::memcpy(&mod_header, program_image.data() + nro_header.module_header_offset,
-                sizeof(ModHeader));
-    const bool has_mod_header{mod_header.magic == Common::MakeMagic('M', 'O', 'D', '0')};
-    if (has_mod_header) {
-        // Resize program image to include .bss section and page align each section
-        bss_size = PageAlignSize(mod_header.bss_end_offset - mod_header.bss_start_offset);
+        std::memcpy(program_image.data() + file_image_size, &args_header,
+                    sizeof(NSOArgumentHeader));
+        std::memcpy(program_image.data() + file_image_size + sizeof(NSOArgumentHeader),
+                    arg_data.data(), arg_data.size());
     }
     codeset.DataSegment().size += bss_size;
-    program_image.resize(static_cast<u32>(program_image.size()) + bss_size);
 
     // Load codeset for current process
     codeset.memory = std::make_shared<std::vector<u8>>(std::move(program_image));
@@ -2,13 +2,19 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
 #include <cinttypes>
+#include <cstring>
+#include <memory>
+#include <utility>
 #include <vector>
 #include <lz4.h>
 #include "common/common_funcs.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/swap.h"
+#include "common/thread_pool.h"
 #include "core/core.h"
 #include "core/file_sys/patch_manager.h"
 #include "core/gdbstub/gdbstub.h"
@@ -74,54 +80,28 @@ FileType AppLoader_NSO::IdentifyType(const FileSys::VirtualFile& file) {
     return FileType::NSO;
 }
 
-static std::vector<u8> DecompressSegment(const std::vector<u8>& compressed_data,
-                                         const NsoSegmentHeader& header) {
-    std::vector<u8> uncompressed_data(header.size);
+static bool DecompressSegment(const std::vector<u8>& compressed_data,
+                              const NsoSegmentHeader& header, u8* out) {
     const int bytes_uncompressed =
         LZ4_decompress_safe(reinterpret_cast<const char*>(compressed_data.data()),
-                            reinterpret_cast<char*>(uncompressed_data.data()),
-                            static_cast<int>(compressed_data.size()), header.size);
-
-    ASSERT_MSG(bytes_uncompressed == static_cast<int>(header.size) &&
-                   bytes_uncompressed == static_cast<int>(uncompressed_data.size()),
-               "{} != {} != {}", bytes_uncompressed, header.size, uncompressed_data.size());
+                            reinterpret_cast<char*>(out), static_cast<int>(compressed_data.size()),
+                            static_cast<int>(header.size));
+    if (bytes_uncompressed != static_cast<int>(header.size)) {
+        LOG_ERROR(Loader, "Segment decompressed to {} bytes instead of {}", bytes_uncompressed,
+                  header.size);
+        return false;
+    }
 
-    return uncompressed_data;
+    return true;
 }
 
 static constexpr u32 PageAlignSize(u32 size) {
     return (size + Memory::PAGE_MASK) & ~Memory::PAGE_MASK;
 }
 
-std::optional<VAddr> AppLoader_NSO::LoadModule(const FileSys::VfsFile& file, VAddr load_base,
-                                               bool should_pass_arguments,
-                                               std::optional<FileSys::PatchManager> pm) {
-    if (file.GetSize() < sizeof(NsoHeader))
-        return {};
-
-    NsoHeader nso_header{};
-    if (sizeof(NsoHeader) != file.ReadObject(&nso_header))
-        return {};
-
-    if (nso_header.magic != Common::MakeMagic('N', 'S', 'O', '0'))
-        return {};
-
-    // Build program image
-    Kernel::CodeSet codeset;
-    std::vector<u8> program_image;
-    for (std::size_t i = 0; i < nso_header.segments.size(); ++i) {
-        std::vector<u8> data =
-            file.ReadBytes(nso_header.segments_compressed_size[i], nso_header.segments[i].offset);
-        if (nso_header.IsSegmentCompressed(i)) {
-            data = DecompressSegment(data, nso_header.segments[i]);
-        }
-        program_image.resize(nso_header.segments[i].location);
-        program_image.insert(program_image.end(), data.begin(), data.end());
-        codeset.segments[i].addr = nso_header.segments[i].location;
-        codeset.segments[i].offset = nso_header.segments[i].location;
-        codeset.segments[i].size = PageAlignSize(static_cast<u32>(data.size()));
-    }
-
+/// Appends the program arguments, if any, and .bss to an image whose segments are decompressed.
+static void FinishProgramImage(std::vector<u8>& program_image, Kernel::CodeSet& codeset,
+                               const NsoHeader& nso_header, bool should_pass_arguments) {
     if (should_pass_arguments && !Settings::values.program_args.empty()) {
         const auto arg_data = Settings::values.program_args;
         codeset.DataSegment().size += NSO_ARGUMENT_DATA_ALLOCATION_SIZE;
@@ -136,42 +116,145 @@ std::optional<VAddr> AppLoader_NSO::LoadModule(const FileSys::VfsFile& file, VAd
     }
 
     // MOD header pointer is at .text offset + 4
-    u32 module_offset;
-    std::memcpy(&module_offset, program_image.data() + 4, sizeof(u32));
+    u32 module_offset{};
+    if (program_image.size() >= 8)
+        std::memcpy(&module_offset, program_image.data() + 4, sizeof(u32));
 
     // Read MOD header
     ModHeader mod_header{};
     // Default .bss to size in segment header if MOD0 section doesn't exist
     u32 bss_size{PageAlignSize(nso_header.segments[2].bss_size)};
-    std::memcpy(&mod_header, program_image.data() + module_offset, sizeof(ModHeader));
+    if (program_image.size() >= sizeof(ModHeader) &&
+        module_offset <= program_image.size() - sizeof(ModHeader)) {
+        std::memcpy(&mod_header, program_image.data() + module_offset, sizeof(ModHeader));
+    }
     const bool has_mod_header{mod_header.magic == Common::MakeMagic('M', 'O', 'D', '0')};
     if (has_mod_header) {
         // Resize program image to include .bss section and page align each section
         bss_size = PageAlignSize(mod_header.bss_end_offset - mod_header.bss_start_offset);
     }
     codeset.DataSegment().size += bss_size;
-    const u32 image_size{PageAlignSize(static_cast<u32>(program_image.size()) + bss_size)};
-    program_image.resize(image_size);
+    program_image.resize(PageAlignSize(static_cast<u32>(program_image.size()) + bss_size));
+}
+
+std::future<std::optional<NSOImage>> AppLoader_NSO::ReadModule(const FileSys::VfsFile& file,
+                                                               bool should_pass_arguments) {
+    NsoHeader nso_header{};
+    if (file.GetSize() < sizeof(NsoHeader) || sizeof(NsoHeader) != file.ReadObject(&nso_header) ||
+        nso_header.magic != Common::MakeMagic('N', 'S', 'O', '0')) {
+        std::promise<std::optional<NSOImage>> invalid;
+        invalid.set_value(std::nullopt);
+        return invalid.get_future();
+    }
+
+    const auto segment_size = [&nso_header](std::size_t i) -> u32 {
+        return nso_header.IsSegmentCompressed(i) ? nso_header.segments[i].size
+                                                 : nso_header.segments_compressed_size[i];
+    };
+
+    // Segments are placed at their location in the image, which is then followed by the program
+    // arguments and .bss. Room is reserved for those as well, so that appending them once the MOD
+    // header is known usually doesn't copy the image again.
+    std::size_t segments_end = 0;
+    for (std::size_t i = 0; i < nso_header.segments.size(); ++i)
+        segments_end = std::max<std::size_t>(segments_end,
+                                             nso_header.segments[i].location + segment_size(i));
+
+    auto program_image = std::make_shared<std::vector<u8>>();
+    program_image->reserve(segments_end + NSO_ARGUMENT_DATA_ALLOCATION_SIZE +
+                           PageAlignSize(nso_header.segments[2].bss_size) + Memory::PAGE_SIZE);
+    program_image->resize(segments_end);
+
+    // Only the compressed data is read into intermediate buffers, the file is only accessed on the
+    // calling thread as most files can't be read from several threads at once.
+    Kernel::CodeSet codeset;
+    std::array<std::vector<u8>, 3> compressed_segments;
+    for (std::size_t i = 0; i < nso_header.segments.size(); ++i) {
+        const auto& segment = nso_header.segments[i];
+        const u32 size = segment_size(i);
+        if (nso_header.IsSegmentCompressed(i)) {
+            compressed_segments[i] =
+                file.ReadBytes(nso_header.segments_compressed_size[i], segment.offset);
+        } else if (file.Read(program_image->data() + segment.location, size, segment.offset) !=
+                   size) {
+            LOG_ERROR(Loader, "Segment {} of {} is truncated", i, file.GetName());
+            std::promise<std::optional<NSOImage>> invalid;
+            invalid.set_value(std::nullopt);
+            return invalid.get_future();
+        }
+        codeset.segments[i].addr = segment.location;
+        codeset.segments[i].offset = segment.location;
+        codeset.segments[i].size = PageAlignSize(size);
+    }
+
+    return Common::GetSharedThreadPool().Submit(
+        [nso_header, compressed_segments = std::move(compressed_segments),
+         program_image = std::move(program_image), codeset,
+         should_pass_arguments]() mutable -> std::optional<NSOImage> {
+            const auto start = std::chrono::steady_clock::now();
+
+            std::atomic_bool decompressed{true};
+            Common::GetSharedThreadPool().ParallelFor(
+                nso_header.segments.size(), [&](std::size_t i) {
+                    if (!nso_header.IsSegmentCompressed(i))
+                        return;
+                    const auto& segment = nso_header.segments[i];
+                    if (!DecompressSegment(compressed_segments[i], segment,
+                                           program_image->data() + segment.location)) {
+                        decompressed = false;
+                    }
+                });
+            if (!decompressed)
+                return std::nullopt;
+
+            FinishProgramImage(*program_image, codeset, nso_header, should_pass_arguments);
+            codeset.memory = std::move(program_image);
+
+            NSOImage image{std::vector<u8>(0x100), nso_header.build_id, std::move(codeset), {}};
+            std::memcpy(image.header.data(), &nso_header, sizeof(NsoHeader));
+            image.decompression_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+            return image;
+        });
+}
+
+std::optional<VAddr> AppLoader_NSO::LoadModule(NSOImage image, VAddr load_base,
+                                               std::optional<FileSys::PatchManager> pm) {
+    auto& program_image = *image.codeset.memory;
 
     // Apply patches if necessary
-    if (pm && pm->HasNSOPatch(nso_header.build_id)) {
-        std::vector<u8> pi_header(program_image.size() + 0x100);
-        std::memcpy(pi_header.data(), &nso_header, sizeof(NsoHeader));
-        std::memcpy(pi_header.data() + 0x100, program_image.data(), program_image.size());
+    if (pm && pm->HasNSOPatch(image.build_id)) {
+        std::vector<u8> pi_header(program_image.size() + image.header.size());
+        std::memcpy(pi_header.data(), image.header.data(), image.header.size());
+        std::memcpy(pi_header.data() + image.header.size(), program_image.data(),
+                    program_image.size());
 
         pi_header = pm->PatchNSO(pi_header);
 
-        std::memcpy(program_image.data(), pi_header.data() + 0x100, program_image.size());
+        std::memcpy(program_image.data(), pi_header.data() + image.header.size(),
+                    program_image.size());
     }
 
     // Load codeset for current process
-    codeset.memory = std::make_shared<std::vector<u8>>(std::move(program_image));
-    Core::CurrentProcess()->LoadModule(std::move(codeset), load_base);
+    const VAddr image_size = program_image.size();
+    Core::CurrentProcess()->LoadModule(std::move(image.codeset), load_base);
+
+    return load_base + image_size;
+}
+
+std::optional<VAddr> AppLoader_NSO::LoadModule(const FileSys::VfsFile& file, VAddr load_base,
+                                               bool should_pass_arguments,
+                                               std::optional<FileSys::PatchManager> pm) {
+    auto image = ReadModule(file, should_pass_arguments).get();
+    if (!image)
+        return {};
+
+    const auto next_load_addr = LoadModule(std::move(*image), load_base, std::move(pm));
 
     // Register module with GDBStub
     GDBStub::RegisterModule(file.GetName(), load_base, load_base);
 
-    return load_base + image_size;
+    return next_load_addr;
 }
 
 ResultStatus AppLoader_NSO::Load(Kernel::Process& process) {
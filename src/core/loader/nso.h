@@ -4,9 +4,14 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <future>
 #include <optional>
+#include <vector>
 #include "common/common_types.h"
 #include "core/file_sys/patch_manager.h"
+#include "core/hle/kernel/process.h"
 #include "core/loader/linker.h"
 #include "core/loader/loader.h"
 
@@ -21,6 +26,16 @@ struct NSOArgumentHeader {
 };
 static_assert(sizeof(NSOArgumentHeader) == 0x20, "NSOArgumentHeader has incorrect size.");
 
+/// The program image of an NSO, which can be loaded at any address
+struct NSOImage {
+    /// The NSO header padded to 0x100 bytes, NSO patches expect it in front of the image
+    std::vector<u8> header;
+    std::array<u8, 0x20> build_id;
+    Kernel::CodeSet codeset;
+    /// Time taken to decompress the segments into the image
+    std::chrono::microseconds decompression_time;
+};
+
 /// Loads an NSO file
 class AppLoader_NSO final : public AppLoader, Linker {
 public:
@@ -37,6 +52,22 @@ public:
         return IdentifyType(file);
     }
 
+    /**
+     * Reads an NSO into a program image. The file is read on the calling thread, while the
+     * compressed segments are decompressed in parallel on worker threads, straight into the
+     * image. This lets the caller read the next NSO while the previous ones are decompressed.
+     * @return A future to the image, which is empty if the file isn't a valid NSO
+     */
+    static std::future<std::optional<NSOImage>> ReadModule(const FileSys::VfsFile& file,
+                                                           bool should_pass_arguments);
+
+    /**
+     * Applies the NSO patches to a program image and loads it into the current process.
+     * @return The address following the loaded module
+     */
+    static std::optional<VAddr> LoadModule(NSOImage image, VAddr load_base,
+                                           std::optional<FileSys::PatchManager> pm = {});
+
     static std::optional<VAddr> LoadModule(const FileSys::VfsFile& file, VAddr load_base,
                                            bool should_pass_arguments,
                                            std::optional<FileSys::PatchManager> pm = {});
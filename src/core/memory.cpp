@@ -3,7 +3,10 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstring>
+#include <mutex>
 #include <utility>
 
 #include <boost/optional.hpp>
@@ -18,14 +21,69 @@
 #include "core/hle/lock.h"
 #include "core/memory.h"
 #include "core/memory_setup.h"
-#include "video_core/renderer_base.h"
+#include "video_core/gpu.h"
 
 namespace Memory {
 
 static PageTable* current_page_table = nullptr;
 
+/**
+ * Synchronizes the page attributes and pointers between the CPU threads and the GPU thread, which
+ * marks pages as cached and reads guest memory without holding the HLE lock. It must not be held
+ * while flushing the rasterizer, as the flush may wait on the GPU thread taking it.
+ */
+static std::mutex page_table_mutex;
+
+/**
+ * Small direct-mapped software TLB that sits in front of the page attribute switch for accesses
+ * that miss the `pointers` fast path. Entries cache the resolved host pointer of the page, the IO
+ * handler of Special pages and whether the page lies inside a region the rasterizer may cache, so
+ * that repeated accesses to the same page avoid the page table, VMManager and special region
+ * lookups.
+ *
+ * There is one TLB per host thread, which means one per emulated core when running multicore.
+ * Rather than shooting down every thread's entries, any page table change bumps a global
+ * generation counter, and each TLB discards its entries the next time it sees a new generation.
+ */
+namespace {
+constexpr std::size_t TLB_BITS = 8;
+constexpr std::size_t TLB_SIZE = 1ULL << TLB_BITS;
+constexpr VAddr INVALID_TLB_TAG = ~0ULL;
+
+struct TLBEntry {
+    /// Page number this entry refers to, or INVALID_TLB_TAG if the entry is empty.
+    VAddr tag = INVALID_TLB_TAG;
+    /// Attribute of the page at the time the entry was filled.
+    PageType type = PageType::Unmapped;
+    /// Whether accesses to the page have to notify the rasterizer cache.
+    bool rasterizer_region = false;
+    /// Host memory backing the page, for Memory and RasterizerCachedMemory pages.
+    u8* pointer = nullptr;
+    /// Handler backing the page, for Special pages.
+    MemoryHook* mmio_handler = nullptr;
+};
+
+struct TLB {
+    std::array<TLBEntry, TLB_SIZE> entries{};
+    u64 generation = 0;
+};
+
+std::atomic<u64> tlb_generation{1};
+thread_local TLB tlb;
+} // Anonymous namespace
+
+/**
+ * Discards the cached translations of every TLB. This has to be called after the page table has
+ * been changed, as a lookup racing with the change could otherwise cache the old translation under
+ * the new generation.
+ */
+static void InvalidateTLB() {
+    tlb_generation.fetch_add(1, std::memory_order_release);
+}
+
 void SetCurrentPageTable(PageTable* page_table) {
     current_page_table = page_table;
+    InvalidateTLB();
 
     auto& system = Core::System::GetInstance();
     if (system.IsPoweredOn()) {
@@ -50,9 +108,58 @@ PageTable::~PageTable() = default;
 
 void PageTable::Resize(std::size_t address_space_width_in_bits) {
     const std::size_t num_page_table_entries = 1ULL << (address_space_width_in_bits - PAGE_BITS);
+    if (num_page_table_entries == pointers.size()) {
+        // Keep the existing allocation, as the JIT may still be referencing it.
+        Clear();
+        return;
+    }
 
+    // Freshly allocated memory pages are zeroed, so this leaves every page unmapped.
     pointers.resize(num_page_table_entries);
-    attributes.resize(num_page_table_entries);
+    cached_pointers.resize(num_page_table_entries);
+    special_regions.clear();
+
+    attribute_leaves.clear();
+    attribute_leaves.resize(std::max<std::size_t>(num_page_table_entries >> LEAF_BITS, 1));
+    num_allocated_leaves = 0;
+}
+
+void PageTable::Clear() {
+    for (std::size_t leaf_index = 0; leaf_index < attribute_leaves.size(); ++leaf_index) {
+        auto& leaf = attribute_leaves[leaf_index];
+        if (!leaf) {
+            continue;
+        }
+
+        leaf->fill(PageType::Unmapped);
+        std::fill_n(&pointers[leaf_index << LEAF_BITS],
+                    std::min(LEAF_SIZE, pointers.size() - (leaf_index << LEAF_BITS)), nullptr);
+    }
+
+    special_regions.clear();
+}
+
+void PageTable::SetEntry(std::size_t page, u8* pointer, PageType type) {
+    auto& leaf = attribute_leaves[page >> LEAF_BITS];
+    if (!leaf) {
+        leaf = std::make_unique<AttributeLeaf>();
+        leaf->fill(PageType::Unmapped);
+        ++num_allocated_leaves;
+    }
+
+    (*leaf)[page & LEAF_MASK] = type;
+    if (type == PageType::RasterizerCachedMemory) {
+        pointers[page] = nullptr;
+        cached_pointers[page] = pointer;
+    } else {
+        pointers[page] = pointer;
+    }
+}
+
+std::size_t PageTable::GetResidentSize() const {
+    constexpr std::size_t leaf_size = sizeof(AttributeLeaf) + LEAF_SIZE * sizeof(u8*);
+    return attribute_leaves.capacity() * sizeof(attribute_leaves[0]) +
+           num_allocated_leaves * leaf_size;
 }
 
 static void MapPages(PageTable& page_table, VAddr base, u64 size, u8* memory, PageType type) {
@@ -62,12 +169,19 @@ static void MapPages(PageTable& page_table, VAddr base, u64 size, u8* memory, Pa
     RasterizerFlushVirtualRegion(base << PAGE_BITS, size * PAGE_SIZE,
                                  FlushMode::FlushAndInvalidate);
 
+    std::lock_guard<std::mutex> lock(page_table_mutex);
     VAddr end = base + size;
     while (base != end) {
-        ASSERT_MSG(base < page_table.pointers.size(), "out of range mapping at {:016X}", base);
+        ASSERT_MSG(base < page_table.GetNumEntries(), "out of range mapping at {:016X}", base);
+
+        // Pages within leaves that were never allocated are already unmapped, so unmapping them
+        // can skip the whole leaf instead of allocating it.
+        if (type == PageType::Unmapped && !page_table.IsLeafAllocated(base)) {
+            base = std::min(end, (base | PageTable::LEAF_MASK) + 1);
+            continue;
+        }
 
-        page_table.attributes[base] = type;
-        page_table.pointers[base] = memory;
+        page_table.SetEntry(base, memory, type);
 
         base += 1;
         if (memory != nullptr)
@@ -79,6 +193,7 @@ void MapMemoryRegion(PageTable& page_table, VAddr base, u64 size, u8* target) {
     ASSERT_MSG((size & PAGE_MASK) == 0, "non-page aligned size: {:016X}", size);
     ASSERT_MSG((base & PAGE_MASK) == 0, "non-page aligned base: {:016X}", base);
     MapPages(page_table, base / PAGE_SIZE, size / PAGE_SIZE, target, PageType::Memory);
+    InvalidateTLB();
 }
 
 void MapIoRegion(PageTable& page_table, VAddr base, u64 size, MemoryHookPointer mmio_handler) {
@@ -89,6 +204,7 @@ void MapIoRegion(PageTable& page_table, VAddr base, u64 size, MemoryHookPointer
     auto interval = boost::icl::discrete_interval<VAddr>::closed(base, base + size - 1);
     SpecialRegion region{SpecialRegion::Type::IODevice, std::move(mmio_handler)};
     page_table.special_regions.add(std::make_pair(interval, std::set<SpecialRegion>{region}));
+    InvalidateTLB();
 }
 
 void UnmapRegion(PageTable& page_table, VAddr base, u64 size) {
@@ -98,55 +214,159 @@ void UnmapRegion(PageTable& page_table, VAddr base, u64 size) {
 
     auto interval = boost::icl::discrete_interval<VAddr>::closed(base, base + size - 1);
     page_table.special_regions.erase(interval);
+    InvalidateTLB();
 }
 
 void AddDebugHook(PageTable& page_table, VAddr base, u64 size, MemoryHookPointer hook) {
     auto interval = boost::icl::discrete_interval<VAddr>::closed(base, base + size - 1);
     SpecialRegion region{SpecialRegion::Type::DebugHook, std::move(hook)};
     page_table.special_regions.add(std::make_pair(interval, std::set<SpecialRegion>{region}));
+    InvalidateTLB();
 }
 
 void RemoveDebugHook(PageTable& page_table, VAddr base, u64 size, MemoryHookPointer hook) {
     auto interval = boost::icl::discrete_interval<VAddr>::closed(base, base + size - 1);
     SpecialRegion region{SpecialRegion::Type::DebugHook, std::move(hook)};
     page_table.special_regions.subtract(std::make_pair(interval, std::set<SpecialRegion>{region}));
+    InvalidateTLB();
+}
+
+/// Gets the IO device handler backing the given address, or nullptr if there is none.
+static MemoryHook* GetMMIOHandler(const PageTable& page_table, VAddr vaddr) {
+    const auto iter = page_table.special_regions.find(vaddr);
+    if (iter == page_table.special_regions.end()) {
+        return nullptr;
+    }
+
+    for (const auto& region : iter->second) {
+        if (region.type == SpecialRegion::Type::IODevice) {
+            return region.handler.get();
+        }
+    }
+
+    return nullptr;
+}
+
+/// Determines whether the given page lies within a region that may be cached by the rasterizer.
+static bool IsRasterizerRegion(VAddr page_vaddr) {
+    const auto& vm_manager = Core::CurrentProcess()->VMManager();
+    const auto IsInRegion = [page_vaddr](VAddr region_start, VAddr region_end) {
+        return region_start <= page_vaddr && page_vaddr < region_end;
+    };
+
+    return IsInRegion(vm_manager.GetCodeRegionBaseAddress(),
+                      vm_manager.GetCodeRegionEndAddress()) ||
+           IsInRegion(vm_manager.GetHeapRegionBaseAddress(), vm_manager.GetHeapRegionEndAddress());
 }
 
 /**
- * Gets a pointer to the exact memory at the virtual address (i.e. not page aligned)
- * using a VMA from the current process
+ * Looks up the translation of the page containing the given address in the current thread's TLB,
+ * filling the entry from the current page table on a miss.
+ *
+ * @note The entry is returned by value, as flushing the rasterizer may reenter the memory
+ *       subsystem and evict it.
  */
-static u8* GetPointerFromVMA(const Kernel::Process& process, VAddr vaddr) {
-    u8* direct_pointer = nullptr;
+static TLBEntry LookupTLB(VAddr vaddr) {
+    const u64 generation = tlb_generation.load(std::memory_order_acquire);
+    if (tlb.generation != generation) {
+        tlb.entries.fill({});
+        tlb.generation = generation;
+    }
 
-    auto& vm_manager = process.VMManager();
+    const VAddr page = vaddr >> PAGE_BITS;
+    TLBEntry& entry = tlb.entries[page & (TLB_SIZE - 1)];
+    if (entry.tag == page) {
+        return entry;
+    }
 
-    auto it = vm_manager.FindVMA(vaddr);
-    ASSERT(it != vm_manager.vma_map.end());
+    std::lock_guard<std::mutex> lock(page_table_mutex);
+    entry = {};
+    entry.tag = page;
+    entry.type = current_page_table->GetAttribute(page);
 
-    auto& vma = it->second;
-    switch (vma.type) {
-    case Kernel::VMAType::AllocatedMemoryBlock:
-        direct_pointer = vma.backing_block->data() + vma.offset;
+    switch (entry.type) {
+    case PageType::Memory:
+        entry.pointer = current_page_table->pointers[page];
         break;
-    case Kernel::VMAType::BackingMemory:
-        direct_pointer = vma.backing_memory;
+    case PageType::RasterizerCachedMemory:
+        entry.pointer = current_page_table->cached_pointers[page];
+        entry.rasterizer_region = IsRasterizerRegion(page << PAGE_BITS);
+        break;
+    case PageType::Special:
+        entry.mmio_handler = GetMMIOHandler(*current_page_table, page << PAGE_BITS);
         break;
-    case Kernel::VMAType::Free:
-        return nullptr;
     default:
-        UNREACHABLE();
+        break;
     }
 
-    return direct_pointer + (vaddr - vma.base);
+    return entry;
 }
 
 /**
- * Gets a pointer to the exact memory at the virtual address (i.e. not page aligned)
- * using a VMA from the current process.
+ * Flushes the rasterizer caches for a region known to be within the code or heap region, skipping
+ * the region checks done by RasterizerFlushVirtualRegion.
  */
-static u8* GetPointerFromVMA(VAddr vaddr) {
-    return GetPointerFromVMA(*Core::CurrentProcess(), vaddr);
+static void FlushRasterizerRegion(VAddr start, u64 size, FlushMode mode) {
+    auto& system_instance = Core::System::GetInstance();
+
+    // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
+    // null here
+    if (!system_instance.IsPoweredOn()) {
+        return;
+    }
+
+    auto& gpu = system_instance.GPU();
+    switch (mode) {
+    case FlushMode::Flush:
+        gpu.FlushRegion(start, size);
+        break;
+    case FlushMode::Invalidate:
+        // Invalidations only ever come from CPU writes, which the rasterizer may batch
+        gpu.OnCPUWrite(start, size);
+        break;
+    case FlushMode::FlushAndInvalidate:
+        gpu.FlushAndInvalidateRegion(start, size);
+        break;
+    }
+}
+
+template <typename T>
+static T ReadMMIO(MemoryHook* mmio_handler, VAddr vaddr) {
+    if (mmio_handler == nullptr) {
+        LOG_ERROR(HW_Memory, "Special Read{} without a handler @ 0x{:016X}", sizeof(T) * 8, vaddr);
+        return 0;
+    }
+
+    boost::optional<T> value;
+    if constexpr (sizeof(T) == 1) {
+        value = mmio_handler->Read8(vaddr);
+    } else if constexpr (sizeof(T) == 2) {
+        value = mmio_handler->Read16(vaddr);
+    } else if constexpr (sizeof(T) == 4) {
+        value = mmio_handler->Read32(vaddr);
+    } else {
+        value = mmio_handler->Read64(vaddr);
+    }
+    return value.value_or(0);
+}
+
+template <typename T>
+static void WriteMMIO(MemoryHook* mmio_handler, VAddr vaddr, T data) {
+    if (mmio_handler == nullptr) {
+        LOG_ERROR(HW_Memory, "Special Write{} without a handler @ 0x{:016X}", sizeof(T) * 8,
+                  vaddr);
+        return;
+    }
+
+    if constexpr (sizeof(T) == 1) {
+        mmio_handler->Write8(vaddr, data);
+    } else if constexpr (sizeof(T) == 2) {
+        mmio_handler->Write16(vaddr, data);
+    } else if constexpr (sizeof(T) == 4) {
+        mmio_handler->Write32(vaddr, data);
+    } else {
+        mmio_handler->Write64(vaddr, data);
+    }
 }
 
 template <typename T>
@@ -162,8 +382,8 @@ T Read(const VAddr vaddr) {
     // The memory access might do an MMIO or cached access, so we have to lock the HLE kernel state
     std::lock_guard<std::recursive_mutex> lock(HLE::g_hle_lock);
 
-    PageType type = current_page_table->attributes[vaddr >> PAGE_BITS];
-    switch (type) {
+    const TLBEntry entry = LookupTLB(vaddr);
+    switch (entry.type) {
     case PageType::Unmapped:
         LOG_ERROR(HW_Memory, "Unmapped Read{} @ 0x{:08X}", sizeof(T) * 8, vaddr);
         return 0;
@@ -171,15 +391,20 @@ T Read(const VAddr vaddr) {
         ASSERT_MSG(false, "Mapped memory page without a pointer @ {:016X}", vaddr);
         break;
     case PageType::RasterizerCachedMemory: {
-        RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Flush);
+        if (entry.rasterizer_region) {
+            FlushRasterizerRegion(vaddr, sizeof(T), FlushMode::Flush);
+        }
 
         T value;
-        std::memcpy(&value, GetPointerFromVMA(vaddr), sizeof(T));
+        std::memcpy(&value, &entry.pointer[vaddr & PAGE_MASK], sizeof(T));
         return value;
     }
+    case PageType::Special:
+        return ReadMMIO<T>(entry.mmio_handler, vaddr);
     default:
         UNREACHABLE();
     }
+    return {};
 }
 
 template <typename T>
@@ -194,8 +419,8 @@ void Write(const VAddr vaddr, const T data) {
     // The memory access might do an MMIO or cached access, so we have to lock the HLE kernel state
     std::lock_guard<std::recursive_mutex> lock(HLE::g_hle_lock);
 
-    PageType type = current_page_table->attributes[vaddr >> PAGE_BITS];
-    switch (type) {
+    const TLBEntry entry = LookupTLB(vaddr);
+    switch (entry.type) {
     case PageType::Unmapped:
         LOG_ERROR(HW_Memory, "Unmapped Write{} 0x{:08X} @ 0x{:016X}", sizeof(data) * 8,
                   static_cast<u32>(data), vaddr);
@@ -204,10 +429,15 @@ void Write(const VAddr vaddr, const T data) {
         ASSERT_MSG(false, "Mapped memory page without a pointer @ {:016X}", vaddr);
         break;
     case PageType::RasterizerCachedMemory: {
-        RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Invalidate);
-        std::memcpy(GetPointerFromVMA(vaddr), &data, sizeof(T));
+        if (entry.rasterizer_region) {
+            FlushRasterizerRegion(vaddr, sizeof(T), FlushMode::Invalidate);
+        }
+        std::memcpy(&entry.pointer[vaddr & PAGE_MASK], &data, sizeof(T));
         break;
     }
+    case PageType::Special:
+        WriteMMIO<T>(entry.mmio_handler, vaddr, data);
+        break;
     default:
         UNREACHABLE();
     }
@@ -220,10 +450,10 @@ bool IsValidVirtualAddress(const Kernel::Process& process, const VAddr vaddr) {
     if (page_pointer)
         return true;
 
-    if (page_table.attributes[vaddr >> PAGE_BITS] == PageType::RasterizerCachedMemory)
+    if (page_table.GetAttribute(vaddr >> PAGE_BITS) == PageType::RasterizerCachedMemory)
         return true;
 
-    if (page_table.attributes[vaddr >> PAGE_BITS] != PageType::Special)
+    if (page_table.GetAttribute(vaddr >> PAGE_BITS) != PageType::Special)
         return false;
 
     return false;
@@ -243,8 +473,9 @@ u8* GetPointer(const VAddr vaddr) {
         return page_pointer + (vaddr & PAGE_MASK);
     }
 
-    if (current_page_table->attributes[vaddr >> PAGE_BITS] == PageType::RasterizerCachedMemory) {
-        return GetPointerFromVMA(vaddr);
+    std::lock_guard<std::mutex> lock(page_table_mutex);
+    if (current_page_table->GetAttribute(vaddr >> PAGE_BITS) == PageType::RasterizerCachedMemory) {
+        return current_page_table->cached_pointers[vaddr >> PAGE_BITS] + (vaddr & PAGE_MASK);
     }
 
     LOG_ERROR(HW_Memory, "Unknown GetPointer @ 0x{:016X}", vaddr);
@@ -275,9 +506,14 @@ void RasterizerMarkRegionCached(VAddr vaddr, u64 size, bool cached) {
     // CPU pages, hence why we iterate on a CPU page basis (note: GPU page size is different). This
     // assumes the specified GPU address region is contiguous as well.
 
+    // With the asynchronous GPU this runs on the GPU thread, which must not take the HLE lock. The
+    // cached pages keep their backing pointer in the page table, so no VMA has to be looked up.
+    std::lock_guard<std::mutex> lock(page_table_mutex);
+
     u64 num_pages = ((vaddr + size - 1) >> PAGE_BITS) - (vaddr >> PAGE_BITS) + 1;
     for (unsigned i = 0; i < num_pages; ++i, vaddr += PAGE_SIZE) {
-        PageType& page_type = current_page_table->attributes[vaddr >> PAGE_BITS];
+        const std::size_t page = vaddr >> PAGE_BITS;
+        const PageType page_type = current_page_table->GetAttribute(page);
 
         if (cached) {
             // Switch page type to cached if now cached
@@ -287,8 +523,8 @@ void RasterizerMarkRegionCached(VAddr vaddr, u64 size, bool cached) {
                 // space, for example, a system module need not have a VRAM mapping.
                 break;
             case PageType::Memory:
-                page_type = PageType::RasterizerCachedMemory;
-                current_page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
+                current_page_table->SetEntry(page, current_page_table->pointers[page],
+                                             PageType::RasterizerCachedMemory);
                 break;
             case PageType::RasterizerCachedMemory:
                 // There can be more than one GPU region mapped per CPU region, so it's common that
@@ -308,24 +544,17 @@ void RasterizerMarkRegionCached(VAddr vaddr, u64 size, bool cached) {
                 // There can be more than one GPU region mapped per CPU region, so it's common that
                 // this area is already unmarked as cached.
                 break;
-            case PageType::RasterizerCachedMemory: {
-                u8* pointer = GetPointerFromVMA(vaddr & ~PAGE_MASK);
-                if (pointer == nullptr) {
-                    // It's possible that this function has been called while updating the pagetable
-                    // after unmapping a VMA. In that case the underlying VMA will no longer exist,
-                    // and we should just leave the pagetable entry blank.
-                    page_type = PageType::Unmapped;
-                } else {
-                    page_type = PageType::Memory;
-                    current_page_table->pointers[vaddr >> PAGE_BITS] = pointer;
-                }
+            case PageType::RasterizerCachedMemory:
+                current_page_table->SetEntry(page, current_page_table->cached_pointers[page],
+                                             PageType::Memory);
                 break;
-            }
             default:
                 UNREACHABLE();
             }
         }
     }
+
+    InvalidateTLB();
 }
 
 void RasterizerFlushVirtualRegion(VAddr start, u64 size, FlushMode mode) {
@@ -349,18 +578,7 @@ void RasterizerFlushVirtualRegion(VAddr start, u64 size, FlushMode mode) {
         const VAddr overlap_end = std::min(end, region_end);
         const VAddr overlap_size = overlap_end - overlap_start;
 
-        auto& rasterizer = system_instance.Renderer().Rasterizer();
-        switch (mode) {
-        case FlushMode::Flush:
-            rasterizer.FlushRegion(overlap_start, overlap_size);
-            break;
-        case FlushMode::Invalidate:
-            rasterizer.InvalidateRegion(overlap_start, overlap_size);
-            break;
-        case FlushMode::FlushAndInvalidate:
-            rasterizer.FlushAndInvalidateRegion(overlap_start, overlap_size);
-            break;
-        }
+        FlushRasterizerRegion(overlap_start, overlap_size, mode);
     };
 
     const auto& vm_manager = Core::CurrentProcess()->VMManager();
@@ -369,6 +587,114 @@ void RasterizerFlushVirtualRegion(VAddr start, u64 size, FlushMode mode) {
     CheckRegion(vm_manager.GetHeapRegionBaseAddress(), vm_manager.GetHeapRegionEndAddress());
 }
 
+/**
+ * Extends a block access starting within a Memory page over the following pages for as long as
+ * their host backing memory stays contiguous, which is the case for all pages backed by the same
+ * VMA. This allows block operations to be done with a single host copy instead of one per page.
+ * The page table lock must be held.
+ *
+ * @returns The number of bytes, at most `size`, reachable through the first page's pointer.
+ */
+static std::size_t GetContiguousMemorySize(const PageTable& page_table, std::size_t page_index,
+                                           std::size_t page_offset, std::size_t size) {
+    std::size_t contiguous_size = static_cast<std::size_t>(PAGE_SIZE) - page_offset;
+    const u8* next_pointer = page_table.pointers[page_index] + PAGE_SIZE;
+
+    while (contiguous_size < size) {
+        ++page_index;
+        if (page_table.GetAttribute(page_index) != PageType::Memory ||
+            page_table.pointers[page_index] != next_pointer) {
+            break;
+        }
+
+        contiguous_size += static_cast<std::size_t>(PAGE_SIZE);
+        next_pointer += PAGE_SIZE;
+    }
+
+    return std::min(contiguous_size, size);
+}
+
+namespace {
+/// Part of a block access that is done through a single host pointer.
+struct BlockRun {
+    /// Attribute of the pages of the run.
+    PageType type;
+    /// Host memory at the start of the run, for Memory and RasterizerCachedMemory pages.
+    u8* pointer;
+    /// Number of bytes of the run.
+    std::size_t size;
+};
+} // Anonymous namespace
+
+/**
+ * Resolves the run a block access of `size` bytes starting at the given page and offset begins
+ * with. Runs of Memory pages extend over the following pages that are contiguous in host memory,
+ * other runs end with their page. Rasterizer cached runs still have to be flushed, which is left
+ * to the caller as it may not be done while holding the page table lock.
+ */
+static BlockRun ResolveBlockRun(const PageTable& page_table, std::size_t page_index,
+                                std::size_t page_offset, std::size_t size) {
+    std::lock_guard<std::mutex> lock(page_table_mutex);
+
+    BlockRun run{page_table.GetAttribute(page_index), nullptr,
+                 std::min(static_cast<std::size_t>(PAGE_SIZE) - page_offset, size)};
+    switch (run.type) {
+    case PageType::Memory:
+        DEBUG_ASSERT(page_table.pointers[page_index]);
+        run.pointer = page_table.pointers[page_index] + page_offset;
+        run.size = GetContiguousMemorySize(page_table, page_index, page_offset, size);
+        break;
+    case PageType::RasterizerCachedMemory:
+        run.pointer = page_table.cached_pointers[page_index] + page_offset;
+        break;
+    default:
+        break;
+    }
+    return run;
+}
+
+u8* GetContiguousPointer(const VAddr vaddr, const std::size_t size) {
+    const std::size_t page_index = vaddr >> PAGE_BITS;
+    const std::size_t page_offset = vaddr & PAGE_MASK;
+    const std::size_t last_page_index = (vaddr + std::max<std::size_t>(size, 1) - 1) >> PAGE_BITS;
+
+    const PageTable& page_table = *current_page_table;
+    if (last_page_index >= page_table.GetNumEntries() || last_page_index < page_index) {
+        return nullptr;
+    }
+
+    const BlockRun run = ResolveBlockRun(page_table, page_index, page_offset, size);
+    if (run.type != PageType::Memory || run.size < size) {
+        return nullptr;
+    }
+    return run.pointer;
+}
+
+u8* GetWritePointer(const VAddr vaddr, const std::size_t size, std::size_t& run_size) {
+    const std::size_t page_index = vaddr >> PAGE_BITS;
+    const std::size_t page_offset = vaddr & PAGE_MASK;
+    run_size = 0;
+
+    const PageTable& page_table = *current_page_table;
+    if (size == 0 || page_index >= page_table.GetNumEntries()) {
+        return nullptr;
+    }
+
+    const BlockRun run = ResolveBlockRun(page_table, page_index, page_offset, size);
+    switch (run.type) {
+    case PageType::Memory:
+        run_size = run.size;
+        return run.pointer;
+    case PageType::RasterizerCachedMemory:
+        // Cached pages are written one at a time, as in WriteBlock.
+        run_size = run.size;
+        RasterizerFlushVirtualRegion(vaddr, run_size, FlushMode::Invalidate);
+        return run.pointer;
+    default:
+        return nullptr;
+    }
+}
+
 u8 Read8(const VAddr addr) {
     return Read<u8>(addr);
 }
@@ -394,11 +720,11 @@ void ReadBlock(const Kernel::Process& process, const VAddr src_addr, void* dest_
     std::size_t page_offset = src_addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const std::size_t copy_amount =
-            std::min(static_cast<std::size_t>(PAGE_SIZE) - page_offset, remaining_size);
+        const BlockRun run = ResolveBlockRun(page_table, page_index, page_offset, remaining_size);
+        const std::size_t copy_amount = run.size;
         const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
 
-        switch (page_table.attributes[page_index]) {
+        switch (run.type) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory,
                       "Unmapped ReadBlock @ 0x{:016X} (start address = 0x{:016X}, size = {})",
@@ -407,24 +733,21 @@ void ReadBlock(const Kernel::Process& process, const VAddr src_addr, void* dest_
             break;
         }
         case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-
-            const u8* src_ptr = page_table.pointers[page_index] + page_offset;
-            std::memcpy(dest_buffer, src_ptr, copy_amount);
+            std::memcpy(dest_buffer, run.pointer, copy_amount);
             break;
         }
         case PageType::RasterizerCachedMemory: {
             RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
                                          FlushMode::Flush);
-            std::memcpy(dest_buffer, GetPointerFromVMA(process, current_vaddr), copy_amount);
+            std::memcpy(dest_buffer, run.pointer, copy_amount);
             break;
         }
         default:
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        page_index += (page_offset + copy_amount) >> PAGE_BITS;
+        page_offset = (page_offset + copy_amount) & PAGE_MASK;
         dest_buffer = static_cast<u8*>(dest_buffer) + copy_amount;
         remaining_size -= copy_amount;
     }
@@ -458,11 +781,11 @@ void WriteBlock(const Kernel::Process& process, const VAddr dest_addr, const voi
     std::size_t page_offset = dest_addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const std::size_t copy_amount =
-            std::min(static_cast<std::size_t>(PAGE_SIZE) - page_offset, remaining_size);
+        const BlockRun run = ResolveBlockRun(page_table, page_index, page_offset, remaining_size);
+        const std::size_t copy_amount = run.size;
         const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
 
-        switch (page_table.attributes[page_index]) {
+        switch (run.type) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory,
                       "Unmapped WriteBlock @ 0x{:016X} (start address = 0x{:016X}, size = {})",
@@ -470,24 +793,21 @@ void WriteBlock(const Kernel::Process& process, const VAddr dest_addr, const voi
             break;
         }
         case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-
-            u8* dest_ptr = page_table.pointers[page_index] + page_offset;
-            std::memcpy(dest_ptr, src_buffer, copy_amount);
+            std::memcpy(run.pointer, src_buffer, copy_amount);
             break;
         }
         case PageType::RasterizerCachedMemory: {
             RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
                                          FlushMode::Invalidate);
-            std::memcpy(GetPointerFromVMA(process, current_vaddr), src_buffer, copy_amount);
+            std::memcpy(run.pointer, src_buffer, copy_amount);
             break;
         }
         default:
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        page_index += (page_offset + copy_amount) >> PAGE_BITS;
+        page_offset = (page_offset + copy_amount) & PAGE_MASK;
         src_buffer = static_cast<const u8*>(src_buffer) + copy_amount;
         remaining_size -= copy_amount;
     }
@@ -504,11 +824,11 @@ void ZeroBlock(const Kernel::Process& process, const VAddr dest_addr, const std:
     std::size_t page_offset = dest_addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const std::size_t copy_amount =
-            std::min(static_cast<std::size_t>(PAGE_SIZE) - page_offset, remaining_size);
+        const BlockRun run = ResolveBlockRun(page_table, page_index, page_offset, remaining_size);
+        const std::size_t copy_amount = run.size;
         const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
 
-        switch (page_table.attributes[page_index]) {
+        switch (run.type) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory,
                       "Unmapped ZeroBlock @ 0x{:016X} (start address = 0x{:016X}, size = {})",
@@ -516,24 +836,21 @@ void ZeroBlock(const Kernel::Process& process, const VAddr dest_addr, const std:
             break;
         }
         case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-
-            u8* dest_ptr = page_table.pointers[page_index] + page_offset;
-            std::memset(dest_ptr, 0, copy_amount);
+            std::memset(run.pointer, 0, copy_amount);
             break;
         }
         case PageType::RasterizerCachedMemory: {
             RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
                                          FlushMode::Invalidate);
-            std::memset(GetPointerFromVMA(process, current_vaddr), 0, copy_amount);
+            std::memset(run.pointer, 0, copy_amount);
             break;
         }
         default:
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        page_index += (page_offset + copy_amount) >> PAGE_BITS;
+        page_offset = (page_offset + copy_amount) & PAGE_MASK;
         remaining_size -= copy_amount;
     }
 }
@@ -546,11 +863,11 @@ void CopyBlock(const Kernel::Process& process, VAddr dest_addr, VAddr src_addr,
     std::size_t page_offset = src_addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const std::size_t copy_amount =
-            std::min(static_cast<std::size_t>(PAGE_SIZE) - page_offset, remaining_size);
+        const BlockRun run = ResolveBlockRun(page_table, page_index, page_offset, remaining_size);
+        const std::size_t copy_amount = run.size;
         const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
 
-        switch (page_table.attributes[page_index]) {
+        switch (run.type) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory,
                       "Unmapped CopyBlock @ 0x{:016X} (start address = 0x{:016X}, size = {})",
@@ -559,23 +876,21 @@ void CopyBlock(const Kernel::Process& process, VAddr dest_addr, VAddr src_addr,
             break;
         }
         case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-            const u8* src_ptr = page_table.pointers[page_index] + page_offset;
-            WriteBlock(process, dest_addr, src_ptr, copy_amount);
+            WriteBlock(process, dest_addr, run.pointer, copy_amount);
             break;
         }
         case PageType::RasterizerCachedMemory: {
             RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
                                          FlushMode::Flush);
-            WriteBlock(process, dest_addr, GetPointerFromVMA(process, current_vaddr), copy_amount);
+            WriteBlock(process, dest_addr, run.pointer, copy_amount);
             break;
         }
         default:
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        page_index += (page_offset + copy_amount) >> PAGE_BITS;
+        page_offset = (page_offset + copy_amount) & PAGE_MASK;
         dest_addr += static_cast<VAddr>(copy_amount);
         src_addr += static_cast<VAddr>(copy_amount);
         remaining_size -= copy_amount;
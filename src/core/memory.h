@@ -4,12 +4,15 @@
 
 #pragma once
 
+#include <array>
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
 #include <boost/icl/interval_map.hpp>
 #include "common/common_types.h"
+#include "common/virtual_buffer.h"
 #include "core/memory_hook.h"
 
 namespace Kernel {
@@ -58,37 +61,95 @@ struct SpecialRegion {
 /**
  * A (reasonably) fast way of allowing switchable and remappable process address spaces. It loosely
  * mimics the way a real CPU page table works.
+ *
+ * Page attributes are stored in a sparse two-level table whose leaves are only allocated once a
+ * page within them is mapped, as guest address spaces are mostly empty. The backing pointers are
+ * kept as a flat array for the JIT, but it is allocated lazily from the host so that only the
+ * parts covered by allocated leaves are ever committed. The same goes for the backing pointers of
+ * rasterizer cached pages, which are only committed for pages that have been cached.
  */
 struct PageTable {
+    /**
+     * Number of pages covered by each leaf of the attribute table. A leaf covers exactly one host
+     * page worth of entries in `pointers`.
+     */
+    static constexpr std::size_t LEAF_BITS = 9;
+    static constexpr std::size_t LEAF_SIZE = 1ULL << LEAF_BITS;
+    static constexpr std::size_t LEAF_MASK = LEAF_SIZE - 1;
+
     explicit PageTable();
     explicit PageTable(std::size_t address_space_width_in_bits);
     ~PageTable();
 
     /**
      * Resizes the page table to be able to accomodate enough pages within
-     * a given address space.
+     * a given address space. All pages are unmapped afterwards.
      *
      * @param address_space_width_in_bits The address size width in bits.
      */
     void Resize(std::size_t address_space_width_in_bits);
 
+    /// Unmaps every page and removes all special regions, keeping allocated leaves around.
+    void Clear();
+
+    /// Gets the total number of pages within the page table.
+    std::size_t GetNumEntries() const {
+        return pointers.size();
+    }
+
+    /// Gets the attribute of the given page.
+    PageType GetAttribute(std::size_t page) const {
+        const auto& leaf = attribute_leaves[page >> LEAF_BITS];
+        return leaf ? (*leaf)[page & LEAF_MASK] : PageType::Unmapped;
+    }
+
+    /**
+     * Sets the backing pointer and attribute of the given page, allocating the leaf containing it
+     * if necessary. The pointer must be null unless the attribute is `Memory` or
+     * `RasterizerCachedMemory`.
+     */
+    void SetEntry(std::size_t page, u8* pointer, PageType type);
+
+    /**
+     * Determines whether the leaf containing the given page has been allocated. All pages within
+     * a leaf that isn't allocated are unmapped.
+     */
+    bool IsLeafAllocated(std::size_t page) const {
+        return attribute_leaves[page >> LEAF_BITS] != nullptr;
+    }
+
+    /// Gets the amount of host memory committed to the populated parts of the table, in bytes.
+    std::size_t GetResidentSize() const;
+
     /**
-     * Vector of memory pointers backing each page. An entry can only be non-null if the
-     * corresponding entry in the `attributes` vector is of type `Memory`.
+     * Flat array of memory pointers backing each page. An entry can only be non-null if the
+     * corresponding page attribute is of type `Memory`. It must only be modified via SetEntry.
      */
-    std::vector<u8*> pointers;
+    Common::VirtualBuffer<u8*> pointers;
 
     /**
-     * Contains MMIO handlers that back memory regions whose entries in the `attribute` vector is
-     * of type `Special`.
+     * Flat array of memory pointers backing each page whose attribute is of type
+     * `RasterizerCachedMemory`, as their entry in `pointers` is null. Entries of other pages are
+     * meaningless. It must only be modified via SetEntry.
+     */
+    Common::VirtualBuffer<u8*> cached_pointers;
+
+    /**
+     * Contains MMIO handlers that back memory regions whose page attributes are of type `Special`.
      */
     boost::icl::interval_map<VAddr, std::set<SpecialRegion>> special_regions;
 
+private:
+    using AttributeLeaf = std::array<PageType, LEAF_SIZE>;
+
     /**
-     * Vector of fine grained page attributes. If it is set to any value other than `Memory`, then
-     * the corresponding entry in `pointers` MUST be set to null.
+     * Top level of the fine grained page attributes. If a page attribute is set to any value
+     * other than `Memory`, then the corresponding entry in `pointers` MUST be set to null.
      */
-    std::vector<PageType> attributes;
+    std::vector<std::unique_ptr<AttributeLeaf>> attribute_leaves;
+
+    /// Number of non-null entries within `attribute_leaves`.
+    std::size_t num_allocated_leaves = 0;
 };
 
 /// Virtual user-space memory regions
@@ -125,6 +186,11 @@ bool IsValidVirtualAddress(VAddr vaddr);
 /// Determines if the given VAddr is a kernel address
 bool IsKernelVirtualAddress(VAddr vaddr);
 
+/*
+ * The slow path of the single value accesses takes the HLE lock, which the GPU thread must never
+ * take. The GPU thread accesses guest memory through the block functions and GetPointer instead,
+ * which only synchronize with the page table.
+ */
 u8 Read8(VAddr addr);
 u16 Read16(VAddr addr);
 u32 Read32(VAddr addr);
@@ -145,6 +211,26 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, std::size_t size);
 
 u8* GetPointer(VAddr vaddr);
 
+/**
+ * Gets a pointer to a region of the current page table if it is entirely backed by regular memory
+ * pages that are contiguous in host memory. Unlike GetPointer, failing is not an error, the region
+ * then has to be accessed through ReadBlock and WriteBlock instead.
+ *
+ * @returns The pointer to the start of the region, or nullptr.
+ */
+u8* GetContiguousPointer(VAddr vaddr, std::size_t size);
+
+/**
+ * Gets a pointer through which the host can write guest memory of the current page table in
+ * place, such as when an HLE service fills an output buffer. `run_size` receives how many of the
+ * `size` bytes starting at vaddr can be written through the pointer, which is less than `size`
+ * when the region isn't contiguous in host memory. Rasterizer cached pages of the run are
+ * invalidated like WriteBlock does, so the run has to be written to right away.
+ *
+ * @returns The pointer to the start of the run, or nullptr if vaddr isn't backed by memory.
+ */
+u8* GetWritePointer(VAddr vaddr, std::size_t size, std::size_t& run_size);
+
 std::string ReadCString(VAddr vaddr, std::size_t max_length);
 
 enum class FlushMode {
@@ -138,6 +138,11 @@ struct Values {
     bool use_frame_limit;
     u16 frame_limit;
     bool use_accurate_gpu_emulation;
+    bool use_asynchronous_gpu_emulation;
+    bool use_null_renderer;
+    bool use_macro_jit;
+    bool use_disk_shader_cache;
+    bool use_asynchronous_shaders;
 
     float bg_red;
     float bg_green;
@@ -157,6 +162,7 @@ struct Values {
     bool use_gdbstub;
     u16 gdbstub_port;
     std::string program_args;
+    bool verify_macro_jit;
 
     // WebService
     bool enable_telemetry;
@@ -0,0 +1,55 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/thread_pool.h"
+
+namespace Common {
+
+TEST_CASE("ThreadPool: Submitted tasks return their results", "[common]") {
+    for (const std::size_t num_threads : {0, 1, 4}) {
+        ThreadPool pool(num_threads);
+        REQUIRE(pool.NumThreads() == num_threads);
+
+        std::vector<std::future<std::size_t>> results;
+        for (std::size_t i = 0; i < 100; ++i) {
+            results.push_back(pool.Submit([i] { return i * i; }));
+        }
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            REQUIRE(results[i].get() == i * i);
+        }
+    }
+}
+
+TEST_CASE("ThreadPool: ParallelFor visits every index once", "[common]") {
+    for (const std::size_t num_threads : {0, 1, 3}) {
+        ThreadPool pool(num_threads);
+        for (const std::size_t count : {0, 1, 2, 1000}) {
+            std::vector<std::atomic<int>> visits(count);
+            pool.ParallelFor(count, [&](std::size_t index) { ++visits[index]; });
+
+            bool visited_once = true;
+            for (const auto& visit : visits) {
+                visited_once &= visit == 1;
+            }
+            REQUIRE(visited_once);
+        }
+    }
+}
+
+TEST_CASE("ThreadPool: ParallelFor can be nested in tasks of the same pool", "[common]") {
+    ThreadPool pool(1);
+    std::atomic<std::size_t> sum{0};
+    pool.Submit([&] {
+            pool.ParallelFor(64, [&](std::size_t index) { sum += index; });
+        })
+        .get();
+    REQUIRE(sum == 64 * 63 / 2);
+}
+
+} // namespace Common
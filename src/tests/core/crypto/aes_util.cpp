@@ -0,0 +1,150 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "common/hex_util.h"
+#include "core/crypto/aes_util.h"
+#include "core/crypto/key_manager.h"
+#include "tests/test_common.h"
+
+namespace Core::Crypto {
+namespace {
+
+constexpr std::array<Backend, 2> backends{Backend::Default, Backend::MbedTLS};
+
+template <typename Key>
+Key RandomKey(std::mt19937& rng) {
+    Key key;
+    const auto bytes = TestCommon::RandomBytes(key.size(), rng);
+    std::copy(bytes.begin(), bytes.end(), key.begin());
+    return key;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("AESCipher: Known answers", "[core][crypto]") {
+    for (const Backend backend : backends) {
+        // FIPS-197 appendix C.1
+        AESCipher<Key128> ecb(Common::HexStringToArray<0x10>("000102030405060708090a0b0c0d0e0f"),
+                              Mode::ECB, backend);
+        const auto block = Common::HexStringToVector("00112233445566778899aabbccddeeff", false);
+        std::vector<u8> encrypted(block.size());
+        ecb.Transcode(block.data(), block.size(), encrypted.data(), Op::Encrypt);
+        REQUIRE(encrypted ==
+                Common::HexStringToVector("69c4e0d86a7b0430d8cdb78070b4c55a", false));
+
+        // SP 800-38A F.5.1, in two calls to check the counter is carried over
+        AESCipher<Key128> ctr(Common::HexStringToArray<0x10>("2b7e151628aed2a6abf7158809cf4f3c"),
+                              Mode::CTR, backend);
+        ctr.SetIV(Common::HexStringToVector("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff", false));
+        const auto plaintext = Common::HexStringToVector(
+            "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51", false);
+        std::vector<u8> ciphertext(plaintext.size());
+        ctr.Transcode(plaintext.data(), 0x10, ciphertext.data(), Op::Encrypt);
+        ctr.Transcode(plaintext.data() + 0x10, 0x10, ciphertext.data() + 0x10, Op::Encrypt);
+        REQUIRE(ciphertext ==
+                Common::HexStringToVector(
+                    "874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff", false));
+
+        // IEEE 1619 vector 2
+        AESCipher<Key256> xts(
+            Common::HexStringToArray<0x20>(
+                "1111111111111111111111111111111122222222222222222222222222222222"),
+            Mode::XTS, backend);
+        xts.SetIV(Common::HexStringToVector("33333333330000000000000000000000", false));
+        const std::vector<u8> unit(0x20, 0x44);
+        std::vector<u8> encrypted_unit(unit.size());
+        xts.Transcode(unit.data(), unit.size(), encrypted_unit.data(), Op::Encrypt);
+        REQUIRE(encrypted_unit ==
+                Common::HexStringToVector(
+                    "c454185e6a16936e39334038acef838bfb186fff7480adc4289382ecd6d394f0", false));
+    }
+}
+
+TEST_CASE("AESCipher: Backends produce identical output", "[core][crypto]") {
+    std::mt19937 rng(0xAE5);
+    for (int iteration = 0; iteration < 64; ++iteration) {
+        const auto key128 = RandomKey<Key128>(rng);
+        const auto key256 = RandomKey<Key256>(rng);
+        const auto iv = TestCommon::RandomBytes(0x10, rng);
+        const auto data = TestCommon::RandomBytes(0x4000 + rng() % 0x200, rng);
+        const std::size_t split = rng() % data.size();
+        const std::size_t sector_size = iteration % 2 == 0 ? 0x200 : 0x4000;
+        const std::size_t xts_size = data.size() - data.size() % sector_size;
+
+        std::array<std::vector<u8>, backends.size()> ctr_output;
+        std::array<std::vector<u8>, backends.size()> ecb_output;
+        std::array<std::vector<u8>, backends.size()> xts_output;
+        std::array<std::vector<u8>, backends.size()> xts_unit_output;
+        for (std::size_t i = 0; i < backends.size(); ++i) {
+            const Op op = iteration % 3 == 0 ? Op::Encrypt : Op::Decrypt;
+
+            AESCipher<Key128> ctr(key128, Mode::CTR, backends[i]);
+            ctr.SetIV(iv);
+            ctr_output[i].resize(data.size());
+            ctr.Transcode(data.data(), split, ctr_output[i].data(), op);
+            ctr.Transcode(data.data() + split, data.size() - split, ctr_output[i].data() + split,
+                          op);
+
+            AESCipher<Key128> ecb(key128, Mode::ECB, backends[i]);
+            ecb_output[i].resize(data.size());
+            ecb.Transcode(data.data(), data.size(), ecb_output[i].data(), op);
+
+            AESCipher<Key256> xts(key256, Mode::XTS, backends[i]);
+            xts_output[i].resize(xts_size);
+            xts.XTSTranscode(data.data(), xts_size, xts_output[i].data(), iteration, sector_size,
+                             op);
+
+            // Units that are not a whole number of blocks use ciphertext stealing
+            const std::size_t unit_size = 0x10 + split % 0x1F0;
+            xts.SetIV(iv);
+            xts_unit_output[i].resize(unit_size);
+            xts.Transcode(data.data(), unit_size, xts_unit_output[i].data(), op);
+        }
+        REQUIRE(ctr_output[0] == ctr_output[1]);
+        REQUIRE(ecb_output[0] == ecb_output[1]);
+        REQUIRE(xts_output[0] == xts_output[1]);
+        REQUIRE(xts_unit_output[0] == xts_unit_output[1]);
+    }
+}
+
+TEST_CASE("AESCipher: Throughput", "[.benchmark][core][crypto]") {
+    constexpr std::size_t size = 0x4000000;
+    std::mt19937 rng(0xBE7C);
+    const auto data = TestCommon::RandomBytes(size, rng);
+    std::vector<u8> output(size);
+
+    const auto measure = [&](auto&& transcode) {
+        const auto elapsed = TestCommon::MeasureTime(transcode);
+        return size / elapsed.count() / 1e9;
+    };
+
+    for (const Backend backend : backends) {
+        AESCipher<Key128> ctr(RandomKey<Key128>(rng), Mode::CTR, backend);
+        AESCipher<Key128> ecb(RandomKey<Key128>(rng), Mode::ECB, backend);
+        AESCipher<Key256> xts(RandomKey<Key256>(rng), Mode::XTS, backend);
+        ctr.SetIV(std::vector<u8>(0x10));
+
+        const double ctr_speed = measure(
+            [&] { ctr.Transcode(data.data(), data.size(), output.data(), Op::Decrypt); });
+        const double ecb_speed = measure(
+            [&] { ecb.Transcode(data.data(), data.size(), output.data(), Op::Decrypt); });
+        const double xts_speed = measure([&] {
+            xts.XTSTranscode(data.data(), data.size(), output.data(), 0, 0x4000, Op::Decrypt);
+        });
+        TestCommon::ReportBenchmark(
+            fmt::format("AES {} backend", backend == Backend::Default ? "default" : "mbedtls"),
+            fmt::format("CTR: {:>6.2f} GB/s, ECB: {:>6.2f} GB/s, XTS: {:>6.2f} GB/s", ctr_speed,
+                        ecb_speed, xts_speed));
+    }
+}
+
+} // namespace Core::Crypto
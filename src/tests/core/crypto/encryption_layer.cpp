@@ -0,0 +1,162 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "common/scope_exit.h"
+#include "core/crypto/aes_util.h"
+#include "core/crypto/ctr_encryption_layer.h"
+#include "core/crypto/xts_encryption_layer.h"
+#include "core/file_sys/vfs_vector.h"
+#include "tests/test_common.h"
+
+namespace Core::Crypto {
+namespace {
+
+constexpr std::size_t XTS_SECTOR_SIZE = 0x4000;
+
+/// Encrypts the data as CTREncryption layer expects it at the start of its section
+std::shared_ptr<CTREncryptionLayer> MakeCTRLayer(const std::vector<u8>& plaintext,
+                                                 std::size_t base_offset) {
+    const Key128 key{0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE};
+    AESCipher<Key128> cipher(key, Mode::CTR);
+    std::vector<u8> iv(0x10);
+    std::size_t counter = base_offset >> 4;
+    for (std::size_t i = 0; i < 8; ++i) {
+        iv[0xF - i] = counter & 0xFF;
+        counter >>= 8;
+    }
+    cipher.SetIV(iv);
+    std::vector<u8> ciphertext(plaintext.size());
+    cipher.Transcode(plaintext.data(), plaintext.size(), ciphertext.data(), Op::Encrypt);
+
+    auto file = std::make_shared<FileSys::VectorVfsFile>(std::move(ciphertext));
+    return std::make_shared<CTREncryptionLayer>(file, key, base_offset);
+}
+
+std::shared_ptr<XTSEncryptionLayer> MakeXTSLayer(const std::vector<u8>& plaintext) {
+    const Key256 key{0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF, 0x11, 0x22};
+    AESCipher<Key256> cipher(key, Mode::XTS);
+    std::vector<u8> ciphertext(plaintext.size());
+    cipher.XTSTranscode(plaintext.data(), plaintext.size(), ciphertext.data(), 0,
+                        XTS_SECTOR_SIZE, Op::Encrypt);
+
+    auto file = std::make_shared<FileSys::VectorVfsFile>(std::move(ciphertext));
+    return std::make_shared<XTSEncryptionLayer>(file, key);
+}
+
+/// Reads random ranges of the layer, including unaligned and past the end ones
+bool RandomReadsMatch(const FileSys::VfsFile& layer, const std::vector<u8>& plaintext,
+                      std::mt19937& rng) {
+    std::uniform_int_distribution<std::size_t> offset_distribution(0, plaintext.size() + 0x100);
+    bool matches = true;
+    for (int i = 0; i < 2000; ++i) {
+        const std::size_t offset = offset_distribution(rng);
+        const std::size_t length = i % 8 == 0 ? offset_distribution(rng) : rng() % 0x300;
+        const std::size_t expected_length =
+            offset < plaintext.size() ? std::min(length, plaintext.size() - offset) : 0;
+
+        std::vector<u8> data(length);
+        matches &= layer.Read(data.data(), length, offset) == expected_length;
+        matches &= std::memcmp(data.data(), plaintext.data() + offset, expected_length) == 0;
+    }
+    return matches;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("EncryptionLayer: CTR reads match the plaintext", "[core][crypto]") {
+    std::mt19937 rng(0xC7C7);
+    const auto plaintext = TestCommon::RandomBytes(0x2345B, rng);
+    const auto layer = MakeCTRLayer(plaintext, 0x4C00);
+    REQUIRE(layer->GetSize() == plaintext.size());
+    REQUIRE(layer->ReadAllBytes() == plaintext);
+    REQUIRE(RandomReadsMatch(*layer, plaintext, rng));
+}
+
+TEST_CASE("EncryptionLayer: XTS reads match the plaintext", "[core][crypto]") {
+    std::mt19937 rng(0x7575);
+    const auto plaintext = TestCommon::RandomBytes(XTS_SECTOR_SIZE * 9, rng);
+    const auto layer = MakeXTSLayer(plaintext);
+    REQUIRE(layer->ReadAllBytes() == plaintext);
+    REQUIRE(RandomReadsMatch(*layer, plaintext, rng));
+}
+
+TEST_CASE("EncryptionLayer: Small reads are served from the read ahead", "[core][crypto]") {
+    constexpr std::size_t block_size = EncryptionLayer::CACHE_BLOCK_SIZE;
+    EncryptionLayer::ConfigureCache(block_size * 64, 4);
+    SCOPE_EXIT({
+        EncryptionLayer::ConfigureCache(EncryptionLayer::DEFAULT_CACHE_SIZE,
+                                        EncryptionLayer::DEFAULT_READ_AHEAD);
+    });
+    std::mt19937 rng(0xCAC4E);
+    const auto plaintext = TestCommon::RandomBytes(block_size * 8, rng);
+    const auto layer = MakeCTRLayer(plaintext, 0);
+
+    const auto read_at = [&](std::size_t offset) {
+        u32 value{};
+        layer->ReadObject(&value, offset);
+        u32 expected{};
+        std::memcpy(&expected, plaintext.data() + offset, sizeof(expected));
+        return value == expected;
+    };
+
+    const auto initial = EncryptionLayer::GetCacheStats();
+    REQUIRE(read_at(0x10));
+    REQUIRE(EncryptionLayer::GetCacheStats().misses == initial.misses + 1);
+
+    // The three blocks following the missed one have been decrypted along with it
+    for (std::size_t block = 0; block < 4; ++block) {
+        REQUIRE(read_at(block * block_size + 0x24));
+    }
+    REQUIRE(EncryptionLayer::GetCacheStats().misses == initial.misses + 1);
+    REQUIRE(EncryptionLayer::GetCacheStats().hits == initial.hits + 4);
+
+    REQUIRE(read_at(4 * block_size + 0x24));
+    REQUIRE(EncryptionLayer::GetCacheStats().misses == initial.misses + 2);
+
+    // Changing the IV drops the blocks decrypted with the previous one
+    layer->SetIV(std::vector<u8>(0x10));
+    REQUIRE(read_at(0x10));
+    REQUIRE(EncryptionLayer::GetCacheStats().misses == initial.misses + 3);
+}
+
+TEST_CASE("EncryptionLayer: Small read throughput", "[.benchmark][core][crypto]") {
+    constexpr std::size_t file_size = 0x100000;
+    constexpr std::size_t read_size = 0x40;
+    std::mt19937 rng(0xBE7C);
+    const auto plaintext = TestCommon::RandomBytes(file_size, rng);
+    const auto layer = MakeCTRLayer(plaintext, 0);
+    SCOPE_EXIT({
+        EncryptionLayer::ConfigureCache(EncryptionLayer::DEFAULT_CACHE_SIZE,
+                                        EncryptionLayer::DEFAULT_READ_AHEAD);
+    });
+
+    for (const std::size_t cache_size : {std::size_t{0}, file_size}) {
+        EncryptionLayer::ConfigureCache(cache_size, 4);
+        const auto initial = EncryptionLayer::GetCacheStats();
+        std::array<u8, read_size> data{};
+
+        const auto elapsed = TestCommon::MeasureTime([&] {
+            for (std::size_t offset = 0; offset < file_size; offset += read_size) {
+                layer->Read(data.data(), data.size(), offset);
+            }
+        });
+
+        const auto stats = EncryptionLayer::GetCacheStats();
+        TestCommon::ReportBenchmark(
+            fmt::format("Encryption layer: cache {} KiB", cache_size / 1024),
+            fmt::format("{:>8.2f} MB/s, {} hits, {} misses", file_size / elapsed.count() / 1e6,
+                        stats.hits - initial.hits, stats.misses - initial.misses));
+    }
+}
+
+} // namespace Core::Crypto
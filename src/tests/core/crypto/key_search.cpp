@@ -0,0 +1,192 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "common/hex_util.h"
+#include "core/crypto/aes_util.h"
+#include "core/crypto/key_manager.h"
+#include "core/crypto/key_search.h"
+#include "core/crypto/sha256_block.h"
+#include "tests/test_common.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include "common/x64/cpu_detect.h"
+#endif
+
+namespace Core::Crypto {
+namespace {
+
+SHA256Hash HashOf(const u8* data, std::size_t size) {
+    std::array<u32, 8> digest;
+    SHA256::HashMessagesGeneric(data, 0, 1, size, digest.data());
+
+    SHA256Hash hash;
+    for (std::size_t i = 0; i < digest.size(); ++i) {
+        for (std::size_t j = 0; j < 4; ++j) {
+            hash[i * 4 + j] = static_cast<u8>(digest[i] >> (24 - j * 8));
+        }
+    }
+    return hash;
+}
+
+/// Plants the data in the binary and returns a target for it.
+KeySearchTarget PlantKey(std::vector<u8>& binary, const std::vector<u8>& key, std::size_t offset) {
+    std::memcpy(binary.data() + offset, key.data(), key.size());
+    return {HashOf(key.data(), key.size()), key.size()};
+}
+
+} // Anonymous namespace
+
+TEST_CASE("SHA256: Known answers", "[core][crypto]") {
+    std::array<u8, 0x20> message;
+    for (std::size_t i = 0; i < message.size(); ++i) {
+        message[i] = static_cast<u8>(i);
+    }
+
+    REQUIRE(HashOf(message.data(), 0) ==
+            Common::HexStringToArray<0x20>(
+                "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+    REQUIRE(HashOf(message.data(), 0x10) ==
+            Common::HexStringToArray<0x20>(
+                "be45cb2605bf36bebde684841a28f0fd43c69850a3dce5fedba69928ee3a8991"));
+    REQUIRE(HashOf(message.data(), 0x20) ==
+            Common::HexStringToArray<0x20>(
+                "630dcd2966c4336691125448bbb25b4ff412a49c732db2c8abc1b8581bd710dd"));
+}
+
+#ifdef ARCHITECTURE_x86_64
+TEST_CASE("SHA256: SIMD implementations match the generic one", "[core][crypto]") {
+    std::mt19937 rng(0x5A);
+    const auto data = TestCommon::RandomBytes(0x4000, rng);
+    const auto& caps = Common::GetCPUCaps();
+
+    std::vector<SHA256::HashMessagesFunction> functions;
+    if (caps.sha && caps.sse4_1) {
+        functions.push_back(SHA256::HashMessagesSHANI);
+    }
+    if (caps.avx2) {
+        functions.push_back(SHA256::HashMessagesAVX2);
+    }
+
+    for (const std::size_t length : {0x10, 0x20, 0x34}) {
+        for (const std::size_t stride : {1, 0x10}) {
+            const std::size_t count = (data.size() - length) / stride - 5;
+            std::vector<u32> expected(count * 8);
+            SHA256::HashMessagesGeneric(data.data(), stride, count, length, expected.data());
+
+            for (const auto function : functions) {
+                std::vector<u32> digests(count * 8);
+                const std::size_t hashed = function(data.data(), stride, count, length,
+                                                    digests.data());
+                REQUIRE(hashed <= count);
+                digests.resize(hashed * 8);
+                REQUIRE(std::equal(digests.begin(), digests.end(), expected.begin()));
+            }
+        }
+    }
+}
+#endif
+
+TEST_CASE("KeySearch: Finds keys of all sizes in one search", "[core][crypto]") {
+    std::mt19937 rng(0x1234);
+    auto binary = TestCommon::RandomBytes(0x123457, rng);
+
+    std::vector<KeySearchTarget> targets;
+    const auto first_key = TestCommon::RandomBytes(0x10, rng);
+    targets.push_back(PlantKey(binary, first_key, 0));
+    targets.push_back(PlantKey(binary, TestCommon::RandomBytes(0x20, rng), 0x4000 - 3));
+    targets.push_back(PlantKey(binary, TestCommon::RandomBytes(0x10, rng), 0xABCDE));
+    const auto last_key = TestCommon::RandomBytes(0x20, rng);
+    targets.push_back(PlantKey(binary, last_key, binary.size() - last_key.size()));
+    // Keys found several times are taken from their lowest offset, the contents are the same.
+    PlantKey(binary, first_key, 0x100000);
+    targets.push_back({HashOf(first_key.data(), 0x10), 0x10});
+    // Keys that aren't in the binary, or are larger than it, are left empty.
+    targets.push_back({SHA256Hash{}, 0x10});
+    targets.push_back({HashOf(binary.data(), 0x20), 0x34});
+
+    const auto keys = FindKeysFromHashes(binary, targets);
+    REQUIRE(keys.size() == targets.size());
+    REQUIRE(keys[0] == first_key);
+    REQUIRE(keys[1] == std::vector<u8>(binary.begin() + 0x4000 - 3, binary.begin() + 0x4000 + 29));
+    REQUIRE(keys[2] == std::vector<u8>(binary.begin() + 0xABCDE, binary.begin() + 0xABCEE));
+    REQUIRE(keys[3] == last_key);
+    REQUIRE(keys[4] == first_key);
+    REQUIRE(keys[5].empty());
+    REQUIRE(keys[6].empty());
+
+    REQUIRE(FindKeysFromHashes(std::vector<u8>(8), targets)[0].empty());
+}
+
+TEST_CASE("KeySearch: Finds encrypted keys", "[core][crypto]") {
+    std::mt19937 rng(0x4321);
+    auto binary = TestCommon::RandomBytes(0x40001, rng);
+    Key128 key;
+    const auto key_bytes = TestCommon::RandomBytes(key.size(), rng);
+    std::memcpy(key.data(), key_bytes.data(), key.size());
+    AESCipher<Key128> cipher(key, Mode::ECB);
+
+    std::vector<SHA256Hash> hashes;
+    std::vector<Key128> expected;
+    for (const std::size_t offset : {std::size_t{7}, std::size_t{0x3FFF}, binary.size() - 0x10}) {
+        Key128 plaintext;
+        const auto plaintext_bytes = TestCommon::RandomBytes(plaintext.size(), rng);
+        std::memcpy(plaintext.data(), plaintext_bytes.data(), plaintext.size());
+        cipher.Transcode(plaintext.data(), plaintext.size(), binary.data() + offset, Op::Encrypt);
+        hashes.push_back(HashOf(plaintext.data(), plaintext.size()));
+        expected.push_back(plaintext);
+    }
+    hashes.push_back(SHA256Hash{});
+    expected.push_back(Key128{});
+
+    REQUIRE(FindEncryptedKeysFromHashes(binary, key, hashes) == expected);
+}
+
+TEST_CASE("KeySearch: Throughput", "[.benchmark][core][crypto]") {
+    constexpr std::size_t binary_size = 8 * 1024 * 1024;
+    constexpr std::size_t num_targets = 16;
+    std::mt19937 rng(0x77);
+    auto binary = TestCommon::RandomBytes(binary_size, rng);
+
+    std::vector<KeySearchTarget> targets;
+    for (std::size_t i = 0; i < num_targets; ++i) {
+        const std::size_t size = i % 4 == 3 ? 0x20 : 0x10;
+        targets.push_back(PlantKey(binary, TestCommon::RandomBytes(size, rng),
+                                   binary_size / num_targets * i));
+    }
+
+    // The previous approach: a scalar pass over the whole binary for every key.
+    std::size_t found = 0;
+    const auto per_key = TestCommon::MeasureTime([&] {
+        for (const auto& target : targets) {
+            for (std::size_t offset = 0; offset + target.size <= binary.size(); ++offset) {
+                if (HashOf(binary.data() + offset, target.size) == target.hash) {
+                    ++found;
+                    break;
+                }
+            }
+        }
+    });
+    REQUIRE(found == num_targets);
+
+    std::vector<std::vector<u8>> keys;
+    const auto single_pass =
+        TestCommon::MeasureTime([&] { keys = FindKeysFromHashes(binary, targets); });
+    REQUIRE(std::none_of(keys.begin(), keys.end(), [](const auto& key) { return key.empty(); }));
+
+    TestCommon::ReportBenchmark(
+        fmt::format("Key search: {} keys in {} MiB", num_targets, binary_size / (1024 * 1024)),
+        fmt::format("one pass per key {:.2f} s, single pass {:.3f} s", per_key.count(),
+                    single_pass.count()));
+}
+
+} // namespace Core::Crypto
@@ -0,0 +1,216 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "core/crypto/aes_util.h"
+#include "core/crypto/key_manager.h"
+#include "core/file_sys/nca_patch.h"
+#include "core/file_sys/vfs_vector.h"
+#include "tests/test_common.h"
+
+namespace FileSys {
+namespace {
+
+constexpr u64 BASE_OFFSET = 0x4000;
+constexpr u64 IVFC_OFFSET = 0x200;
+constexpr std::array<u8, 8> SECTION_CTR{0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF};
+constexpr Core::Crypto::Key128 KEY{0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE,
+                                   0x0F, 0x1E, 0x2D, 0x3C, 0x4B, 0x5A, 0x69, 0x78};
+
+/// Encrypts the patch data the way BKTR expects it, with a separate counter for each subsection
+void EncryptPatch(std::vector<u8>& data, const std::vector<SubsectionEntry>& subsections) {
+    Core::Crypto::AESCipher<Core::Crypto::Key128> cipher(KEY, Core::Crypto::Mode::CTR);
+    for (std::size_t i = 0; i < subsections.size(); ++i) {
+        const u64 begin = subsections[i].address_patch;
+        const u64 end = i + 1 < subsections.size() ? subsections[i + 1].address_patch : data.size();
+        const u64 block_begin = begin & ~u64{0xF};
+
+        std::vector<u8> iv(16);
+        for (std::size_t j = 0; j < SECTION_CTR.size(); ++j)
+            iv[j] = SECTION_CTR[0x7 - j];
+        u32 ctr = subsections[i].ctr;
+        for (std::size_t j = 0; j < sizeof(u32); ++j, ctr >>= 8)
+            iv[0x7 - j] = static_cast<u8>(ctr);
+        u64 counter = (block_begin + BASE_OFFSET) >> 4;
+        for (std::size_t j = 0; j < sizeof(u64); ++j, counter >>= 8)
+            iv[0xF - j] = static_cast<u8>(counter);
+
+        std::vector<u8> keystream(end - block_begin);
+        cipher.SetIV(iv);
+        cipher.Transcode(keystream.data(), keystream.size(), keystream.data(),
+                         Core::Crypto::Op::Encrypt);
+        for (u64 offset = begin; offset < end; ++offset)
+            data[offset] ^= keystream[offset - block_begin];
+    }
+}
+
+template <typename Bucket, typename Entry>
+std::vector<Bucket> MakeBuckets(const std::vector<Entry>& entries, std::size_t bucket_size) {
+    std::vector<Bucket> buckets;
+    for (std::size_t i = 0; i < entries.size(); i += bucket_size) {
+        const std::size_t count = std::min(bucket_size, entries.size() - i);
+        buckets.push_back({static_cast<u32>(count), 0,
+                           std::vector<Entry>(entries.begin() + i, entries.begin() + i + count)});
+    }
+    return buckets;
+}
+
+/// A patched RomFS along with the data it's expected to read as
+struct TestPatch {
+    std::shared_ptr<BKTR> bktr;
+    std::vector<u8> expected;
+};
+
+/**
+ * Builds a patched RomFS alternating between the base and patch RomFS. Some neighbouring
+ * relocations and subsections continue each other, and some subsections aren't block aligned.
+ */
+TestPatch BuildTestPatch(std::size_t size, std::size_t max_relocation_size, bool encrypted,
+                         std::size_t bucket_size = 7) {
+    std::mt19937 rng(1234);
+    const std::vector<u8> base = TestCommon::RandomBytes(size, rng);
+    std::vector<u8> patch = TestCommon::RandomBytes(size, rng);
+
+    TestPatch result;
+    result.expected.resize(size);
+    std::vector<RelocationEntry> relocations;
+    u64 patch_end = 0;
+    for (u64 address = 0; address < size;) {
+        const u64 length = std::min<u64>(1 + rng() % max_relocation_size, size - address);
+        const bool from_patch = rng() % 2 == 0;
+        const bool continues = !relocations.empty() && rng() % 4 == 0;
+        u64 source = 0;
+        if (continues) {
+            const auto& last = relocations.back();
+            source = last.address_source + (address - last.address_patch);
+        }
+
+        if (continues && (relocations.back().from_patch != 0 ||
+                          source - IVFC_OFFSET + length <= base.size())) {
+            // Continues the previous relocation.
+            if (relocations.back().from_patch != 0)
+                patch_end = source + length;
+            relocations.push_back({address, source, relocations.back().from_patch});
+        } else if (from_patch) {
+            source = patch_end;
+            patch_end += length;
+            relocations.push_back({address, source, 1});
+        } else {
+            source = IVFC_OFFSET + rng() % (size - length + 1);
+            relocations.push_back({address, source, 0});
+        }
+
+        const auto& data = relocations.back().from_patch != 0 ? patch : base;
+        const u64 data_offset = relocations.back().from_patch != 0 ? source : source - IVFC_OFFSET;
+        std::memcpy(result.expected.data() + address, data.data() + data_offset, length);
+        address += length;
+    }
+
+    std::vector<SubsectionEntry> subsections;
+    for (u64 address = 0; address < patch.size();) {
+        const u32 ctr = subsections.empty() || rng() % 4 != 0 ? static_cast<u32>(rng())
+                                                               : subsections.back().ctr;
+        subsections.push_back({address, {0}, ctr});
+        address += rng() % 3 == 0 ? 1 + rng() % 0x800 : (1 + rng() % 0x80) * 0x10;
+    }
+    if (encrypted)
+        EncryptPatch(patch, subsections);
+
+    RelocationBlock relocation_block{};
+    const auto relocation_buckets = MakeBuckets<RelocationBucket>(relocations, bucket_size);
+    relocation_block.number_buckets = static_cast<u32>(relocation_buckets.size());
+    relocation_block.size = size;
+    for (std::size_t i = 0; i < relocation_buckets.size(); ++i)
+        relocation_block.base_offsets[i] = relocation_buckets[i].entries[0].address_patch;
+
+    SubsectionBlock subsection_block{};
+    auto subsection_buckets = MakeBuckets<SubsectionBucket>(subsections, bucket_size);
+    // As in NCAs, the last bucket also covers the BKTR tables following the patch data and ends
+    // with the end of the section.
+    subsection_buckets.back().entries.push_back({patch.size(), {0}, 0x1234});
+    subsection_buckets.back().entries.push_back({patch.size() + 0x8000, {0}, 0});
+    subsection_block.number_buckets = static_cast<u32>(subsection_buckets.size());
+    subsection_block.size = patch.size();
+    for (std::size_t i = 0; i < subsection_buckets.size(); ++i)
+        subsection_block.base_offsets[i] = subsection_buckets[i].entries[0].address_patch;
+
+    result.bktr = std::make_shared<BKTR>(
+        std::make_shared<VectorVfsFile>(base), std::make_shared<VectorVfsFile>(patch),
+        relocation_block, relocation_buckets, subsection_block, subsection_buckets, encrypted, KEY,
+        BASE_OFFSET, IVFC_OFFSET, SECTION_CTR);
+    return result;
+}
+
+void CheckReads(const TestPatch& patch) {
+    const auto& expected = patch.expected;
+    REQUIRE(patch.bktr->GetSize() == expected.size());
+    REQUIRE(patch.bktr->ReadAllBytes() == expected);
+
+    // Sequential reads of a size that doesn't line up with relocations or AES blocks.
+    std::vector<u8> data(0x123);
+    for (std::size_t offset = 0; offset < expected.size(); offset += data.size()) {
+        const std::size_t read = patch.bktr->Read(data.data(), data.size(), offset);
+        REQUIRE(read == std::min(data.size(), expected.size() - offset));
+        REQUIRE(std::equal(data.begin(), data.begin() + read, expected.begin() + offset));
+    }
+
+    std::mt19937 rng(5678);
+    for (std::size_t i = 0; i < 1000; ++i) {
+        const std::size_t offset = rng() % expected.size();
+        const std::size_t length = 1 + rng() % 0x2000;
+        std::vector<u8> random_data(length);
+        const std::size_t read = patch.bktr->Read(random_data.data(), length, offset);
+        REQUIRE(read == std::min(length, expected.size() - offset));
+        REQUIRE(std::equal(random_data.begin(), random_data.begin() + read,
+                           expected.begin() + offset));
+    }
+
+    REQUIRE(patch.bktr->Read(data.data(), data.size(), expected.size()) == 0);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("BKTR: Reads match the relocated data", "[core][file_sys]") {
+    CheckReads(BuildTestPatch(0x40000, 0x1000, false));
+}
+
+TEST_CASE("BKTR: Reads decrypt every subsection they span", "[core][file_sys]") {
+    CheckReads(BuildTestPatch(0x40000, 0x1000, true));
+    CheckReads(BuildTestPatch(0x8000, 0x40, true));
+}
+
+TEST_CASE("BKTR: Sequential and random read throughput", "[.benchmark][core][file_sys]") {
+    constexpr std::size_t size = 0x4000000;
+    const auto patch = BuildTestPatch(size, 0x10000, true, 0x332);
+    std::vector<u8> data(0x4000);
+
+    const auto measure = [&](auto&& read) {
+        const auto elapsed = TestCommon::MeasureTime([&] {
+            for (std::size_t offset = 0; offset < size; offset += data.size())
+                read(offset);
+        });
+        return static_cast<double>(size) / elapsed.count() / 0x100000;
+    };
+
+    std::mt19937 rng(1);
+    const double sequential =
+        measure([&](std::size_t offset) { patch.bktr->Read(data.data(), data.size(), offset); });
+    const double random = measure([&](std::size_t) {
+        patch.bktr->Read(data.data(), data.size(), rng() % (size - data.size()));
+    });
+    TestCommon::ReportBenchmark(
+        "BKTR reads of 16 KiB",
+        fmt::format("sequential {:.1f} MiB/s, random {:.1f} MiB/s", sequential, random));
+}
+
+} // namespace FileSys
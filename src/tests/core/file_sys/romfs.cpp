@@ -0,0 +1,160 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "core/file_sys/romfs.h"
+#include "core/file_sys/vfs_layered.h"
+#include "core/file_sys/vfs_vector.h"
+
+namespace FileSys {
+namespace {
+
+constexpr char CACHE_PATH[] = "romfs_layout_cache_test.bin";
+
+/// A file that counts how often its contents were read
+class CountingVfsFile : public VectorVfsFile {
+public:
+    CountingVfsFile(std::vector<u8> data, std::string name)
+        : VectorVfsFile(std::move(data), std::move(name)) {}
+
+    std::size_t Read(u8* data, std::size_t length, std::size_t offset) const override {
+        ++num_reads;
+        return VectorVfsFile::Read(data, length, offset);
+    }
+
+    ReadOnlySpan ReadSpan(std::size_t length, std::size_t offset) const override {
+        ++num_reads;
+        return VectorVfsFile::ReadSpan(length, offset);
+    }
+
+    mutable std::size_t num_reads = 0;
+};
+
+std::vector<u8> MakeData(std::size_t size, u8 seed) {
+    std::vector<u8> data(size);
+    for (std::size_t i = 0; i < size; ++i)
+        data[i] = static_cast<u8>(seed + i * 7);
+    return data;
+}
+
+std::shared_ptr<VectorVfsDirectory> MakeDirectory(std::string name,
+                                                  std::vector<VirtualFile> files = {},
+                                                  std::vector<VirtualDir> dirs = {}) {
+    return std::make_shared<VectorVfsDirectory>(std::move(files), std::move(dirs),
+                                                std::move(name));
+}
+
+/// The game files and a mod replacing one of them, hiding two entries and patching another one
+struct TestSources {
+    TestSources() {
+        base = MakeDirectory(
+            "romfs",
+            {a, std::make_shared<VectorVfsFile>(std::vector<u8>{}, "empty.bin"),
+             std::make_shared<VectorVfsFile>(MakeData(0x10, 1), "stubbed.bin")},
+            {MakeDirectory("sub", {base_b, patched}),
+             MakeDirectory("stubbed_dir",
+                           {std::make_shared<VectorVfsFile>(MakeData(0x10, 2), "c.bin")})});
+        const auto mod = MakeDirectory("romfs", {}, {MakeDirectory("sub", {mod_b})});
+        dir = LayeredVfsDirectory::MakeLayeredDirectory({mod, base});
+
+        // Replaces 4 bytes at offset 0x10.
+        const std::vector<u8> ips{'P', 'A', 'T', 'C', 'H', 0x00, 0x00, 0x10, 0x00, 0x04,
+                                  0xDE, 0xAD, 0xBE, 0xEF, 'E',  'O',  'F'};
+        ext = MakeDirectory(
+            "romfs_ext",
+            {std::make_shared<VectorVfsFile>(std::vector<u8>{}, "stubbed.bin.stub"),
+             std::make_shared<VectorVfsFile>(std::vector<u8>{}, "stubbed_dir.stub")},
+            {MakeDirectory("sub", {std::make_shared<VectorVfsFile>(ips, "patched.bin.ips")})});
+    }
+
+    std::size_t NumReads() const {
+        return a->num_reads + base_b->num_reads + mod_b->num_reads + patched->num_reads;
+    }
+
+    void CheckRomFS(const VirtualFile& romfs) const {
+        const auto extracted = ExtractRomFS(romfs);
+        REQUIRE(extracted != nullptr);
+        REQUIRE(extracted->GetFiles().size() == 2);
+        REQUIRE(extracted->GetFile("stubbed.bin") == nullptr);
+        REQUIRE(extracted->GetSubdirectories().size() == 1);
+        REQUIRE(extracted->GetSubdirectory("stubbed_dir") == nullptr);
+        REQUIRE(extracted->GetFile("empty.bin")->GetSize() == 0);
+
+        // Only the metadata of the RomFS is read until the contents of a file are.
+        REQUIRE(NumReads() == 0);
+        REQUIRE(extracted->GetFile("a.bin")->ReadAllBytes() == a->ReadAllBytes());
+        REQUIRE(a->num_reads != 0);
+        REQUIRE(NumReads() == a->num_reads);
+
+        REQUIRE(extracted->GetFileRelative("sub/b.bin")->ReadAllBytes() == mod_b->ReadAllBytes());
+        REQUIRE(base_b->num_reads == 0);
+
+        auto expected_patched = patched->ReadAllBytes();
+        const std::vector<u8> patch{0xDE, 0xAD, 0xBE, 0xEF};
+        std::copy(patch.begin(), patch.end(), expected_patched.begin() + 0x10);
+        REQUIRE(extracted->GetFileRelative("sub/patched.bin")->ReadAllBytes() == expected_patched);
+    }
+
+    std::shared_ptr<CountingVfsFile> a =
+        std::make_shared<CountingVfsFile>(MakeData(0x1234, 3), "a.bin");
+    std::shared_ptr<CountingVfsFile> base_b =
+        std::make_shared<CountingVfsFile>(MakeData(0x100, 4), "b.bin");
+    std::shared_ptr<CountingVfsFile> mod_b =
+        std::make_shared<CountingVfsFile>(MakeData(0x321, 5), "b.bin");
+    std::shared_ptr<CountingVfsFile> patched =
+        std::make_shared<CountingVfsFile>(MakeData(0x40, 6), "patched.bin");
+
+    std::shared_ptr<VectorVfsDirectory> base;
+    VirtualDir dir;
+    VirtualDir ext;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("RomFS: Files are only read once the built RomFS is", "[core][file_sys]") {
+    const TestSources sources;
+    sources.CheckRomFS(CreateRomFS(sources.dir, sources.ext));
+}
+
+TEST_CASE("RomFS: Cached layouts are used while the stamp is unchanged", "[core][file_sys]") {
+    FileUtil::Delete(CACHE_PATH);
+
+    const TestSources sources;
+    std::size_t num_opens = 0;
+    const RomFSSourceOpener open = [&] {
+        ++num_opens;
+        return std::make_pair(sources.dir, sources.ext);
+    };
+
+    // Without a cache, the directories have to be walked right away.
+    const auto built = CreateRomFS(open, CACHE_PATH, 1);
+    REQUIRE(num_opens == 1);
+    REQUIRE(FileUtil::Exists(CACHE_PATH));
+
+    const auto cached = CreateRomFS(open, CACHE_PATH, 1);
+    REQUIRE(num_opens == 1);
+    REQUIRE(cached->GetSize() == built->GetSize());
+    sources.CheckRomFS(cached);
+    REQUIRE(num_opens == 2);
+    REQUIRE(cached->ReadAllBytes() == built->ReadAllBytes());
+
+    // A different stamp means the directories changed, the layout is built again.
+    sources.base->AddFile(std::make_shared<VectorVfsFile>(MakeData(0x20, 7), "new.bin"));
+    const auto rebuilt = CreateRomFS(open, CACHE_PATH, 2);
+    REQUIRE(num_opens == 3);
+    REQUIRE(ExtractRomFS(rebuilt)->GetFile("new.bin") != nullptr);
+    REQUIRE(CreateRomFS(open, CACHE_PATH, 2)->ReadAllBytes() == rebuilt->ReadAllBytes());
+
+    FileUtil::Delete(CACHE_PATH);
+}
+
+} // namespace FileSys
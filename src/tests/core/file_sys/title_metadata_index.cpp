@@ -0,0 +1,240 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "core/file_sys/content_archive.h"
+#include "core/file_sys/mode.h"
+#include "core/file_sys/nca_metadata.h"
+#include "core/file_sys/registered_cache.h"
+#include "core/file_sys/title_metadata_index.h"
+#include "core/file_sys/vfs_real.h"
+#include "core/file_sys/vfs_vector.h"
+#include "core/loader/loader.h"
+#include "tests/test_common.h"
+
+namespace FileSys {
+namespace {
+
+constexpr char TEST_DIRECTORY[] = "title_metadata_index_test";
+constexpr char TEST_INDEX[] = "title_metadata_index_test.bin";
+
+template <typename T>
+void WriteAt(std::vector<u8>& data, std::size_t offset, const T& value) {
+    std::memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+/// Builds an unencrypted meta NCA whose only section is a PFS0 holding the CNMT of the title
+std::vector<u8> BuildMetaNCA(u64 title_id, u32 version) {
+    CNMTHeader cnmt_header{};
+    cnmt_header.title_id = title_id;
+    cnmt_header.title_version = version;
+    cnmt_header.type = TitleType::Application;
+    cnmt_header.table_offset = sizeof(OptionalHeader);
+    const auto cnmt = CNMT(cnmt_header, OptionalHeader{title_id, 0}, {}, {}).Serialize();
+
+    const std::string name = fmt::format("Application_{:016x}.cnmt", title_id);
+    const std::size_t strtab_size = (name.size() + 1 + 0xF) & ~std::size_t{0xF};
+    const std::size_t pfs_offset = 0xC00;
+    const std::size_t content_offset = pfs_offset + 0x10 + 0x18 + strtab_size;
+    const std::size_t nca_size = (content_offset + cnmt.size() + 0x1FF) & ~std::size_t{0x1FF};
+    std::vector<u8> nca(nca_size);
+
+    NCAHeader header{};
+    header.magic = Common::MakeMagic('N', 'C', 'A', '3');
+    header.content_type = NCAContentType::Meta;
+    header.size = nca_size;
+    header.title_id = title_id;
+    header.section_tables[0].media_offset = static_cast<u32>(pfs_offset / 0x200);
+    header.section_tables[0].media_end_offset = static_cast<u32>(nca_size / 0x200);
+    WriteAt(nca, 0, header);
+
+    // Section header: PFS0 filesystem without encryption, the superblock is otherwise unused.
+    nca[0x400 + 3] = 0x2;
+    nca[0x400 + 4] = static_cast<u8>(NCASectionCryptoType::NONE);
+
+    WriteAt(nca, pfs_offset, Common::MakeMagic('P', 'F', 'S', '0'));
+    WriteAt(nca, pfs_offset + 4, u32{1});
+    WriteAt(nca, pfs_offset + 8, static_cast<u32>(strtab_size));
+    WriteAt(nca, pfs_offset + 0x10 + 8, static_cast<u64>(cnmt.size()));
+    std::memcpy(nca.data() + pfs_offset + 0x10 + 0x18, name.data(), name.size());
+    std::memcpy(nca.data() + content_offset, cnmt.data(), cnmt.size());
+    return nca;
+}
+
+u64 GetTestTitleID(std::size_t index) {
+    return 0x0100000000010000 + (index << 13);
+}
+
+/// Fills a registered directory with meta NCAs of consecutive titles
+VirtualDir CreateRegisteredDirectory(RealVfsFilesystem& fs, std::size_t num_titles) {
+    FileUtil::DeleteDirRecursively(TEST_DIRECTORY);
+    const auto dir = fs.CreateDirectory(TEST_DIRECTORY, Mode::ReadWrite);
+    REQUIRE(dir != nullptr);
+
+    for (std::size_t i = 0; i < num_titles; ++i) {
+        const auto file = dir->CreateFile(fmt::format("{:032X}.nca", i + 1));
+        REQUIRE(file != nullptr);
+        const auto nca = BuildMetaNCA(GetTestTitleID(i), static_cast<u32>(i) << 16);
+        REQUIRE(file->WriteBytes(nca) == nca.size());
+    }
+    return fs.OpenDirectory(TEST_DIRECTORY, Mode::Read);
+}
+
+/// Parsing function counting the NCAs that had to be parsed
+RegisteredCacheParsingFunction CountingParser(std::size_t& count) {
+    return [&count](const VirtualFile& file, const NcaID& id) {
+        ++count;
+        return file;
+    };
+}
+
+} // Anonymous namespace
+
+TEST_CASE("TitleMetadataIndex: Entries are dropped when files change", "[core][file_sys]") {
+    FileUtil::Delete(TEST_INDEX);
+    RealVfsFilesystem fs;
+    const auto dir = CreateRegisteredDirectory(fs, 1);
+    const auto file = dir->GetFile(fmt::format("{:032X}.nca", 1));
+    REQUIRE(file != nullptr);
+
+    {
+        TitleMetadataIndex index(TEST_INDEX);
+        REQUIRE(index.FindNCA(file) == boost::none);
+        index.AddNCA(file, IndexedNCA{0x1234, NCAContentType::Meta, {1, 2, 3}});
+        index.AddGame(file,
+                      IndexedGame{0x1234, Loader::FileType::NCA, "Name", {4}, true, false, 7});
+        // Files that aren't on the host can't be indexed.
+        const auto vector_file = std::make_shared<VectorVfsFile>(std::vector<u8>(0x10), "vector");
+        index.AddNCA(vector_file, IndexedNCA{0x5678, NCAContentType::Meta, {}});
+        REQUIRE(index.FindNCA(vector_file) == boost::none);
+        index.Save();
+    }
+
+    {
+        TitleMetadataIndex index(TEST_INDEX);
+        const auto nca = index.FindNCA(file);
+        REQUIRE(nca != boost::none);
+        REQUIRE(nca->title_id == 0x1234);
+        REQUIRE(nca->type == NCAContentType::Meta);
+        const std::vector<u8> expected_cnmt{1, 2, 3};
+        REQUIRE(nca->cnmt == expected_cnmt);
+
+        const auto game = index.FindGame(file);
+        REQUIRE(game != boost::none);
+        REQUIRE(game->file_type == Loader::FileType::NCA);
+        REQUIRE(game->name == "Name");
+        REQUIRE(game->romfs_updatable);
+        REQUIRE(!game->has_packed_update);
+        REQUIRE(game->update_version == 7);
+    }
+
+    // Growing the file changes its size, the stale entries aren't returned anymore.
+    const std::vector<u8> padding(0x200);
+    FileUtil::IOFile(file->GetFullPath(), "ab").WriteBytes(padding.data(), padding.size());
+    {
+        TitleMetadataIndex index(TEST_INDEX);
+        REQUIRE(index.FindNCA(file) == boost::none);
+        REQUIRE(index.FindGame(file) == boost::none);
+    }
+
+    // Indices of another version are ignored.
+    {
+        TitleMetadataIndex index(TEST_INDEX);
+        index.AddNCA(file, IndexedNCA{0x1234, NCAContentType::Meta, {}});
+        index.Save();
+    }
+    {
+        FileUtil::IOFile index_file(TEST_INDEX, "r+b");
+        REQUIRE(index_file.Seek(4, SEEK_SET));
+        REQUIRE(index_file.WriteObject(TitleMetadataIndex::VERSION + 1) == 1);
+    }
+    REQUIRE(TitleMetadataIndex(TEST_INDEX).FindNCA(file) == boost::none);
+
+    FileUtil::DeleteDirRecursively(TEST_DIRECTORY);
+    FileUtil::Delete(TEST_INDEX);
+}
+
+TEST_CASE("RegisteredCache: Unchanged NCAs are read from the index", "[core][file_sys]") {
+    constexpr std::size_t num_titles = 8;
+    FileUtil::Delete(TEST_INDEX);
+    RealVfsFilesystem fs;
+    const auto dir = CreateRegisteredDirectory(fs, num_titles);
+
+    std::size_t cold_parses = 0;
+    std::vector<RegisteredCacheEntry> cold_entries;
+    {
+        TitleMetadataIndex index(TEST_INDEX);
+        const RegisteredCache cache(dir, CountingParser(cold_parses), &index);
+        cold_entries = cache.ListEntries();
+    }
+    REQUIRE(cold_parses == num_titles);
+    REQUIRE(cold_entries.size() == num_titles);
+
+    std::size_t warm_parses = 0;
+    {
+        TitleMetadataIndex index(TEST_INDEX);
+        const RegisteredCache cache(dir, CountingParser(warm_parses), &index);
+        REQUIRE(cache.ListEntries() == cold_entries);
+        REQUIRE(cache.GetEntryVersion(GetTestTitleID(3)) == u32{3 << 16});
+        REQUIRE(cache.GetEntryUnparsed(GetTestTitleID(5), ContentRecordType::Meta) != nullptr);
+    }
+    REQUIRE(warm_parses == 0);
+
+    // Replacing a file with the NCA of another title only parses that file again.
+    auto replacement = BuildMetaNCA(GetTestTitleID(num_titles), 1);
+    replacement.resize(replacement.size() + 0x200);
+    FileUtil::IOFile(dir->GetFullPath() + fmt::format("/{:032X}.nca", 1), "wb")
+        .WriteBytes(replacement.data(), replacement.size());
+
+    std::size_t update_parses = 0;
+    {
+        TitleMetadataIndex index(TEST_INDEX);
+        const RegisteredCache cache(dir, CountingParser(update_parses), &index);
+        REQUIRE(cache.GetEntryUnparsed(GetTestTitleID(0), ContentRecordType::Meta) == nullptr);
+        REQUIRE(cache.GetEntryVersion(GetTestTitleID(num_titles)) == u32{1});
+    }
+    REQUIRE(update_parses == 1);
+
+    FileUtil::DeleteDirRecursively(TEST_DIRECTORY);
+    FileUtil::Delete(TEST_INDEX);
+}
+
+TEST_CASE("RegisteredCache: Cold and warm scan times", "[.benchmark][core][file_sys]") {
+    constexpr std::size_t num_titles = 500;
+    FileUtil::Delete(TEST_INDEX);
+    RealVfsFilesystem fs;
+    const auto dir = CreateRegisteredDirectory(fs, num_titles);
+
+    const auto measure = [&](std::size_t& parses) {
+        return TestCommon::MeasureTime([&] {
+            TitleMetadataIndex index(TEST_INDEX);
+            const RegisteredCache cache(dir, CountingParser(parses), &index);
+            REQUIRE(cache.ListEntries().size() == num_titles);
+        });
+    };
+
+    std::size_t cold_parses = 0;
+    std::size_t warm_parses = 0;
+    const auto cold = measure(cold_parses);
+    const auto warm = measure(warm_parses);
+    REQUIRE(warm_parses == 0);
+    TestCommon::ReportBenchmark(
+        fmt::format("Registered cache scan of {} titles", num_titles),
+        fmt::format("cold {:.0f} ms ({} NCAs parsed), warm {:.0f} ms ({} NCAs parsed)",
+                    cold.count() * 1e3, cold_parses, warm.count() * 1e3, warm_parses));
+
+    FileUtil::DeleteDirRecursively(TEST_DIRECTORY);
+    FileUtil::Delete(TEST_INDEX);
+}
+
+} // namespace FileSys
@@ -0,0 +1,110 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/scope_exit.h"
+#include "core/file_sys/mode.h"
+#include "core/file_sys/vfs_concat.h"
+#include "core/file_sys/vfs_offset.h"
+#include "core/file_sys/vfs_real.h"
+#include "core/file_sys/vfs_vector.h"
+
+namespace FileSys {
+namespace {
+
+std::vector<u8> SequentialBytes(std::size_t size, u8 first) {
+    std::vector<u8> bytes(size);
+    std::iota(bytes.begin(), bytes.end(), first);
+    return bytes;
+}
+
+/// Checks that the span covers the same bytes as a regular read of the range
+void RequireSpanMatchesRead(const VirtualFile& file, std::size_t length, std::size_t offset) {
+    const ReadOnlySpan span = file->ReadSpan(length, offset);
+    const std::vector<u8> expected = file->ReadBytes(length, offset);
+    REQUIRE(span.data != nullptr);
+    REQUIRE(span.size == expected.size());
+    REQUIRE(std::vector<u8>(span.data, span.data + span.size) == expected);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("VfsFile: Spans propagate through offset files", "[core][file_sys]") {
+    const auto vector = std::make_shared<VectorVfsFile>(SequentialBytes(0x1000, 0));
+    const auto offset = std::make_shared<OffsetVfsFile>(vector, 0x800, 0x400);
+    const auto nested = std::make_shared<OffsetVfsFile>(offset, 0x100, 0x80);
+
+    RequireSpanMatchesRead(offset, 0x100, 0x10);
+    RequireSpanMatchesRead(nested, 0x100, 0x10);
+
+    // Spans point into the storage of the innermost file.
+    const ReadOnlySpan base_span = vector->ReadSpan(1, 0);
+    REQUIRE(nested->ReadSpan(0x10, 0x20).data == base_span.data + 0x400 + 0x80 + 0x20);
+
+    // Ranges are trimmed to the end of the offset file, not the one it is based on.
+    REQUIRE(offset->ReadSpan(0x1000, 0x700).size == 0x100);
+    REQUIRE(offset->ReadSpan(0x10, 0x800).data == nullptr);
+}
+
+TEST_CASE("VfsFile: Spans of concatenated files stay within one part", "[core][file_sys]") {
+    const VirtualFile concat = ConcatenatedVfsFile::MakeConcatenatedFile(
+        {std::make_shared<VectorVfsFile>(SequentialBytes(0x100, 0)),
+         std::make_shared<VectorVfsFile>(SequentialBytes(0x100, 0))},
+        "concat");
+    REQUIRE(concat->GetSize() == 0x200);
+
+    RequireSpanMatchesRead(concat, 0x80, 0x40);
+    RequireSpanMatchesRead(concat, 0x100, 0x100);
+    RequireSpanMatchesRead(concat, 0x400, 0x180);
+
+    // Ranges crossing parts aren't contiguous and have to be read instead.
+    REQUIRE(concat->ReadSpan(0x20, 0xF0).data == nullptr);
+    REQUIRE(concat->ReadBytes(0x20, 0xF0) == SequentialBytes(0x20, 0xF0));
+}
+
+TEST_CASE("RealVfsFile: Read-only files are mapped", "[core][file_sys]") {
+    // Removed even if the test fails, once the filesystem has closed the file
+    const std::string directory = FileUtil::GetTempDir() + DIR_SEP +
+                                  fmt::format("yuzu_vfs_span_test_{:08X}", std::random_device{}());
+    REQUIRE(FileUtil::CreateDir(directory));
+    SCOPE_EXIT({ FileUtil::DeleteDirRecursively(directory); });
+
+    const std::string path = directory + DIR_SEP "vfs_span_test.bin";
+    const std::vector<u8> contents = SequentialBytes(0x3000, 0x40);
+    RealVfsFilesystem fs;
+
+    {
+        const VirtualFile file = fs.CreateFile(path, Mode::ReadWrite);
+        REQUIRE(file != nullptr);
+        REQUIRE(file->WriteBytes(contents) == contents.size());
+        // Writable files may be resized, they never hand out views.
+        REQUIRE(file->ReadSpan(0x10, 0).data == nullptr);
+    }
+
+    {
+        const VirtualFile file = fs.OpenFile(path, Mode::Read);
+        REQUIRE(file != nullptr);
+        RequireSpanMatchesRead(file, contents.size(), 0);
+        RequireSpanMatchesRead(file, 0x1000, 0x2800);
+        REQUIRE(file->ReadAllBytes() == contents);
+        REQUIRE(file->ReadSpan(0x10, contents.size()).data == nullptr);
+
+        const auto offset = std::make_shared<OffsetVfsFile>(file, 0x100, 0x1000);
+        RequireSpanMatchesRead(offset, 0x100, 0x20);
+    }
+
+    REQUIRE(fs.DeleteFile(path));
+}
+
+} // namespace FileSys
@@ -0,0 +1,101 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_funcs.h"
+#include "common/common_paths.h"
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "core/file_sys/vfs_real.h"
+#include "core/game_scanner.h"
+#include "core/loader/loader.h"
+
+namespace Core {
+namespace {
+
+constexpr char TEST_DIRECTORY[] = "game_scanner_test";
+
+/// Writes a file the NSO loader accepts, it has no metadata of its own.
+void CreateGameFile(const std::string& path) {
+    FileUtil::IOFile file(path, "wb");
+    const std::vector<u8> padding(0x100);
+    REQUIRE(file.WriteObject(Common::MakeMagic('N', 'S', 'O', '0')) == 1);
+    REQUIRE(file.WriteBytes(padding.data(), padding.size()) == padding.size());
+}
+
+/// Creates a directory with games, files that aren't games and a subdirectory with more games
+void CreateGameDirectory(std::size_t num_games, std::size_t num_nested_games) {
+    FileUtil::DeleteDirRecursively(TEST_DIRECTORY);
+    REQUIRE(FileUtil::CreateFullPath(std::string(TEST_DIRECTORY) + "/nested/"));
+
+    for (std::size_t i = 0; i < num_games; ++i)
+        CreateGameFile(fmt::format("{}/game_{}.nso", TEST_DIRECTORY, i));
+    for (std::size_t i = 0; i < num_nested_games; ++i)
+        CreateGameFile(fmt::format("{}/nested/game_{}.NSO", TEST_DIRECTORY, i));
+    FileUtil::IOFile(fmt::format("{}/readme.txt", TEST_DIRECTORY), "wb");
+}
+
+/// Returns the paths of the games found, in the order they were reported
+std::vector<std::string> ScanGamePaths(std::size_t num_workers, unsigned int recursion,
+                                       std::vector<std::string>& directories) {
+    GameScanner scanner(std::make_shared<FileSys::RealVfsFilesystem>(), num_workers);
+    std::vector<std::string> paths;
+    scanner.ScanDirectory(
+        TEST_DIRECTORY, recursion,
+        [&paths](ScannedGame game) {
+            REQUIRE(game.metadata.file_type == Loader::FileType::NSO);
+            REQUIRE(game.size == 0x104);
+            paths.push_back(std::move(game.path));
+        },
+        [&directories](const std::string& directory) { directories.push_back(directory); });
+    return paths;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("GameScanner: Games are reported in the order they are found", "[core]") {
+    constexpr std::size_t num_games = 64;
+    constexpr std::size_t num_nested_games = 8;
+    CreateGameDirectory(num_games, num_nested_games);
+
+    std::vector<std::string> directories;
+    const auto serial_paths = ScanGamePaths(0, 1, directories);
+    REQUIRE(serial_paths.size() == num_games + num_nested_games);
+    REQUIRE(directories.size() == 1);
+    REQUIRE(directories[0] == std::string(TEST_DIRECTORY) + DIR_SEP + "nested");
+
+    for (const std::size_t num_workers : {1, 3, 8}) {
+        directories.clear();
+        REQUIRE(ScanGamePaths(num_workers, 1, directories) == serial_paths);
+        REQUIRE(directories.size() == 1);
+    }
+
+    // Subdirectories are only scanned when asked to.
+    directories.clear();
+    REQUIRE(ScanGamePaths(4, 0, directories).size() == num_games);
+    REQUIRE(directories.empty());
+
+    FileUtil::DeleteDirRecursively(TEST_DIRECTORY);
+}
+
+TEST_CASE("GameScanner: No games are reported once cancelled", "[core]") {
+    CreateGameDirectory(64, 0);
+
+    GameScanner scanner(std::make_shared<FileSys::RealVfsFilesystem>(), 4);
+    std::size_t num_reported = 0;
+    scanner.ScanDirectory(TEST_DIRECTORY, 0, [&](ScannedGame game) {
+        ++num_reported;
+        scanner.Cancel();
+    });
+    REQUIRE(num_reported == 1);
+
+    FileUtil::DeleteDirRecursively(TEST_DIRECTORY);
+}
+
+} // namespace Core
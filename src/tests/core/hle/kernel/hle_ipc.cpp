@@ -0,0 +1,148 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "core/core.h"
+#include "core/file_sys/vfs_vector.h"
+#include "core/hle/ipc.h"
+#include "core/hle/kernel/client_port.h"
+#include "core/hle/kernel/client_session.h"
+#include "core/hle/kernel/hle_ipc.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/server_session.h"
+#include "core/hle/kernel/vm_manager.h"
+#include "core/memory.h"
+#include "core/memory_setup.h"
+#include "tests/core/memory_test_common.h"
+#include "tests/test_common.h"
+
+namespace Kernel {
+namespace {
+
+constexpr u64 CACHED_REGION_SIZE = 0x10 * Memory::PAGE_SIZE;
+
+/// Sets up the memory of a process as in MemoryTests::TestEnvironment, and a session to receive
+/// requests on.
+class IPCEnvironment final : public MemoryTests::TestEnvironment {
+public:
+    explicit IPCEnvironment(u64 memory_size)
+        : TestEnvironment("hle_ipc_test", memory_size, CACHED_REGION_SIZE) {
+        server_session = std::get<SharedPtr<ServerSession>>(ServerSession::CreateSessionPair(
+            Core::System::GetInstance().Kernel(), "hle_ipc_test"));
+    }
+
+    ~IPCEnvironment() {
+        server_session = nullptr;
+    }
+
+    /// Fills in a request with a single B buffer descriptor, as sent by a guest.
+    void PopulateRequest(HLERequestContext& ctx, VAddr address, u64 size) const {
+        IPC::CommandHeader header{};
+        header.type.Assign(IPC::CommandType::Request);
+        header.num_buf_b_descriptors.Assign(1);
+        header.data_size.Assign(8);
+
+        IPC::BufferDescriptorABW buffer{};
+        buffer.size_bits_0_31 = static_cast<u32>(size);
+        buffer.size_bits_32_35.Assign(static_cast<u32>(size >> 32));
+        buffer.address_bits_0_31 = static_cast<u32>(address);
+        buffer.address_bits_32_35.Assign(static_cast<u32>(address >> 32));
+        buffer.address_bits_36_38.Assign(static_cast<u32>(address >> 36));
+
+        // The data payload follows the descriptors, aligned to 16 bytes.
+        IPC::DataPayloadHeader payload{};
+        payload.magic = Common::MakeMagic('S', 'F', 'C', 'I');
+
+        std::array<u32_le, IPC::COMMAND_BUFFER_LENGTH> cmdbuf{};
+        std::memcpy(&cmdbuf[0], &header, sizeof(header));
+        std::memcpy(&cmdbuf[2], &buffer, sizeof(buffer));
+        std::memcpy(&cmdbuf[8], &payload, sizeof(payload));
+        REQUIRE(ctx.PopulateFromIncomingCommandBuffer(process->GetHandleTable(), cmdbuf.data())
+                    .IsSuccess());
+    }
+
+    SharedPtr<ServerSession> server_session;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("HLERequestContext: Direct buffer writes cover each page type", "[core][kernel]") {
+    constexpr u64 memory_size = 0x10 * Memory::PAGE_SIZE;
+    constexpr u64 buffer_size = 0x3000;
+    IPCEnvironment env(memory_size);
+
+    // The buffer starts in regular memory and ends in rasterizer cached memory.
+    const VAddr address = env.cached_base - 0x800;
+    HLERequestContext ctx(env.server_session);
+    env.PopulateRequest(ctx, address, buffer_size);
+    REQUIRE(ctx.GetWriteBufferSize() == buffer_size);
+
+    std::vector<std::size_t> run_offsets;
+    const auto fill = [&run_offsets](u8* dest, std::size_t size, std::size_t offset) {
+        run_offsets.push_back(offset);
+        for (std::size_t i = 0; i < size; ++i) {
+            dest[i] = static_cast<u8>((offset + i) * 7);
+        }
+        return size;
+    };
+
+    // Requests larger than the buffer are truncated to it.
+    REQUIRE(ctx.WriteBufferDirect(buffer_size * 2, fill) == buffer_size);
+    for (std::size_t i = 0; i < buffer_size; ++i) {
+        REQUIRE((*env.block)[address - env.memory_base + i] == static_cast<u8>(i * 7));
+    }
+
+    // Regular memory is written in one run, cached memory one page at a time.
+    const std::vector<std::size_t> expected_offsets{0, 0x800, 0x1800, 0x2800};
+    REQUIRE(run_offsets == expected_offsets);
+
+    // Writing stops at the first short write.
+    const auto short_write = [](u8* dest, std::size_t size, std::size_t offset) {
+        return size / 2;
+    };
+    REQUIRE(ctx.WriteBufferDirect(buffer_size, short_write) == 0x400);
+}
+
+TEST_CASE("HLERequestContext: File read throughput", "[.benchmark][core][kernel]") {
+    constexpr u64 max_size = 64 * 1024 * 1024;
+    constexpr std::size_t iterations = 8;
+    IPCEnvironment env(max_size);
+    const FileSys::VirtualFile file =
+        std::make_shared<FileSys::VectorVfsFile>(std::vector<u8>(max_size, 0xA5));
+
+    for (u64 size = 1024 * 1024; size <= max_size; size *= 4) {
+        HLERequestContext ctx(env.server_session);
+        env.PopulateRequest(ctx, env.memory_base, size);
+
+        const auto measure = [size](const char* name, const auto& read) {
+            const auto elapsed =
+                TestCommon::MeasureTime([&] { REQUIRE(read() == size); }, iterations);
+
+            TestCommon::ReportBenchmark(
+                fmt::format("{:>3} MiB {}", size / (1024 * 1024), name),
+                fmt::format("{:>6.2f} GB/s",
+                            static_cast<double>(size * iterations) / elapsed.count() / 1e9));
+        };
+
+        measure("intermediate copy", [&] { return ctx.WriteBuffer(file->ReadBytes(size, 0)); });
+        measure("direct", [&] {
+            return ctx.WriteBufferDirect(size, [&](u8* dest, std::size_t run_size,
+                                                   std::size_t offset) {
+                return file->Read(dest, run_size, offset);
+            });
+        });
+    }
+}
+
+} // namespace Kernel
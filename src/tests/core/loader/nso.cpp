@@ -0,0 +1,152 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <cstring>
+#include <future>
+#include <optional>
+#include <vector>
+#include <lz4.h>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "core/file_sys/vfs_vector.h"
+#include "core/loader/nso.h"
+#include "core/memory.h"
+
+namespace Loader {
+namespace {
+
+constexpr std::size_t HEADER_SIZE = 0x100;
+constexpr u32 BSS_SIZE = 0x1800;
+constexpr u32 MOD_BSS_SIZE = 0x5000;
+
+/// Sizes of the .text, .rodata and .data segments
+constexpr std::array<u32, 3> SEGMENT_SIZES{0x3000, 0x1000, 0x1234};
+
+template <typename T>
+void WriteAt(std::vector<u8>& data, std::size_t offset, const T& value) {
+    std::memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+std::vector<u8> MakeSegment(std::size_t index) {
+    std::vector<u8> segment(SEGMENT_SIZES[index]);
+    for (std::size_t i = 0; i < segment.size(); ++i)
+        segment[i] = static_cast<u8>((i * (index + 3)) ^ (i >> 8));
+    return segment;
+}
+
+/**
+ * Builds an NSO with a compressed .text and .data and an uncompressed .rodata. The .text contains
+ * a MOD header at 0x100, which sets the size of .bss.
+ */
+std::vector<u8> BuildNSO(bool with_mod_header, std::array<std::vector<u8>, 3>& segments) {
+    std::vector<u8> nso(HEADER_SIZE);
+    WriteAt(nso, 0x0, Common::MakeMagic('N', 'S', 'O', '0'));
+    WriteAt(nso, 0xC, static_cast<u8>(0b101));
+
+    u32 location = 0;
+    for (std::size_t i = 0; i < segments.size(); ++i) {
+        segments[i] = MakeSegment(i);
+        if (i == 0 && with_mod_header) {
+            WriteAt(segments[0], 4, u32{0x100});
+            WriteAt(segments[0], 0x100, Common::MakeMagic('M', 'O', 'D', '0'));
+            WriteAt(segments[0], 0x108, u32{0x10000});
+            WriteAt(segments[0], 0x10C, u32{0x10000 + MOD_BSS_SIZE});
+        }
+
+        std::vector<u8> stored = segments[i];
+        if (i != 1) {
+            stored.resize(LZ4_compressBound(static_cast<int>(segments[i].size())));
+            const int size = LZ4_compress_default(
+                reinterpret_cast<const char*>(segments[i].data()),
+                reinterpret_cast<char*>(stored.data()), static_cast<int>(segments[i].size()),
+                static_cast<int>(stored.size()));
+            REQUIRE(size > 0);
+            stored.resize(size);
+        }
+
+        const std::size_t header_offset = 0x10 + i * 0x10;
+        WriteAt(nso, header_offset, static_cast<u32>(nso.size()));
+        WriteAt(nso, header_offset + 4, location);
+        WriteAt(nso, header_offset + 8, static_cast<u32>(segments[i].size()));
+        WriteAt(nso, header_offset + 12, i == 2 ? BSS_SIZE : u32{0x1000});
+        WriteAt(nso, 0x60 + i * 4, static_cast<u32>(stored.size()));
+
+        nso.insert(nso.end(), stored.begin(), stored.end());
+        location += static_cast<u32>(segments[i].size() + Memory::PAGE_MASK) & ~Memory::PAGE_MASK;
+    }
+
+    return nso;
+}
+
+std::optional<NSOImage> ReadNSO(std::vector<u8> data) {
+    const FileSys::VectorVfsFile file(std::move(data), "main");
+    return AppLoader_NSO::ReadModule(file, false).get();
+}
+
+void CheckImage(const NSOImage& image, const std::array<std::vector<u8>, 3>& segments,
+                u32 bss_size) {
+    const auto& program_image = *image.codeset.memory;
+    for (std::size_t i = 0; i < segments.size(); ++i) {
+        const auto& segment = image.codeset.segments[i];
+        REQUIRE(segment.size >= segments[i].size());
+        REQUIRE(segment.offset + segments[i].size() <= program_image.size());
+        REQUIRE(std::memcmp(program_image.data() + segment.offset, segments[i].data(),
+                            segments[i].size()) == 0);
+    }
+
+    const auto& data = image.codeset.DataSegment();
+    REQUIRE(data.size == 0x2000 + bss_size);
+    REQUIRE(program_image.size() == data.offset + data.size);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("NSO: Segments are decompressed into the program image", "[core][loader]") {
+    std::array<std::vector<u8>, 3> segments;
+
+    const auto image = ReadNSO(BuildNSO(true, segments));
+    REQUIRE(image);
+    CheckImage(*image, segments, MOD_BSS_SIZE);
+    REQUIRE(image->header.size() == HEADER_SIZE);
+
+    // Without a MOD header, .bss is sized from the NSO header.
+    const auto image_without_mod = ReadNSO(BuildNSO(false, segments));
+    REQUIRE(image_without_mod);
+    CheckImage(*image_without_mod, segments, 0x2000);
+}
+
+TEST_CASE("NSO: Modules read in a row are decompressed concurrently", "[core][loader]") {
+    std::array<std::vector<u8>, 3> segments;
+    const auto nso = BuildNSO(true, segments);
+
+    std::vector<std::future<std::optional<NSOImage>>> images;
+    for (std::size_t i = 0; i < 8; ++i)
+        images.push_back(AppLoader_NSO::ReadModule(FileSys::VectorVfsFile(nso), false));
+
+    for (auto& image : images) {
+        const auto result = image.get();
+        REQUIRE(result);
+        CheckImage(*result, segments, MOD_BSS_SIZE);
+    }
+}
+
+TEST_CASE("NSO: Invalid NSOs aren't read", "[core][loader]") {
+    std::array<std::vector<u8>, 3> segments;
+    auto nso = BuildNSO(true, segments);
+
+    REQUIRE(!ReadNSO(std::vector<u8>(nso.begin(), nso.begin() + 0x40)));
+
+    auto bad_magic = nso;
+    bad_magic[0] = 'X';
+    REQUIRE(!ReadNSO(bad_magic));
+
+    // The compressed .data is cut short.
+    nso.resize(nso.size() - 0x10);
+    REQUIRE(!ReadNSO(nso));
+}
+
+} // namespace Loader
@@ -0,0 +1,316 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <memory>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "core/core.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/vm_manager.h"
+#include "core/memory.h"
+#include "core/memory_hook.h"
+#include "core/memory_setup.h"
+#include "tests/core/memory_test_common.h"
+#include "tests/test_common.h"
+
+namespace {
+
+/// MMIO handler returning a fixed pattern and counting the accesses made to it.
+class CountingHook final : public Memory::MemoryHook {
+public:
+    boost::optional<bool> IsValidAddress(VAddr addr) override {
+        return true;
+    }
+
+    boost::optional<u8> Read8(VAddr addr) override {
+        ++reads;
+        return static_cast<u8>(addr);
+    }
+    boost::optional<u16> Read16(VAddr addr) override {
+        ++reads;
+        return static_cast<u16>(addr);
+    }
+    boost::optional<u32> Read32(VAddr addr) override {
+        ++reads;
+        return static_cast<u32>(addr);
+    }
+    boost::optional<u64> Read64(VAddr addr) override {
+        ++reads;
+        return addr;
+    }
+
+    bool ReadBlock(VAddr src_addr, void* dest_buffer, std::size_t size) override {
+        return false;
+    }
+
+    bool Write8(VAddr addr, u8 data) override {
+        ++writes;
+        return true;
+    }
+    bool Write16(VAddr addr, u16 data) override {
+        ++writes;
+        return true;
+    }
+    bool Write32(VAddr addr, u32 data) override {
+        ++writes;
+        return true;
+    }
+    bool Write64(VAddr addr, u64 data) override {
+        ++writes;
+        return true;
+    }
+
+    bool WriteBlock(VAddr dest_addr, const void* src_buffer, std::size_t size) override {
+        return false;
+    }
+
+    u64 reads = 0;
+    u64 writes = 0;
+};
+
+constexpr u64 REGION_SIZE = 0x10 * Memory::PAGE_SIZE;
+
+/**
+ * Sets up a process with a region of each page type in its heap region, the special region
+ * following the cached one. Only the memory subsystem overhead is measured, as rasterizer flushes
+ * are no-ops.
+ */
+class MemoryEnvironment final : public MemoryTests::TestEnvironment {
+public:
+    MemoryEnvironment() : TestEnvironment("memory_test", REGION_SIZE, REGION_SIZE) {
+        special_base = cached_base + REGION_SIZE;
+
+        hook = std::make_shared<CountingHook>();
+        REQUIRE(process->VMManager()
+                    .MapMMIO(special_base, 0, REGION_SIZE, Kernel::MemoryState::Io, hook)
+                    .Succeeded());
+    }
+
+    std::shared_ptr<CountingHook> hook;
+
+    VAddr special_base = 0;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("Memory: Accesses resolve through each page type", "[core][memory]") {
+    MemoryEnvironment env;
+
+    Memory::Write32(env.memory_base + 0x10, 0xDEADBEEF);
+    REQUIRE(Memory::Read32(env.memory_base + 0x10) == 0xDEADBEEF);
+
+    // Cached pages are backed by the same block, right after the uncached ones.
+    Memory::Write32(env.cached_base + 0x20, 0xCAFEBABE);
+    REQUIRE(Memory::Read32(env.cached_base + 0x20) == 0xCAFEBABE);
+    REQUIRE(Memory::Read32(env.cached_base + 0x20) == 0xCAFEBABE);
+    REQUIRE((*env.block)[REGION_SIZE + 0x20] == 0xBE);
+
+    REQUIRE(Memory::Read16(env.special_base + 0x1234) == 0x1234);
+    Memory::Write64(env.special_base, 0);
+    REQUIRE(env.hook->reads == 1);
+    REQUIRE(env.hook->writes == 1);
+}
+
+TEST_CASE("Memory: Changing page attributes invalidates cached translations", "[core][memory]") {
+    MemoryEnvironment env;
+
+    Memory::Write32(env.cached_base, 0x12345678);
+    REQUIRE(Memory::Read32(env.cached_base) == 0x12345678);
+
+    // Uncaching the page must switch back to the pointer fast path with the same contents.
+    Memory::RasterizerMarkRegionCached(env.cached_base, REGION_SIZE, false);
+    REQUIRE(Memory::Read32(env.cached_base) == 0x12345678);
+
+    // Remapping the page must not leave stale pointers behind.
+    std::vector<u8> other(Memory::PAGE_SIZE);
+    Memory::RasterizerMarkRegionCached(env.cached_base, REGION_SIZE, true);
+    REQUIRE(Memory::Read32(env.cached_base) == 0x12345678);
+    Memory::MapMemoryRegion(env.process->VMManager().page_table, env.cached_base,
+                            Memory::PAGE_SIZE, other.data());
+    REQUIRE(Memory::Read32(env.cached_base) == 0);
+}
+
+TEST_CASE("Memory: Marking remapped memory cached does not reuse stale translations",
+          "[core][memory]") {
+    MemoryEnvironment env;
+    auto& vm_manager = env.process->VMManager();
+
+    // Fill the TLB entry of the cached page, which resolves into the original block.
+    Memory::Write32(env.cached_base, 0x12345678);
+    REQUIRE(Memory::Read32(env.cached_base) == 0x12345678);
+
+    // Move the whole region over to another block as regular memory and read it back.
+    Memory::RasterizerMarkRegionCached(env.cached_base, REGION_SIZE, false);
+    const auto other = std::make_shared<std::vector<u8>>(REGION_SIZE * 2);
+    vm_manager.vma_map[env.memory_base].backing_block = other;
+    Memory::MapMemoryRegion(vm_manager.page_table, env.memory_base, REGION_SIZE * 2,
+                            other->data());
+    Memory::Write32(env.cached_base, 0xCAFEBABE);
+    REQUIRE(Memory::Read32(env.cached_base) == 0xCAFEBABE);
+
+    // Once cached again, the page must resolve into the new block rather than the old entry.
+    Memory::RasterizerMarkRegionCached(env.cached_base, REGION_SIZE, true);
+    REQUIRE(Memory::Read32(env.cached_base) == 0xCAFEBABE);
+    Memory::Write32(env.cached_base, 0xDEADBEEF);
+    REQUIRE((*other)[REGION_SIZE] == 0xEF);
+    REQUIRE((*env.block)[REGION_SIZE] == 0x78);
+}
+
+TEST_CASE("Memory: Block accesses merge pages contiguous in host memory", "[core][memory]") {
+    MemoryEnvironment env;
+    auto& vm_manager = env.process->VMManager();
+    constexpr std::size_t page_size = Memory::PAGE_SIZE;
+
+    for (std::size_t i = 0; i < env.block->size(); ++i) {
+        (*env.block)[i] = static_cast<u8>(i * 7);
+    }
+    const auto expected = [&env](std::size_t offset, std::size_t size) {
+        return std::vector<u8>(env.block->begin() + offset, env.block->begin() + offset + size);
+    };
+    std::vector<u8> data(2 * page_size);
+
+    SECTION("Runs cross VMA boundaries") {
+        // Splits the VMA of the region, the pages stay backed by the same block
+        REQUIRE(vm_manager.ReprotectRange(env.memory_base + page_size, page_size,
+                                          Kernel::VMAPermission::Read)
+                    .IsSuccess());
+        REQUIRE(vm_manager.FindVMA(env.memory_base)->second.size == page_size);
+
+        const VAddr addr = env.memory_base + page_size / 2;
+        REQUIRE(Memory::GetContiguousPointer(addr, 2 * page_size) ==
+                env.block->data() + page_size / 2);
+        std::size_t run_size;
+        REQUIRE(Memory::GetWritePointer(addr, 2 * page_size, run_size) ==
+                env.block->data() + page_size / 2);
+        REQUIRE(run_size == 2 * page_size);
+
+        Memory::ReadBlock(addr, data.data(), data.size());
+        REQUIRE(data == expected(page_size / 2, data.size()));
+    }
+
+    SECTION("Runs stop at rasterizer cached pages") {
+        Memory::RasterizerMarkRegionCached(env.memory_base + page_size, page_size, true);
+
+        REQUIRE(Memory::GetContiguousPointer(env.memory_base, page_size) == env.block->data());
+        REQUIRE(Memory::GetContiguousPointer(env.memory_base, page_size + 1) == nullptr);
+        std::size_t run_size;
+        REQUIRE(Memory::GetWritePointer(env.memory_base, 3 * page_size, run_size) ==
+                env.block->data());
+        REQUIRE(run_size == page_size);
+        REQUIRE(Memory::GetWritePointer(env.memory_base + page_size, 2 * page_size, run_size) ==
+                env.block->data() + page_size);
+        REQUIRE(run_size == page_size);
+
+        // The accesses spanning the cached page go through it and continue after it
+        const VAddr addr = env.memory_base + page_size / 2;
+        Memory::ReadBlock(addr, data.data(), data.size());
+        REQUIRE(data == expected(page_size / 2, data.size()));
+
+        std::fill(data.begin(), data.end(), u8{0xAB});
+        Memory::WriteBlock(addr, data.data(), data.size());
+        REQUIRE(expected(page_size / 2, data.size()) == data);
+        REQUIRE((*env.block)[page_size / 2 - 1] == static_cast<u8>((page_size / 2 - 1) * 7));
+        REQUIRE((*env.block)[page_size / 2 + data.size()] ==
+                static_cast<u8>((page_size / 2 + data.size()) * 7));
+    }
+
+    SECTION("Runs stop where host memory isn't contiguous") {
+        // Like an adjacent VMA backed by another block
+        std::vector<u8> other(page_size, 0x55);
+        Memory::MapMemoryRegion(vm_manager.page_table, env.memory_base + page_size, page_size,
+                                other.data());
+
+        REQUIRE(Memory::GetContiguousPointer(env.memory_base, 2 * page_size) == nullptr);
+        std::size_t run_size;
+        REQUIRE(Memory::GetWritePointer(env.memory_base, 3 * page_size, run_size) ==
+                env.block->data());
+        REQUIRE(run_size == page_size);
+        REQUIRE(Memory::GetWritePointer(env.memory_base + page_size, 2 * page_size, run_size) ==
+                other.data());
+        REQUIRE(run_size == page_size);
+
+        // The original block resumes right after the other one
+        const VAddr addr = env.memory_base + page_size / 2;
+        Memory::ReadBlock(addr, data.data(), data.size());
+        REQUIRE(std::vector<u8>(data.begin(), data.begin() + page_size / 2) ==
+                expected(page_size / 2, page_size / 2));
+        REQUIRE(std::vector<u8>(data.begin() + page_size / 2, data.end() - page_size / 2) ==
+                other);
+        REQUIRE(std::vector<u8>(data.end() - page_size / 2, data.end()) ==
+                expected(2 * page_size, page_size / 2));
+
+        std::fill(data.begin(), data.end(), u8{0xAB});
+        Memory::WriteBlock(addr, data.data(), data.size());
+        REQUIRE(other == std::vector<u8>(page_size, 0xAB));
+        REQUIRE(expected(page_size / 2, page_size / 2) == std::vector<u8>(page_size / 2, 0xAB));
+        REQUIRE(expected(2 * page_size, page_size / 2) == std::vector<u8>(page_size / 2, 0xAB));
+        // The block's own page in between is left untouched
+        REQUIRE((*env.block)[page_size] == static_cast<u8>(page_size * 7));
+    }
+}
+
+TEST_CASE("Memory: Access latency per page type", "[.benchmark][core][memory]") {
+    constexpr u64 iterations = 10000000;
+    MemoryEnvironment env;
+
+    const auto measure = [](const char* name, VAddr base) {
+        u64 sum = 0;
+        const auto elapsed = TestCommon::MeasureTime([&] {
+            for (u64 i = 0; i < iterations; ++i) {
+                // Walk over a few pages to also exercise distinct TLB entries.
+                sum += Memory::Read32(base + ((i * 8) & (REGION_SIZE - 1)));
+            }
+        });
+
+        TestCommon::ReportBenchmark(name, fmt::format("{:>8.2f} ns/access (checksum {:x})",
+                                                      elapsed.count() * 1e9 / iterations, sum));
+    };
+
+    measure("Memory", env.memory_base);
+    measure("RasterizerCachedMemory", env.cached_base);
+    measure("Special", env.special_base);
+}
+
+TEST_CASE("Memory: Page tables only allocate populated leaves", "[core][memory]") {
+    Memory::PageTable page_table(39);
+    const std::size_t empty_size = page_table.GetResidentSize();
+    REQUIRE(page_table.GetAttribute(0x12345) == Memory::PageType::Unmapped);
+
+    // Unmapping the whole address space must not populate anything.
+    Memory::UnmapRegion(page_table, 0, 1ULL << 39);
+    REQUIRE(page_table.GetResidentSize() == empty_size);
+
+    std::vector<u8> backing(2 * Memory::PAGE_SIZE);
+    Memory::MapMemoryRegion(page_table, 0x10000000, backing.size(), backing.data());
+    REQUIRE(page_table.GetAttribute(0x10000) == Memory::PageType::Memory);
+    REQUIRE(page_table.pointers[0x10001] == backing.data() + Memory::PAGE_SIZE);
+    REQUIRE(page_table.GetResidentSize() > empty_size);
+
+    page_table.Clear();
+    REQUIRE(page_table.GetAttribute(0x10000) == Memory::PageType::Unmapped);
+    REQUIRE(page_table.pointers[0x10001] == nullptr);
+}
+
+TEST_CASE("Memory: Process creation cost", "[.benchmark][core][memory]") {
+    constexpr int iterations = 16;
+    Kernel::KernelCore kernel;
+
+    std::size_t resident_size = 0;
+    const auto elapsed = TestCommon::MeasureTime(
+        [&] {
+            const auto process = Kernel::Process::Create(kernel, "memory_test");
+            resident_size = process->VMManager().page_table.GetResidentSize();
+            kernel.Shutdown();
+        },
+        iterations);
+
+    TestCommon::ReportBenchmark("Process creation",
+                                fmt::format("{:.2f} ms, page table resident size: {} KiB",
+                                            elapsed.count() * 1e3 / iterations,
+                                            resident_size / 1024));
+}
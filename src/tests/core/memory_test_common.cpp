@@ -0,0 +1,58 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "core/core.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/vm_manager.h"
+#include "core/memory.h"
+#include "core/memory_setup.h"
+#include "tests/core/memory_test_common.h"
+
+namespace MemoryTests {
+
+TestEnvironment::TestEnvironment(const char* name, u64 memory_size, u64 cached_size) {
+    // Memory resolves cached pages through the current process of the global system instance.
+    auto& kernel = Core::System::GetInstance().Kernel();
+    process = Kernel::Process::Create(kernel, name);
+    kernel.MakeCurrentProcess(process.get());
+
+    auto& vm_manager = process->VMManager();
+    memory_base = vm_manager.GetHeapRegionBaseAddress();
+    cached_base = memory_base + memory_size;
+
+    // The CPU cores do not exist without a running system, so the backing VMA is inserted
+    // directly instead of going through VMManager::MapMemoryBlock. The free VMA it lands in is
+    // split around it, so the VMManager can still map the memory after it.
+    const u64 total_size = memory_size + cached_size;
+    const Kernel::VirtualMemoryArea free_vma = vm_manager.FindVMA(memory_base)->second;
+    vm_manager.vma_map[free_vma.base].size = memory_base - free_vma.base;
+
+    Kernel::VirtualMemoryArea free_tail = free_vma;
+    free_tail.base = memory_base + total_size;
+    free_tail.size = free_vma.base + free_vma.size - free_tail.base;
+    vm_manager.vma_map[free_tail.base] = free_tail;
+
+    block = std::make_shared<std::vector<u8>>(total_size);
+    Kernel::VirtualMemoryArea vma;
+    vma.base = memory_base;
+    vma.size = total_size;
+    vma.type = Kernel::VMAType::AllocatedMemoryBlock;
+    vma.permissions = Kernel::VMAPermission::ReadWrite;
+    vma.meminfo_state = Kernel::MemoryState::Heap;
+    vma.backing_block = block;
+    vm_manager.vma_map[memory_base] = vma;
+    Memory::MapMemoryRegion(vm_manager.page_table, memory_base, total_size, block->data());
+
+    Memory::SetCurrentPageTable(&vm_manager.page_table);
+    Memory::RasterizerMarkRegionCached(cached_base, cached_size, true);
+}
+
+TestEnvironment::~TestEnvironment() {
+    Memory::SetCurrentPageTable(nullptr);
+    process = nullptr;
+    Core::System::GetInstance().Kernel().Shutdown();
+}
+
+} // namespace MemoryTests
@@ -0,0 +1,43 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/common_types.h"
+#include "core/hle/kernel/object.h"
+
+namespace Kernel {
+class Process;
+}
+
+namespace MemoryTests {
+
+/**
+ * Sets up a process of the global system instance whose heap region starts with a region of
+ * regular memory followed by a region of rasterizer cached memory, both backed by the same block.
+ * The system is never powered on, so rasterizer flushes are no-ops.
+ */
+class TestEnvironment {
+public:
+    /**
+     * @param name Name of the process
+     * @param memory_size Size in bytes of the regular memory region
+     * @param cached_size Size in bytes of the rasterizer cached region following it
+     */
+    TestEnvironment(const char* name, u64 memory_size, u64 cached_size);
+
+    /// Shuts down the kernel, releasing the process and everything created for it
+    ~TestEnvironment();
+
+    Kernel::SharedPtr<Kernel::Process> process;
+    std::shared_ptr<std::vector<u8>> block;
+
+    VAddr memory_base = 0;
+    VAddr cached_base = 0;
+};
+
+} // namespace MemoryTests
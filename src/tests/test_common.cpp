@@ -0,0 +1,25 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstdio>
+#include <fmt/format.h>
+#include "tests/test_common.h"
+
+namespace TestCommon {
+
+std::vector<u8> RandomBytes(std::size_t size, std::mt19937& rng) {
+    std::uniform_int_distribution<u32> distribution(0, 255);
+    std::vector<u8> bytes(size);
+    for (u8& byte : bytes) {
+        byte = static_cast<u8>(distribution(rng));
+    }
+    return bytes;
+}
+
+void ReportBenchmark(std::string_view name, std::string_view results) {
+    fmt::print("{:<40} {}\n", name, results);
+    std::fflush(stdout);
+}
+
+} // namespace TestCommon
@@ -0,0 +1,39 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "common/common_types.h"
+
+namespace TestCommon {
+
+/// Returns the given number of bytes drawn from the generator, seeded by the caller so that the
+/// data of a test is the same on every run
+std::vector<u8> RandomBytes(std::size_t size, std::mt19937& rng);
+
+/// Runs the function the given number of times, returning the time all the runs took
+template <typename Func>
+std::chrono::duration<double> MeasureTime(Func&& func, std::size_t iterations = 1) {
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        func();
+    }
+    return std::chrono::steady_clock::now() - start;
+}
+
+/**
+ * Prints a line of results of a [.benchmark] test case. The line is flushed right away, so that
+ * results show up as they're measured.
+ * @param name What was measured, printed in a column aligned across all benchmarks
+ * @param results The measured values, formatted by the caller
+ */
+void ReportBenchmark(std::string_view name, std::string_view results);
+
+} // namespace TestCommon
@@ -0,0 +1,131 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+#include "video_core/cached_page_tracker.h"
+
+namespace {
+
+using Regions = std::vector<std::pair<VAddr, u64>>;
+
+constexpr u64 PAGE_SIZE = VideoCore::CachedPageTracker::PAGE_SIZE;
+
+Regions UpdateCachedCount(VideoCore::CachedPageTracker& tracker, VAddr addr, u64 size, int delta) {
+    Regions regions;
+    tracker.UpdateCachedCount(addr, size, delta,
+                              [&](VAddr run_addr, u64 run_size) {
+                                  regions.emplace_back(run_addr, run_size);
+                              });
+    return regions;
+}
+
+Regions ConsumeDirtyRegions(VideoCore::CachedPageTracker& tracker) {
+    Regions regions;
+    tracker.ConsumeDirtyRegions(
+        [&](VAddr addr, u64 size) { regions.emplace_back(addr, size); });
+    return regions;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("CachedPageTracker: Reports the pages becoming cached and uncached", "[video_core]") {
+    VideoCore::CachedPageTracker tracker;
+
+    REQUIRE(UpdateCachedCount(tracker, PAGE_SIZE, 2 * PAGE_SIZE, 1) ==
+            Regions{{PAGE_SIZE, 2 * PAGE_SIZE}});
+
+    // Only the page that wasn't cached yet changes
+    REQUIRE(UpdateCachedCount(tracker, 2 * PAGE_SIZE, 2 * PAGE_SIZE, 1) ==
+            Regions{{3 * PAGE_SIZE, PAGE_SIZE}});
+
+    // The second page is still used by the second object
+    REQUIRE(UpdateCachedCount(tracker, PAGE_SIZE, 2 * PAGE_SIZE, -1) ==
+            Regions{{PAGE_SIZE, PAGE_SIZE}});
+    REQUIRE(UpdateCachedCount(tracker, 2 * PAGE_SIZE, 2 * PAGE_SIZE, -1) ==
+            Regions{{2 * PAGE_SIZE, 2 * PAGE_SIZE}});
+
+    // Unaligned regions cover every page they touch
+    REQUIRE(UpdateCachedCount(tracker, 5 * PAGE_SIZE + 0x800, PAGE_SIZE, 1) ==
+            Regions{{5 * PAGE_SIZE, 2 * PAGE_SIZE}});
+
+    // Runs continue across groups of pages
+    REQUIRE(UpdateCachedCount(tracker, 60 * PAGE_SIZE, 8 * PAGE_SIZE, 1) ==
+            Regions{{60 * PAGE_SIZE, 8 * PAGE_SIZE}});
+
+    REQUIRE(UpdateCachedCount(tracker, 0, 0, 1).empty());
+}
+
+TEST_CASE("CachedPageTracker: Only cached pages are marked as dirty", "[video_core]") {
+    VideoCore::CachedPageTracker tracker;
+    UpdateCachedCount(tracker, 16 * PAGE_SIZE, 4 * PAGE_SIZE, 1);
+
+    tracker.MarkRegionDirty(0x100 * PAGE_SIZE, PAGE_SIZE);
+    REQUIRE(!tracker.HasDirtyPages());
+
+    tracker.MarkRegionDirty(0, 0x100 * PAGE_SIZE);
+    REQUIRE(tracker.HasDirtyPages());
+    REQUIRE(ConsumeDirtyRegions(tracker) == Regions{{16 * PAGE_SIZE, 4 * PAGE_SIZE}});
+
+    REQUIRE(!tracker.HasDirtyPages());
+    REQUIRE(ConsumeDirtyRegions(tracker).empty());
+}
+
+TEST_CASE("CachedPageTracker: Adjacent dirty pages are coalesced", "[video_core]") {
+    VideoCore::CachedPageTracker tracker;
+    UpdateCachedCount(tracker, 60 * PAGE_SIZE, 8 * PAGE_SIZE, 1);
+    UpdateCachedCount(tracker, 200 * PAGE_SIZE, PAGE_SIZE, 1);
+
+    // Marked out of order, in small writes, and across two groups of pages
+    tracker.MarkRegionDirty(200 * PAGE_SIZE + 8, 4);
+    tracker.MarkRegionDirty(64 * PAGE_SIZE, 4);
+    tracker.MarkRegionDirty(63 * PAGE_SIZE + 0xffc, 8);
+    tracker.MarkRegionDirty(62 * PAGE_SIZE, 1);
+    tracker.MarkRegionDirty(62 * PAGE_SIZE + 1, 1);
+    tracker.MarkRegionDirty(66 * PAGE_SIZE, 4);
+
+    REQUIRE(ConsumeDirtyRegions(tracker) == Regions{{62 * PAGE_SIZE, 3 * PAGE_SIZE},
+                                                    {66 * PAGE_SIZE, PAGE_SIZE},
+                                                    {200 * PAGE_SIZE, PAGE_SIZE}});
+}
+
+TEST_CASE("CachedPageTracker: Uncached pages stop being dirty", "[video_core]") {
+    VideoCore::CachedPageTracker tracker;
+    UpdateCachedCount(tracker, 0, 2 * PAGE_SIZE, 1);
+    UpdateCachedCount(tracker, PAGE_SIZE, PAGE_SIZE, 1);
+
+    tracker.MarkRegionDirty(0, 2 * PAGE_SIZE);
+    UpdateCachedCount(tracker, 0, 2 * PAGE_SIZE, -1);
+    REQUIRE(ConsumeDirtyRegions(tracker) == Regions{{PAGE_SIZE, PAGE_SIZE}});
+
+    // Caching the page again doesn't bring its dirty bit back
+    tracker.MarkRegionDirty(PAGE_SIZE, PAGE_SIZE);
+    UpdateCachedCount(tracker, PAGE_SIZE, PAGE_SIZE, -1);
+    UpdateCachedCount(tracker, PAGE_SIZE, PAGE_SIZE, 1);
+    REQUIRE(ConsumeDirtyRegions(tracker).empty());
+
+    tracker.MarkRegionDirty(PAGE_SIZE, PAGE_SIZE);
+    REQUIRE(ConsumeDirtyRegions(tracker) == Regions{{PAGE_SIZE, PAGE_SIZE}});
+}
+
+TEST_CASE("CachedPageTracker: Regions can be uncached while consumed", "[video_core]") {
+    VideoCore::CachedPageTracker tracker;
+    UpdateCachedCount(tracker, 0, 4 * PAGE_SIZE, 1);
+    UpdateCachedCount(tracker, 100 * PAGE_SIZE, 4 * PAGE_SIZE, 1);
+    tracker.MarkRegionDirty(0, 0x200 * PAGE_SIZE);
+
+    // Like invalidating the objects of the region does
+    Regions regions;
+    tracker.ConsumeDirtyRegions([&](VAddr addr, u64 size) {
+        regions.emplace_back(addr, size);
+        UpdateCachedCount(tracker, addr, size, -1);
+    });
+
+    REQUIRE(regions == Regions{{0, 4 * PAGE_SIZE}, {100 * PAGE_SIZE, 4 * PAGE_SIZE}});
+    REQUIRE(!tracker.HasDirtyPages());
+    REQUIRE(UpdateCachedCount(tracker, 0, 4 * PAGE_SIZE, 1) == Regions{{0, 4 * PAGE_SIZE}});
+}
@@ -0,0 +1,183 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/gpu.h"
+#include "tests/test_common.h"
+#include "tests/video_core/gpu_test_common.h"
+
+namespace GPUTests {
+
+using Tegra::SubmissionMode;
+
+constexpr u64 CONST_BUFFER_OFFSET = 0x800000;
+constexpr u32 CONST_BUFFER_SIZE = 0x10000;
+
+/// Helper appending methods of the 3D engine, bound to subchannel 0, to a pushbuffer
+class PushBufferBuilder final {
+public:
+    PushBufferBuilder() {
+        Method(SubmissionMode::Increasing, 0, {static_cast<u32>(Tegra::EngineID::MAXWELL_B)});
+    }
+
+    void Method(SubmissionMode mode, u32 method, std::initializer_list<u32> args) {
+        words.push_back(EncodeHeader(mode, method, 0, static_cast<u32>(args.size())));
+        words.insert(words.end(), args);
+    }
+
+    void Method(SubmissionMode mode, u32 method, const std::vector<u32>& args) {
+        words.push_back(EncodeHeader(mode, method, 0, static_cast<u32>(args.size())));
+        words.insert(words.end(), args.begin(), args.end());
+    }
+
+    void Inline(u32 method, u32 value) {
+        words.push_back(EncodeInlineHeader(method, 0, value));
+    }
+
+    /// Binds the constant buffer to upload to, at the given position
+    void BindConstBuffer(Tegra::GPUVAddr address, u32 position) {
+        Method(SubmissionMode::Increasing, MAXWELL3D_REG_INDEX(const_buffer.cb_size),
+               {CONST_BUFFER_SIZE, static_cast<u32>(address >> 32), static_cast<u32>(address),
+                position});
+    }
+
+    std::vector<u32> words;
+};
+
+/**
+ * Builds the pushbuffer of a frame, modeled after what games submit: every draw updates the
+ * viewport and vertex formats, uploads its uniforms to a constant buffer and toggles a few states
+ * with inline methods before drawing.
+ */
+static std::vector<u32> BuildFramePushBuffer(Tegra::GPUVAddr const_buffer, std::size_t num_draws) {
+    PushBufferBuilder builder;
+    std::vector<u32> viewport(32);
+    std::vector<u32> attribs(16);
+    std::vector<u32> uniforms(64);
+
+    for (u32 draw = 0; draw < num_draws; ++draw) {
+        for (u32 i = 0; i < viewport.size(); ++i) {
+            viewport[i] = draw + i;
+        }
+        builder.Method(SubmissionMode::Increasing, MAXWELL3D_REG_INDEX(viewport_transform[0]),
+                       viewport);
+
+        for (u32 i = 0; i < attribs.size(); ++i) {
+            attribs[i] = i << 7;
+        }
+        builder.Method(SubmissionMode::Increasing, MAXWELL3D_REG_INDEX(vertex_attrib_format),
+                       attribs);
+
+        builder.BindConstBuffer(const_buffer, (draw % 64) * 0x100);
+        for (u32 i = 0; i < uniforms.size(); ++i) {
+            uniforms[i] = draw * 0x100 + i;
+        }
+        builder.Method(SubmissionMode::NonIncreasing,
+                       MAXWELL3D_REG_INDEX(const_buffer.cb_data[0]), uniforms);
+
+        builder.Inline(MAXWELL3D_REG_INDEX(depth_test_enable), draw & 1);
+        builder.Inline(MAXWELL3D_REG_INDEX(stencil_enable), 0);
+        builder.Method(SubmissionMode::Increasing, MAXWELL3D_REG_INDEX(vertex_buffer.first),
+                       {0, 3});
+        builder.Inline(MAXWELL3D_REG_INDEX(draw.vertex_end_gl), 0);
+    }
+    return builder.words;
+}
+
+TEST_CASE("GPU: Command lists are decoded", "[video_core]") {
+    GPUEnvironment env;
+    const Tegra::GPUVAddr const_buffer = env.GetGPUAddress(CONST_BUFFER_OFFSET);
+
+    PushBufferBuilder builder;
+    builder.Method(SubmissionMode::Increasing, MAXWELL3D_REG_INDEX(clear_color),
+                   {1, 2, 3, 4});
+    builder.Method(SubmissionMode::IncreaseOnce, MAXWELL3D_REG_INDEX(clear_depth),
+                   {5, 6, 7});
+    builder.Inline(MAXWELL3D_REG_INDEX(clear_stencil), 0x1234);
+
+    // Uploads with both the single data register and the whole range of data registers.
+    builder.BindConstBuffer(const_buffer, 0);
+    builder.Method(SubmissionMode::NonIncreasing, MAXWELL3D_REG_INDEX(const_buffer.cb_data[0]),
+                   {10, 11, 12, 13, 14});
+    builder.Method(SubmissionMode::Increasing, MAXWELL3D_REG_INDEX(const_buffer.cb_data[0]),
+                   {20, 21, 22});
+
+    env.GPU().PushGPUEntries({env.WriteCommandList(0, builder.words)});
+
+    const auto& regs = env.GPU().Maxwell3D().regs;
+    REQUIRE(regs.reg_array[MAXWELL3D_REG_INDEX(clear_color) + 3] == 4);
+    REQUIRE(regs.reg_array[MAXWELL3D_REG_INDEX(clear_depth)] == 5);
+    REQUIRE(regs.reg_array[MAXWELL3D_REG_INDEX(clear_depth) + 1] == 7);
+    REQUIRE(regs.reg_array[MAXWELL3D_REG_INDEX(clear_stencil)] == 0x1234);
+    REQUIRE(regs.const_buffer.cb_pos == 8 * sizeof(u32));
+
+    const std::vector<u32> expected{10, 11, 12, 13, 14, 20, 21, 22};
+    std::vector<u32> uploaded(expected.size());
+    std::memcpy(uploaded.data(), env.GetMemory(CONST_BUFFER_OFFSET), expected.size() * sizeof(u32));
+    REQUIRE(uploaded == expected);
+}
+
+TEST_CASE("GPU: Command lists spanning discontiguous pages are decoded", "[video_core]") {
+    using Tegra::MemoryManager;
+    GPUEnvironment env;
+
+    // Map two GPU pages in the reverse order of their backing memory.
+    constexpr u64 first_page_offset = 0x110000;
+    constexpr u64 second_page_offset = 0x100000;
+    auto& memory_manager = env.GPU().MemoryManager();
+    const Tegra::GPUVAddr gpu_base =
+        memory_manager.AllocateSpace(2 * MemoryManager::PAGE_SIZE, MemoryManager::PAGE_SIZE);
+    memory_manager.MapBufferEx(GPUEnvironment::MEMORY_BASE + first_page_offset, gpu_base,
+                               MemoryManager::PAGE_SIZE);
+    memory_manager.MapBufferEx(GPUEnvironment::MEMORY_BASE + second_page_offset,
+                               gpu_base + MemoryManager::PAGE_SIZE, MemoryManager::PAGE_SIZE);
+
+    PushBufferBuilder builder;
+    builder.Method(SubmissionMode::Increasing, MAXWELL3D_REG_INDEX(clear_color),
+                   {1, 2, 3, 4});
+
+    // Place the list so that the first page holds the bind and the header of the second method.
+    constexpr std::size_t words_in_first_page = 3;
+    const std::size_t bytes_in_first_page = words_in_first_page * sizeof(u32);
+    std::memcpy(env.GetMemory(first_page_offset + MemoryManager::PAGE_SIZE - bytes_in_first_page),
+                builder.words.data(), bytes_in_first_page);
+    std::memcpy(env.GetMemory(second_page_offset), builder.words.data() + words_in_first_page,
+                (builder.words.size() - words_in_first_page) * sizeof(u32));
+
+    const Tegra::GPUVAddr list_address =
+        gpu_base + MemoryManager::PAGE_SIZE - bytes_in_first_page;
+    env.GPU().PushGPUEntries(
+        {GPUEnvironment::MakeCommandListHeader(list_address, builder.words.size())});
+
+    const auto& regs = env.GPU().Maxwell3D().regs;
+    REQUIRE(regs.reg_array[MAXWELL3D_REG_INDEX(clear_color)] == 1);
+    REQUIRE(regs.reg_array[MAXWELL3D_REG_INDEX(clear_color) + 3] == 4);
+}
+
+TEST_CASE("GPU: Pushbuffer decoding throughput", "[.benchmark][video_core]") {
+    constexpr std::size_t num_draws = 1000;
+    constexpr int num_frames = 200;
+
+    GPUEnvironment env;
+    const auto pushbuffer =
+        BuildFramePushBuffer(env.GetGPUAddress(CONST_BUFFER_OFFSET), num_draws);
+    const auto header = env.WriteCommandList(0, pushbuffer);
+
+    const auto elapsed =
+        TestCommon::MeasureTime([&] { env.GPU().PushGPUEntries({header}); }, num_frames);
+
+    const double words = static_cast<double>(pushbuffer.size()) * num_frames;
+    TestCommon::ReportBenchmark("Pushbuffer replay",
+                                fmt::format("{:.2f} ms/frame, {:.1f} Mwords/s",
+                                            elapsed.count() * 1e3 / num_frames,
+                                            words / elapsed.count() / 1e6));
+}
+
+} // namespace GPUTests
@@ -0,0 +1,62 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include "common/assert.h"
+#include "core/memory.h"
+#include "core/memory_setup.h"
+#include "tests/video_core/gpu_test_common.h"
+
+namespace GPUTests {
+
+u32 EncodeHeader(Tegra::SubmissionMode mode, u32 method, u32 subchannel, u32 arg_count) {
+    Tegra::CommandHeader header{};
+    header.method.Assign(method);
+    header.subchannel.Assign(subchannel);
+    header.arg_count.Assign(arg_count);
+    header.mode.Assign(mode);
+    return header.hex;
+}
+
+u32 EncodeInlineHeader(u32 method, u32 subchannel, u32 value) {
+    Tegra::CommandHeader header{};
+    header.method.Assign(method);
+    header.subchannel.Assign(subchannel);
+    header.inline_data.Assign(value);
+    header.mode.Assign(Tegra::SubmissionMode::Inline);
+    return header.hex;
+}
+
+GPUEnvironment::GPUEnvironment(bool is_async) : page_table{36}, memory(MEMORY_SIZE) {
+    Memory::MapMemoryRegion(page_table, MEMORY_BASE, MEMORY_SIZE, memory.data());
+    Memory::SetCurrentPageTable(&page_table);
+
+    renderer.Init();
+    gpu = std::make_unique<Tegra::GPU>(renderer, is_async);
+    gpu_memory_base = gpu->MemoryManager().MapBufferEx(MEMORY_BASE, MEMORY_SIZE);
+}
+
+GPUEnvironment::~GPUEnvironment() {
+    gpu.reset();
+    Memory::SetCurrentPageTable(nullptr);
+}
+
+Tegra::CommandListHeader GPUEnvironment::WriteCommandList(u64 offset,
+                                                          const std::vector<u32>& words) {
+    const std::size_t size = words.size() * sizeof(u32);
+    ASSERT(offset + size <= MEMORY_SIZE);
+    std::memcpy(GetMemory(offset), words.data(), size);
+    return MakeCommandListHeader(GetGPUAddress(offset), words.size());
+}
+
+Tegra::CommandListHeader GPUEnvironment::MakeCommandListHeader(Tegra::GPUVAddr address,
+                                                               std::size_t num_words) {
+    Tegra::CommandListHeader header{};
+    header.entry0 = static_cast<u32>(address);
+    header.gpu_va_hi.Assign(static_cast<u32>(address >> 32));
+    header.sz.Assign(static_cast<u32>(num_words));
+    return header;
+}
+
+} // namespace GPUTests
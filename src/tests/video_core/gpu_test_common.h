@@ -0,0 +1,76 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/common_types.h"
+#include "core/frontend/emu_window.h"
+#include "core/memory.h"
+#include "video_core/command_processor.h"
+#include "video_core/gpu.h"
+#include "video_core/renderer_null/renderer_null.h"
+
+namespace GPUTests {
+
+/// Window without any context, the null renderer never draws to it
+class NullEmuWindow final : public Core::Frontend::EmuWindow {
+public:
+    void SwapBuffers() override {}
+    void PollEvents() override {}
+    void MakeCurrent() override {}
+    void DoneCurrent() override {}
+};
+
+/// Encodes a command header writing `arg_count` arguments to the given subchannel
+u32 EncodeHeader(Tegra::SubmissionMode mode, u32 method, u32 subchannel, u32 arg_count);
+
+/// Encodes a command header writing an immediate value to the given subchannel
+u32 EncodeInlineHeader(u32 method, u32 subchannel, u32 value);
+
+/**
+ * Sets up guest memory mapped to the GPU and a GPU processing command lists with the null
+ * renderer. The whole guest memory region is mapped at the same offsets in the GPU address space.
+ */
+class GPUEnvironment final {
+public:
+    static constexpr VAddr MEMORY_BASE = 0x10000000;
+    static constexpr u64 MEMORY_SIZE = 0x1000000;
+
+    explicit GPUEnvironment(bool is_async = false);
+    ~GPUEnvironment();
+
+    /// Gets a pointer to the guest memory at the given offset of the region
+    u8* GetMemory(u64 offset) {
+        return memory.data() + offset;
+    }
+
+    /// Gets the GPU address of the given offset of the region
+    Tegra::GPUVAddr GetGPUAddress(u64 offset) const {
+        return gpu_memory_base + offset;
+    }
+
+    /// Copies a command list to the given offset of the region, returning its header
+    Tegra::CommandListHeader WriteCommandList(u64 offset, const std::vector<u32>& words);
+
+    /// Builds the header of a command list at the given GPU address
+    static Tegra::CommandListHeader MakeCommandListHeader(Tegra::GPUVAddr address,
+                                                          std::size_t num_words);
+
+    Tegra::GPU& GPU() {
+        return *gpu;
+    }
+
+private:
+    NullEmuWindow window;
+    Null::RendererNull renderer{window};
+    Memory::PageTable page_table;
+    std::vector<u8> memory;
+    std::unique_ptr<Tegra::GPU> gpu;
+    Tegra::GPUVAddr gpu_memory_base = 0;
+};
+
+} // namespace GPUTests
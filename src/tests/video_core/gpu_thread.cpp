@@ -0,0 +1,73 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/gpu.h"
+#include "tests/test_common.h"
+#include "tests/video_core/gpu_test_common.h"
+
+namespace GPUTests {
+
+/**
+ * Builds a command list binding the 3D engine and setting its clear color `num_writes` times,
+ * the last write setting it to `value`.
+ */
+static std::vector<u32> BuildClearColorList(u32 value, std::size_t num_writes) {
+    using Tegra::SubmissionMode;
+    std::vector<u32> words{EncodeHeader(SubmissionMode::Increasing, 0, 0, 1),
+                           static_cast<u32>(Tegra::EngineID::MAXWELL_B)};
+    for (std::size_t i = 0; i < num_writes; ++i) {
+        const u32 written = i + 1 == num_writes ? value : static_cast<u32>(i);
+        words.push_back(
+            EncodeHeader(SubmissionMode::Increasing, MAXWELL3D_REG_INDEX(clear_color), 0, 4));
+        words.insert(words.end(), {written, written + 1, written + 2, written + 3});
+    }
+    return words;
+}
+
+TEST_CASE("GPU: Asynchronous processing matches synchronous processing", "[video_core]") {
+    constexpr std::size_t num_lists = 256;
+
+    for (const bool is_async : {false, true}) {
+        GPUEnvironment env(is_async);
+        REQUIRE(env.GPU().IsAsync() == is_async);
+
+        // Every list lives in its own memory, as they may be read after all have been pushed.
+        for (u32 i = 0; i < num_lists; ++i) {
+            const auto header = env.WriteCommandList(i * 0x100, BuildClearColorList(i, 4));
+            env.GPU().PushGPUEntries({header});
+        }
+        env.GPU().WaitIdle();
+
+        const auto& regs = env.GPU().Maxwell3D().regs;
+        REQUIRE(regs.reg_array[MAXWELL3D_REG_INDEX(clear_color)] == num_lists - 1);
+        REQUIRE(regs.reg_array[MAXWELL3D_REG_INDEX(clear_color) + 3] == num_lists + 2);
+    }
+}
+
+TEST_CASE("GPU: Command submission cost", "[.benchmark][video_core]") {
+    constexpr std::size_t num_lists = 20000;
+    constexpr std::size_t writes_per_list = 256;
+
+    for (const bool is_async : {false, true}) {
+        GPUEnvironment env(is_async);
+        const auto header = env.WriteCommandList(0, BuildClearColorList(0, writes_per_list));
+
+        const auto submission = TestCommon::MeasureTime(
+            [&] { env.GPU().PushGPUEntries({header}); }, num_lists);
+        const auto wait = TestCommon::MeasureTime([&] { env.GPU().WaitIdle(); });
+
+        TestCommon::ReportBenchmark(is_async ? "Asynchronous GPU" : "Synchronous GPU",
+                                    fmt::format("submission: {:>8.0f} us, total: {:>8.0f} us",
+                                                submission.count() * 1e6,
+                                                (submission + wait).count() * 1e6));
+    }
+}
+
+} // namespace GPUTests
@@ -0,0 +1,325 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "core/settings.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/macro_opcode.h"
+#include "tests/test_common.h"
+#include "tests/video_core/gpu_test_common.h"
+
+namespace GPUTests {
+
+using Tegra::Engines::Maxwell3D;
+using Tegra::Macro::ALUOperation;
+using Tegra::Macro::BranchCondition;
+using Tegra::Macro::Opcode;
+using Tegra::Macro::Operation;
+using Tegra::Macro::ResultOperation;
+
+constexpr u32 MACRO_REGISTERS_START = 0xE00;
+
+static Opcode MakeOpcode(Operation operation, ResultOperation result, u32 dst, u32 src_a) {
+    Opcode opcode{};
+    opcode.operation.Assign(operation);
+    opcode.result_operation.Assign(result);
+    opcode.dst.Assign(dst);
+    opcode.src_a.Assign(src_a);
+    return opcode;
+}
+
+static u32 EncodeALU(ALUOperation alu, ResultOperation result, u32 dst, u32 src_a, u32 src_b,
+                     bool is_exit = false) {
+    Opcode opcode = MakeOpcode(Operation::ALU, result, dst, src_a);
+    opcode.src_b.Assign(src_b);
+    opcode.alu_operation.Assign(alu);
+    opcode.is_exit.Assign(is_exit);
+    return opcode.raw;
+}
+
+static u32 EncodeAddImmediate(ResultOperation result, u32 dst, u32 src_a, s32 immediate,
+                              bool is_exit = false) {
+    Opcode opcode = MakeOpcode(Operation::AddImmediate, result, dst, src_a);
+    opcode.immediate.Assign(immediate);
+    opcode.is_exit.Assign(is_exit);
+    return opcode.raw;
+}
+
+static u32 EncodeBitfield(Operation operation, ResultOperation result, u32 dst, u32 src_a,
+                          u32 src_b, u32 src_bit, u32 size, u32 dst_bit) {
+    Opcode opcode = MakeOpcode(operation, result, dst, src_a);
+    opcode.src_b.Assign(src_b);
+    opcode.bf_src_bit.Assign(src_bit);
+    opcode.bf_size.Assign(size);
+    opcode.bf_dst_bit.Assign(dst_bit);
+    return opcode.raw;
+}
+
+static u32 EncodeRead(ResultOperation result, u32 dst, u32 src_a, s32 immediate) {
+    Opcode opcode = MakeOpcode(Operation::Read, result, dst, src_a);
+    opcode.immediate.Assign(immediate);
+    return opcode.raw;
+}
+
+static u32 EncodeBranch(BranchCondition condition, u32 src_a, s32 offset, bool annul) {
+    Opcode opcode{};
+    opcode.operation.Assign(Operation::Branch);
+    opcode.branch_condition.Assign(condition);
+    opcode.branch_annul.Assign(annul);
+    opcode.src_a.Assign(src_a);
+    opcode.immediate.Assign(offset);
+    return opcode.raw;
+}
+
+/// Returns an exit followed by the nop of its delay slot
+static std::vector<u32> EncodeExit() {
+    return {EncodeAddImmediate(ResultOperation::Move, 0, 0, 0, true),
+            EncodeAddImmediate(ResultOperation::Move, 0, 0, 0)};
+}
+
+/// Uploads a macro to the given entry, returning the method that calls it
+static u32 UploadMacro(Maxwell3D& maxwell3d, u32 entry, const std::vector<u32>& code) {
+    maxwell3d.WriteReg(MAXWELL3D_REG_INDEX(macros.entry), entry, 0);
+    for (const u32 word : code) {
+        maxwell3d.WriteReg(MAXWELL3D_REG_INDEX(macros.data), word, 0);
+    }
+    return MACRO_REGISTERS_START + entry * 2;
+}
+
+/// Calls a macro the way a command list does, the method once and the arguments after it
+static void CallMacro(Maxwell3D& maxwell3d, u32 method, const std::vector<u32>& parameters) {
+    const auto num_arguments = static_cast<u32>(parameters.size() - 1);
+    maxwell3d.WriteReg(method, parameters[0], num_arguments);
+    if (num_arguments != 0) {
+        maxwell3d.WriteRegs(method + 1, parameters.data() + 1, num_arguments, false);
+    }
+}
+
+/**
+ * Builds a macro sending its arguments to consecutive registers starting at `first_method`. The
+ * first parameter is the number of arguments that follow.
+ */
+static std::vector<u32> BuildSendLoopMacro(u32 first_method) {
+    std::vector<u32> code{
+        // Set the method address with an increment of one.
+        EncodeAddImmediate(ResultOperation::MoveAndSetMethod, 0, 0,
+                           static_cast<s32>(first_method | (1 << 12))),
+        // $r2 counts the arguments left.
+        EncodeAddImmediate(ResultOperation::Move, 2, 1, 0),
+        EncodeAddImmediate(ResultOperation::IgnoreAndFetch, 3, 0, 0),
+        EncodeAddImmediate(ResultOperation::MoveAndSend, 0, 3, 0),
+        EncodeAddImmediate(ResultOperation::Move, 2, 2, -1),
+        EncodeBranch(BranchCondition::NotZero, 2, -3, true),
+    };
+    const auto exit = EncodeExit();
+    code.insert(code.end(), exit.begin(), exit.end());
+    return code;
+}
+
+/**
+ * Generates a macro of random operations that terminates and fetches the same number of
+ * parameters on every path. Branches only skip forward over instructions that don't fetch.
+ * @param num_fetches Set to the number of parameters fetched by the macro
+ */
+static std::vector<u32> GenerateRandomMacro(std::mt19937& rng, std::size_t length,
+                                            std::size_t& num_fetches) {
+    std::uniform_int_distribution<u32> reg{0, 7};
+    std::uniform_int_distribution<u32> bit{0, 31};
+    std::uniform_int_distribution<s32> immediate{-0x20000, 0x1FFFF};
+    std::uniform_int_distribution<s32> read_method{0, 0xDFF};
+    std::uniform_int_distribution<int> kind{0, 7};
+    std::uniform_int_distribution<int> skip_length{1, 4};
+
+    static constexpr ALUOperation alu_operations[] = {
+        ALUOperation::Add, ALUOperation::Subtract, ALUOperation::Xor,    ALUOperation::Or,
+        ALUOperation::And, ALUOperation::AndNot,   ALUOperation::Nand,
+    };
+    static constexpr ResultOperation fetching_results[] = {
+        ResultOperation::IgnoreAndFetch,
+        ResultOperation::FetchAndSend,
+        ResultOperation::FetchAndSetMethod,
+        ResultOperation::MoveAndSetMethodFetchAndSend,
+    };
+    static constexpr ResultOperation moving_results[] = {
+        ResultOperation::Move,
+        ResultOperation::MoveAndSetMethod,
+        ResultOperation::MoveAndSend,
+        ResultOperation::MoveAndSetMethodSend,
+    };
+
+    const auto random_instruction = [&](bool may_fetch) {
+        const bool fetches = may_fetch && std::uniform_int_distribution<int>{0, 3}(rng) == 0;
+        const ResultOperation result =
+            fetches ? fetching_results[rng() % 4] : moving_results[rng() % 4];
+        num_fetches += fetches ? 1 : 0;
+
+        switch (kind(rng)) {
+        case 0:
+        case 1:
+            return EncodeALU(alu_operations[rng() % 7], result, reg(rng), reg(rng), reg(rng));
+        case 2:
+        case 3:
+            return EncodeAddImmediate(result, reg(rng), reg(rng), immediate(rng));
+        case 4:
+            return EncodeBitfield(Operation::ExtractInsert, result, reg(rng), reg(rng), reg(rng),
+                                  bit(rng), bit(rng), bit(rng));
+        case 5:
+            // The shift amount register is $r0, shifting by 32 or more is undefined in C++.
+            return EncodeBitfield(Operation::ExtractShiftLeftImmediate, result, reg(rng), 0,
+                                  reg(rng), bit(rng), bit(rng), bit(rng));
+        case 6:
+            return EncodeBitfield(Operation::ExtractShiftLeftRegister, result, reg(rng), 0,
+                                  reg(rng), bit(rng), bit(rng), bit(rng));
+        default:
+            // Reads are absolute so that they stay within the register file.
+            return EncodeRead(result, reg(rng), 0, read_method(rng));
+        }
+    };
+
+    num_fetches = 0;
+    std::vector<u32> code;
+    while (code.size() < length) {
+        if (std::uniform_int_distribution<int>{0, 5}(rng) != 0) {
+            code.push_back(random_instruction(true));
+            continue;
+        }
+
+        // Forward branch over a few instructions. The delay slot runs on both paths unless the
+        // branch is annulled, only then it must not fetch either.
+        const int skipped = skip_length(rng);
+        const bool annul = (rng() & 1) != 0;
+        const auto condition = (rng() & 1) != 0 ? BranchCondition::Zero : BranchCondition::NotZero;
+        code.push_back(EncodeBranch(condition, reg(rng), skipped + 2, annul));
+        code.push_back(random_instruction(!annul));
+        for (int i = 0; i < skipped; ++i) {
+            code.push_back(random_instruction(false));
+        }
+    }
+
+    const auto exit = EncodeExit();
+    code.insert(code.end(), exit.begin(), exit.end());
+    return code;
+}
+
+TEST_CASE("MacroJIT: Random macros match the interpreter", "[video_core]") {
+    Settings::values.use_macro_jit = true;
+    std::mt19937 rng{1234};
+
+    // Uploads append to the code of an entry, use a new engine once all entries have been used.
+    for (int batch = 0; batch < 4; ++batch) {
+        GPUEnvironment env;
+        auto& maxwell3d = env.GPU().Maxwell3D();
+
+        for (u32 entry = 0; entry < 0x80; ++entry) {
+            std::size_t num_fetches{};
+            const auto code = GenerateRandomMacro(rng, 8 + entry % 64, num_fetches);
+            const u32 method = UploadMacro(maxwell3d, entry, code);
+
+            std::vector<u32> parameters(num_fetches + 1);
+            for (u32& parameter : parameters) {
+                parameter = rng();
+            }
+            REQUIRE(maxwell3d.VerifyMacroJIT(method, parameters));
+        }
+    }
+}
+
+TEST_CASE("MacroJIT: Loops and variable shifts match the interpreter", "[video_core]") {
+    Settings::values.use_macro_jit = true;
+    GPUEnvironment env;
+    auto& maxwell3d = env.GPU().Maxwell3D();
+
+    const u32 loop_method =
+        UploadMacro(maxwell3d, 0, BuildSendLoopMacro(MAXWELL3D_REG_INDEX(vertex_attrib_format)));
+    REQUIRE(maxwell3d.VerifyMacroJIT(loop_method, {3, 10, 20, 30}));
+    REQUIRE(maxwell3d.VerifyMacroJIT(loop_method, {1, 0xDEADBEEF}));
+
+    // Shifts by amounts taken from the parameters, sent to the clear color.
+    std::vector<u32> shift_code{
+        EncodeAddImmediate(ResultOperation::MoveAndSetMethod, 0, 0,
+                           static_cast<s32>(MAXWELL3D_REG_INDEX(clear_color) | (1 << 12))),
+        EncodeAddImmediate(ResultOperation::IgnoreAndFetch, 2, 0, 0),
+        EncodeAddImmediate(ResultOperation::IgnoreAndFetch, 3, 0, 0),
+        EncodeBitfield(Operation::ExtractShiftLeftImmediate, ResultOperation::MoveAndSend, 4, 2, 3,
+                       0, 12, 4),
+        EncodeBitfield(Operation::ExtractShiftLeftRegister, ResultOperation::MoveAndSend, 4, 2, 3,
+                       8, 16, 0),
+    };
+    const auto exit = EncodeExit();
+    shift_code.insert(shift_code.end(), exit.begin(), exit.end());
+    const u32 shift_method = UploadMacro(maxwell3d, 1, shift_code);
+    for (u32 shift = 0; shift < 32; ++shift) {
+        REQUIRE(maxwell3d.VerifyMacroJIT(shift_method, {0, shift, 0x12345678}));
+    }
+}
+
+TEST_CASE("MacroJIT: Macros write to the engine", "[video_core]") {
+    GPUEnvironment env;
+    auto& maxwell3d = env.GPU().Maxwell3D();
+    const u32 method =
+        UploadMacro(maxwell3d, 0, BuildSendLoopMacro(MAXWELL3D_REG_INDEX(vertex_attrib_format)));
+
+    for (const bool use_macro_jit : {false, true}) {
+        Settings::values.use_macro_jit = use_macro_jit;
+        CallMacro(maxwell3d, method, {4, 1, 2, 3, use_macro_jit ? 5U : 4U});
+
+        const auto& regs = maxwell3d.regs;
+        REQUIRE(regs.reg_array[MAXWELL3D_REG_INDEX(vertex_attrib_format)] == 1);
+        REQUIRE(regs.reg_array[MAXWELL3D_REG_INDEX(vertex_attrib_format) + 3] ==
+                (use_macro_jit ? 5U : 4U));
+    }
+}
+
+TEST_CASE("MacroJIT: Macros that can't be compiled are interpreted", "[video_core]") {
+    Settings::values.use_macro_jit = true;
+    GPUEnvironment env;
+    auto& maxwell3d = env.GPU().Maxwell3D();
+
+    // The branch is never taken but its target is out of bounds, the JIT refuses to compile it.
+    std::vector<u32> code{
+        EncodeAddImmediate(ResultOperation::MoveAndSetMethod, 0, 0,
+                           static_cast<s32>(MAXWELL3D_REG_INDEX(clear_stencil))),
+        EncodeBranch(BranchCondition::NotZero, 0, 0x100, true),
+        EncodeAddImmediate(ResultOperation::MoveAndSend, 0, 1, 1),
+    };
+    const auto exit = EncodeExit();
+    code.insert(code.end(), exit.begin(), exit.end());
+    const u32 method = UploadMacro(maxwell3d, 0, code);
+
+    REQUIRE(maxwell3d.VerifyMacroJIT(method, {41}));
+    CallMacro(maxwell3d, method, {41});
+    REQUIRE(maxwell3d.regs.reg_array[MAXWELL3D_REG_INDEX(clear_stencil)] == 42);
+}
+
+TEST_CASE("MacroJIT: Macro execution throughput", "[.benchmark][video_core]") {
+    constexpr int num_calls = 200000;
+    constexpr u32 num_arguments = 16;
+
+    GPUEnvironment env;
+    auto& maxwell3d = env.GPU().Maxwell3D();
+    const u32 method =
+        UploadMacro(maxwell3d, 0, BuildSendLoopMacro(MAXWELL3D_REG_INDEX(vertex_attrib_format)));
+
+    std::vector<u32> parameters{num_arguments};
+    for (u32 i = 0; i < num_arguments; ++i) {
+        parameters.push_back(i << 7);
+    }
+
+    for (const bool use_macro_jit : {false, true}) {
+        Settings::values.use_macro_jit = use_macro_jit;
+        const auto elapsed = TestCommon::MeasureTime(
+            [&] { CallMacro(maxwell3d, method, parameters); }, num_calls);
+
+        TestCommon::ReportBenchmark(
+            fmt::format("Macro {}: {} calls", use_macro_jit ? "JIT" : "interpreter", num_calls),
+            fmt::format("{:>8.0f} us", elapsed.count() * 1e6));
+    }
+}
+
+} // namespace GPUTests
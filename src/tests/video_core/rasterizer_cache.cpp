@@ -0,0 +1,386 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+#include <boost/icl/interval_map.hpp>
+#include <boost/range/iterator_range_core.hpp>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "tests/test_common.h"
+#include "video_core/cached_page_tracker.h"
+#include "video_core/rasterizer_cache.h"
+#include "video_core/rasterizer_interface.h"
+
+namespace {
+
+/// Provides the modification ticks of test objects, like RasterizerCache does for real ones
+struct TickSource {
+    u64 GetModifiedTicks() {
+        return ++ticks;
+    }
+
+    u64 ticks{};
+};
+
+class TestObject final : public RasterizerCacheObject {
+public:
+    TestObject(VAddr addr, std::size_t size) : addr{addr}, size{size} {}
+
+    VAddr GetAddr() const override {
+        return addr;
+    }
+
+    std::size_t GetSizeInBytes() const override {
+        return size;
+    }
+
+    void Flush() override {}
+
+private:
+    VAddr addr;
+    std::size_t size;
+};
+
+using Object = std::shared_ptr<TestObject>;
+
+/// Object index as it was implemented before RasterizerCacheIndex, used as reference
+class IntervalMapIndex final {
+public:
+    void Add(const Object& object) {
+        object_cache.add({GetInterval(object), ObjectSet{object}});
+    }
+
+    void Remove(const Object& object) {
+        object_cache.subtract({GetInterval(object), ObjectSet{object}});
+    }
+
+    Object Find(VAddr addr) const {
+        const ObjectInterval interval{addr};
+        for (auto& pair : boost::make_iterator_range(object_cache.equal_range(interval))) {
+            for (auto& cached_object : pair.second) {
+                if (cached_object->GetAddr() == addr) {
+                    return cached_object;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    std::vector<Object> GetSortedObjectsFromRegion(VAddr addr, u64 size) const {
+        if (size == 0) {
+            return {};
+        }
+
+        std::vector<Object> objects;
+        const ObjectInterval interval{addr, addr + size};
+        for (auto& pair : boost::make_iterator_range(object_cache.equal_range(interval))) {
+            for (auto& cached_object : pair.second) {
+                objects.push_back(cached_object);
+            }
+        }
+
+        std::sort(objects.begin(), objects.end(), [](const Object& a, const Object& b) {
+            return a->GetLastModifiedTicks() < b->GetLastModifiedTicks();
+        });
+        return objects;
+    }
+
+private:
+    using ObjectSet = std::set<Object>;
+    using ObjectCache = boost::icl::interval_map<VAddr, ObjectSet>;
+    using ObjectInterval = ObjectCache::interval_type;
+
+    static ObjectInterval GetInterval(const Object& object) {
+        return ObjectInterval::right_open(object->GetAddr(),
+                                          object->GetAddr() + object->GetSizeInBytes());
+    }
+
+    ObjectCache object_cache;
+};
+
+constexpr VAddr HEAP_BASE = 0x80000000;
+constexpr u64 HEAP_SIZE = 0x40000000;
+
+/// Generates a mix of surfaces (64 KiB to 8 MiB) and buffers (256 bytes to 64 KiB)
+std::vector<Object> GenerateObjects(std::size_t count, std::mt19937& rng) {
+    std::uniform_int_distribution<u64> surface_size{0x10, 0x800};
+    std::uniform_int_distribution<u64> buffer_size{1, 0x100};
+    std::uniform_int_distribution<u64> address{0, HEAP_SIZE / 0x100 - 1};
+
+    std::vector<Object> objects;
+    objects.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const bool is_surface = i % 4 == 0;
+        const std::size_t size = is_surface ? surface_size(rng) * 0x1000 : buffer_size(rng) * 0x100;
+        objects.push_back(std::make_shared<TestObject>(HEAP_BASE + address(rng) * 0x100, size));
+    }
+
+    // Give each object a distinct modification time, in an order unrelated to their addresses
+    TickSource tick_source;
+    std::vector<Object> modification_order{objects};
+    std::shuffle(modification_order.begin(), modification_order.end(), rng);
+    for (const auto& object : modification_order) {
+        object->MarkAsModified(false, tick_source);
+    }
+
+    return objects;
+}
+
+class TestCache final : public RasterizerCache<Object> {
+public:
+    explicit TestCache(VideoCore::RasterizerInterface& rasterizer) : RasterizerCache{rasterizer} {}
+
+    /// Looks up an object, like the caches do when binding a resource
+    Object Get(VAddr addr) const {
+        return TryGet(addr);
+    }
+
+    void Add(const Object& object) {
+        Register(object);
+    }
+};
+
+/// Rasterizer batching CPU writes like RasterizerOpenGL does, with the objects of a single cache
+class TestRasterizer final : public VideoCore::RasterizerInterface {
+public:
+    void DrawArrays() override {
+        SyncGuestWrites();
+    }
+
+    void Clear() override {}
+
+    void FlushAll() override {}
+
+    void FlushRegion(VAddr addr, u64 size) override {}
+
+    void InvalidateRegion(VAddr addr, u64 size) override {
+        invalidated_regions.emplace_back(addr, size);
+        cache->InvalidateRegion(addr, size);
+    }
+
+    void FlushAndInvalidateRegion(VAddr addr, u64 size) override {
+        InvalidateRegion(addr, size);
+    }
+
+    void OnCPUWrite(VAddr addr, u64 size) override {
+        cached_pages.MarkRegionDirty(addr, size);
+    }
+
+    void SyncGuestWrites() override {
+        cached_pages.ConsumeDirtyRegions(
+            [this](VAddr addr, u64 size) { InvalidateRegion(addr, size); });
+    }
+
+    void UpdatePagesCachedCount(Tegra::GPUVAddr addr, u64 size, int delta) override {
+        cached_pages.UpdateCachedCount(addr, size, delta, [](VAddr, u64) {});
+    }
+
+    TestCache* cache{};
+    std::vector<std::pair<VAddr, u64>> invalidated_regions;
+
+private:
+    VideoCore::CachedPageTracker cached_pages;
+};
+
+std::vector<VAddr> ToAddresses(const std::vector<Object>& objects) {
+    std::vector<VAddr> addresses;
+    for (const auto& object : objects) {
+        addresses.push_back(object->GetAddr());
+    }
+    return addresses;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("RasterizerCacheIndex: Matches the interval map index", "[video_core]") {
+    std::mt19937 rng{1234};
+    const auto objects = GenerateObjects(1000, rng);
+
+    RasterizerCacheIndex<Object> index;
+    IntervalMapIndex reference;
+    for (const auto& object : objects) {
+        index.Add(object);
+        reference.Add(object);
+    }
+
+    // Remove some of the objects again to check removal keeps both in sync.
+    for (std::size_t i = 0; i < objects.size(); i += 3) {
+        index.Remove(objects[i]);
+        reference.Remove(objects[i]);
+    }
+
+    std::uniform_int_distribution<u64> offset{0, HEAP_SIZE - 1};
+    std::uniform_int_distribution<u64> size{1, 0x40000};
+    std::vector<Object> found;
+    for (int i = 0; i < 1000; ++i) {
+        const VAddr addr = HEAP_BASE + offset(rng);
+        const u64 query_size = size(rng);
+
+        found.clear();
+        index.GetSortedObjectsFromRegion(addr, query_size, found);
+        // The interval map returns an object once per interval it spans, the duplicates are
+        // adjacent as they share the same modification time.
+        auto expected = reference.GetSortedObjectsFromRegion(addr, query_size);
+        expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+        REQUIRE(ToAddresses(found) == ToAddresses(expected));
+    }
+
+    for (const auto& object : objects) {
+        REQUIRE(index.Find(object->GetAddr()) == reference.Find(object->GetAddr()));
+        REQUIRE(index.Find(object->GetAddr() + 1) == reference.Find(object->GetAddr() + 1));
+    }
+}
+
+TEST_CASE("RasterizerCache: CPU writes invalidate objects before they're used", "[video_core]") {
+    TestRasterizer rasterizer;
+    TestCache cache{rasterizer};
+    rasterizer.cache = &cache;
+
+    const auto first = std::make_shared<TestObject>(0x10000, 0x2000);
+    const auto second = std::make_shared<TestObject>(0x12000, 0x1000);
+    const auto third = std::make_shared<TestObject>(0x20000, 0x1000);
+    for (const auto& object : {first, second, third}) {
+        cache.Add(object);
+    }
+
+    SECTION("At draw time") {
+        rasterizer.OnCPUWrite(0x11000, 4);
+        REQUIRE(first->IsRegistered());
+
+        rasterizer.DrawArrays();
+        REQUIRE(!first->IsRegistered());
+        REQUIRE(second->IsRegistered());
+        REQUIRE(third->IsRegistered());
+    }
+
+    SECTION("At bind time") {
+        rasterizer.OnCPUWrite(0x20ffc, 4);
+        REQUIRE(cache.Get(0x10000) == first);
+        REQUIRE(!third->IsRegistered());
+        REQUIRE(cache.Get(0x20000) == nullptr);
+    }
+
+    SECTION("Adjacent written pages are invalidated at once") {
+        rasterizer.OnCPUWrite(0x12000, 4);
+        rasterizer.OnCPUWrite(0x11ffc, 4);
+        rasterizer.OnCPUWrite(0x10000, 4);
+        rasterizer.DrawArrays();
+
+        REQUIRE(rasterizer.invalidated_regions == std::vector<std::pair<VAddr, u64>>{
+                                                      {0x10000, 0x3000}});
+        REQUIRE(!first->IsRegistered());
+        REQUIRE(!second->IsRegistered());
+        REQUIRE(third->IsRegistered());
+    }
+
+    SECTION("Writes to uncached pages") {
+        rasterizer.OnCPUWrite(0x13000, 0xd000);
+        rasterizer.DrawArrays();
+
+        REQUIRE(rasterizer.invalidated_regions.empty());
+        REQUIRE(cache.Get(0x10000) == first);
+        REQUIRE(cache.Get(0x12000) == second);
+        REQUIRE(cache.Get(0x20000) == third);
+    }
+
+    SECTION("Pages uncached before the sync") {
+        rasterizer.OnCPUWrite(0x12000, 0x1000);
+        cache.InvalidateRegion(0x12000, 0x1000);
+        rasterizer.invalidated_regions.clear();
+
+        rasterizer.DrawArrays();
+        REQUIRE(rasterizer.invalidated_regions.empty());
+        REQUIRE(first->IsRegistered());
+    }
+}
+
+TEST_CASE("RasterizerCacheIndex: Lookup throughput", "[.benchmark][video_core]") {
+    constexpr std::size_t num_objects = 10000;
+    constexpr std::size_t num_queries = 200000;
+
+    std::mt19937 rng{5678};
+    const auto objects = GenerateObjects(num_objects, rng);
+
+    std::uniform_int_distribution<u64> offset{0, HEAP_SIZE - 1};
+    std::uniform_int_distribution<u64> size{4, 0x1000};
+    std::vector<std::pair<VAddr, u64>> queries;
+    for (std::size_t i = 0; i < num_queries; ++i) {
+        queries.emplace_back(HEAP_BASE + offset(rng), size(rng));
+    }
+
+    const auto measure = [](const char* name, auto&& func) {
+        std::size_t checksum = 0;
+        const auto elapsed = TestCommon::MeasureTime([&] { checksum = func(); });
+        TestCommon::ReportBenchmark(
+            name, fmt::format("{:>10.0f} us (checksum {})", elapsed.count() * 1e6, checksum));
+    };
+
+    IntervalMapIndex reference;
+    RasterizerCacheIndex<Object> index;
+
+    measure("interval_map: register 10k objects", [&] {
+        for (const auto& object : objects) {
+            reference.Add(object);
+        }
+        return objects.size();
+    });
+    measure("page index: register 10k objects", [&] {
+        for (const auto& object : objects) {
+            index.Add(object);
+        }
+        return objects.size();
+    });
+
+    measure("interval_map: region queries", [&] {
+        std::size_t found = 0;
+        for (const auto& [addr, query_size] : queries) {
+            found += reference.GetSortedObjectsFromRegion(addr, query_size).size();
+        }
+        return found;
+    });
+    measure("page index: region queries", [&] {
+        std::size_t found = 0;
+        std::vector<Object> result;
+        for (const auto& [addr, query_size] : queries) {
+            result.clear();
+            index.GetSortedObjectsFromRegion(addr, query_size, result);
+            found += result.size();
+        }
+        return found;
+    });
+
+    measure("interval_map: address lookups", [&] {
+        std::size_t found = 0;
+        for (const auto& object : objects) {
+            found += reference.Find(object->GetAddr()) != nullptr;
+        }
+        return found;
+    });
+    measure("page index: address lookups", [&] {
+        std::size_t found = 0;
+        for (const auto& object : objects) {
+            found += index.Find(object->GetAddr()) != nullptr;
+        }
+        return found;
+    });
+
+    measure("interval_map: unregister 10k objects", [&] {
+        for (const auto& object : objects) {
+            reference.Remove(object);
+        }
+        return objects.size();
+    });
+    measure("page index: unregister 10k objects", [&] {
+        for (const auto& object : objects) {
+            index.Remove(object);
+        }
+        return objects.size();
+    });
+}
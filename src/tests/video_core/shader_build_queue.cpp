@@ -0,0 +1,202 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <exception>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+#include "video_core/renderer_opengl/gl_shader_build_queue.h"
+
+namespace OpenGL {
+namespace {
+
+using ShaderProgram = ShaderBuildQueue::ShaderProgram;
+using namespace std::chrono_literals;
+
+/// Link step whose programs are only linked once the test completes them
+struct FakeLinker {
+    std::future<void> Link(const std::shared_ptr<CachedProgram>& program, ShaderProgram) {
+        programs.push_back(program);
+        promises.emplace_back();
+        return promises.back().get_future();
+    }
+
+    std::vector<std::shared_ptr<CachedProgram>> programs;
+    std::vector<std::promise<void>> promises;
+};
+
+struct BuildQueueFixture {
+    BuildQueueFixture()
+        : queue{[this](const std::shared_ptr<CachedProgram>& program,
+                       ShaderProgram program_type) { return linker.Link(program, program_type); },
+                [this](u64 unique_identifier, ShaderProgram, const CachedProgram&) {
+                    built.push_back(unique_identifier);
+                }} {}
+
+    /// Queues a program, returning the promise that completes its decompilation
+    std::promise<void> Queue(u64 unique_identifier, std::shared_ptr<CachedProgram> program) {
+        std::promise<void> decompiled;
+        queue.Queue(unique_identifier, ShaderProgram::VertexB, std::move(program),
+                    decompiled.get_future());
+        return decompiled;
+    }
+
+    FakeLinker linker;
+    std::vector<u64> built;
+    ShaderBuildQueue queue;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("ShaderBuildQueue: Latency buckets are powers of two of milliseconds", "[video_core]") {
+    REQUIRE(GetLatencyBucket(0ms) == 0);
+    REQUIRE(GetLatencyBucket(999us) == 0);
+    REQUIRE(GetLatencyBucket(1ms) == 1);
+    REQUIRE(GetLatencyBucket(2ms) == 2);
+    REQUIRE(GetLatencyBucket(3ms) == 2);
+    REQUIRE(GetLatencyBucket(4ms) == 3);
+    REQUIRE(GetLatencyBucket(1023ms) == 10);
+
+    // The last bucket counts all the slower programs
+    constexpr std::size_t last_bucket = ShaderBuildStatistics::NumLatencyBuckets - 1;
+    REQUIRE(GetLatencyBucket(1024ms) == last_bucket);
+    REQUIRE(GetLatencyBucket(1h) == last_bucket);
+}
+
+TEST_CASE_METHOD(BuildQueueFixture, "ShaderBuildQueue: Programs are built once linked",
+                 "[video_core]") {
+    const auto program = std::make_shared<CachedProgram>();
+    auto decompiled = Queue(1, program);
+    REQUIRE(!program->is_built);
+
+    // Not handed to the link step before it's decompiled
+    queue.Collect();
+    REQUIRE(linker.programs.empty());
+    REQUIRE(queue.GetStatistics().queue_depth == 1);
+
+    decompiled.set_value();
+    queue.Collect();
+    REQUIRE(linker.programs.size() == 1);
+    REQUIRE(linker.programs[0] == program);
+    REQUIRE(!program->is_built);
+
+    // Collecting again doesn't link it twice
+    queue.Collect();
+    REQUIRE(linker.programs.size() == 1);
+
+    linker.promises[0].set_value();
+    queue.Collect();
+    REQUIRE(program->is_built);
+    REQUIRE(built == std::vector<u64>{1});
+
+    const auto statistics = queue.GetStatistics();
+    REQUIRE(statistics.queue_depth == 0);
+    REQUIRE(statistics.max_queue_depth == 1);
+    REQUIRE(statistics.programs_built == 1);
+    u64 histogram_total = 0;
+    for (const u64 count : statistics.latency_histogram) {
+        histogram_total += count;
+    }
+    REQUIRE(histogram_total == 1);
+}
+
+TEST_CASE_METHOD(BuildQueueFixture, "ShaderBuildQueue: Programs are collected as they're built",
+                 "[video_core]") {
+    const auto first = std::make_shared<CachedProgram>();
+    const auto second = std::make_shared<CachedProgram>();
+    auto first_decompiled = Queue(1, first);
+    auto second_decompiled = Queue(2, second);
+    REQUIRE(queue.GetStatistics().max_queue_depth == 2);
+
+    // The second program doesn't wait for the first one
+    second_decompiled.set_value();
+    queue.Collect();
+    REQUIRE(linker.programs == std::vector<std::shared_ptr<CachedProgram>>{second});
+    linker.promises[0].set_value();
+    queue.Collect();
+    REQUIRE(second->is_built);
+    REQUIRE(!first->is_built);
+    REQUIRE(queue.GetStatistics().queue_depth == 1);
+
+    first_decompiled.set_value();
+    queue.Collect();
+    linker.promises[1].set_value();
+    queue.Collect();
+    REQUIRE(first->is_built);
+    REQUIRE(built == std::vector<u64>{2, 1});
+}
+
+TEST_CASE_METHOD(BuildQueueFixture, "ShaderBuildQueue: Waiting builds all the programs",
+                 "[video_core]") {
+    // A link step that links right away, like the one without a link thread
+    ShaderBuildQueue synchronous_queue{
+        [](const std::shared_ptr<CachedProgram>&, ShaderProgram) {
+            std::promise<void> linked;
+            linked.set_value();
+            return linked.get_future();
+        },
+        [this](u64 unique_identifier, ShaderProgram, const CachedProgram&) {
+            built.push_back(unique_identifier);
+        }};
+
+    std::vector<std::shared_ptr<CachedProgram>> programs;
+    for (u64 unique_identifier = 1; unique_identifier <= 3; ++unique_identifier) {
+        programs.push_back(std::make_shared<CachedProgram>());
+        // Decompiled on another thread while the queue waits for it
+        synchronous_queue.Queue(unique_identifier, ShaderProgram::VertexB, programs.back(),
+                                std::async(std::launch::async, [] {
+                                    std::this_thread::sleep_for(10ms);
+                                }));
+    }
+
+    synchronous_queue.WaitAll();
+    for (const auto& program : programs) {
+        REQUIRE(program->is_built);
+    }
+    REQUIRE(built == std::vector<u64>{1, 2, 3});
+
+    const auto statistics = synchronous_queue.GetStatistics();
+    REQUIRE(statistics.queue_depth == 0);
+    REQUIRE(statistics.max_queue_depth == 3);
+    REQUIRE(statistics.programs_built == 3);
+}
+
+TEST_CASE_METHOD(BuildQueueFixture, "ShaderBuildQueue: Programs that fail to link are dropped",
+                 "[video_core]") {
+    const auto failed = std::make_shared<CachedProgram>();
+    const auto linked = std::make_shared<CachedProgram>();
+    Queue(1, failed).set_value();
+    Queue(2, linked).set_value();
+    queue.Collect();
+    REQUIRE(linker.programs.size() == 2);
+
+    // Like the link thread does with the programs it drops when it's stopped
+    linker.promises[0].set_exception(
+        std::make_exception_ptr(std::runtime_error("the link thread was stopped")));
+    linker.promises[1].set_value();
+    queue.Collect();
+
+    REQUIRE(!failed->is_built);
+    REQUIRE(linked->is_built);
+    REQUIRE(built == std::vector<u64>{2});
+
+    const auto statistics = queue.GetStatistics();
+    REQUIRE(statistics.queue_depth == 0);
+    REQUIRE(statistics.programs_built == 1);
+}
+
+TEST_CASE_METHOD(BuildQueueFixture, "ShaderBuildQueue: Skipped draws are counted",
+                 "[video_core]") {
+    queue.RecordSkippedDraw();
+    queue.RecordSkippedDraw();
+    REQUIRE(queue.GetStatistics().skipped_draws == 2);
+}
+
+} // namespace OpenGL
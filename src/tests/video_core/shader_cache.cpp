@@ -0,0 +1,223 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <memory>
+#include <optional>
+#include <vector>
+#include "common/common_types.h"
+#include "core/memory.h"
+#include "tests/core/memory_test_common.h"
+#include "video_core/cached_page_tracker.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_opengl/gl_shader_cache.h"
+
+namespace OpenGL {
+namespace {
+
+/// Offset of the first instruction, right after the header and the first scheduling word
+constexpr std::size_t MAIN_OFFSET = 11;
+
+/// Chunk of words GetShaderCode reads memory in
+constexpr std::size_t CHUNK_SIZE = 0x100;
+
+/// A branch to itself, which terminates programs
+constexpr u64 SELF_JUMPING_BRANCH = 0xE2400FFFFF07000FULL;
+
+/// Any instruction that isn't a terminator
+constexpr u64 INSTRUCTION = 0x5C58000000270002ULL;
+
+/// Returns true if the word at the given offset is a scheduling word, which never terminates
+constexpr bool IsSchedulingWord(std::size_t offset) {
+    return (offset - (MAIN_OFFSET - 1)) % 4 == 0;
+}
+
+/// Fills a whole program with instructions, terminated at the given offset if there is one
+GLShader::ProgramCode MakeProgram(std::optional<std::size_t> terminator) {
+    GLShader::ProgramCode code(GLShader::MAX_PROGRAM_CODE_LENGTH);
+    for (std::size_t offset = 0; offset < code.size(); ++offset) {
+        code[offset] = IsSchedulingWord(offset) ? 0 : INSTRUCTION;
+    }
+    if (terminator) {
+        code[*terminator] = SELF_JUMPING_BRANCH;
+    }
+    return code;
+}
+
+constexpr u64 PROGRAM_REGION_SIZE = GLShader::MAX_PROGRAM_CODE_LENGTH * sizeof(u64);
+
+/// Memory holding a program, which GetShaderCode reads from
+class ProgramEnvironment final : public MemoryTests::TestEnvironment {
+public:
+    ProgramEnvironment() : TestEnvironment("shader_cache_test", PROGRAM_REGION_SIZE, 0x1000) {}
+
+    void Write(const GLShader::ProgramCode& code) {
+        Memory::WriteBlock(memory_base, code.data(), code.size() * sizeof(u64));
+    }
+};
+
+/// Rasterizer counting the pages cached by the objects registered in its caches
+class PageCountingRasterizer final : public VideoCore::RasterizerInterface {
+public:
+    void DrawArrays() override {}
+    void Clear() override {}
+    void FlushAll() override {}
+    void FlushRegion(VAddr addr, u64 size) override {}
+    void InvalidateRegion(VAddr addr, u64 size) override {}
+    void FlushAndInvalidateRegion(VAddr addr, u64 size) override {}
+
+    void UpdatePagesCachedCount(Tegra::GPUVAddr addr, u64 size, int delta) override {
+        cached_pages.UpdateCachedCount(addr, size, delta, [this, delta](VAddr, u64 run_size) {
+            num_cached_pages += delta * static_cast<s64>(run_size / Memory::PAGE_SIZE);
+        });
+    }
+
+    s64 num_cached_pages{};
+
+private:
+    VideoCore::CachedPageTracker cached_pages;
+};
+
+/// Combined VertexA shader, whose program is still being built so that no GL call is made
+Shader MakeCombinedShader(VAddr addr, ProgramB program_b) {
+    auto cached_program = std::make_shared<CachedProgram>();
+    cached_program->is_built = false;
+    return std::make_shared<CachedShader>(addr, 0x100, Maxwell::ShaderProgram::VertexA,
+                                          std::move(cached_program), std::move(program_b));
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ShaderCache: Programs end at their terminating instruction", "[video_core]") {
+    const auto program = MakeProgram(MAIN_OFFSET + 5);
+    REQUIRE(FindProgramEnd(program, 0, program.size()) == MAIN_OFFSET + 5);
+    REQUIRE(CalculateProgramSize(program) == (MAIN_OFFSET + 6) * sizeof(u64));
+
+    // The search is limited to the given range
+    REQUIRE(FindProgramEnd(program, 0, MAIN_OFFSET + 4) == MAIN_OFFSET + 4);
+    REQUIRE(FindProgramEnd(program, MAIN_OFFSET + 6, program.size()) == program.size());
+
+    // Empty instructions end programs, but empty scheduling words don't
+    auto empty = MakeProgram(std::nullopt);
+    empty[MAIN_OFFSET + 4] = 0;
+    REQUIRE(IsSchedulingWord(MAIN_OFFSET + 3));
+    REQUIRE(FindProgramEnd(empty, 0, empty.size()) == MAIN_OFFSET + 4);
+
+    // Programs without a terminator take up the whole code
+    const auto unterminated = MakeProgram(std::nullopt);
+    REQUIRE(FindProgramEnd(unterminated, 0, unterminated.size()) == unterminated.size());
+    REQUIRE(CalculateProgramSize(unterminated) == PROGRAM_REGION_SIZE);
+}
+
+TEST_CASE("ShaderCache: Programs are read up to the chunk holding their end", "[video_core]") {
+    ProgramEnvironment env;
+
+    SECTION("Terminator inside a chunk") {
+        const std::size_t terminator = CHUNK_SIZE + 0x43;
+        REQUIRE(!IsSchedulingWord(terminator));
+        env.Write(MakeProgram(terminator));
+
+        const auto code = GetShaderCode(env.memory_base);
+        REQUIRE(code.size() == GLShader::MAX_PROGRAM_CODE_LENGTH);
+        REQUIRE(code[terminator] == SELF_JUMPING_BRANCH);
+        REQUIRE(CalculateProgramSize(code) == (terminator + 1) * sizeof(u64));
+        // The rest of the chunk is read, the next chunks are left empty
+        REQUIRE(code[2 * CHUNK_SIZE - 1] == INSTRUCTION);
+        REQUIRE(code[2 * CHUNK_SIZE + 1] == 0);
+    }
+
+    SECTION("Terminator at the end of a chunk") {
+        const std::size_t terminator = CHUNK_SIZE - 1;
+        REQUIRE(!IsSchedulingWord(terminator));
+        env.Write(MakeProgram(terminator));
+
+        const auto code = GetShaderCode(env.memory_base);
+        REQUIRE(CalculateProgramSize(code) == CHUNK_SIZE * sizeof(u64));
+        REQUIRE(code[CHUNK_SIZE + 1] == 0);
+    }
+
+    SECTION("Terminator at the start of a chunk") {
+        const std::size_t terminator = CHUNK_SIZE;
+        REQUIRE(!IsSchedulingWord(terminator));
+        env.Write(MakeProgram(terminator));
+
+        const auto code = GetShaderCode(env.memory_base);
+        REQUIRE(code[CHUNK_SIZE - 1] == INSTRUCTION);
+        REQUIRE(CalculateProgramSize(code) == (CHUNK_SIZE + 1) * sizeof(u64));
+        REQUIRE(code[2 * CHUNK_SIZE + 1] == 0);
+    }
+
+    SECTION("No terminator") {
+        const auto program = MakeProgram(std::nullopt);
+        env.Write(program);
+
+        const auto code = GetShaderCode(env.memory_base);
+        REQUIRE(code == program);
+        REQUIRE(CalculateProgramSize(code) == PROGRAM_REGION_SIZE);
+    }
+}
+
+TEST_CASE("ShaderCache: Combined shaders are dropped when their VertexB program changes",
+          "[video_core]") {
+    constexpr VAddr program_b_addr = 0x10000;
+    constexpr std::size_t program_b_size = 0x800;
+
+    PageCountingRasterizer rasterizer;
+    ProgramBCache program_b_cache{rasterizer};
+
+    const auto shader = MakeCombinedShader(0x20000, program_b_cache.Get(program_b_addr,
+                                                                        program_b_size));
+    REQUIRE(shader->IsProgramBCurrent(program_b_addr));
+    REQUIRE(!shader->IsProgramBCurrent(program_b_addr + 0x100));
+    REQUIRE(!shader->IsProgramBCurrent(std::nullopt));
+
+    // Writes after the program don't change it
+    program_b_cache.InvalidateRegion(program_b_addr + program_b_size, 8);
+    REQUIRE(shader->IsProgramBCurrent(program_b_addr));
+
+    program_b_cache.InvalidateRegion(program_b_addr + 0x10, 8);
+    REQUIRE(!shader->IsProgramBCurrent(program_b_addr));
+
+    // The program is registered again for the next shader combining it, the old shader stays stale
+    const ProgramB program_b = program_b_cache.Get(program_b_addr, program_b_size);
+    REQUIRE(program_b != shader->GetProgramB());
+    REQUIRE(program_b->IsRegistered());
+    REQUIRE(!shader->IsProgramBCurrent(program_b_addr));
+    REQUIRE(MakeCombinedShader(0x20000, program_b)->IsProgramBCurrent(program_b_addr));
+
+    // Releasing the invalidated program doesn't touch the new registration
+    program_b_cache.Release(shader->GetProgramB());
+    REQUIRE(program_b->IsRegistered());
+    REQUIRE(rasterizer.num_cached_pages == 1);
+}
+
+TEST_CASE("ShaderCache: VertexB programs are unregistered with their last shader",
+          "[video_core]") {
+    constexpr VAddr program_b_addr = 0x10000;
+
+    PageCountingRasterizer rasterizer;
+    ProgramBCache program_b_cache{rasterizer};
+
+    const ProgramB first = program_b_cache.Get(program_b_addr, 0x1800);
+    const ProgramB second = program_b_cache.Get(program_b_addr, 0x1800);
+    REQUIRE(first == second);
+    REQUIRE(rasterizer.num_cached_pages == 2);
+
+    program_b_cache.Release(first);
+    REQUIRE(first->IsRegistered());
+    REQUIRE(rasterizer.num_cached_pages == 2);
+
+    program_b_cache.Release(second);
+    REQUIRE(!first->IsRegistered());
+    REQUIRE(rasterizer.num_cached_pages == 0);
+
+    // A program gotten again is registered anew
+    const ProgramB third = program_b_cache.Get(program_b_addr, 0x1800);
+    REQUIRE(third != first);
+    REQUIRE(third->IsRegistered());
+    REQUIRE(rasterizer.num_cached_pages == 2);
+}
+
+} // namespace OpenGL
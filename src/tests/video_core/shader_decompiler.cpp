@@ -0,0 +1,285 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "tests/test_common.h"
+#include "video_core/renderer_opengl/gl_shader_decompiler.h"
+
+namespace OpenGL::GLShader::Decompiler {
+namespace {
+
+using Stage = Maxwell3D::Regs::ShaderStage;
+
+/// Offset of the first instruction, right after the header and the first scheduling word
+constexpr u32 MAIN_OFFSET = 10;
+
+constexpr u64 RZ = 255;
+constexpr u64 PT = 7;
+constexpr u64 ATTRIBUTE_POSITION = 7;
+constexpr u64 ATTRIBUTE_0 = 8;
+
+/// Encodes the opcode bits of an instruction from its pattern in shader_bytecode.h
+u64 Opcode(std::string_view pattern) {
+    u64 value = 0;
+    for (std::size_t bit = 0; bit < pattern.size(); ++bit) {
+        if (pattern[bit] == '1') {
+            value |= u64{1} << (63 - bit);
+        }
+    }
+    return value;
+}
+
+u64 Field(u64 value, u32 position) {
+    return value << position;
+}
+
+u32 FloatBits(float value) {
+    u32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+u64 LoadAttribute(u64 reg, u64 attribute, u64 element) {
+    return Opcode("1110111111011---") | Field(reg, 0) | Field(RZ, 8) | Field(PT, 16) |
+           Field(element, 22) | Field(attribute, 24) | Field(RZ, 39);
+}
+
+u64 StoreAttribute(u64 reg, u64 attribute, u64 element) {
+    return Opcode("1110111111110---") | Field(reg, 0) | Field(RZ, 8) | Field(PT, 16) |
+           Field(element, 22) | Field(attribute, 24) | Field(RZ, 39);
+}
+
+u64 MoveImmediate(u64 reg, float value) {
+    return Opcode("000000010000----") | Field(reg, 0) | Field(0xF, 12) | Field(PT, 16) |
+           Field(FloatBits(value), 20);
+}
+
+u64 FloatAdd(u64 dest, u64 a, u64 b) {
+    return Opcode("0101110001011---") | Field(dest, 0) | Field(a, 8) | Field(PT, 16) |
+           Field(b, 20);
+}
+
+u64 IntegerAdd(u64 dest, u64 a, u64 b) {
+    return Opcode("0101110000010---") | Field(dest, 0) | Field(a, 8) | Field(PT, 16) |
+           Field(b, 20);
+}
+
+u64 ShiftLeft(u64 dest, u64 a, u64 shift) {
+    return Opcode("0011100-01001---") | Field(dest, 0) | Field(a, 8) | Field(PT, 16) |
+           Field(shift, 20);
+}
+
+u64 IntegerToFloat(u64 dest, u64 source) {
+    return Opcode("0101110010111---") | Field(dest, 0) | Field(2, 8) | Field(2, 10) |
+           Field(1, 13) | Field(PT, 16) | Field(source, 20);
+}
+
+/// Encodes a SSY to the word that is the given distance ahead, scheduling words included
+u64 SetSyncPoint(s64 distance) {
+    // Branch targets are relative to the next instruction and stored in bytes.
+    return Opcode("111000101001----") | Field(0xF, 0) |
+           Field(static_cast<u64>((distance - 1) * 8) & 0xFFFFFF, 20);
+}
+
+u64 Sync() {
+    return Opcode("1111000011111---") | Field(0xF, 0) | Field(PT, 16);
+}
+
+u64 Exit() {
+    return Opcode("111000110000----") | Field(0xF, 0) | Field(PT, 16);
+}
+
+/// Lays out instructions after the header, with a scheduling word before every three of them.
+ProgramCode MakeProgram(const std::vector<u64>& instructions) {
+    ProgramCode code(MAX_PROGRAM_CODE_LENGTH);
+    u32 offset = MAIN_OFFSET;
+    for (const u64 instruction : instructions) {
+        if ((offset - MAIN_OFFSET) % 4 == 0) {
+            ++offset;
+        }
+        code[offset++] = instruction;
+    }
+    return code;
+}
+
+std::string Decompile(const std::vector<u64>& instructions) {
+    const auto result =
+        DecompileProgram(MakeProgram(instructions), MAIN_OFFSET, Stage::Vertex, "vertex");
+    REQUIRE(result.is_initialized());
+    return result->first;
+}
+
+bool Contains(const std::string& code, std::string_view text) {
+    return code.find(text) != std::string::npos;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ShaderDecompiler: Only the registers that are read are kept", "[video_core]") {
+    const std::string code = Decompile({
+        LoadAttribute(4, ATTRIBUTE_0, 0),
+        MoveImmediate(5, 1.0f),
+        FloatAdd(6, 5, 4),
+        StoreAttribute(4, ATTRIBUTE_POSITION, 0),
+        Exit(),
+    });
+
+    REQUIRE(Contains(code, "float reg_4_vertex"));
+    // The chain of writes ending in a register that is never read is removed as a whole.
+    REQUIRE(!Contains(code, "reg_5_vertex"));
+    REQUIRE(!Contains(code, "reg_6_vertex"));
+    REQUIRE(!Contains(code, "reg_0_vertex"));
+    REQUIRE(!Contains(code, "internalFlag_"));
+}
+
+TEST_CASE("ShaderDecompiler: Long chains of dead writes are removed", "[video_core]") {
+    std::vector<u64> instructions{LoadAttribute(4, ATTRIBUTE_0, 0)};
+    for (u64 reg = 5; reg < 15; ++reg) {
+        instructions.push_back(FloatAdd(reg, reg - 1, reg - 1));
+    }
+    instructions.push_back(StoreAttribute(4, ATTRIBUTE_POSITION, 0));
+    instructions.push_back(Exit());
+    const std::string code = Decompile(instructions);
+
+    REQUIRE(Contains(code, "float reg_4_vertex"));
+    for (u64 reg = 5; reg < 15; ++reg) {
+        REQUIRE(!Contains(code, fmt::format("reg_{}_vertex", reg)));
+    }
+}
+
+TEST_CASE("ShaderDecompiler: Writes read by live code are kept", "[video_core]") {
+    const std::string code = Decompile({
+        MoveImmediate(1, 2.0f),
+        FloatAdd(2, 1, 1),
+        FloatAdd(3, 2, 1),
+        // Overwrites reg_2, the first write stays live through reg_3
+        MoveImmediate(2, 3.0f),
+        StoreAttribute(3, ATTRIBUTE_POSITION, 0),
+        Exit(),
+    });
+
+    REQUIRE(Contains(code, "reg_1_vertex = 2.0;"));
+    REQUIRE(Contains(code, "reg_2_vertex = (reg_1_vertex + reg_1_vertex);"));
+    REQUIRE(Contains(code, "reg_3_vertex = (reg_2_vertex + reg_1_vertex);"));
+    // Writes are kept per variable, not per position in the program
+    REQUIRE(Contains(code, "reg_2_vertex = 3.0;"));
+}
+
+TEST_CASE("ShaderDecompiler: Immediates are folded into literals", "[video_core]") {
+    const std::string code = Decompile({
+        MoveImmediate(1, 1.5f),
+        MoveImmediate(2, -2.0f),
+        StoreAttribute(1, ATTRIBUTE_POSITION, 0),
+        StoreAttribute(2, ATTRIBUTE_POSITION, 1),
+        Exit(),
+    });
+
+    REQUIRE(Contains(code, "reg_1_vertex = 1.5;"));
+    REQUIRE(Contains(code, "reg_2_vertex = (-2.0);"));
+    REQUIRE(!Contains(code, "uintBitsToFloat"));
+}
+
+TEST_CASE("ShaderDecompiler: Registers only used as integers are declared as such",
+          "[video_core]") {
+    const std::string code = Decompile({
+        IntegerAdd(2, 3, 4),
+        ShiftLeft(5, 2, 8),
+        IntegerToFloat(6, 5),
+        StoreAttribute(6, ATTRIBUTE_POSITION, 0),
+        Exit(),
+    });
+
+    REQUIRE(Contains(code, "int reg_2_vertex"));
+    REQUIRE(Contains(code, "int reg_5_vertex"));
+    REQUIRE(Contains(code, "float reg_6_vertex"));
+    REQUIRE(!Contains(code, "floatBitsToInt"));
+    REQUIRE(!Contains(code, "intBitsToFloat"));
+}
+
+TEST_CASE("ShaderDecompiler: The flow stack is only emitted when it is popped", "[video_core]") {
+    const std::string without_sync = Decompile({
+        SetSyncPoint(3),
+        LoadAttribute(1, ATTRIBUTE_0, 0),
+        StoreAttribute(1, ATTRIBUTE_POSITION, 0),
+        Exit(),
+    });
+    REQUIRE(!Contains(without_sync, "flow_stack"));
+    REQUIRE(!Contains(without_sync, "switch"));
+
+    // The SSY skips the scheduling word before its target.
+    const std::string with_sync = Decompile({
+        SetSyncPoint(4),
+        LoadAttribute(1, ATTRIBUTE_0, 0),
+        Sync(),
+        StoreAttribute(1, ATTRIBUTE_POSITION, 0),
+        Exit(),
+    });
+    REQUIRE(Contains(with_sync, "flow_stack"));
+    REQUIRE(Contains(with_sync, "switch"));
+}
+
+TEST_CASE("ShaderDecompiler: Code size and decompilation time", "[.benchmark][video_core]") {
+    constexpr int num_programs = 100;
+    constexpr int num_instructions = 600;
+    constexpr u64 num_registers = 32;
+
+    std::mt19937 rng{1234};
+    std::vector<ProgramCode> programs;
+    for (int program = 0; program < num_programs; ++program) {
+        std::vector<u64> instructions;
+        for (u64 i = 0; i < 8; ++i) {
+            instructions.push_back(LoadAttribute(i, ATTRIBUTE_0 + i / 4, i % 4));
+        }
+        for (int i = 0; i < num_instructions; ++i) {
+            const u64 dest = rng() % num_registers;
+            const u64 a = rng() % num_registers;
+            const u64 b = rng() % num_registers;
+            switch (rng() % 5) {
+            case 0:
+                instructions.push_back(MoveImmediate(dest, static_cast<float>(rng() % 16) / 4));
+                break;
+            case 1:
+                instructions.push_back(IntegerAdd(dest, a, b));
+                break;
+            case 2:
+                instructions.push_back(ShiftLeft(dest, a, rng() % 16));
+                break;
+            case 3:
+                instructions.push_back(IntegerToFloat(dest, a));
+                break;
+            default:
+                instructions.push_back(FloatAdd(dest, a, b));
+                break;
+            }
+        }
+        for (u64 element = 0; element < 4; ++element) {
+            instructions.push_back(StoreAttribute(element, ATTRIBUTE_POSITION, element));
+        }
+        instructions.push_back(Exit());
+        programs.push_back(MakeProgram(instructions));
+    }
+
+    std::size_t code_size = 0;
+    const auto elapsed = TestCommon::MeasureTime([&] {
+        for (const auto& program : programs) {
+            const auto result = DecompileProgram(program, MAIN_OFFSET, Stage::Vertex, "vertex");
+            REQUIRE(result.is_initialized());
+            code_size += result->first.size();
+        }
+    });
+
+    TestCommon::ReportBenchmark(fmt::format("Decompiling {} programs", num_programs),
+                                fmt::format("{} bytes of GLSL, {:>8.0f} us", code_size,
+                                            elapsed.count() * 1e6));
+}
+
+} // namespace OpenGL::GLShader::Decompiler
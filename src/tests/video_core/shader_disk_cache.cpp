@@ -0,0 +1,153 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+#include "common/common_paths.h"
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
+
+namespace OpenGL {
+namespace {
+
+constexpr char TEST_DIR[] = "shader_disk_cache_test";
+constexpr u64 TITLE_ID = 0x0100000000010000;
+
+const std::string TRANSFERABLE_PATH =
+    std::string(TEST_DIR) + DIR_SEP "transferable" DIR_SEP "0100000000010000.bin";
+
+ShaderDiskCacheDecompiled MakeShader(u64 unique_identifier, Maxwell::ShaderProgram program_type) {
+    ShaderDiskCacheDecompiled shader{unique_identifier, program_type, {}, {}};
+    shader.code = "void main() { /* " + std::to_string(unique_identifier) + " */ }\n";
+
+    GLShader::ConstBufferEntry direct;
+    direct.MarkAsUsed(1, 0x40, Maxwell::ShaderStage::Fragment);
+    GLShader::ConstBufferEntry indirect;
+    indirect.MarkAsUsed(3, 0x10, Maxwell::ShaderStage::Fragment);
+    indirect.MarkAsUsedIndirect(3, Maxwell::ShaderStage::Fragment);
+    shader.entries.const_buffer_entries = {direct, indirect};
+
+    shader.entries.texture_samplers.emplace_back(Maxwell::ShaderStage::Fragment, 0x20, 0,
+                                                 Tegra::Shader::TextureType::Texture2D, true,
+                                                 false);
+    shader.entries.texture_samplers.emplace_back(Maxwell::ShaderStage::Fragment, 0x28, 1,
+                                                 Tegra::Shader::TextureType::TextureCube, false,
+                                                 true);
+    return shader;
+}
+
+void CheckShader(const ShaderDiskCacheDecompiled& loaded,
+                 const ShaderDiskCacheDecompiled& expected) {
+    REQUIRE(loaded.unique_identifier == expected.unique_identifier);
+    REQUIRE(loaded.program_type == expected.program_type);
+    REQUIRE(loaded.code == expected.code);
+
+    const auto& buffers = loaded.entries.const_buffer_entries;
+    const auto& expected_buffers = expected.entries.const_buffer_entries;
+    REQUIRE(buffers.size() == expected_buffers.size());
+    for (std::size_t i = 0; i < buffers.size(); ++i) {
+        REQUIRE(buffers[i].IsUsed());
+        REQUIRE(buffers[i].IsIndirect() == expected_buffers[i].IsIndirect());
+        REQUIRE(buffers[i].GetIndex() == expected_buffers[i].GetIndex());
+        REQUIRE(buffers[i].GetSize() == expected_buffers[i].GetSize());
+        REQUIRE(buffers[i].GetHash() == expected_buffers[i].GetHash());
+    }
+
+    const auto& samplers = loaded.entries.texture_samplers;
+    const auto& expected_samplers = expected.entries.texture_samplers;
+    REQUIRE(samplers.size() == expected_samplers.size());
+    for (std::size_t i = 0; i < samplers.size(); ++i) {
+        REQUIRE(samplers[i].GetOffset() == expected_samplers[i].GetOffset());
+        REQUIRE(samplers[i].GetIndex() == expected_samplers[i].GetIndex());
+        REQUIRE(samplers[i].GetStage() == expected_samplers[i].GetStage());
+        REQUIRE(samplers[i].GetType() == expected_samplers[i].GetType());
+        REQUIRE(samplers[i].IsArray() == expected_samplers[i].IsArray());
+        REQUIRE(samplers[i].IsShadow() == expected_samplers[i].IsShadow());
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ShaderDiskCache: Decompiled shaders are loaded back", "[video_core]") {
+    FileUtil::DeleteDirRecursively(TEST_DIR);
+
+    const std::vector<ShaderDiskCacheDecompiled> shaders{
+        MakeShader(0x1234, Maxwell::ShaderProgram::VertexB),
+        MakeShader(0x5678, Maxwell::ShaderProgram::Fragment),
+        MakeShader(0x9ABC, Maxwell::ShaderProgram::Geometry),
+    };
+    {
+        ShaderDiskCacheOpenGL cache(TEST_DIR, TITLE_ID);
+        REQUIRE(cache.LoadDecompiled().empty());
+        for (const auto& shader : shaders)
+            cache.SaveDecompiled(shader);
+    }
+
+    ShaderDiskCacheOpenGL cache(TEST_DIR, TITLE_ID);
+    const auto loaded = cache.LoadDecompiled();
+    REQUIRE(loaded.size() == shaders.size());
+    for (std::size_t i = 0; i < loaded.size(); ++i)
+        CheckShader(loaded[i], shaders[i]);
+
+    // Other titles have their own cache.
+    REQUIRE(ShaderDiskCacheOpenGL(TEST_DIR, TITLE_ID + 1).LoadDecompiled().empty());
+
+    FileUtil::DeleteDirRecursively(TEST_DIR);
+}
+
+TEST_CASE("ShaderDiskCache: A shader cut short is dropped", "[video_core]") {
+    FileUtil::DeleteDirRecursively(TEST_DIR);
+
+    const auto first = MakeShader(1, Maxwell::ShaderProgram::VertexA);
+    const auto second = MakeShader(2, Maxwell::ShaderProgram::Fragment);
+    const auto third = MakeShader(3, Maxwell::ShaderProgram::Fragment);
+    {
+        ShaderDiskCacheOpenGL cache(TEST_DIR, TITLE_ID);
+        cache.SaveDecompiled(first);
+        cache.SaveDecompiled(second);
+    }
+    {
+        // As if the emulator was closed while saving the last shader
+        FileUtil::IOFile file(TRANSFERABLE_PATH, "r+b");
+        REQUIRE(file.Resize(file.GetSize() - 5));
+    }
+
+    ShaderDiskCacheOpenGL cache(TEST_DIR, TITLE_ID);
+    auto loaded = cache.LoadDecompiled();
+    REQUIRE(loaded.size() == 1);
+    CheckShader(loaded[0], first);
+
+    // Shaders saved afterwards follow the ones that were complete.
+    cache.SaveDecompiled(third);
+    loaded = cache.LoadDecompiled();
+    REQUIRE(loaded.size() == 2);
+    CheckShader(loaded[0], first);
+    CheckShader(loaded[1], third);
+
+    FileUtil::DeleteDirRecursively(TEST_DIR);
+}
+
+TEST_CASE("ShaderDiskCache: Caches of other versions are removed", "[video_core]") {
+    FileUtil::DeleteDirRecursively(TEST_DIR);
+
+    ShaderDiskCacheOpenGL(TEST_DIR, TITLE_ID)
+        .SaveDecompiled(MakeShader(1, Maxwell::ShaderProgram::VertexB));
+    {
+        FileUtil::IOFile file(TRANSFERABLE_PATH, "r+b");
+        const u32 version = 0xFFFFFFFF;
+        REQUIRE(file.Seek(4, SEEK_SET));
+        REQUIRE(file.WriteObject(version) == 1);
+    }
+
+    ShaderDiskCacheOpenGL cache(TEST_DIR, TITLE_ID);
+    REQUIRE(cache.LoadDecompiled().empty());
+    REQUIRE(!FileUtil::Exists(TRANSFERABLE_PATH));
+
+    FileUtil::DeleteDirRecursively(TEST_DIR);
+}
+
+} // namespace OpenGL
@@ -0,0 +1,283 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <random>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "tests/test_common.h"
+#include "tests/video_core/textures/astc_reference.h"
+#include "video_core/textures/astc.h"
+
+namespace {
+
+/// Block sizes of the ASTC formats of the rasterizer cache
+constexpr std::array<std::pair<u32, u32>, 4> block_sizes{{{4, 4}, {5, 4}, {8, 8}, {8, 5}}};
+
+using Block = std::array<u8, 16>;
+
+u32 BlockBits(const Block& block, u32 position, u32 count) {
+    u32 value = 0;
+    for (u32 bit = 0; bit < count; ++bit) {
+        value |= ((block[(position + bit) / 8] >> ((position + bit) % 8)) & 1) << bit;
+    }
+    return value;
+}
+
+/// Number of bits of `count` integers below `range` in a bounded integer sequence
+u32 SequenceBits(u32 range, u32 count) {
+    const auto log2 = [](u32 value) {
+        u32 bits = 0;
+        while ((1U << bits) < value) {
+            ++bits;
+        }
+        return bits;
+    };
+    if (range % 3 == 0) {
+        return count * log2(range / 3) + (count * 8 + 4) / 5;
+    }
+    if (range % 5 == 0) {
+        return count * log2(range / 5) + (count * 7 + 2) / 3;
+    }
+    return count * log2(range);
+}
+
+/**
+ * Returns true when a block is a legal LDR block that isn't a void extent, written from the
+ * block mode table and the list of illegal encodings of the ASTC specification. The reference
+ * decoder asserts on the other ones.
+ */
+bool IsLegalBlock(const Block& block, u32 block_width, u32 block_height) {
+    const u32 mode = BlockBits(block, 0, 11);
+    if ((mode & 0x1FF) == 0x1FC || (mode & 0xF) == 0) {
+        return false;
+    }
+
+    const u32 a = (mode >> 5) & 3;
+    const u32 b = (mode >> 7) & 3;
+    u32 range_index = (mode >> 4) & 1;
+    bool high_precision = (mode >> 9) & 1;
+    bool dual_plane = (mode >> 10) & 1;
+    u32 width;
+    u32 height;
+    if ((mode & 3) != 0) {
+        range_index |= (mode & 3) << 1;
+        switch ((mode >> 2) & 3) {
+        case 0:
+            width = b + 4;
+            height = a + 2;
+            break;
+        case 1:
+            width = b + 8;
+            height = a + 2;
+            break;
+        case 2:
+            width = a + 2;
+            height = b + 8;
+            break;
+        default:
+            width = (mode & 0x100) != 0 ? (b & 1) + 2 : a + 2;
+            height = (mode & 0x100) != 0 ? a + 2 : (b & 1) + 6;
+            break;
+        }
+    } else {
+        range_index |= (mode >> 1) & 6;
+        switch (b) {
+        case 0:
+            width = 12;
+            height = a + 2;
+            break;
+        case 1:
+            width = a + 2;
+            height = 12;
+            break;
+        case 2:
+            width = a + 6;
+            height = ((mode >> 9) & 3) + 6;
+            high_precision = false;
+            dual_plane = false;
+            break;
+        default:
+            if ((mode & 0x40) != 0) {
+                return false;
+            }
+            width = (mode & 0x20) != 0 ? 10 : 6;
+            height = (mode & 0x20) != 0 ? 6 : 10;
+            break;
+        }
+    }
+    static constexpr u32 weight_ranges[2][6]{{2, 3, 4, 5, 6, 8}, {10, 12, 16, 20, 24, 32}};
+    const u32 num_weights = width * height * (dual_plane ? 2 : 1);
+    const u32 weight_range = weight_ranges[high_precision][range_index - 2];
+    const u32 weight_bits = SequenceBits(weight_range, num_weights);
+    if (width > block_width || height > block_height || num_weights > 64 || weight_bits < 24 ||
+        weight_bits > 96) {
+        return false;
+    }
+
+    const u32 num_partitions = BlockBits(block, 11, 2) + 1;
+    if (num_partitions == 4 && dual_plane) {
+        return false;
+    }
+    std::array<u32, 4> endpoint_modes{};
+    u32 config_bits = 17;
+    u32 extra_cem_bits = 0;
+    if (num_partitions == 1) {
+        endpoint_modes[0] = BlockBits(block, 13, 4);
+    } else {
+        config_bits = 29;
+        const u32 base_cem = BlockBits(block, 23, 6);
+        if ((base_cem & 3) == 0) {
+            endpoint_modes.fill(base_cem >> 2);
+        } else {
+            extra_cem_bits = num_partitions * 3 - 4;
+            const u32 extra_cem = BlockBits(block, 128 - weight_bits - extra_cem_bits,
+                                            extra_cem_bits);
+            const u32 cem = ((extra_cem << 6) | base_cem) >> 2;
+            for (u32 i = 0; i < num_partitions; ++i) {
+                const u32 endpoint_class = (base_cem & 3) - 1 + ((cem >> i) & 1);
+                const u32 selector = (cem >> (num_partitions + i * 2)) & 3;
+                endpoint_modes[i] = (endpoint_class << 2) | selector;
+            }
+        }
+    }
+
+    u32 num_color_values = 0;
+    for (u32 i = 0; i < num_partitions; ++i) {
+        // HDR endpoint modes
+        switch (endpoint_modes[i]) {
+        case 2:
+        case 3:
+        case 7:
+        case 11:
+        case 14:
+        case 15:
+            return false;
+        }
+        num_color_values += ((endpoint_modes[i] >> 2) + 1) * 2;
+    }
+    const int color_bits = 128 - static_cast<int>(weight_bits + extra_cem_bits + config_bits) -
+                           (dual_plane ? 2 : 0);
+    return num_color_values <= 18 && color_bits >= static_cast<int>(num_color_values * 13 + 4) / 5;
+}
+
+/// Generates legal blocks, with a few LDR void extent blocks among them
+std::vector<u8> RandomBlocks(std::size_t count, u32 block_width, u32 block_height,
+                             std::mt19937& rng) {
+    std::vector<u8> data;
+    data.reserve(count * 16);
+    while (data.size() < count * 16) {
+        Block block;
+        for (u8& byte : block) {
+            byte = static_cast<u8>(rng());
+        }
+        if (rng() % 16 == 0) {
+            block[0] = 0xFC;
+            block[1] = 0x0D | (block[1] & 0xF0);
+        } else if (!IsLegalBlock(block, block_width, block_height)) {
+            continue;
+        }
+        data.insert(data.end(), block.begin(), block.end());
+    }
+    return data;
+}
+
+void CheckConformance(u32 block_width, u32 block_height, u32 blocks_on_x, u32 blocks_on_y,
+                      std::mt19937& rng) {
+    // Textures aren't always a whole number of blocks
+    const u32 width = blocks_on_x * block_width - 1;
+    const u32 height = blocks_on_y * block_height - 2;
+    auto data =
+        RandomBlocks(std::size_t{blocks_on_x} * blocks_on_y, block_width, block_height, rng);
+
+    const auto expected = ASTCReference::Decompress(data, width, height, block_width, block_height);
+    const auto decoded =
+        Tegra::Texture::ASTC::Decompress(data, width, height, block_width, block_height);
+    REQUIRE(decoded.size() == expected.size());
+    for (std::size_t i = 0; i < decoded.size(); ++i) {
+        if (decoded[i] != expected[i]) {
+            const std::size_t texel = i / 4;
+            const std::size_t block = texel / width / block_height * blocks_on_x +
+                                      texel % width / block_width;
+            FAIL(fmt::format("{}x{} texel ({}, {}) channel {}: {} instead of {}, block {:02X}",
+                             block_width, block_height, texel % width, texel / width, i % 4,
+                             decoded[i], expected[i],
+                             fmt::join(data.begin() + block * 16, data.begin() + block * 16 + 16,
+                                       " ")));
+        }
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ASTC: Decoded blocks match the reference decoder", "[video_core]") {
+    std::mt19937 rng(0xa57c);
+    for (const auto& [block_width, block_height] : block_sizes) {
+        // Small textures are decoded on the calling thread, large ones on a thread pool.
+        CheckConformance(block_width, block_height, 3, 2, rng);
+        CheckConformance(block_width, block_height, 64, 64, rng);
+    }
+}
+
+TEST_CASE("ASTC: Illegal blocks are decoded as magenta", "[video_core]") {
+    const auto decode = [](Block block, u32 block_width, u32 block_height) {
+        std::vector<u8> data(block.begin(), block.end());
+        return Tegra::Texture::ASTC::Decompress(data, block_width, block_height, block_width,
+                                                block_height);
+    };
+    const auto is_magenta = [](const std::vector<u8>& texels) {
+        for (std::size_t i = 0; i < texels.size(); i += 4) {
+            if (texels[i] != 0xFF || texels[i + 1] != 0 || texels[i + 2] != 0xFF ||
+                texels[i + 3] != 0xFF) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Reserved block mode
+    REQUIRE(is_magenta(decode({}, 4, 4)));
+    // HDR void extent
+    REQUIRE(is_magenta(decode({0xFC, 0x0F}, 8, 8)));
+    // A 12x4 weight grid doesn't fit in a 8x5 block
+    REQUIRE(is_magenta(decode({0x4C, 0x00}, 8, 5)));
+    // 4x4 weights of 5 bits with two planes take more than 96 bits
+    REQUIRE(is_magenta(decode({0x53, 0x06}, 4, 4)));
+    // LDR void extent blocks are still decoded
+    const Block void_extent{0xFC, 0x0D, 0, 0, 0, 0, 0, 0, 0, 0x12, 0, 0x34, 0, 0x56, 0, 0x78};
+    const auto texels = decode(void_extent, 4, 4);
+    REQUIRE(texels[0] == 0x12);
+    REQUIRE(texels[1] == 0x34);
+    REQUIRE(texels[2] == 0x56);
+    REQUIRE(texels[3] == 0x78);
+}
+
+TEST_CASE("ASTC: Decompression throughput", "[.benchmark][video_core]") {
+    constexpr u32 texture_size = 1024;
+    std::mt19937 rng(0xbe7c);
+
+    for (const auto& [block_width, block_height] : block_sizes) {
+        const u32 blocks_on_x = texture_size / block_width;
+        const u32 blocks_on_y = texture_size / block_height;
+        const u32 width = blocks_on_x * block_width;
+        const u32 height = blocks_on_y * block_height;
+        auto data = RandomBlocks(std::size_t{blocks_on_x} * blocks_on_y, block_width,
+                                 block_height, rng);
+
+        const auto measure = [&](auto&& decompress, int iterations) {
+            const auto elapsed = TestCommon::MeasureTime(
+                [&] { decompress(data, width, height, block_width, block_height); }, iterations);
+            return static_cast<double>(width) * height * iterations / elapsed.count() / 1e6;
+        };
+        const double throughput = measure(Tegra::Texture::ASTC::Decompress, 16);
+        const double reference_throughput = measure(ASTCReference::Decompress, 1);
+        TestCommon::ReportBenchmark(
+            fmt::format("ASTC decompression: {}x{} blocks", block_width, block_height),
+            fmt::format("{:>8.1f} Mtexel/s, reference {:>8.1f} Mtexel/s", throughput,
+                        reference_throughput));
+    }
+}
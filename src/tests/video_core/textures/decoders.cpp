@@ -0,0 +1,254 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <random>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+#include "tests/test_common.h"
+#include "tests/video_core/gpu_test_common.h"
+#include "video_core/textures/decoders.h"
+
+namespace {
+
+/// Offset of a byte of a block linear surface, computed from the layout documentation
+std::size_t ReferenceOffset(u32 x, u32 y, u32 z, u32 width_in_bytes, u32 height,
+                            u32 block_height, u32 block_depth) {
+    const std::size_t gobs_in_x = (width_in_bytes + 63) / 64;
+    const std::size_t blocks_on_y = (height + 8 * block_height - 1) / (8 * block_height);
+    const std::size_t block_size = 512 * block_height * block_depth;
+    const u32 gob_y = y / 8;
+    const std::size_t block_offset = (z / block_depth) * blocks_on_y * gobs_in_x * block_size +
+                                     (gob_y / block_height) * gobs_in_x * block_size +
+                                     (x / 64) * block_size;
+    const std::size_t gob_offset = (z % block_depth) * 512 * block_height +
+                                   (gob_y % block_height) * 512;
+    const u32 x_in_gob = x % 64;
+    const u32 y_in_gob = y % 8;
+    return block_offset + gob_offset + (x_in_gob / 32) * 256 + (y_in_gob / 2) * 64 +
+           ((x_in_gob % 32) / 16) * 32 + (y_in_gob % 2) * 16 + x_in_gob % 16;
+}
+
+/// Copies a surface texel by texel, as the decoders did before being vectorized
+void ScalarCopySwizzledData(u32 width, u32 height, u32 depth, u32 bytes_per_pixel,
+                            u8* swizzled_data, u8* unswizzled_data, bool unswizzle,
+                            u32 block_height, u32 block_depth) {
+    const u32 pitch = width * bytes_per_pixel;
+    for (u32 z = 0; z < depth; ++z) {
+        for (u32 y = 0; y < height; ++y) {
+            u8* const line = unswizzled_data + (z * height + y) * pitch;
+            for (u32 x = 0; x < pitch; x += bytes_per_pixel) {
+                u8* const swizzled = swizzled_data + ReferenceOffset(x, y, z, pitch, height,
+                                                                     block_height, block_depth);
+                if (unswizzle) {
+                    std::memcpy(line + x, swizzled, bytes_per_pixel);
+                } else {
+                    std::memcpy(swizzled, line + x, bytes_per_pixel);
+                }
+            }
+        }
+    }
+}
+
+constexpr u32 bytes_per_pixel_cases[] = {1, 2, 4, 8, 12, 16};
+
+} // Anonymous namespace
+
+namespace Tegra::Texture {
+
+TEST_CASE("Texture decoders: Block linear copies match the layout", "[video_core]") {
+    struct Extent {
+        u32 width;
+        u32 height;
+        u32 depth;
+    };
+    constexpr Extent extents[] = {{1, 1, 1}, {17, 9, 1}, {64, 64, 1}, {100, 37, 3}, {5, 70, 5}};
+    std::mt19937 rng(0x5a1d);
+
+    for (const u32 bytes_per_pixel : bytes_per_pixel_cases) {
+        for (const Extent& extent : extents) {
+            for (const u32 block_height : {1U, 2U, 16U}) {
+                for (const u32 block_depth : {1U, 2U}) {
+                    const u32 pitch = extent.width * bytes_per_pixel;
+                    const std::size_t size = CalculateSize(
+                        true, bytes_per_pixel, extent.width, extent.height, extent.depth,
+                        block_height, block_depth);
+                    auto linear = TestCommon::RandomBytes(
+                        std::size_t{pitch} * extent.height * extent.depth, rng);
+                    std::vector<u8> swizzled(size);
+                    CopySwizzledData(extent.width, extent.height, extent.depth, bytes_per_pixel,
+                                     bytes_per_pixel, swizzled.data(), linear.data(), false,
+                                     block_height, block_depth);
+
+                    bool layout_matches = true;
+                    for (u32 z = 0; z < extent.depth; ++z) {
+                        for (u32 y = 0; y < extent.height; ++y) {
+                            for (u32 x = 0; x < pitch; ++x) {
+                                const std::size_t offset =
+                                    ReferenceOffset(x, y, z, pitch, extent.height, block_height,
+                                                    block_depth);
+                                const u8 expected = linear[(z * extent.height + y) * pitch + x];
+                                layout_matches &= offset < size && swizzled[offset] == expected;
+                            }
+                        }
+                    }
+                    INFO("bpp " << bytes_per_pixel << " width " << extent.width << " height "
+                                << extent.height << " depth " << extent.depth << " block "
+                                << block_height << "x" << block_depth);
+                    REQUIRE(layout_matches);
+
+                    std::vector<u8> unswizzled(linear.size());
+                    CopySwizzledData(extent.width, extent.height, extent.depth, bytes_per_pixel,
+                                     bytes_per_pixel, swizzled.data(), unswizzled.data(), true,
+                                     block_height, block_depth);
+                    REQUIRE(unswizzled == linear);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Texture decoders: Large surfaces copied in parallel match a serial copy",
+          "[video_core]") {
+    constexpr u32 width = 1000;
+    constexpr u32 height = 300;
+    constexpr u32 depth = 4;
+    constexpr u32 bytes_per_pixel = 4;
+    constexpr u32 block_height = 4;
+    constexpr u32 block_depth = 2;
+    std::mt19937 rng(0x9a7a);
+
+    const std::size_t size =
+        CalculateSize(true, bytes_per_pixel, width, height, depth, block_height, block_depth);
+    const auto linear =
+        TestCommon::RandomBytes(std::size_t{width} * height * depth * bytes_per_pixel, rng);
+
+    std::vector<u8> swizzled(size);
+    std::vector<u8> expected(size);
+    auto source = linear;
+    CopySwizzledData(width, height, depth, bytes_per_pixel, bytes_per_pixel, swizzled.data(),
+                     source.data(), false, block_height, block_depth);
+    ScalarCopySwizzledData(width, height, depth, bytes_per_pixel, expected.data(), source.data(),
+                           false, block_height, block_depth);
+    REQUIRE(swizzled == expected);
+
+    std::vector<u8> unswizzled(linear.size());
+    CopySwizzledData(width, height, depth, bytes_per_pixel, bytes_per_pixel, swizzled.data(),
+                     unswizzled.data(), true, block_height, block_depth);
+    REQUIRE(unswizzled == linear);
+}
+
+TEST_CASE("Texture decoders: Sub rectangle copies", "[video_core]") {
+    GPUTests::GPUEnvironment env;
+    constexpr u64 swizzled_offset = 0;
+    constexpr u64 linear_offset = 0x400000;
+    constexpr u32 surface_width = 150;
+    constexpr u32 surface_height = 90;
+    constexpr u32 block_height = 2;
+    std::mt19937 rng(0x7ec7);
+
+    for (const u32 bytes_per_pixel : bytes_per_pixel_cases) {
+        const u32 surface_pitch = surface_width * bytes_per_pixel;
+        const std::size_t surface_size = CalculateSize(true, bytes_per_pixel, surface_width,
+                                                       surface_height, 1, block_height, 1);
+        const auto surface = TestCommon::RandomBytes(surface_size, rng);
+        u8* const swizzled = env.GetMemory(swizzled_offset);
+        u8* const linear = env.GetMemory(linear_offset);
+        const VAddr swizzled_address = GPUTests::GPUEnvironment::MEMORY_BASE + swizzled_offset;
+        const VAddr linear_address = GPUTests::GPUEnvironment::MEMORY_BASE + linear_offset;
+
+        INFO("bpp " << bytes_per_pixel);
+
+        {
+            constexpr u32 offset_x = 13;
+            constexpr u32 offset_y = 11;
+            constexpr u32 width = 101;
+            constexpr u32 height = 60;
+            const u32 dest_pitch = width * bytes_per_pixel + 24;
+            std::memcpy(swizzled, surface.data(), surface.size());
+            std::memset(linear, 0xCD, dest_pitch * height);
+            UnswizzleSubrect(width, height, dest_pitch, surface_width, bytes_per_pixel,
+                             swizzled_address, linear_address, block_height, offset_x, offset_y);
+
+            bool matches = true;
+            for (u32 y = 0; y < height; ++y) {
+                for (u32 x = 0; x < dest_pitch; ++x) {
+                    const u32 line_size = width * bytes_per_pixel;
+                    const u8 expected =
+                        x < line_size
+                            ? surface[ReferenceOffset(offset_x * bytes_per_pixel + x, offset_y + y,
+                                                      0, surface_pitch, surface_height,
+                                                      block_height, 1)]
+                            : 0xCD;
+                    matches &= linear[y * dest_pitch + x] == expected;
+                }
+            }
+            REQUIRE(matches);
+        }
+
+        {
+            constexpr u32 width = 77;
+            constexpr u32 height = 35;
+            const u32 source_pitch = width * bytes_per_pixel + 40;
+            const auto source = TestCommon::RandomBytes(source_pitch * height, rng);
+            std::memcpy(swizzled, surface.data(), surface.size());
+            std::memcpy(linear, source.data(), source.size());
+            SwizzleSubrect(width, height, source_pitch, surface_width, bytes_per_pixel,
+                           swizzled_address, linear_address, block_height);
+
+            // Bytes outside of the rectangle have to be preserved
+            auto expected = surface;
+            for (u32 y = 0; y < height; ++y) {
+                for (u32 x = 0; x < width * bytes_per_pixel; ++x) {
+                    expected[ReferenceOffset(x, y, 0, surface_pitch, surface_height, block_height,
+                                             1)] = source[y * source_pitch + x];
+                }
+            }
+            REQUIRE(std::memcmp(swizzled, expected.data(), expected.size()) == 0);
+        }
+    }
+}
+
+TEST_CASE("Texture decoders: Block linear copy throughput", "[.benchmark][video_core]") {
+    constexpr u32 width = 1024;
+    constexpr u32 height = 1024;
+    constexpr u32 block_height = 16;
+    constexpr int iterations = 16;
+    std::mt19937 rng(0xbe7c);
+
+    const auto measure = [](auto&& copy, std::size_t bytes) {
+        const auto elapsed = TestCommon::MeasureTime(copy, iterations);
+        return static_cast<double>(bytes) * iterations / elapsed.count() / 1e9;
+    };
+
+    for (const u32 bytes_per_pixel : bytes_per_pixel_cases) {
+        const std::size_t size = CalculateSize(true, bytes_per_pixel, width, height, 1,
+                                               block_height, 1);
+        auto linear = TestCommon::RandomBytes(std::size_t{width} * height * bytes_per_pixel, rng);
+        std::vector<u8> swizzled(size);
+
+        const auto copy = [&](bool unswizzle) {
+            CopySwizzledData(width, height, 1, bytes_per_pixel, bytes_per_pixel, swizzled.data(),
+                             linear.data(), unswizzle, block_height, 1);
+        };
+        const auto scalar_copy = [&](bool unswizzle) {
+            ScalarCopySwizzledData(width, height, 1, bytes_per_pixel, swizzled.data(),
+                                   linear.data(), unswizzle, block_height, 1);
+        };
+        const double swizzle = measure([&] { copy(false); }, linear.size());
+        const double scalar_swizzle = measure([&] { scalar_copy(false); }, linear.size());
+        const double unswizzle = measure([&] { copy(true); }, linear.size());
+        const double scalar_unswizzle = measure([&] { scalar_copy(true); }, linear.size());
+        TestCommon::ReportBenchmark(
+            fmt::format("Block linear copy: {} bytes per pixel", bytes_per_pixel),
+            fmt::format("swizzle {:>6.2f} GB/s (scalar {:>6.2f}), unswizzle {:>6.2f} GB/s "
+                        "(scalar {:>6.2f})",
+                        swizzle, scalar_swizzle, unswizzle, scalar_unswizzle));
+    }
+}
+
+} // namespace Tegra::Texture
@@ -0,0 +1,77 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include "common/assert.h"
+#include "video_core/cached_page_tracker.h"
+
+namespace VideoCore {
+
+CachedPageTracker::CachedPageTracker() = default;
+
+CachedPageTracker::~CachedPageTracker() = default;
+
+void CachedPageTracker::MarkRegionDirty(VAddr addr, u64 size) {
+    ForEachGroup(addr, size, [this](u64 group_index, u64 mask) {
+        const auto iter = groups.find(group_index);
+        if (iter == groups.end()) {
+            return;
+        }
+
+        PageGroup& group = iter->second;
+        group.dirty_mask |= mask & group.cached_mask;
+        if (group.dirty_mask != 0 && !group.is_queued) {
+            group.is_queued = true;
+            dirty_groups.push_back(group_index);
+        }
+    });
+}
+
+u64 CachedPageTracker::UpdateGroupCount(u64 group_index, u64 mask, int delta) {
+    PageGroup& group = groups[group_index];
+
+    u64 changed = 0;
+    for (u64 pages = mask; pages != 0; pages &= pages - 1) {
+        const std::size_t bit = CountTrailingZeroes(pages);
+        u32& count = group.counts[bit];
+        ASSERT(delta > 0 || count >= static_cast<u32>(-delta));
+
+        const bool was_cached = count != 0;
+        count += delta;
+        if (was_cached != (count != 0)) {
+            changed |= 1ULL << bit;
+        }
+    }
+
+    if (delta > 0) {
+        group.cached_mask |= changed;
+    } else {
+        // Pages without cached objects have nothing to invalidate
+        group.cached_mask &= ~changed;
+        group.dirty_mask &= ~changed;
+    }
+    return changed;
+}
+
+u64 CachedPageTracker::TakeDirtyMask(u64 group_index) {
+    PageGroup& group = groups.at(group_index);
+    const u64 dirty_mask = group.dirty_mask;
+    group.dirty_mask = 0;
+    group.is_queued = false;
+    return dirty_mask;
+}
+
+std::size_t CachedPageTracker::CountTrailingZeroes(u64 value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return index;
+#else
+    return static_cast<std::size_t>(__builtin_ctzll(value));
+#endif
+}
+
+} // namespace VideoCore
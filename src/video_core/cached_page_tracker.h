@@ -0,0 +1,161 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+
+namespace VideoCore {
+
+/**
+ * Tracks, for each guest CPU page, how many rasterizer cached objects it backs and whether the CPU
+ * has written to it since the caches were last synchronized. Only cached pages can be dirty, a page
+ * stops being dirty as soon as no cached object uses it anymore.
+ *
+ * Pages are stored in groups of 64, allocated the first time one of their pages is cached, so that
+ * both the counts and the dirty bits of a region are a few bit operations per group.
+ */
+class CachedPageTracker final {
+public:
+    static constexpr std::size_t PAGE_BITS = 12;
+    static constexpr u64 PAGE_SIZE = 1ULL << PAGE_BITS;
+
+    CachedPageTracker();
+    ~CachedPageTracker();
+
+    /**
+     * Increases or decreases the number of cached objects in the pages touching the given region.
+     * The given function is called with the address and size of each contiguous run of pages that
+     * became cached, when delta is positive, or uncached, when it is negative.
+     */
+    template <typename Func>
+    void UpdateCachedCount(VAddr addr, u64 size, int delta, Func&& func) {
+        PageRun run;
+        ForEachGroup(addr, size, [&](u64 group_index, u64 mask) {
+            const u64 changed = UpdateGroupCount(group_index, mask, delta);
+            AppendToRun(run, group_index, changed, func);
+        });
+        FinishRun(run, func);
+    }
+
+    /// Marks the cached pages touching the given region as dirty, other pages are left untouched
+    void MarkRegionDirty(VAddr addr, u64 size);
+
+    /// Returns true if a cached page may have been marked as dirty since the last consumption
+    bool HasDirtyPages() const {
+        return !dirty_groups.empty();
+    }
+
+    /**
+     * Clears all dirty pages, calling the given function with the address and size of each
+     * contiguous dirty region, in ascending address order. The function may update the cached
+     * counts, as invalidating the objects of a region does.
+     */
+    template <typename Func>
+    void ConsumeDirtyRegions(Func&& func) {
+        if (dirty_groups.empty()) {
+            return;
+        }
+
+        consumed_groups.swap(dirty_groups);
+        std::sort(consumed_groups.begin(), consumed_groups.end());
+
+        PageRun run;
+        for (const u64 group_index : consumed_groups) {
+            AppendToRun(run, group_index, TakeDirtyMask(group_index), func);
+        }
+        FinishRun(run, func);
+
+        consumed_groups.clear();
+    }
+
+private:
+    static constexpr std::size_t PAGES_PER_GROUP = 64;
+
+    struct PageGroup {
+        std::array<u32, PAGES_PER_GROUP> counts{};
+        u64 cached_mask{}; ///< One bit per page used by at least one cached object
+        u64 dirty_mask{};  ///< One bit per cached page written by the CPU, subset of cached_mask
+        bool is_queued{};  ///< Whether the group is in dirty_groups
+    };
+
+    /// Contiguous run of pages being built, handed to the caller once it can't grow anymore
+    struct PageRun {
+        u64 start_page{};
+        u64 num_pages{};
+    };
+
+    /// Calls the given function with the index of each group touching a region, and the mask of
+    /// the pages of the region in that group
+    template <typename Func>
+    static void ForEachGroup(VAddr addr, u64 size, Func&& func) {
+        if (size == 0) {
+            return;
+        }
+
+        const u64 page_start = addr >> PAGE_BITS;
+        const u64 page_end = (addr + size + PAGE_SIZE - 1) >> PAGE_BITS;
+        for (u64 page = page_start; page < page_end;) {
+            const u64 group_index = page / PAGES_PER_GROUP;
+            const u64 first_bit = page % PAGES_PER_GROUP;
+            const u64 num_bits = std::min<u64>(PAGES_PER_GROUP - first_bit, page_end - page);
+            const u64 mask = num_bits == PAGES_PER_GROUP ? ~0ULL
+                                                         : ((1ULL << num_bits) - 1) << first_bit;
+            func(group_index, mask);
+            page += num_bits;
+        }
+    }
+
+    /// Adds the pages set in `mask` to the run, handing the run to func every time it's broken
+    template <typename Func>
+    static void AppendToRun(PageRun& run, u64 group_index, u64 mask, Func& func) {
+        while (mask != 0) {
+            const u64 page = group_index * PAGES_PER_GROUP + CountTrailingZeroes(mask);
+            mask &= mask - 1;
+
+            if (run.num_pages != 0 && run.start_page + run.num_pages == page) {
+                ++run.num_pages;
+                continue;
+            }
+            FinishRun(run, func);
+            run.start_page = page;
+            run.num_pages = 1;
+        }
+    }
+
+    template <typename Func>
+    static void FinishRun(PageRun& run, Func& func) {
+        if (run.num_pages != 0) {
+            func(run.start_page << PAGE_BITS, run.num_pages << PAGE_BITS);
+        }
+        run.num_pages = 0;
+    }
+
+    /**
+     * Adds delta to the counts of the pages of a group set in `mask`.
+     * @returns The mask of the pages that became cached or uncached
+     */
+    u64 UpdateGroupCount(u64 group_index, u64 mask, int delta);
+
+    /// Clears the dirty bits of a group, returning them
+    u64 TakeDirtyMask(u64 group_index);
+
+    static std::size_t CountTrailingZeroes(u64 value);
+
+    std::unordered_map<u64, PageGroup> groups;
+
+    /// Indices of the groups marked dirty since the last consumption, without duplicates. Their
+    /// pages may have been uncached since.
+    std::vector<u64> dirty_groups;
+
+    /// Storage of the groups being consumed, reused so that consuming doesn't allocate
+    std::vector<u64> consumed_groups;
+};
+
+} // namespace VideoCore
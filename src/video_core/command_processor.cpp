@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <memory>
@@ -31,102 +32,169 @@ enum class BufferMethods {
 
 MICROPROFILE_DEFINE(ProcessCommandLists, "GPU", "Execute command buffer", MP_RGB(128, 128, 192));
 
-void GPU::ProcessCommandLists(const std::vector<CommandListHeader>& commands) {
-    MICROPROFILE_SCOPE(ProcessCommandLists);
-
-    auto WriteReg = [this](u32 method, u32 subchannel, u32 value, u32 remaining_params) {
-        LOG_TRACE(HW_GPU,
-                  "Processing method {:08X} on subchannel {} value "
-                  "{:08X} remaining params {}",
-                  method, subchannel, value, remaining_params);
+const u32* GPU::GetCommandListWords(GPUVAddr address, std::size_t num_words) {
+    const std::size_t size = num_words * sizeof(u32);
 
-        ASSERT(subchannel < bound_engines.size());
-
-        if (method == static_cast<u32>(BufferMethods::BindObject)) {
-            // Bind the current subchannel to the desired engine id.
-            LOG_DEBUG(HW_GPU, "Binding subchannel {} to engine {}", subchannel, value);
-            bound_engines[subchannel] = static_cast<EngineID>(value);
-            return;
+    // Command lists are usually allocated from a single heap block, so they can be read in place
+    const boost::optional<VAddr> head_address = memory_manager->GpuToCpuAddress(address);
+    if (!head_address) {
+        return nullptr;
+    }
+    const u64 head_size = std::min<u64>(size, MemoryManager::PAGE_SIZE -
+                                                  (address & MemoryManager::PAGE_MASK));
+    const u8* const head_pointer = Memory::GetContiguousPointer(*head_address, head_size);
+
+    bool is_contiguous = head_pointer != nullptr;
+    for (u64 offset = head_size; is_contiguous && offset < size;
+         offset += MemoryManager::PAGE_SIZE) {
+        const boost::optional<VAddr> cpu_address =
+            memory_manager->GpuToCpuAddress(address + offset);
+        if (!cpu_address) {
+            return nullptr;
         }
+        const u64 copy_size = std::min<u64>(size - offset, MemoryManager::PAGE_SIZE);
+        is_contiguous = Memory::GetContiguousPointer(*cpu_address, copy_size) ==
+                        head_pointer + offset;
+    }
+    if (is_contiguous) {
+        return reinterpret_cast<const u32*>(head_pointer);
+    }
 
-        if (method < static_cast<u32>(BufferMethods::CountBufferMethods)) {
-            // TODO(Subv): Research and implement these methods.
-            LOG_ERROR(HW_GPU, "Special buffer methods other than Bind are not implemented");
-            return;
+    // Otherwise gather the list page by page, which also flushes rasterizer cached pages
+    command_list_copy.resize(num_words);
+    u8* const dest = reinterpret_cast<u8*>(command_list_copy.data());
+    for (u64 offset = 0; offset < size;) {
+        const GPUVAddr gpu_address = address + offset;
+        const boost::optional<VAddr> cpu_address = memory_manager->GpuToCpuAddress(gpu_address);
+        if (!cpu_address) {
+            return nullptr;
         }
+        const u64 copy_size = std::min<u64>(
+            size - offset, MemoryManager::PAGE_SIZE - (gpu_address & MemoryManager::PAGE_MASK));
+        Memory::ReadBlock(*cpu_address, dest + offset, copy_size);
+        offset += copy_size;
+    }
+    return command_list_copy.data();
+}
 
-        const EngineID engine = bound_engines[subchannel];
+void GPU::CallMethod(u32 method, u32 subchannel, u32 value, u32 remaining_params) {
+    LOG_TRACE(HW_GPU,
+              "Processing method {:08X} on subchannel {} value "
+              "{:08X} remaining params {}",
+              method, subchannel, value, remaining_params);
 
-        switch (engine) {
-        case EngineID::FERMI_TWOD_A:
-            fermi_2d->WriteReg(method, value);
-            break;
+    ASSERT(subchannel < bound_engines.size());
+
+    if (method == static_cast<u32>(BufferMethods::BindObject)) {
+        // Bind the current subchannel to the desired engine id.
+        LOG_DEBUG(HW_GPU, "Binding subchannel {} to engine {}", subchannel, value);
+        bound_engines[subchannel] = static_cast<EngineID>(value);
+        return;
+    }
+
+    if (method < static_cast<u32>(BufferMethods::CountBufferMethods)) {
+        // TODO(Subv): Research and implement these methods.
+        LOG_ERROR(HW_GPU, "Special buffer methods other than Bind are not implemented");
+        return;
+    }
+
+    const EngineID engine = bound_engines[subchannel];
+
+    switch (engine) {
+    case EngineID::FERMI_TWOD_A:
+        fermi_2d->WriteReg(method, value);
+        break;
+    case EngineID::MAXWELL_B:
+        maxwell_3d->WriteReg(method, value, remaining_params);
+        break;
+    case EngineID::MAXWELL_COMPUTE_B:
+        maxwell_compute->WriteReg(method, value);
+        break;
+    case EngineID::MAXWELL_DMA_COPY_A:
+        maxwell_dma->WriteReg(method, value);
+        break;
+    case EngineID::KEPLER_INLINE_TO_MEMORY_B:
+        kepler_memory->WriteReg(method, value);
+        break;
+    default:
+        UNIMPLEMENTED_MSG("Unimplemented engine");
+    }
+}
+
+void GPU::CallMultiMethod(u32 method, u32 subchannel, const u32* values, u32 amount,
+                          bool increasing) {
+    ASSERT(subchannel < bound_engines.size());
+
+    // Only the engines with bulk data registers handle batches on their own, everything else is
+    // written one register at a time.
+    if (method >= static_cast<u32>(BufferMethods::CountBufferMethods)) {
+        switch (bound_engines[subchannel]) {
         case EngineID::MAXWELL_B:
-            maxwell_3d->WriteReg(method, value, remaining_params);
-            break;
-        case EngineID::MAXWELL_COMPUTE_B:
-            maxwell_compute->WriteReg(method, value);
-            break;
-        case EngineID::MAXWELL_DMA_COPY_A:
-            maxwell_dma->WriteReg(method, value);
-            break;
+            maxwell_3d->WriteRegs(method, values, amount, increasing);
+            return;
         case EngineID::KEPLER_INLINE_TO_MEMORY_B:
-            kepler_memory->WriteReg(method, value);
-            break;
+            kepler_memory->WriteRegs(method, values, amount, increasing);
+            return;
         default:
-            UNIMPLEMENTED_MSG("Unimplemented engine");
+            break;
+        }
+    }
+
+    for (u32 i = 0; i < amount; ++i) {
+        CallMethod(increasing ? method + i : method, subchannel, values[i], amount - i - 1);
+    }
+}
+
+void GPU::ProcessCommandLists(const std::vector<CommandListHeader>& commands) {
+    MICROPROFILE_SCOPE(ProcessCommandLists);
+
+    for (const auto& entry : commands) {
+        const std::size_t num_words = entry.sz;
+        const u32* const words = GetCommandListWords(entry.Address(), num_words);
+        if (words == nullptr) {
+            LOG_ERROR(HW_GPU, "Command list at 0x{:X} is not mapped", entry.Address());
+            continue;
         }
-    };
 
-    for (auto entry : commands) {
-        Tegra::GPUVAddr address = entry.Address();
-        u32 size = entry.sz;
-        const boost::optional<VAddr> head_address = memory_manager->GpuToCpuAddress(address);
-        VAddr current_addr = *head_address;
-        while (current_addr < *head_address + size * sizeof(CommandHeader)) {
-            const CommandHeader header = {Memory::Read32(current_addr)};
-            current_addr += sizeof(u32);
+        std::size_t index = 0;
+        while (index < num_words) {
+            const CommandHeader header = {words[index++]};
+
+            // Arguments past the end of the list are ignored, rather than read out of bounds.
+            const u32 arg_count =
+                static_cast<u32>(std::min<std::size_t>(header.arg_count, num_words - index));
+            const u32* const args = words + index;
 
             switch (header.mode.Value()) {
             case SubmissionMode::IncreasingOld:
-            case SubmissionMode::Increasing: {
+            case SubmissionMode::Increasing:
                 // Increase the method value with each argument.
-                for (unsigned i = 0; i < header.arg_count; ++i) {
-                    WriteReg(header.method + i, header.subchannel, Memory::Read32(current_addr),
-                             header.arg_count - i - 1);
-                    current_addr += sizeof(u32);
-                }
+                CallMultiMethod(header.method, header.subchannel, args, arg_count, true);
+                index += arg_count;
                 break;
-            }
             case SubmissionMode::NonIncreasingOld:
-            case SubmissionMode::NonIncreasing: {
+            case SubmissionMode::NonIncreasing:
                 // Use the same method value for all arguments.
-                for (unsigned i = 0; i < header.arg_count; ++i) {
-                    WriteReg(header.method, header.subchannel, Memory::Read32(current_addr),
-                             header.arg_count - i - 1);
-                    current_addr += sizeof(u32);
-                }
+                CallMultiMethod(header.method, header.subchannel, args, arg_count, false);
+                index += arg_count;
                 break;
-            }
             case SubmissionMode::IncreaseOnce: {
                 ASSERT(header.arg_count.Value() >= 1);
+                if (arg_count == 0) {
+                    break;
+                }
 
                 // Use the original method for the first argument and then the next method for all
                 // other arguments.
-                WriteReg(header.method, header.subchannel, Memory::Read32(current_addr),
-                         header.arg_count - 1);
-                current_addr += sizeof(u32);
-
-                for (unsigned i = 1; i < header.arg_count; ++i) {
-                    WriteReg(header.method + 1, header.subchannel, Memory::Read32(current_addr),
-                             header.arg_count - i - 1);
-                    current_addr += sizeof(u32);
-                }
+                CallMethod(header.method, header.subchannel, args[0], arg_count - 1);
+                CallMultiMethod(header.method + 1, header.subchannel, args + 1, arg_count - 1,
+                                false);
+                index += arg_count;
                 break;
             }
             case SubmissionMode::Inline: {
                 // The register value is stored in the bits 16-28 as an immediate
-                WriteReg(header.method, header.subchannel, header.inline_data, 0);
+                CallMethod(header.method, header.subchannel, header.inline_data, 0);
                 break;
             }
             default:
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include "common/logging/log.h"
 #include "core/memory.h"
 #include "video_core/engines/kepler_memory.h"
@@ -33,6 +34,18 @@ void KeplerMemory::WriteReg(u32 method, u32 value) {
     }
 }
 
+void KeplerMemory::WriteRegs(u32 method, const u32* values, u32 amount, bool increasing) {
+    if (amount != 0 && !increasing && method == KEPLERMEMORY_REG_INDEX(data)) {
+        regs.reg_array[method] = values[amount - 1];
+        ProcessMultiData(values, amount);
+        return;
+    }
+
+    for (u32 i = 0; i < amount; ++i) {
+        WriteReg(increasing ? method + i : method, values[i]);
+    }
+}
+
 void KeplerMemory::ProcessData(u32 data) {
     ASSERT_MSG(regs.exec.linear, "Non-linear uploads are not supported");
     ASSERT(regs.dest.x == 0 && regs.dest.y == 0 && regs.dest.z == 0);
@@ -46,9 +59,33 @@ void KeplerMemory::ProcessData(u32 data) {
     // a dirty surface that will have to be written back to memory.
     rasterizer.InvalidateRegion(dest_address, sizeof(u32));
 
-    Memory::Write32(dest_address, data);
+    Memory::WriteBlock(dest_address, &data, sizeof(data));
 
     state.write_offset++;
 }
 
+void KeplerMemory::ProcessMultiData(const u32* values, u32 amount) {
+    ASSERT_MSG(regs.exec.linear, "Non-linear uploads are not supported");
+    ASSERT(regs.dest.x == 0 && regs.dest.y == 0 && regs.dest.z == 0);
+
+    // The upload may cross GPU pages, which aren't necessarily contiguous in CPU memory.
+    const u8* data = reinterpret_cast<const u8*>(values);
+    const u32 size = amount * sizeof(u32);
+    GPUVAddr address = regs.dest.Address() + state.write_offset * sizeof(u32);
+    for (u32 offset = 0; offset < size;) {
+        const u32 copy_size = static_cast<u32>(std::min<u64>(
+            size - offset, MemoryManager::PAGE_SIZE - (address & MemoryManager::PAGE_MASK)));
+        const VAddr dest_address = *memory_manager.GpuToCpuAddress(address);
+
+        // Invalidate before writing for the same reason as in ProcessData.
+        rasterizer.InvalidateRegion(dest_address, copy_size);
+        Memory::WriteBlock(dest_address, data + offset, copy_size);
+
+        offset += copy_size;
+        address += copy_size;
+    }
+
+    state.write_offset += amount;
+}
+
 } // namespace Tegra::Engines
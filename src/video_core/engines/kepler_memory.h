@@ -28,6 +28,12 @@ public:
     /// Write the value to the register identified by method.
     void WriteReg(u32 method, u32 value);
 
+    /**
+     * Write all the arguments of a command header, starting at the register identified by method.
+     * The method is advanced after each value when `increasing` is set.
+     */
+    void WriteRegs(u32 method, const u32* values, u32 amount, bool increasing);
+
     struct Regs {
         static constexpr size_t NUM_REGS = 0x7F;
 
@@ -79,6 +85,9 @@ private:
     VideoCore::RasterizerInterface& rasterizer;
 
     void ProcessData(u32 data);
+
+    /// Handles consecutive writes to the data register, uploading all the values at once.
+    void ProcessMultiData(const u32* values, u32 amount);
 };
 
 #define ASSERT_REG_POSITION(field_name, position)                                                  \
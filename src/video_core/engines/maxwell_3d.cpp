@@ -2,13 +2,20 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
+#include <cstring>
 #include "common/assert.h"
+#include "common/cityhash.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/memory.h"
+#include "core/settings.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/engines/maxwell_3d.h"
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/macro_jit_x64.h"
+#endif
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/textures/texture.h"
@@ -21,6 +28,8 @@ constexpr u32 MacroRegistersStart = 0xE00;
 Maxwell3D::Maxwell3D(VideoCore::RasterizerInterface& rasterizer, MemoryManager& memory_manager)
     : memory_manager(memory_manager), rasterizer{rasterizer}, macro_interpreter(*this) {}
 
+Maxwell3D::~Maxwell3D() = default;
+
 void Maxwell3D::CallMacroMethod(u32 method, std::vector<u32> parameters) {
     // Reset the current macro.
     executing_macro = 0;
@@ -32,10 +41,111 @@ void Maxwell3D::CallMacroMethod(u32 method, std::vector<u32> parameters) {
         return;
     }
 
+    if (Settings::values.verify_macro_jit) {
+        VerifyMacroJIT(method, parameters);
+    }
+
+#ifdef ARCHITECTURE_x86_64
+    if (Settings::values.use_macro_jit) {
+        if (MacroJITx64* const program = GetCompiledMacro(method, macro_code->second)) {
+            program->Execute(parameters);
+            return;
+        }
+    }
+#endif
+
     // Execute the current macro.
     macro_interpreter.Execute(macro_code->second, std::move(parameters));
 }
 
+#ifdef ARCHITECTURE_x86_64
+MacroJITx64* Maxwell3D::GetCompiledMacro(u32 method, const std::vector<u32>& code) {
+    const auto compiled = compiled_macros.find(method);
+    if (compiled != compiled_macros.end()) {
+        return compiled->second;
+    }
+
+    // Games upload the same macros to several entries and again on every boot, only compile each
+    // distinct code once.
+    const u64 hash = Common::CityHash64(reinterpret_cast<const char*>(code.data()),
+                                        code.size() * sizeof(u32));
+    auto [cached, is_new] = macro_jit_cache.try_emplace(hash);
+    if (is_new) {
+        cached->second = MacroJITx64::Compile(*this, code);
+        if (!cached->second) {
+            LOG_WARNING(HW_GPU, "Macro {:04X} can't be compiled, it will be interpreted", method);
+        }
+    }
+
+    MacroJITx64* const program = cached->second.get();
+    compiled_macros.emplace(method, program);
+    return program;
+}
+#endif
+
+bool Maxwell3D::VerifyMacroJIT(u32 method, const std::vector<u32>& parameters) {
+#ifdef ARCHITECTURE_x86_64
+    const auto macro_code = uploaded_macros.find(method);
+    if (macro_code == uploaded_macros.end()) {
+        return true;
+    }
+    MacroJITx64* const program = GetCompiledMacro(method, macro_code->second);
+    if (program == nullptr) {
+        return true;
+    }
+
+    // Run both from the same register state. Recorded writes still update the register file, so
+    // that reads done by the macro see its own writes.
+    const auto saved_regs = std::make_unique<Regs>(regs);
+    std::vector<std::pair<u32, u32>> interpreter_writes;
+    recorded_macro_writes = &interpreter_writes;
+    macro_interpreter.Execute(macro_code->second, parameters);
+    const auto interpreter_regs = std::make_unique<Regs>(regs);
+
+    // Regs can't be assigned as a whole because of its BitFields, copy its bytes instead.
+    std::memcpy(&regs, saved_regs.get(), sizeof(Regs));
+    std::vector<std::pair<u32, u32>> jit_writes;
+    recorded_macro_writes = &jit_writes;
+    program->Execute(parameters);
+    recorded_macro_writes = nullptr;
+
+    const bool regs_match = std::memcmp(&regs, interpreter_regs.get(), sizeof(Regs)) == 0;
+    std::memcpy(&regs, saved_regs.get(), sizeof(Regs));
+    if (regs_match && jit_writes == interpreter_writes) {
+        return true;
+    }
+
+    const auto mismatch =
+        std::mismatch(interpreter_writes.begin(), interpreter_writes.end(), jit_writes.begin(),
+                      jit_writes.end());
+    const std::size_t index = mismatch.first - interpreter_writes.begin();
+    LOG_CRITICAL(HW_GPU,
+                 "Macro {:04X} differs between the JIT and the interpreter: {} and {} writes, "
+                 "first difference at write {}",
+                 method, interpreter_writes.size(), jit_writes.size(), index);
+    if (mismatch.first != interpreter_writes.end() && mismatch.second != jit_writes.end()) {
+        LOG_CRITICAL(HW_GPU, "Interpreter wrote {:08X} to {:03X}, JIT wrote {:08X} to {:03X}",
+                     mismatch.first->second, mismatch.first->first, mismatch.second->second,
+                     mismatch.second->first);
+    }
+    return false;
+#else
+    return true;
+#endif
+}
+
+void Maxwell3D::CallMethodFromMacro(u32 method, u32 value) {
+    if (recorded_macro_writes != nullptr) {
+        recorded_macro_writes->emplace_back(method, value);
+        if (method < Regs::NUM_REGS) {
+            regs.reg_array[method] = value;
+        }
+        return;
+    }
+
+    WriteReg(method, value, 0);
+}
+
 void Maxwell3D::WriteReg(u32 method, u32 value, u32 remaining_params) {
     auto debug_context = Core::System::GetInstance().GetGPUDebugContext();
 
@@ -139,10 +249,47 @@ void Maxwell3D::WriteReg(u32 method, u32 value, u32 remaining_params) {
     }
 }
 
+void Maxwell3D::WriteRegs(u32 method, const u32* values, u32 amount, bool increasing) {
+    if (amount == 0) {
+        return;
+    }
+
+    // The batched paths skip the per register debugger events.
+    const bool use_batch = Core::System::GetInstance().GetGPUDebugContext() == nullptr;
+    const u32 last_method = increasing ? method + amount - 1 : method;
+
+    if (use_batch && !increasing && executing_macro != 0 && method == executing_macro + 1) {
+        // All the remaining parameters of a macro call, it is executed right away.
+        macro_params.insert(macro_params.end(), values, values + amount);
+        CallMacroMethod(executing_macro, std::move(macro_params));
+        return;
+    }
+
+    constexpr u32 cb_data_first = MAXWELL3D_REG_INDEX(const_buffer.cb_data[0]);
+    constexpr u32 cb_data_last = MAXWELL3D_REG_INDEX(const_buffer.cb_data[15]);
+    if (use_batch && executing_macro == 0 && method >= cb_data_first &&
+        last_method <= cb_data_last) {
+        // Constant buffer uploads, every one of these registers appends to the buffer.
+        regs.reg_array[last_method] = values[amount - 1];
+        ProcessCBMultiData(values, amount);
+        return;
+    }
+
+    for (u32 i = 0; i < amount; ++i) {
+        WriteReg(increasing ? method + i : method, values[i], amount - i - 1);
+    }
+}
+
 void Maxwell3D::ProcessMacroUpload(u32 data) {
     // Store the uploaded macro code to interpret them when they're called.
-    auto& macro = uploaded_macros[regs.macros.entry * 2 + MacroRegistersStart];
+    const u32 method = regs.macros.entry * 2 + MacroRegistersStart;
+    auto& macro = uploaded_macros[method];
     macro.push_back(data);
+
+#ifdef ARCHITECTURE_x86_64
+    // The code changed, look it up in the JIT cache again on the next call.
+    compiled_macros.erase(method);
+#endif
 }
 
 void Maxwell3D::ProcessQueryGet() {
@@ -155,7 +302,8 @@ void Maxwell3D::ProcessQueryGet() {
     ASSERT_MSG(regs.query.query_get.unit == Regs::QueryUnit::Crop,
                "Units other than CROP are unimplemented");
 
-    u32 value = Memory::Read32(*address);
+    u32 value;
+    Memory::ReadBlock(*address, &value, sizeof(value));
     u64 result = 0;
 
     // TODO(Subv): Support the other query variables
@@ -185,7 +333,7 @@ void Maxwell3D::ProcessQueryGet() {
             // Write the current query sequence to the sequence address.
             // TODO(Subv): Find out what happens if you use a long query type but mark it as a short
             // query.
-            Memory::Write32(*address, sequence);
+            Memory::WriteBlock(*address, &sequence, sizeof(sequence));
         } else {
             // Write the 128-bit result structure in long mode. Note: We emulate an infinitely fast
             // GPU, this command may actually take a while to complete in real hardware due to GPU
@@ -271,12 +419,37 @@ void Maxwell3D::ProcessCBData(u32 value) {
     boost::optional<VAddr> address =
         memory_manager.GpuToCpuAddress(buffer_address + regs.const_buffer.cb_pos);
 
-    Memory::Write32(*address, value);
+    Memory::WriteBlock(*address, &value, sizeof(value));
 
     // Increment the current buffer position.
     regs.const_buffer.cb_pos = regs.const_buffer.cb_pos + 4;
 }
 
+void Maxwell3D::ProcessCBMultiData(const u32* values, u32 amount) {
+    const GPUVAddr buffer_address = regs.const_buffer.BufferAddress();
+    ASSERT(buffer_address != 0);
+
+    // Don't allow writing past the end of the buffer.
+    const u32 size = amount * sizeof(u32);
+    ASSERT(regs.const_buffer.cb_pos + size <= regs.const_buffer.cb_size);
+
+    // The upload may cross GPU pages, which aren't necessarily contiguous in CPU memory.
+    const u8* data = reinterpret_cast<const u8*>(values);
+    GPUVAddr dest_address = buffer_address + regs.const_buffer.cb_pos;
+    for (u32 offset = 0; offset < size;) {
+        const u32 copy_size = static_cast<u32>(std::min<u64>(
+            size - offset, MemoryManager::PAGE_SIZE - (dest_address & MemoryManager::PAGE_MASK)));
+        const boost::optional<VAddr> address = memory_manager.GpuToCpuAddress(dest_address);
+        Memory::WriteBlock(*address, data + offset, copy_size);
+
+        offset += copy_size;
+        dest_address += copy_size;
+    }
+
+    // Increment the current buffer position.
+    regs.const_buffer.cb_pos = regs.const_buffer.cb_pos + size;
+}
+
 Texture::TICEntry Maxwell3D::GetTICEntry(u32 tic_index) const {
     GPUVAddr tic_base_address = regs.tic.TICAddress();
 
@@ -327,8 +500,9 @@ std::vector<Texture::FullTextureInfo> Maxwell3D::GetStageTextures(Regs::ShaderSt
     for (GPUVAddr current_texture = tex_info_buffer.address + TextureInfoOffset;
          current_texture < tex_info_buffer_end; current_texture += sizeof(Texture::TextureHandle)) {
 
-        Texture::TextureHandle tex_handle{
-            Memory::Read32(*memory_manager.GpuToCpuAddress(current_texture))};
+        Texture::TextureHandle tex_handle;
+        Memory::ReadBlock(*memory_manager.GpuToCpuAddress(current_texture), &tex_handle,
+                          sizeof(tex_handle));
 
         Texture::FullTextureInfo tex_info{};
         // TODO(Subv): Use the shader to determine which textures are actually accessed.
@@ -370,7 +544,8 @@ Texture::FullTextureInfo Maxwell3D::GetStageTexture(Regs::ShaderStage stage,
     ASSERT(tex_info_address < tex_info_buffer.address + tex_info_buffer.size);
 
     boost::optional<VAddr> tex_address_cpu = memory_manager.GpuToCpuAddress(tex_info_address);
-    Texture::TextureHandle tex_handle{Memory::Read32(*tex_address_cpu)};
+    Texture::TextureHandle tex_handle;
+    Memory::ReadBlock(*tex_address_cpu, &tex_handle, sizeof(tex_handle));
 
     Texture::FullTextureInfo tex_info{};
     tex_info.index = static_cast<u32>(offset);
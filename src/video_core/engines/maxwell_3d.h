@@ -5,7 +5,9 @@
 #pragma once
 
 #include <array>
+#include <memory>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include "common/assert.h"
 #include "common/bit_field.h"
@@ -21,6 +23,10 @@ namespace VideoCore {
 class RasterizerInterface;
 }
 
+namespace Tegra {
+class MacroJITx64;
+}
+
 namespace Tegra::Engines {
 
 #define MAXWELL3D_REG_INDEX(field_name)                                                            \
@@ -29,7 +35,7 @@ namespace Tegra::Engines {
 class Maxwell3D final {
 public:
     explicit Maxwell3D(VideoCore::RasterizerInterface& rasterizer, MemoryManager& memory_manager);
-    ~Maxwell3D() = default;
+    ~Maxwell3D();
 
     /// Register structure of the Maxwell3D engine.
     /// TODO(Subv): This structure will need to be made bigger as more registers are discovered.
@@ -977,6 +983,25 @@ public:
     /// Write the value to the register identified by method.
     void WriteReg(u32 method, u32 value, u32 remaining_params);
 
+    /**
+     * Write all the arguments of a command header, starting at the register identified by method.
+     * The method is advanced after each value when `increasing` is set.
+     */
+    void WriteRegs(u32 method, const u32* values, u32 amount, bool increasing);
+
+    /// Write the value to the register identified by method, on behalf of a running macro.
+    void CallMethodFromMacro(u32 method, u32 value);
+
+    /**
+     * Runs an uploaded macro with both the JIT and the interpreter, recording the register writes
+     * of each instead of executing them. The engine state is left untouched.
+     * @param method Macro method to verify
+     * @param parameters Arguments to the macro call
+     * @returns False if the JIT and the interpreter disagree, true otherwise. Also true when the
+     * macro can't be compiled, as it is always interpreted then.
+     */
+    bool VerifyMacroJIT(u32 method, const std::vector<u32>& parameters);
+
     /// Returns a list of enabled textures for the specified shader stage.
     std::vector<Texture::FullTextureInfo> GetStageTextures(Regs::ShaderStage stage) const;
 
@@ -996,6 +1021,16 @@ private:
     /// Interpreter for the macro codes uploaded to the GPU.
     MacroInterpreter macro_interpreter;
 
+#ifdef ARCHITECTURE_x86_64
+    /// Compiled macros indexed by the hash of their code, null when the code can't be compiled.
+    std::unordered_map<u64, std::unique_ptr<MacroJITx64>> macro_jit_cache;
+    /// Compiled macro of each macro method, until new code is uploaded to it.
+    std::unordered_map<u32, MacroJITx64*> compiled_macros;
+#endif
+
+    /// Writes of the macro being verified, they are recorded instead of executed when set.
+    std::vector<std::pair<u32, u32>>* recorded_macro_writes = nullptr;
+
     /// Retrieves information about a specific TIC entry from the TIC buffer.
     Texture::TICEntry GetTICEntry(u32 tic_index) const;
 
@@ -1009,6 +1044,11 @@ private:
      */
     void CallMacroMethod(u32 method, std::vector<u32> parameters);
 
+#ifdef ARCHITECTURE_x86_64
+    /// Returns the compiled code of a macro, compiling it on first use. Null if it can't be.
+    MacroJITx64* GetCompiledMacro(u32 method, const std::vector<u32>& code);
+#endif
+
     /// Handles writes to the macro uploading registers.
     void ProcessMacroUpload(u32 data);
 
@@ -1021,6 +1061,9 @@ private:
     /// Handles a write to the CB_DATA[i] register.
     void ProcessCBData(u32 value);
 
+    /// Handles consecutive writes to the CB_DATA[i] registers, uploading all the values at once.
+    void ProcessCBMultiData(const u32* values, u32 amount);
+
     /// Handles a write to the CB_BIND register.
     void ProcessCBBind(Regs::ShaderStage stage);
 
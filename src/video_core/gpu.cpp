@@ -9,7 +9,8 @@
 #include "video_core/engines/maxwell_compute.h"
 #include "video_core/engines/maxwell_dma.h"
 #include "video_core/gpu.h"
-#include "video_core/rasterizer_interface.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/renderer_base.h"
 
 namespace Tegra {
 
@@ -22,17 +23,76 @@ u32 FramebufferConfig::BytesPerPixel(PixelFormat format) {
     UNREACHABLE();
 }
 
-GPU::GPU(VideoCore::RasterizerInterface& rasterizer) {
+GPU::GPU(VideoCore::RendererBase& renderer, bool is_async) : renderer{renderer} {
+    auto& rasterizer = renderer.Rasterizer();
     memory_manager = std::make_unique<Tegra::MemoryManager>();
     maxwell_3d = std::make_unique<Engines::Maxwell3D>(rasterizer, *memory_manager);
     fermi_2d = std::make_unique<Engines::Fermi2D>(rasterizer, *memory_manager);
     maxwell_compute = std::make_unique<Engines::MaxwellCompute>();
     maxwell_dma = std::make_unique<Engines::MaxwellDMA>(rasterizer, *memory_manager);
     kepler_memory = std::make_unique<Engines::KeplerMemory>(rasterizer, *memory_manager);
+
+    if (is_async) {
+        gpu_thread = std::make_unique<GPUThread::ThreadManager>(renderer, *this);
+    }
 }
 
 GPU::~GPU() = default;
 
+void GPU::PushGPUEntries(std::vector<CommandListHeader>&& entries) {
+    if (gpu_thread) {
+        gpu_thread->SubmitList(std::move(entries));
+    } else {
+        ProcessCommandLists(entries);
+    }
+}
+
+void GPU::SwapBuffers(boost::optional<const FramebufferConfig&> framebuffer) {
+    if (gpu_thread) {
+        gpu_thread->SwapBuffers(framebuffer);
+    } else {
+        renderer.SwapBuffers(framebuffer);
+    }
+}
+
+void GPU::FlushRegion(VAddr addr, u64 size) {
+    if (gpu_thread) {
+        gpu_thread->FlushRegion(addr, size);
+    } else {
+        renderer.Rasterizer().FlushRegion(addr, size);
+    }
+}
+
+void GPU::OnCPUWrite(VAddr addr, u64 size) {
+    if (gpu_thread) {
+        gpu_thread->OnCPUWrite(addr, size);
+    } else {
+        renderer.Rasterizer().OnCPUWrite(addr, size);
+    }
+}
+
+void GPU::FlushAndInvalidateRegion(VAddr addr, u64 size) {
+    if (gpu_thread) {
+        gpu_thread->FlushAndInvalidateRegion(addr, size);
+    } else {
+        renderer.Rasterizer().FlushAndInvalidateRegion(addr, size);
+    }
+}
+
+void GPU::LoadDiskResources(u64 title_id, const VideoCore::DiskResourceLoadCallback& callback) {
+    if (gpu_thread) {
+        gpu_thread->LoadDiskResources(title_id, callback);
+    } else {
+        renderer.Rasterizer().LoadDiskResources(title_id, callback);
+    }
+}
+
+void GPU::WaitIdle() {
+    if (gpu_thread) {
+        gpu_thread->WaitIdle();
+    }
+}
+
 Engines::Maxwell3D& GPU::Maxwell3D() {
     return *maxwell_3d;
 }
@@ -5,15 +5,27 @@
 #pragma once
 
 #include <array>
+#include <functional>
 #include <memory>
 #include <vector>
+#include <boost/optional.hpp>
 #include "common/common_types.h"
 #include "core/hle/service/nvflinger/buffer_queue.h"
 #include "video_core/memory_manager.h"
 
 namespace VideoCore {
 class RasterizerInterface;
-}
+class RendererBase;
+
+enum class LoadCallbackStage {
+    Prepare,
+    Build,
+    Complete,
+};
+
+/// Reports the progress of a stage of loading the disk resources, as (stage, value, total)
+using DiskResourceLoadCallback = std::function<void(LoadCallbackStage, std::size_t, std::size_t)>;
+} // namespace VideoCore
 
 namespace Tegra {
 
@@ -114,14 +126,53 @@ enum class EngineID {
     MAXWELL_DMA_COPY_A = 0xB0B5,
 };
 
+namespace GPUThread {
+class ThreadManager;
+} // namespace GPUThread
+
 class GPU final {
 public:
-    explicit GPU(VideoCore::RasterizerInterface& rasterizer);
+    /**
+     * Creates the GPU and its engines.
+     * @param renderer Renderer the engines draw with and which presents the framebuffers.
+     * @param is_async Whether commands are processed on a dedicated GPU thread, in which case that
+     *                 thread owns the engines and the rasterizer for the lifetime of the GPU.
+     */
+    explicit GPU(VideoCore::RendererBase& renderer, bool is_async);
     ~GPU();
 
-    /// Processes a command list stored at the specified address in GPU memory.
+    /// Processes a command list stored at the specified address in GPU memory, on the calling
+    /// thread. Everything but the GPU thread should go through PushGPUEntries instead.
     void ProcessCommandLists(const std::vector<CommandListHeader>& commands);
 
+    /// Pushes a command list to be processed, possibly asynchronously.
+    void PushGPUEntries(std::vector<CommandListHeader>&& entries);
+
+    /// Presents the given framebuffer, or the previous one if there is none, once all the
+    /// previously pushed command lists have been processed.
+    void SwapBuffers(boost::optional<const FramebufferConfig&> framebuffer);
+
+    /// Flushes the rasterizer caches of the given region back to guest memory.
+    void FlushRegion(VAddr addr, u64 size);
+
+    /// Notifies the rasterizer that the CPU has written to the given region.
+    void OnCPUWrite(VAddr addr, u64 size);
+
+    /// Flushes the rasterizer caches of the given region back to guest memory and invalidates them.
+    void FlushAndInvalidateRegion(VAddr addr, u64 size);
+
+    /// Loads the resources the given title cached on disk in previous runs, such as its shaders.
+    /// This blocks until they're loaded, the callback is called from the thread loading them.
+    void LoadDiskResources(u64 title_id, const VideoCore::DiskResourceLoadCallback& callback = {});
+
+    /// Blocks until all the previously pushed command lists have been processed.
+    void WaitIdle();
+
+    /// Returns true if commands are processed on a dedicated GPU thread.
+    bool IsAsync() const {
+        return gpu_thread != nullptr;
+    }
+
     /// Returns a reference to the Maxwell3D GPU engine.
     Engines::Maxwell3D& Maxwell3D();
 
@@ -135,11 +186,33 @@ public:
     const Tegra::MemoryManager& MemoryManager() const;
 
 private:
+    /**
+     * Gets the words of a command list from guest memory. This is a pointer to guest memory when
+     * the list is contiguous in host memory, and a copy in `command_list_copy` otherwise.
+     * @returns The pointer to the words of the list, or nullptr if the list is not mapped.
+     */
+    const u32* GetCommandListWords(GPUVAddr address, std::size_t num_words);
+
+    /// Writes a value to the register identified by method of the engine bound to subchannel.
+    void CallMethod(u32 method, u32 subchannel, u32 value, u32 remaining_params);
+
+    /**
+     * Writes all the arguments of a command header to the engine bound to subchannel. The method
+     * is advanced after each value when `increasing` is set, the last value is the last parameter.
+     */
+    void CallMultiMethod(u32 method, u32 subchannel, const u32* values, u32 amount,
+                         bool increasing);
+
+    VideoCore::RendererBase& renderer;
+
     std::unique_ptr<Tegra::MemoryManager> memory_manager;
 
     /// Mapping of command subchannels to their bound engine ids.
     std::array<EngineID, 8> bound_engines = {};
 
+    /// Copy of the command list being processed, when it can't be read from guest memory in place.
+    std::vector<u32> command_list_copy;
+
     /// 3D engine
     std::unique_ptr<Engines::Maxwell3D> maxwell_3d;
     /// 2D engine
@@ -150,6 +223,10 @@ private:
     std::unique_ptr<Engines::MaxwellDMA> maxwell_dma;
     /// Inline memory engine
     std::unique_ptr<Engines::KeplerMemory> kepler_memory;
+
+    /// Thread processing the commands when asynchronous, destroyed first so it stops before the
+    /// engines it uses go away.
+    std::unique_ptr<GPUThread::ThreadManager> gpu_thread;
 };
 
 } // namespace Tegra
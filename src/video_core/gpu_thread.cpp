@@ -0,0 +1,180 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <limits>
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/gpu.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/renderer_base.h"
+
+namespace Tegra::GPUThread {
+
+/// Executes a single command on the GPU thread
+static void ExecuteCommand(CommandData* command, VideoCore::RendererBase& renderer, GPU& gpu) {
+    if (const auto submit_list = std::get_if<SubmitListCommand>(command)) {
+        gpu.ProcessCommandLists(submit_list->entries);
+    } else if (const auto data = std::get_if<SwapBuffersCommand>(command)) {
+        if (data->framebuffer) {
+            renderer.SwapBuffers(*data->framebuffer);
+        } else {
+            renderer.SwapBuffers({});
+        }
+    } else if (const auto data = std::get_if<FlushRegionCommand>(command)) {
+        renderer.Rasterizer().FlushRegion(data->addr, data->size);
+    } else if (const auto data = std::get_if<CPUWriteCommand>(command)) {
+        renderer.Rasterizer().OnCPUWrite(data->addr, data->size);
+    } else if (const auto data = std::get_if<FlushAndInvalidateRegionCommand>(command)) {
+        renderer.Rasterizer().FlushAndInvalidateRegion(data->addr, data->size);
+    } else if (const auto data = std::get_if<LoadDiskResourcesCommand>(command)) {
+        renderer.Rasterizer().LoadDiskResources(data->title_id, data->callback);
+    } else {
+        UNREACHABLE();
+    }
+}
+
+/// Runs the GPU thread
+static void RunThread(VideoCore::RendererBase& renderer, GPU& gpu, SynchState& state) {
+    MicroProfileOnThreadCreate("GpuThread");
+
+    // The GPU thread owns the render context for the whole emulation session
+    auto& window = renderer.GetRenderWindow();
+    window.MakeCurrent();
+
+    CommandDataContainer next;
+    while (state.is_running) {
+        state.WaitForCommands();
+        while (state.queue.Pop(next)) {
+            ExecuteCommand(&next.data, renderer, gpu);
+            state.SignalFence(next.fence);
+        }
+    }
+
+    // Commands still in the queue are discarded, release anyone waiting on them
+    state.SignalFence(std::numeric_limits<u64>::max());
+
+    window.DoneCurrent();
+
+#if MICROPROFILE_ENABLED
+    MicroProfileOnThreadExit();
+#endif
+}
+
+void SynchState::WaitForCommands() {
+    std::unique_lock<std::mutex> lock(commands_mutex);
+    commands_condition.wait(lock, [this] { return !queue.Empty() || !is_running; });
+}
+
+void SynchState::SignalCommands() {
+    {
+        // Taking the lock orders the notification after a concurrent predicate check
+        std::lock_guard<std::mutex> lock(commands_mutex);
+    }
+    commands_condition.notify_one();
+}
+
+void SynchState::SignalFence(u64 fence) {
+    signaled_fence = fence;
+    {
+        std::lock_guard<std::mutex> lock(fence_mutex);
+    }
+    fence_condition.notify_all();
+}
+
+void SynchState::WaitForFence(u64 fence) {
+    if (signaled_fence >= fence) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(fence_mutex);
+    fence_condition.wait(lock, [this, fence] { return signaled_fence >= fence; });
+}
+
+ThreadManager::ThreadManager(VideoCore::RendererBase& renderer, GPU& gpu)
+    : renderer{renderer}, gpu{gpu}, thread{RunThread, std::ref(renderer), std::ref(gpu),
+                                           std::ref(state)},
+      thread_id{thread.get_id()} {}
+
+ThreadManager::~ThreadManager() {
+    // Notify GPU thread that a shutdown is pending
+    state.is_running = false;
+    state.SignalCommands();
+    thread.join();
+}
+
+void ThreadManager::SubmitList(std::vector<CommandListHeader>&& entries) {
+    PushCommand(SubmitListCommand(std::move(entries)));
+}
+
+void ThreadManager::SwapBuffers(boost::optional<const FramebufferConfig&> framebuffer) {
+    // Only let the CPU run one frame ahead of the GPU thread. Otherwise the queue would grow
+    // without bound when the GPU is the bottleneck, along with the input latency.
+    state.WaitForFence(last_swap_fence);
+
+    boost::optional<FramebufferConfig> framebuffer_copy;
+    if (framebuffer) {
+        framebuffer_copy = *framebuffer;
+    }
+    last_swap_fence = PushCommand(SwapBuffersCommand(std::move(framebuffer_copy)));
+}
+
+void ThreadManager::FlushRegion(VAddr addr, u64 size) {
+    if (IsGPUThread()) {
+        renderer.Rasterizer().FlushRegion(addr, size);
+        return;
+    }
+    state.WaitForFence(PushCommand(FlushRegionCommand(addr, size)));
+}
+
+void ThreadManager::OnCPUWrite(VAddr addr, u64 size) {
+    if (IsGPUThread()) {
+        renderer.Rasterizer().OnCPUWrite(addr, size);
+        return;
+    }
+    PushCommand(CPUWriteCommand(addr, size));
+}
+
+void ThreadManager::FlushAndInvalidateRegion(VAddr addr, u64 size) {
+    if (IsGPUThread()) {
+        renderer.Rasterizer().FlushAndInvalidateRegion(addr, size);
+        return;
+    }
+    state.WaitForFence(PushCommand(FlushAndInvalidateRegionCommand(addr, size)));
+}
+
+void ThreadManager::LoadDiskResources(u64 title_id,
+                                      const VideoCore::DiskResourceLoadCallback& callback) {
+    if (IsGPUThread()) {
+        renderer.Rasterizer().LoadDiskResources(title_id, callback);
+        return;
+    }
+    state.WaitForFence(PushCommand(LoadDiskResourcesCommand(title_id, callback)));
+}
+
+void ThreadManager::WaitIdle() {
+    u64 fence;
+    {
+        std::lock_guard<std::mutex> lock(state.push_mutex);
+        fence = state.last_fence;
+    }
+    state.WaitForFence(fence);
+}
+
+u64 ThreadManager::PushCommand(CommandData&& command_data) {
+    u64 fence;
+    {
+        std::lock_guard<std::mutex> lock(state.push_mutex);
+        fence = ++state.last_fence;
+        state.queue.Push(CommandDataContainer(std::move(command_data), fence));
+    }
+    state.SignalCommands();
+    return fence;
+}
+
+bool ThreadManager::IsGPUThread() const {
+    return std::this_thread::get_id() == thread_id;
+}
+
+} // namespace Tegra::GPUThread
@@ -0,0 +1,174 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <variant>
+#include <vector>
+#include <boost/optional.hpp>
+#include "common/common_types.h"
+#include "common/threadsafe_queue.h"
+#include "video_core/command_processor.h"
+#include "video_core/gpu.h"
+
+namespace VideoCore {
+class RendererBase;
+} // namespace VideoCore
+
+namespace Tegra::GPUThread {
+
+/// Command to signal to the GPU thread that a command list is ready for processing
+struct SubmitListCommand final {
+    explicit SubmitListCommand(std::vector<CommandListHeader>&& entries)
+        : entries{std::move(entries)} {}
+
+    std::vector<CommandListHeader> entries;
+};
+
+/// Command to signal to the GPU thread that a swap buffers is pending
+struct SwapBuffersCommand final {
+    explicit SwapBuffersCommand(boost::optional<FramebufferConfig> framebuffer)
+        : framebuffer{std::move(framebuffer)} {}
+
+    boost::optional<FramebufferConfig> framebuffer;
+};
+
+/// Command to signal to the GPU thread to flush a region
+struct FlushRegionCommand final {
+    explicit constexpr FlushRegionCommand(VAddr addr, u64 size) : addr{addr}, size{size} {}
+
+    VAddr addr;
+    u64 size;
+};
+
+/// Command to signal to the GPU thread that the CPU has written to a region
+struct CPUWriteCommand final {
+    explicit constexpr CPUWriteCommand(VAddr addr, u64 size) : addr{addr}, size{size} {}
+
+    VAddr addr;
+    u64 size;
+};
+
+/// Command to signal to the GPU thread to flush and invalidate a region
+struct FlushAndInvalidateRegionCommand final {
+    explicit constexpr FlushAndInvalidateRegionCommand(VAddr addr, u64 size)
+        : addr{addr}, size{size} {}
+
+    VAddr addr;
+    u64 size;
+};
+
+/// Command to signal to the GPU thread to load the disk resources of a title
+struct LoadDiskResourcesCommand final {
+    LoadDiskResourcesCommand(u64 title_id, VideoCore::DiskResourceLoadCallback callback)
+        : title_id{title_id}, callback{std::move(callback)} {}
+
+    u64 title_id;
+    VideoCore::DiskResourceLoadCallback callback;
+};
+
+using CommandData = std::variant<std::monostate, SubmitListCommand, SwapBuffersCommand,
+                                 FlushRegionCommand, CPUWriteCommand,
+                                 FlushAndInvalidateRegionCommand, LoadDiskResourcesCommand>;
+
+/// Container for a command along with the fence signaled once it has been processed
+struct CommandDataContainer {
+    CommandDataContainer() = default;
+
+    CommandDataContainer(CommandData&& data, u64 next_fence)
+        : data{std::move(data)}, fence{next_fence} {}
+
+    CommandData data;
+    u64 fence{};
+};
+
+/// Struct used to synchronize the GPU thread
+struct SynchState final {
+    std::atomic_bool is_running{true};
+
+    /// Wakes up the GPU thread when commands are pushed or it is asked to stop
+    std::mutex commands_mutex;
+    std::condition_variable commands_condition;
+
+    /// Wakes up threads waiting for a fence to be signaled
+    std::mutex fence_mutex;
+    std::condition_variable fence_condition;
+
+    /// Fence of the last command pushed to the queue, only modified while holding push_mutex
+    u64 last_fence{};
+    /// Fence of the last command the GPU thread has finished processing
+    std::atomic<u64> signaled_fence{};
+
+    /// Serializes the producers, the queue itself only supports a single writer
+    std::mutex push_mutex;
+    Common::SPSCQueue<CommandDataContainer, false> queue;
+
+    /// Blocks the GPU thread until there are commands to process or it has to stop
+    void WaitForCommands();
+
+    /// Wakes up the GPU thread
+    void SignalCommands();
+
+    /// Marks every command up to and including the given fence as processed
+    void SignalFence(u64 fence);
+
+    /// Blocks the calling thread until the given fence has been signaled
+    void WaitForFence(u64 fence);
+};
+
+/**
+ * Runs the GPU engines and the rasterizer on a dedicated host thread. Command lists, swaps and
+ * cache maintenance requests are pushed to a queue from the emulated CPU threads and executed in
+ * order by the GPU thread. Operations whose results the CPU depends on (flushes) wait for the
+ * fence of their command, everything else returns as soon as it is queued.
+ */
+class ThreadManager final {
+public:
+    explicit ThreadManager(VideoCore::RendererBase& renderer, GPU& gpu);
+    ~ThreadManager();
+
+    /// Pushes a command list to be processed by the GPU thread
+    void SubmitList(std::vector<CommandListHeader>&& entries);
+
+    /// Swaps the buffers once all the commands pushed so far have been processed
+    void SwapBuffers(boost::optional<const FramebufferConfig&> framebuffer);
+
+    /// Flushes the rasterizer caches of a region, returning once the flush is complete
+    void FlushRegion(VAddr addr, u64 size);
+
+    /// Notifies the rasterizer of a CPU write to a region
+    void OnCPUWrite(VAddr addr, u64 size);
+
+    /// Flushes and invalidates the rasterizer caches of a region, returning once it is complete
+    void FlushAndInvalidateRegion(VAddr addr, u64 size);
+
+    /// Loads the disk resources of a title on the GPU thread, returning once they're loaded
+    void LoadDiskResources(u64 title_id, const VideoCore::DiskResourceLoadCallback& callback);
+
+    /// Blocks until the GPU thread has processed every command pushed so far
+    void WaitIdle();
+
+private:
+    /// Pushes a command to the queue, returning the fence signaled once it has been processed
+    u64 PushCommand(CommandData&& command_data);
+
+    /// Returns true if the caller is the GPU thread itself
+    bool IsGPUThread() const;
+
+    VideoCore::RendererBase& renderer;
+    GPU& gpu;
+
+    SynchState state;
+    /// Fence of the last swap, the CPU may only run one frame ahead of the GPU thread
+    std::atomic<u64> last_swap_fence{};
+
+    std::thread thread;
+    std::thread::id thread_id;
+};
+
+} // namespace Tegra::GPUThread
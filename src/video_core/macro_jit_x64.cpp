@@ -0,0 +1,372 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstddef>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/x64/xbyak_abi.h"
+#include "common/x64/xbyak_util.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/macro_jit_x64.h"
+
+namespace Tegra {
+
+using namespace Common::X64;
+using namespace Xbyak::util;
+using Macro::ALUOperation;
+using Macro::BranchCondition;
+using Macro::Opcode;
+using Macro::Operation;
+using Macro::ResultOperation;
+
+// Registers holding the execution state, all callee saved so they survive calls to the engine.
+// eax, ecx and edx are used as temporaries.
+static const Xbyak::Reg64 STATE = r15;
+static const Xbyak::Reg64 PARAMETERS = r14;
+static const Xbyak::Reg64 PARAMETER_INDEX = r13;
+static const Xbyak::Reg32 NUM_PARAMETERS = ebp;
+static const Xbyak::Reg32 RESULT = ebx;
+
+static const BitSet32 PERSISTENT_REGISTERS = BuildRegSet({STATE, PARAMETERS, PARAMETER_INDEX,
+                                                          NUM_PARAMETERS.cvt64(), RESULT.cvt64()});
+
+/// Host code bytes reserved per macro instruction, delay slots are emitted more than once
+constexpr std::size_t CODE_SIZE_PER_INSTRUCTION = 256;
+constexpr std::size_t BASE_CODE_SIZE = 4096;
+
+std::unique_ptr<MacroJITx64> MacroJITx64::Compile(Engines::Maxwell3D& maxwell3d,
+                                                  const std::vector<u32>& code) {
+    if (code.empty()) {
+        return nullptr;
+    }
+
+    const std::size_t max_size = BASE_CODE_SIZE + code.size() * CODE_SIZE_PER_INSTRUCTION;
+    try {
+        std::unique_ptr<MacroJITx64> jit{new MacroJITx64(maxwell3d, code, max_size)};
+        if (!jit->CompileProgram()) {
+            return nullptr;
+        }
+        jit->program = jit->getCode<ProgramType>();
+        return jit;
+    } catch (const Xbyak::Error& error) {
+        LOG_ERROR(HW_GPU, "Failed to compile macro: {}", error.what());
+        return nullptr;
+    }
+}
+
+void MacroJITx64::Execute(const std::vector<u32>& parameters) {
+    ASSERT(!parameters.empty());
+
+    state.registers = {};
+    // $r1 starts with the value of the first parameter, the code fetches the following ones.
+    state.registers[1] = parameters[0];
+    state.method_address = 0;
+    program(&state, parameters.data(), static_cast<u32>(parameters.size()));
+}
+
+MacroJITx64::MacroJITx64(Engines::Maxwell3D& maxwell3d, const std::vector<u32>& code,
+                         std::size_t max_size)
+    : Xbyak::CodeGenerator(max_size), code{code}, labels(code.size()) {
+    state.maxwell3d = &maxwell3d;
+}
+
+bool MacroJITx64::CompileProgram() {
+    ABI_PushRegistersAndAdjustStack(*this, PERSISTENT_REGISTERS, 8);
+    mov(STATE, ABI_PARAM1);
+    mov(PARAMETERS, ABI_PARAM2);
+    mov(NUM_PARAMETERS, ABI_PARAM3.cvt32());
+    mov(PARAMETER_INDEX.cvt32(), 1);
+
+    for (std::size_t index = 0; index < code.size(); ++index) {
+        L(labels[index]);
+        if (!CompileInstruction(index)) {
+            return false;
+        }
+    }
+
+    // Running past the end of the code, the interpreter asserts here.
+    L(end_label);
+    ABI_PopRegistersAndAdjustStack(*this, PERSISTENT_REGISTERS, 8);
+    ret();
+    return true;
+}
+
+bool MacroJITx64::CompileInstruction(std::size_t index) {
+    const Opcode opcode{code[index]};
+    if (opcode.operation == Operation::Branch) {
+        if (!CompileBranch(index, opcode)) {
+            return false;
+        }
+    } else if (!CompileOperation(opcode)) {
+        return false;
+    }
+
+    if (opcode.is_exit) {
+        // Exit has a delay slot, execute the next instruction before leaving.
+        if (!CompileExitDelaySlot(index + 1)) {
+            return false;
+        }
+        jmp(end_label, T_NEAR);
+    }
+    return true;
+}
+
+bool MacroJITx64::CompileBranch(std::size_t index, Opcode opcode) {
+    const s64 target = static_cast<s64>(index) + opcode.immediate;
+    if (target < 0 || target >= static_cast<s64>(code.size())) {
+        LOG_ERROR(HW_GPU, "Macro branch at {} targets {}, out of bounds", index, target);
+        return false;
+    }
+    const auto target_index = static_cast<std::size_t>(target);
+
+    Xbyak::Label not_taken;
+    if (opcode.src_a == 0) {
+        // $r0 always reads as zero, the condition is known at compile time.
+        if (opcode.branch_condition != BranchCondition::Zero) {
+            return true;
+        }
+    } else {
+        LoadRegister(eax, opcode.src_a);
+        test(eax, eax);
+        if (opcode.branch_condition == BranchCondition::Zero) {
+            jnz(not_taken, T_NEAR);
+        } else {
+            jz(not_taken, T_NEAR);
+        }
+    }
+
+    if (opcode.branch_annul) {
+        // Branches with the annul bit don't execute their delay slot.
+        jmp(labels[target_index], T_NEAR);
+    } else {
+        const std::size_t slot_index = index + 1;
+        if (slot_index >= code.size()) {
+            return false;
+        }
+        const Opcode slot{code[slot_index]};
+        if (slot.operation == Operation::Branch) {
+            LOG_ERROR(HW_GPU, "Macro branch at {} has a branch in its delay slot", index);
+            return false;
+        }
+        if (!CompileOperation(slot)) {
+            return false;
+        }
+        if (slot.is_exit) {
+            // An exit in the delay slot executes the instruction at the branch target before
+            // leaving.
+            if (!CompileExitDelaySlot(target_index)) {
+                return false;
+            }
+            jmp(end_label, T_NEAR);
+        } else {
+            jmp(labels[target_index], T_NEAR);
+        }
+    }
+
+    L(not_taken);
+    return true;
+}
+
+bool MacroJITx64::CompileExitDelaySlot(std::size_t index) {
+    if (index >= code.size()) {
+        return false;
+    }
+    const Opcode opcode{code[index]};
+    if (opcode.operation == Operation::Branch) {
+        LOG_ERROR(HW_GPU, "Macro has a branch in the delay slot of an exit at {}", index);
+        return false;
+    }
+    if (!CompileOperation(opcode)) {
+        return false;
+    }
+    if (opcode.is_exit) {
+        return CompileExitDelaySlot(index + 1);
+    }
+    return true;
+}
+
+bool MacroJITx64::CompileOperation(Opcode opcode) {
+    switch (opcode.operation) {
+    case Operation::ALU: {
+        LoadRegister(eax, opcode.src_a);
+        LoadRegister(ecx, opcode.src_b);
+        switch (opcode.alu_operation) {
+        case ALUOperation::Add:
+            add(eax, ecx);
+            break;
+        case ALUOperation::Subtract:
+            sub(eax, ecx);
+            break;
+        case ALUOperation::Xor:
+            xor_(eax, ecx);
+            break;
+        case ALUOperation::Or:
+            or_(eax, ecx);
+            break;
+        case ALUOperation::And:
+            and_(eax, ecx);
+            break;
+        case ALUOperation::AndNot:
+            not_(ecx);
+            and_(eax, ecx);
+            break;
+        case ALUOperation::Nand:
+            and_(eax, ecx);
+            not_(eax);
+            break;
+        default:
+            // Let the interpreter report the operations it doesn't implement either.
+            LOG_WARNING(HW_GPU, "Unsupported macro ALU operation {}",
+                        static_cast<u32>(opcode.alu_operation.Value()));
+            return false;
+        }
+        break;
+    }
+    case Operation::AddImmediate: {
+        LoadRegister(eax, opcode.src_a);
+        add(eax, opcode.immediate);
+        break;
+    }
+    case Operation::ExtractInsert: {
+        const u32 mask = opcode.GetBitfieldMask();
+        LoadRegister(ecx, opcode.src_b);
+        shr(ecx, opcode.bf_src_bit);
+        and_(ecx, mask);
+        shl(ecx, opcode.bf_dst_bit);
+        LoadRegister(eax, opcode.src_a);
+        and_(eax, ~(mask << opcode.bf_dst_bit));
+        or_(eax, ecx);
+        break;
+    }
+    case Operation::ExtractShiftLeftImmediate: {
+        // The shift amount comes from a register, x64 masks it to 5 bits like the interpreter
+        // does when running on x64.
+        LoadRegister(ecx, opcode.src_a);
+        LoadRegister(eax, opcode.src_b);
+        shr(eax, cl);
+        and_(eax, opcode.GetBitfieldMask());
+        shl(eax, opcode.bf_dst_bit);
+        break;
+    }
+    case Operation::ExtractShiftLeftRegister: {
+        LoadRegister(ecx, opcode.src_a);
+        LoadRegister(eax, opcode.src_b);
+        shr(eax, opcode.bf_src_bit);
+        and_(eax, opcode.GetBitfieldMask());
+        shl(eax, cl);
+        break;
+    }
+    case Operation::Read: {
+        LoadRegister(eax, opcode.src_a);
+        add(eax, opcode.immediate);
+        mov(ABI_PARAM2.cvt32(), eax);
+        mov(ABI_PARAM1, STATE);
+        CallFarFunction(*this, &MacroJITx64::ReadHelper);
+        break;
+    }
+    default:
+        LOG_WARNING(HW_GPU, "Unsupported macro operation {}",
+                    static_cast<u32>(opcode.operation.Value()));
+        return false;
+    }
+
+    CompileProcessResult(opcode.result_operation, opcode.dst);
+    return true;
+}
+
+void MacroJITx64::CompileProcessResult(ResultOperation operation, u32 reg) {
+    // Keep the result where calls to the engine don't clobber it.
+    mov(RESULT, eax);
+
+    switch (operation) {
+    case ResultOperation::IgnoreAndFetch:
+        FetchParameter();
+        StoreRegister(reg, eax);
+        break;
+    case ResultOperation::Move:
+        StoreRegister(reg, RESULT);
+        break;
+    case ResultOperation::MoveAndSetMethod:
+        StoreRegister(reg, RESULT);
+        mov(dword[STATE + offsetof(JITState, method_address)], RESULT);
+        break;
+    case ResultOperation::FetchAndSend:
+        FetchParameter();
+        StoreRegister(reg, eax);
+        Send(RESULT);
+        break;
+    case ResultOperation::MoveAndSend:
+        StoreRegister(reg, RESULT);
+        Send(RESULT);
+        break;
+    case ResultOperation::FetchAndSetMethod:
+        FetchParameter();
+        StoreRegister(reg, eax);
+        mov(dword[STATE + offsetof(JITState, method_address)], RESULT);
+        break;
+    case ResultOperation::MoveAndSetMethodFetchAndSend:
+        StoreRegister(reg, RESULT);
+        mov(dword[STATE + offsetof(JITState, method_address)], RESULT);
+        FetchParameter();
+        Send(eax);
+        break;
+    case ResultOperation::MoveAndSetMethodSend:
+        StoreRegister(reg, RESULT);
+        mov(dword[STATE + offsetof(JITState, method_address)], RESULT);
+        mov(eax, RESULT);
+        shr(eax, 12);
+        and_(eax, 0b111111);
+        Send(eax);
+        break;
+    }
+}
+
+void MacroJITx64::LoadRegister(const Xbyak::Reg32& dest, u32 reg) {
+    // Register 0 always reads as zero.
+    if (reg == 0) {
+        xor_(dest, dest);
+        return;
+    }
+    mov(dest, dword[STATE + offsetof(JITState, registers) + reg * sizeof(u32)]);
+}
+
+void MacroJITx64::StoreRegister(u32 reg, const Xbyak::Reg32& src) {
+    // Writes to register 0 are discarded, this is how NOP is encoded.
+    if (reg == 0) {
+        return;
+    }
+    mov(dword[STATE + offsetof(JITState, registers) + reg * sizeof(u32)], src);
+}
+
+void MacroJITx64::FetchParameter() {
+    // Reading past the parameters yields zero instead of reading out of bounds.
+    Xbyak::Label out_of_bounds;
+    xor_(eax, eax);
+    cmp(PARAMETER_INDEX.cvt32(), NUM_PARAMETERS);
+    jae(out_of_bounds);
+    mov(eax, dword[PARAMETERS + PARAMETER_INDEX * sizeof(u32)]);
+    inc(PARAMETER_INDEX.cvt32());
+    L(out_of_bounds);
+}
+
+void MacroJITx64::Send(const Xbyak::Reg32& value) {
+    mov(ABI_PARAM2.cvt32(), value);
+    mov(ABI_PARAM1, STATE);
+    CallFarFunction(*this, &MacroJITx64::SendHelper);
+}
+
+void MacroJITx64::SendHelper(JITState* state, u32 value) {
+    Macro::MethodAddress method_address{state->method_address};
+    state->maxwell3d->CallMethodFromMacro(method_address.address, value);
+    // Increment the method address by the method increment.
+    method_address.address.Assign(method_address.address.Value() +
+                                  method_address.increment.Value());
+    state->method_address = method_address.raw;
+}
+
+u32 MacroJITx64::ReadHelper(JITState* state, u32 method) {
+    return state->maxwell3d->GetRegisterValue(method);
+}
+
+} // namespace Tegra
@@ -0,0 +1,103 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <xbyak.h>
+#include "common/common_types.h"
+#include "video_core/macro_opcode.h"
+
+namespace Tegra {
+namespace Engines {
+class Maxwell3D;
+}
+
+/**
+ * Translates a macro to x64 code ahead of its execution. Every macro instruction is decoded once
+ * at compile time, control flow becomes native jumps and the delay slots of branches and exits
+ * are duplicated at their targets. Only engine writes and register reads call back into C++.
+ */
+class MacroJITx64 final : public Xbyak::CodeGenerator {
+public:
+    /**
+     * Compiles the macro code.
+     * @param maxwell3d Engine the macro writes to and reads from
+     * @param code The macro byte code to compile
+     * @returns The compiled macro, or null if it uses features not supported by the JIT. Such
+     * macros have to be executed by the interpreter.
+     */
+    static std::unique_ptr<MacroJITx64> Compile(Engines::Maxwell3D& maxwell3d,
+                                                const std::vector<u32>& code);
+
+    /**
+     * Executes the macro with the specified input parameters.
+     * @param parameters The parameters of the macro
+     */
+    void Execute(const std::vector<u32>& parameters);
+
+private:
+    /// Execution state accessed by the generated code
+    struct JITState {
+        Engines::Maxwell3D* maxwell3d;
+        std::array<u32, Macro::NUM_MACRO_REGISTERS> registers;
+        u32 method_address;
+    };
+
+    using ProgramType = void (*)(JITState* state, const u32* parameters, u32 num_parameters);
+
+    MacroJITx64(Engines::Maxwell3D& maxwell3d, const std::vector<u32>& code,
+                std::size_t max_size);
+
+    /// Emits the whole program, returns false if an instruction can't be compiled.
+    bool CompileProgram();
+
+    /// Emits the instruction at the given index as reached through regular control flow.
+    bool CompileInstruction(std::size_t index);
+
+    /// Emits a branch instruction along with the delay slot of its taken path.
+    bool CompileBranch(std::size_t index, Macro::Opcode opcode);
+
+    /**
+     * Emits the instruction at the given index as the delay slot of an exit. Exits in the slot
+     * itself chain into the following instruction, as they do in the interpreter.
+     */
+    bool CompileExitDelaySlot(std::size_t index);
+
+    /// Emits the operation and result of a non-branch instruction.
+    bool CompileOperation(Macro::Opcode opcode);
+
+    /// Emits the result operation of an instruction, whose result is in eax.
+    void CompileProcessResult(Macro::ResultOperation operation, u32 reg);
+
+    /// Loads a macro register into the given host register.
+    void LoadRegister(const Xbyak::Reg32& dest, u32 reg);
+
+    /// Stores the given host register into a macro register.
+    void StoreRegister(u32 reg, const Xbyak::Reg32& src);
+
+    /// Loads the next parameter into eax.
+    void FetchParameter();
+
+    /// Sends the given host register to the engine.
+    void Send(const Xbyak::Reg32& value);
+
+    /// Called by the generated code to write a register of the engine.
+    static void SendHelper(JITState* state, u32 value);
+
+    /// Called by the generated code to read a register of the engine.
+    static u32 ReadHelper(JITState* state, u32 method);
+
+    /// Code being compiled, only valid during Compile
+    const std::vector<u32>& code;
+    std::vector<Xbyak::Label> labels;
+    Xbyak::Label end_label;
+
+    JITState state{};
+    ProgramType program{};
+};
+
+} // namespace Tegra
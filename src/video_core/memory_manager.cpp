@@ -9,6 +9,8 @@
 namespace Tegra {
 
 GPUVAddr MemoryManager::AllocateSpace(u64 size, u64 align) {
+    std::lock_guard<std::mutex> lock(mutex);
+
     boost::optional<GPUVAddr> gpu_addr = FindFreeBlock(size, align);
     ASSERT(gpu_addr);
 
@@ -23,6 +25,8 @@ GPUVAddr MemoryManager::AllocateSpace(u64 size, u64 align) {
 }
 
 GPUVAddr MemoryManager::AllocateSpace(GPUVAddr gpu_addr, u64 size, u64 align) {
+    std::lock_guard<std::mutex> lock(mutex);
+
     for (u64 offset = 0; offset < size; offset += PAGE_SIZE) {
         VAddr& slot = PageSlot(gpu_addr + offset);
 
@@ -34,6 +38,8 @@ GPUVAddr MemoryManager::AllocateSpace(GPUVAddr gpu_addr, u64 size, u64 align) {
 }
 
 GPUVAddr MemoryManager::MapBufferEx(VAddr cpu_addr, u64 size) {
+    std::lock_guard<std::mutex> lock(mutex);
+
     boost::optional<GPUVAddr> gpu_addr = FindFreeBlock(size, PAGE_SIZE);
     ASSERT(gpu_addr);
 
@@ -51,6 +57,8 @@ GPUVAddr MemoryManager::MapBufferEx(VAddr cpu_addr, u64 size) {
 }
 
 GPUVAddr MemoryManager::MapBufferEx(VAddr cpu_addr, GPUVAddr gpu_addr, u64 size) {
+    std::lock_guard<std::mutex> lock(mutex);
+
     ASSERT((gpu_addr & PAGE_MASK) == 0);
 
     for (u64 offset = 0; offset < size; offset += PAGE_SIZE) {
@@ -67,6 +75,8 @@ GPUVAddr MemoryManager::MapBufferEx(VAddr cpu_addr, GPUVAddr gpu_addr, u64 size)
 }
 
 GPUVAddr MemoryManager::UnmapBuffer(GPUVAddr gpu_addr, u64 size) {
+    std::lock_guard<std::mutex> lock(mutex);
+
     ASSERT((gpu_addr & PAGE_MASK) == 0);
 
     for (u64 offset = 0; offset < size; offset += PAGE_SIZE) {
@@ -88,6 +98,8 @@ GPUVAddr MemoryManager::UnmapBuffer(GPUVAddr gpu_addr, u64 size) {
 }
 
 GPUVAddr MemoryManager::GetRegionEnd(GPUVAddr region_start) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
     for (const auto& region : mapped_regions) {
         const GPUVAddr region_end{region.gpu_addr + region.size};
         if (region_start >= region.gpu_addr && region_start < region_end) {
@@ -119,6 +131,8 @@ boost::optional<GPUVAddr> MemoryManager::FindFreeBlock(u64 size, u64 align) {
 }
 
 boost::optional<VAddr> MemoryManager::GpuToCpuAddress(GPUVAddr gpu_addr) {
+    std::lock_guard<std::mutex> lock(mutex);
+
     VAddr base_addr = PageSlot(gpu_addr);
 
     if (base_addr == static_cast<u64>(PageStatus::Allocated) ||
@@ -130,6 +144,8 @@ boost::optional<VAddr> MemoryManager::GpuToCpuAddress(GPUVAddr gpu_addr) {
 }
 
 std::vector<GPUVAddr> MemoryManager::CpuToGpuAddress(VAddr cpu_addr) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
     std::vector<GPUVAddr> results;
     for (const auto& region : mapped_regions) {
         if (cpu_addr >= region.cpu_addr && cpu_addr < (region.cpu_addr + region.size)) {
@@ -6,6 +6,7 @@
 
 #include <array>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include <boost/optional.hpp>
@@ -17,6 +18,12 @@ namespace Tegra {
 /// Virtual addresses in the GPU's memory map are 64 bit.
 using GPUVAddr = u64;
 
+/**
+ * Maps GPU virtual addresses to CPU virtual addresses. With the asynchronous GPU, it is modified by
+ * the CPU threads through nvhost_as_gpu while the GPU thread translates the addresses of the
+ * command lists it runs, so every public function is serialized with a mutex. Unmapping a buffer
+ * is ordered after the command lists submitted before it by the flush done beforehand.
+ */
 class MemoryManager final {
 public:
     MemoryManager() = default;
@@ -62,6 +69,9 @@ private:
     };
 
     std::vector<MappedRegion> mapped_regions;
+
+    /// Guards the page table and the mapped regions
+    mutable std::mutex mutex;
 };
 
 } // namespace Tegra
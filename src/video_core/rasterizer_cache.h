@@ -4,16 +4,17 @@
 
 #pragma once
 
-#include <set>
+#include <algorithm>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
-#include <boost/icl/interval_map.hpp>
-#include <boost/range/iterator_range_core.hpp>
+#include <boost/container/small_vector.hpp>
 
 #include "common/common_types.h"
-#include "core/core.h"
 #include "core/settings.h"
 #include "video_core/rasterizer_interface.h"
-#include "video_core/renderer_base.h"
 
 class RasterizerCacheObject {
 public:
@@ -59,22 +60,135 @@ private:
     u64 last_modified_ticks{}; ///< When the object was last modified, used for in-order flushing
 };
 
+/**
+ * Index of cached objects by the guest memory they cover. Memory is split in fixed size pages, and
+ * each page keeps a small inline list of the objects overlapping it, so that lookups are a hash
+ * table probe and a short linear scan, without any allocations.
+ */
+template <class T>
+class RasterizerCacheIndex final {
+public:
+    /// Adds an object to the index
+    void Add(const T& object) {
+        ForEachPage(object->GetAddr(), object->GetSizeInBytes(),
+                    [&](u64 page) { buckets[page].push_back(object); });
+    }
+
+    /// Removes an object from the index, it must have the same address and size as when added
+    void Remove(const T& object) {
+        ForEachPage(object->GetAddr(), object->GetSizeInBytes(), [&](u64 page) {
+            const auto bucket_iter = buckets.find(page);
+            if (bucket_iter == buckets.end()) {
+                return;
+            }
+
+            auto& bucket = bucket_iter->second;
+            const auto iter = std::find(bucket.begin(), bucket.end(), object);
+            if (iter != bucket.end()) {
+                bucket.erase(iter);
+            }
+            if (bucket.empty()) {
+                buckets.erase(bucket_iter);
+            }
+        });
+    }
+
+    /// Returns the object starting at the specified address, or nullptr if there is none
+    T Find(VAddr addr) const {
+        const auto bucket_iter = buckets.find(addr >> PAGE_BITS);
+        if (bucket_iter == buckets.end()) {
+            return nullptr;
+        }
+
+        for (const auto& object : bucket_iter->second) {
+            if (object->GetAddr() == addr) {
+                return object;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Appends the objects overlapping the specified region to `objects`, ordered by the time they
+     * were last modified. Each object is only appended once.
+     */
+    void GetSortedObjectsFromRegion(VAddr addr, u64 size, std::vector<T>& objects) const {
+        if (size == 0) {
+            return;
+        }
+
+        const VAddr end = addr + size;
+        ForEachPage(addr, size, [&](u64 page) {
+            const auto bucket_iter = buckets.find(page);
+            if (bucket_iter == buckets.end()) {
+                return;
+            }
+
+            for (const auto& object : bucket_iter->second) {
+                const VAddr object_addr = object->GetAddr();
+                if (object_addr < end && addr < object_addr + object->GetSizeInBytes()) {
+                    objects.push_back(object);
+                }
+            }
+        });
+
+        // Objects spanning several pages are found once per page, sorting by the object as well
+        // makes those duplicates adjacent.
+        const auto key = [](const T& object) {
+            return std::make_tuple(object->GetLastModifiedTicks(), object);
+        };
+        std::sort(objects.begin(), objects.end(),
+                  [&key](const T& a, const T& b) { return key(a) < key(b); });
+        objects.erase(std::unique(objects.begin(), objects.end()), objects.end());
+    }
+
+    /// Returns any object from the index, or nullptr if it is empty
+    T Any() const {
+        return buckets.empty() ? nullptr : buckets.begin()->second.front();
+    }
+
+private:
+    /// Size of the pages objects are bucketed by. It is larger than a CPU page, as most cached
+    /// objects are large, and each page an object touches costs a bucket entry.
+    static constexpr std::size_t PAGE_BITS = 16;
+
+    template <typename Func>
+    static void ForEachPage(VAddr addr, u64 size, Func&& func) {
+        if (size == 0) {
+            return;
+        }
+
+        const u64 page_end = (addr + size - 1) >> PAGE_BITS;
+        for (u64 page = addr >> PAGE_BITS; page <= page_end; ++page) {
+            func(page);
+        }
+    }
+
+    using ObjectBucket = boost::container::small_vector<T, 4>;
+
+    std::unordered_map<u64, ObjectBucket> buckets;
+};
+
 template <class T>
 class RasterizerCache : NonCopyable {
     friend class RasterizerCacheObject;
 
 public:
+    explicit RasterizerCache(VideoCore::RasterizerInterface& rasterizer) : rasterizer{rasterizer} {}
+    virtual ~RasterizerCache() = default;
+
     /// Write any cached resources overlapping the specified region back to memory
     void FlushRegion(Tegra::GPUVAddr addr, size_t size) {
-        const auto& objects{GetSortedObjectsFromRegion(addr, size)};
+        auto objects{AcquireObjectsFromRegion(addr, size)};
         for (auto& object : objects) {
             FlushObject(object);
         }
+        ReleaseObjects(std::move(objects));
     }
 
     /// Mark the specified region as being invalidated
     void InvalidateRegion(VAddr addr, u64 size) {
-        const auto& objects{GetSortedObjectsFromRegion(addr, size)};
+        auto objects{AcquireObjectsFromRegion(addr, size)};
         for (auto& object : objects) {
             if (!object->IsRegistered()) {
                 // Skip duplicates
@@ -82,41 +196,34 @@ public:
             }
             Unregister(object);
         }
+        ReleaseObjects(std::move(objects));
     }
 
     /// Invalidates everything in the cache
     void InvalidateAll() {
-        while (object_cache.begin() != object_cache.end()) {
-            Unregister(*object_cache.begin()->second.begin());
+        while (const T object = object_index.Any()) {
+            Unregister(object);
         }
     }
 
 protected:
-    /// Tries to get an object from the cache with the specified address
+    /// Tries to get an object from the cache with the specified address. Pending CPU writes are
+    /// applied first, so the object returned is never stale.
     T TryGet(VAddr addr) const {
-        const ObjectInterval interval{addr};
-        for (auto& pair : boost::make_iterator_range(object_cache.equal_range(interval))) {
-            for (auto& cached_object : pair.second) {
-                if (cached_object->GetAddr() == addr) {
-                    return cached_object;
-                }
-            }
-        }
-        return nullptr;
+        rasterizer.SyncGuestWrites();
+        return object_index.Find(addr);
     }
 
     /// Register an object into the cache
     void Register(const T& object) {
         object->SetIsRegistered(true);
-        object_cache.add({GetInterval(object), ObjectSet{object}});
-        auto& rasterizer = Core::System::GetInstance().Renderer().Rasterizer();
+        object_index.Add(object);
         rasterizer.UpdatePagesCachedCount(object->GetAddr(), object->GetSizeInBytes(), 1);
     }
 
     /// Unregisters an object from the cache
     void Unregister(const T& object) {
         object->SetIsRegistered(false);
-        auto& rasterizer = Core::System::GetInstance().Renderer().Rasterizer();
         rasterizer.UpdatePagesCachedCount(object->GetAddr(), object->GetSizeInBytes(), -1);
 
         // Only flush if use_accurate_gpu_emulation is enabled, as it incurs a performance hit
@@ -124,39 +231,37 @@ protected:
             FlushObject(object);
         }
 
-        object_cache.subtract({GetInterval(object), ObjectSet{object}});
+        object_index.Remove(object);
+        OnUnregister(object);
     }
 
+    /// Called once an object is unregistered, for caches keeping state tied to their objects
+    virtual void OnUnregister(const T& object) {}
+
     /// Returns a ticks counter used for tracking when cached objects were last modified
     u64 GetModifiedTicks() {
         return ++modified_ticks;
     }
 
 private:
-    /// Returns a list of cached objects from the specified memory region, ordered by access time
-    std::vector<T> GetSortedObjectsFromRegion(VAddr addr, u64 size) {
-        if (size == 0) {
-            return {};
-        }
-
-        std::vector<T> objects;
-        const ObjectInterval interval{addr, addr + size};
-        for (auto& pair : boost::make_iterator_range(object_cache.equal_range(interval))) {
-            for (auto& cached_object : pair.second) {
-                if (!cached_object) {
-                    continue;
-                }
-                objects.push_back(cached_object);
-            }
-        }
-
-        std::sort(objects.begin(), objects.end(), [](const T& a, const T& b) -> bool {
-            return a->GetLastModifiedTicks() < b->GetLastModifiedTicks();
-        });
-
+    /**
+     * Returns a list of cached objects from the specified memory region, ordered by access time.
+     * The list reuses the storage of the last released one, unless the cache is being reentered
+     * while flushing or invalidating, so that no allocations happen in the common case.
+     */
+    std::vector<T> AcquireObjectsFromRegion(VAddr addr, u64 size) {
+        std::vector<T> objects{std::move(objects_scratch)};
+        objects.clear();
+        object_index.GetSortedObjectsFromRegion(addr, size, objects);
         return objects;
     }
 
+    /// Gives back a list returned by AcquireObjectsFromRegion, so its storage can be reused
+    void ReleaseObjects(std::vector<T>&& objects) {
+        objects.clear();
+        objects_scratch = std::move(objects);
+    }
+
     /// Flushes the specified object, updating appropriate cache state as needed
     void FlushObject(const T& object) {
         if (!object->IsDirty()) {
@@ -166,15 +271,8 @@ private:
         object->MarkAsModified(false, *this);
     }
 
-    using ObjectSet = std::set<T>;
-    using ObjectCache = boost::icl::interval_map<VAddr, ObjectSet>;
-    using ObjectInterval = typename ObjectCache::interval_type;
-
-    static auto GetInterval(const T& object) {
-        return ObjectInterval::right_open(object->GetAddr(),
-                                          object->GetAddr() + object->GetSizeInBytes());
-    }
-
-    ObjectCache object_cache; ///< Cache of objects
-    u64 modified_ticks{};     ///< Counter of cache state ticks, used for in-order flushing
+    VideoCore::RasterizerInterface& rasterizer; ///< Rasterizer tracking the cached pages
+    RasterizerCacheIndex<T> object_index;       ///< Cache of objects
+    std::vector<T> objects_scratch;             ///< Storage reused for region queries
+    u64 modified_ticks{}; ///< Counter of cache state ticks, used for in-order flushing
 };
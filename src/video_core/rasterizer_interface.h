@@ -34,6 +34,16 @@ public:
     /// and invalidated
     virtual void FlushAndInvalidateRegion(VAddr addr, u64 size) = 0;
 
+    /// Notify rasterizer that the CPU has written to the specified region. The caches of the region
+    /// must be invalidated before the GPU uses them again, but this may be done lazily.
+    virtual void OnCPUWrite(VAddr addr, u64 size) {
+        InvalidateRegion(addr, size);
+    }
+
+    /// Invalidates the caches of the regions written by the CPU that OnCPUWrite hasn't invalidated
+    /// yet. Caches call it before handing out any cached object, so stale objects are never used.
+    virtual void SyncGuestWrites() {}
+
     /// Attempt to use a faster method to perform a surface copy
     virtual bool AccelerateSurfaceCopy(const Tegra::Engines::Fermi2D::Regs::Surface& src,
                                        const Tegra::Engines::Fermi2D::Regs::Surface& dst) {
@@ -57,5 +67,8 @@ public:
 
     /// Increase/decrease the number of object in pages touching the specified region
     virtual void UpdatePagesCachedCount(Tegra::GPUVAddr addr, u64 size, int delta) {}
+
+    /// Loads the resources the given title cached on disk in previous runs, such as its shaders
+    virtual void LoadDiskResources(u64 title_id, const DiskResourceLoadCallback& callback = {}) {}
 };
 } // namespace VideoCore
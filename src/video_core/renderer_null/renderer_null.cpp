@@ -0,0 +1,36 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/frontend/emu_window.h"
+#include "core/perf_stats.h"
+#include "video_core/renderer_null/renderer_null.h"
+
+namespace Null {
+
+RendererNull::RendererNull(Core::Frontend::EmuWindow& window) : VideoCore::RendererBase{window} {}
+
+RendererNull::~RendererNull() = default;
+
+void RendererNull::SwapBuffers(boost::optional<const Tegra::FramebufferConfig&> framebuffer) {
+    auto& system = Core::System::GetInstance();
+    system.GetPerfStats().EndSystemFrame();
+
+    m_current_frame++;
+    render_window.PollEvents();
+
+    system.FrameLimiter().DoFrameLimiting(CoreTiming::GetGlobalTimeUs());
+    system.GetPerfStats().BeginSystemFrame();
+}
+
+bool RendererNull::Init() {
+    rasterizer = std::make_unique<RasterizerNull>();
+    return true;
+}
+
+void RendererNull::ShutDown() {}
+
+} // namespace Null
@@ -0,0 +1,47 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+
+namespace Core::Frontend {
+class EmuWindow;
+}
+
+namespace Null {
+
+/// Rasterizer discarding all draws, so that the GPU can be emulated without a host GPU
+class RasterizerNull final : public VideoCore::RasterizerInterface {
+public:
+    void DrawArrays() override {}
+    void Clear() override {}
+    void FlushAll() override {}
+    void FlushRegion(VAddr addr, u64 size) override {}
+    void InvalidateRegion(VAddr addr, u64 size) override {}
+    void FlushAndInvalidateRegion(VAddr addr, u64 size) override {}
+};
+
+/**
+ * Renderer presenting nothing. Command processing, the engines and frame pacing behave as with a
+ * real renderer, which makes it possible to measure the emulation overhead headless.
+ */
+class RendererNull final : public VideoCore::RendererBase {
+public:
+    explicit RendererNull(Core::Frontend::EmuWindow& window);
+    ~RendererNull() override;
+
+    /// Swap buffers (render frame)
+    void SwapBuffers(boost::optional<const Tegra::FramebufferConfig&> framebuffer) override;
+
+    /// Initialize the renderer
+    bool Init() override;
+
+    /// Shutdown the renderer
+    void ShutDown() override;
+};
+
+} // namespace Null
@@ -79,7 +79,8 @@ struct DrawParameters {
 };
 
 RasterizerOpenGL::RasterizerOpenGL(Core::Frontend::EmuWindow& window, ScreenInfo& info)
-    : emu_window{window}, screen_info{info}, buffer_cache(STREAM_BUFFER_SIZE) {
+    : res_cache{*this}, shader_cache{*this, window}, emu_window{window}, screen_info{info},
+      buffer_cache(*this, STREAM_BUFFER_SIZE) {
     // Create sampler objects
     for (std::size_t i = 0; i < texture_samplers.size(); ++i) {
         texture_samplers[i].Create();
@@ -364,39 +365,11 @@ bool RasterizerOpenGL::AccelerateDrawBatch(bool is_indexed) {
     return true;
 }
 
-template <typename Map, typename Interval>
-static constexpr auto RangeFromInterval(Map& map, const Interval& interval) {
-    return boost::make_iterator_range(map.equal_range(interval));
-}
-
 void RasterizerOpenGL::UpdatePagesCachedCount(VAddr addr, u64 size, int delta) {
-    const u64 page_start{addr >> Memory::PAGE_BITS};
-    const u64 page_end{(addr + size + Memory::PAGE_SIZE - 1) >> Memory::PAGE_BITS};
-
-    // Interval maps will erase segments if count reaches 0, so if delta is negative we have to
-    // subtract after iterating
-    const auto pages_interval = CachedPageMap::interval_type::right_open(page_start, page_end);
-    if (delta > 0)
-        cached_pages.add({pages_interval, delta});
-
-    for (const auto& pair : RangeFromInterval(cached_pages, pages_interval)) {
-        const auto interval = pair.first & pages_interval;
-        const int count = pair.second;
-
-        const VAddr interval_start_addr = boost::icl::first(interval) << Memory::PAGE_BITS;
-        const VAddr interval_end_addr = boost::icl::last_next(interval) << Memory::PAGE_BITS;
-        const u64 interval_size = interval_end_addr - interval_start_addr;
-
-        if (delta > 0 && count == delta)
-            Memory::RasterizerMarkRegionCached(interval_start_addr, interval_size, true);
-        else if (delta < 0 && count == -delta)
-            Memory::RasterizerMarkRegionCached(interval_start_addr, interval_size, false);
-        else
-            ASSERT(count >= 0);
-    }
-
-    if (delta < 0)
-        cached_pages.add({pages_interval, delta});
+    static_assert(VideoCore::CachedPageTracker::PAGE_BITS == Memory::PAGE_BITS);
+    cached_pages.UpdateCachedCount(addr, size, delta, [delta](VAddr run_addr, u64 run_size) {
+        Memory::RasterizerMarkRegionCached(run_addr, run_size, delta > 0);
+    });
 }
 
 void RasterizerOpenGL::ConfigureFramebuffers(bool using_color_fb, bool using_depth_fb,
@@ -494,6 +467,8 @@ void RasterizerOpenGL::ConfigureFramebuffers(bool using_color_fb, bool using_dep
 }
 
 void RasterizerOpenGL::Clear() {
+    SyncGuestWrites();
+
     const auto prev_state{state};
     SCOPE_EXIT({ prev_state.Apply(); });
 
@@ -557,12 +532,20 @@ void RasterizerOpenGL::DrawArrays() {
     if (accelerate_draw == AccelDraw::Disabled)
         return;
 
+    SyncGuestWrites();
+
     MICROPROFILE_SCOPE(OpenGL_Drawing);
     const auto& gpu = Core::System::GetInstance().GPU().Maxwell3D();
     const auto& regs = gpu.regs;
 
     ScopeAcquireGLContext acquire_context{emu_window};
 
+    if (!shader_cache.PrepareStagePrograms()) {
+        // The programs of the draw are being built in the background, skip it to avoid stalling
+        accelerate_draw = AccelDraw::Disabled;
+        return;
+    }
+
     ConfigureFramebuffers();
 
     SyncDepthTestState();
@@ -640,6 +623,9 @@ void RasterizerOpenGL::FlushRegion(VAddr addr, u64 size) {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
 
     if (Settings::values.use_accurate_gpu_emulation) {
+        // Pending CPU writes have to be applied first, so they aren't overwritten by the flush
+        SyncGuestWrites();
+
         // Only flush if use_accurate_gpu_emulation is enabled, as it incurs a performance hit
         res_cache.FlushRegion(addr, size);
     }
@@ -657,6 +643,30 @@ void RasterizerOpenGL::FlushAndInvalidateRegion(VAddr addr, u64 size) {
     InvalidateRegion(addr, size);
 }
 
+void RasterizerOpenGL::OnCPUWrite(VAddr addr, u64 size) {
+    // With accurate GPU emulation, unregistering an object flushes it. That has to happen before
+    // the CPU write lands in memory, so the invalidation can't be deferred.
+    if (Settings::values.use_accurate_gpu_emulation) {
+        InvalidateRegion(addr, size);
+        return;
+    }
+    cached_pages.MarkRegionDirty(addr, size);
+}
+
+void RasterizerOpenGL::LoadDiskResources(u64 title_id,
+                                         const VideoCore::DiskResourceLoadCallback& callback) {
+    shader_cache.LoadDiskCache(title_id, callback);
+}
+
+void RasterizerOpenGL::SyncGuestWrites() {
+    if (!cached_pages.HasDirtyPages()) {
+        return;
+    }
+
+    cached_pages.ConsumeDirtyRegions(
+        [this](VAddr addr, u64 size) { InvalidateRegion(addr, size); });
+}
+
 bool RasterizerOpenGL::AccelerateSurfaceCopy(const Tegra::Engines::Fermi2D::Regs::Surface& src,
                                              const Tegra::Engines::Fermi2D::Regs::Surface& dst) {
     MICROPROFILE_SCOPE(OpenGL_Blits);
@@ -666,6 +676,8 @@ bool RasterizerOpenGL::AccelerateSurfaceCopy(const Tegra::Engines::Fermi2D::Regs
         return false;
     }
 
+    SyncGuestWrites();
+
     res_cache.FermiCopySurface(src, dst);
     return true;
 }
@@ -683,6 +695,8 @@ bool RasterizerOpenGL::AccelerateDisplay(const Tegra::FramebufferConfig& config,
 
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
 
+    SyncGuestWrites();
+
     const auto& surface{res_cache.TryFindFramebufferSurface(framebuffer_addr)};
     if (!surface) {
         return {};
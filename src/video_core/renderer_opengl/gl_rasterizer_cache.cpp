@@ -350,6 +350,17 @@ void MortonCopy(u32 stride, u32 block_height, u32 height, u32 block_depth, u32 d
     const u32 tile_size{IsFormatBCn(format) ? 4U : 1U};
 
     if (morton_to_gl) {
+        const u32 width{stride / tile_size};
+        const u32 tiled_height{height / tile_size};
+        const std::size_t unswizzled_size{std::size_t{width} * tiled_height * depth *
+                                          bytes_per_pixel};
+        if (unswizzled_size <= gl_buffer_size) {
+            // Unswizzle straight into the buffer, which is split across threads for large surfaces
+            Tegra::Texture::CopySwizzledData(width, tiled_height, depth, bytes_per_pixel,
+                                             bytes_per_pixel, Memory::GetPointer(addr), gl_buffer,
+                                             true, block_height, block_depth);
+            return;
+        }
         const std::vector<u8> data = Tegra::Texture::UnswizzleTexture(
             addr, tile_size, bytes_per_pixel, stride, height, depth, block_height, block_depth);
         const std::size_t size_to_copy{std::min(gl_buffer_size, data.size())};
@@ -1060,7 +1071,8 @@ void CachedSurface::UploadGLTexture(GLuint read_fb_handle, GLuint draw_fb_handle
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 }
 
-RasterizerCacheOpenGL::RasterizerCacheOpenGL() {
+RasterizerCacheOpenGL::RasterizerCacheOpenGL(VideoCore::RasterizerInterface& rasterizer)
+    : RasterizerCache{rasterizer} {
     read_framebuffer.Create();
     draw_framebuffer.Create();
     copy_pbo.Create();
@@ -133,10 +133,10 @@ public:
     }
 
     template <typename... T>
-    void Create(bool separable_program, T... shaders) {
+    void Create(bool separable_program, bool hint_retrievable, T... shaders) {
         if (handle != 0)
             return;
-        handle = GLShader::LoadProgram(separable_program, shaders...);
+        handle = GLShader::LoadProgram(separable_program, hint_retrievable, shaders...);
     }
 
     /// Creates a new internal OpenGL resource and stores the handle
@@ -149,7 +149,7 @@ public:
             geo.Create(geo_shader, GL_GEOMETRY_SHADER);
         if (frag_shader)
             frag.Create(frag_shader, GL_FRAGMENT_SHADER);
-        Create(separable_program, vert.handle, geo.handle, frag.handle);
+        Create(separable_program, false, vert.handle, geo.handle, frag.handle);
     }
 
     /// Deletes the internal OpenGL resource
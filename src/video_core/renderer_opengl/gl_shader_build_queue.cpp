@@ -0,0 +1,98 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include "common/logging/log.h"
+#include "video_core/renderer_opengl/gl_shader_build_queue.h"
+
+namespace OpenGL {
+
+std::size_t GetLatencyBucket(std::chrono::steady_clock::duration latency) {
+    auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(latency).count();
+    std::size_t bucket = 0;
+    for (; milliseconds > 0 && bucket < ShaderBuildStatistics::NumLatencyBuckets - 1; ++bucket) {
+        milliseconds >>= 1;
+    }
+    return bucket;
+}
+
+ShaderBuildQueue::ShaderBuildQueue(LinkFunction link, BuiltCallback on_built)
+    : link{std::move(link)}, on_built{std::move(on_built)} {}
+
+ShaderBuildQueue::~ShaderBuildQueue() {
+    for (auto& pending : pending_programs) {
+        if (pending.decompiled.valid()) {
+            pending.decompiled.wait();
+        }
+    }
+}
+
+void ShaderBuildQueue::Queue(u64 unique_identifier, ShaderProgram program_type,
+                             std::shared_ptr<CachedProgram> program,
+                             std::future<void> decompiled) {
+    program->is_built = false;
+
+    PendingProgram pending{unique_identifier, program_type, std::move(program),
+                           std::move(decompiled)};
+    pending.queue_time = std::chrono::steady_clock::now();
+    pending_programs.push_back(std::move(pending));
+    statistics.max_queue_depth = std::max(statistics.max_queue_depth, pending_programs.size());
+}
+
+void ShaderBuildQueue::Collect() {
+    for (auto it = pending_programs.begin(); it != pending_programs.end();) {
+        it = AdvanceBuild(*it, false) ? pending_programs.erase(it) : std::next(it);
+    }
+}
+
+void ShaderBuildQueue::WaitAll() {
+    for (auto& pending : pending_programs) {
+        AdvanceBuild(pending, true);
+    }
+    pending_programs.clear();
+}
+
+ShaderBuildStatistics ShaderBuildQueue::GetStatistics() const {
+    ShaderBuildStatistics current = statistics;
+    current.queue_depth = pending_programs.size();
+    return current;
+}
+
+bool ShaderBuildQueue::AdvanceBuild(PendingProgram& pending, bool wait) {
+    constexpr auto is_ready = [](const std::future<void>& future) {
+        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    };
+
+    if (!pending.linked.valid()) {
+        if (!wait && !is_ready(pending.decompiled)) {
+            return false;
+        }
+        pending.decompiled.get();
+        pending.linked = link(pending.program, pending.program_type);
+    }
+    if (!wait && !is_ready(pending.linked)) {
+        return false;
+    }
+
+    try {
+        pending.linked.get();
+    } catch (const std::exception& exception) {
+        // The program is left unbuilt
+        LOG_ERROR(Render_OpenGL, "Shader {:016x} was not linked: {}", pending.unique_identifier,
+                  exception.what());
+        return true;
+    }
+    pending.program->is_built.store(true, std::memory_order_release);
+
+    on_built(pending.unique_identifier, pending.program_type, *pending.program);
+
+    ++statistics.programs_built;
+    ++statistics.latency_histogram[GetLatencyBucket(std::chrono::steady_clock::now() -
+                                                    pending.queue_time)];
+    return true;
+}
+
+} // namespace OpenGL
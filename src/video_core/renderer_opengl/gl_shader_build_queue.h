@@ -0,0 +1,132 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_shader_gen.h"
+
+namespace OpenGL {
+
+/// A decompiled and built stage program, shared by all the shaders with the same code
+struct CachedProgram {
+    std::string code;
+    GLShader::ShaderEntries entries;
+    /// Linked program, except for geometry shaders which are linked for each input topology
+    OGLProgram program;
+    /// Whether the program can be used, programs built in the background are set once linked
+    std::atomic_bool is_built{true};
+};
+
+/// Counters of the programs built in the background
+struct ShaderBuildStatistics {
+    /// Number of buckets of the latency histogram
+    static constexpr std::size_t NumLatencyBuckets = 12;
+
+    /// Number of programs being built
+    std::size_t queue_depth{};
+    /// Highest number of programs that were being built at once
+    std::size_t max_queue_depth{};
+    /// Number of programs built since the title started, not counting the ones loaded from disk
+    u64 programs_built{};
+    /// Programs by the time it took until they could be used. The first bucket counts the ones
+    /// built in less than 1 ms, bucket i the ones built in [2^(i-1), 2^i) ms and the last bucket
+    /// all the slower ones.
+    std::array<u64, NumLatencyBuckets> latency_histogram{};
+    /// Number of draws skipped because their programs were still being built
+    u64 skipped_draws{};
+};
+
+/// Returns the latency histogram bucket of a program built in the given time
+std::size_t GetLatencyBucket(std::chrono::steady_clock::duration latency);
+
+/**
+ * Programs being built in the background. Each program is decompiled on a worker thread, then
+ * handed to the link step, and is marked as built once linked. The queue doesn't use the GL
+ * context itself, the link step does.
+ */
+class ShaderBuildQueue {
+public:
+    using ShaderProgram = Tegra::Engines::Maxwell3D::Regs::ShaderProgram;
+
+    /**
+     * Links a decompiled program, on the calling thread or in the background.
+     * @returns A future that is ready once the program is linked, or holds an exception if it
+     *          won't be
+     */
+    using LinkFunction = std::function<std::future<void>(const std::shared_ptr<CachedProgram>&,
+                                                         ShaderProgram)>;
+
+    /// Called on the thread collecting the programs with each program once it's built
+    using BuiltCallback =
+        std::function<void(u64 unique_identifier, ShaderProgram, const CachedProgram&)>;
+
+    ShaderBuildQueue(LinkFunction link, BuiltCallback on_built);
+
+    /// Waits for the programs still being decompiled, as the worker threads use them
+    ~ShaderBuildQueue();
+
+    /**
+     * Queues a program being decompiled, it's built once it's collected.
+     * @param decompiled Ready once the code of the program has been decompiled
+     */
+    void Queue(u64 unique_identifier, ShaderProgram program_type,
+               std::shared_ptr<CachedProgram> program, std::future<void> decompiled);
+
+    /// Advances the build of all the queued programs, without waiting for them
+    void Collect();
+
+    /// Builds all the queued programs, waiting for them
+    void WaitAll();
+
+    /// Counts a draw skipped because its programs were still being built
+    void RecordSkippedDraw() {
+        ++statistics.skipped_draws;
+    }
+
+    /// Returns the counters of the programs built since the queue was created
+    ShaderBuildStatistics GetStatistics() const;
+
+private:
+    struct PendingProgram {
+        u64 unique_identifier;
+        ShaderProgram program_type;
+        std::shared_ptr<CachedProgram> program;
+        /// Ready once the program has been decompiled
+        std::future<void> decompiled;
+        /// Ready once the program has been linked, valid once it's handed to the link step
+        std::future<void> linked;
+        std::chrono::steady_clock::time_point queue_time;
+    };
+
+    /**
+     * Advances the build of a pending program: hands it to the link step once it's decompiled,
+     * then marks it as built once it's linked.
+     * @param wait Whether to wait for the program to be decompiled and linked
+     * @returns True once the program is done with, built or not
+     */
+    bool AdvanceBuild(PendingProgram& pending, bool wait);
+
+    LinkFunction link;
+    BuiltCallback on_built;
+
+    /// Programs still being built, in the order they were queued
+    std::vector<PendingProgram> pending_programs;
+
+    ShaderBuildStatistics statistics;
+};
+
+} // namespace OpenGL
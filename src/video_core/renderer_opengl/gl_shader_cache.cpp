@@ -2,9 +2,26 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <fmt/format.h>
 #include "common/assert.h"
+#include "common/cityhash.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/thread_pool.h"
 #include "core/core.h"
+#include "core/frontend/emu_window.h"
 #include "core/memory.h"
+#include "core/settings.h"
 #include "video_core/engines/maxwell_3d.h"
 #include "video_core/renderer_opengl/gl_shader_cache.h"
 #include "video_core/renderer_opengl/gl_shader_manager.h"
@@ -20,13 +37,6 @@ static VAddr GetShaderAddress(Maxwell::ShaderProgram program) {
                                                shader_config.offset);
 }
 
-/// Gets the shader program code from memory for the specified address
-static GLShader::ProgramCode GetShaderCode(VAddr addr) {
-    GLShader::ProgramCode program_code(GLShader::MAX_PROGRAM_CODE_LENGTH);
-    Memory::ReadBlock(addr, program_code.data(), program_code.size() * sizeof(u64));
-    return program_code;
-}
-
 /// Helper function to set shader uniform block bindings for a single shader stage
 static void SetShaderUniformBlockBinding(GLuint shader, const char* name,
                                          Maxwell::ShaderStage binding, std::size_t expected_size) {
@@ -52,55 +62,213 @@ static void SetShaderUniformBlockBindings(GLuint shader) {
                                  sizeof(GLShader::MaxwellUniformData));
 }
 
-CachedShader::CachedShader(VAddr addr, Maxwell::ShaderProgram program_type)
-    : addr{addr}, program_type{program_type}, setup{GetShaderCode(addr)} {
+/// The program itself starts after the shader header
+constexpr std::size_t PROGRAM_START_OFFSET = 10;
+
+std::size_t FindProgramEnd(const GLShader::ProgramCode& program, std::size_t begin,
+                           std::size_t end) {
+    // Sched instructions appear once every 4 instructions.
+    constexpr std::size_t sched_period = 4;
+    constexpr u64 self_jumping_branch = 0xE2400FFFFF07000FULL;
+    constexpr u64 self_jumping_branch_mask = 0xFFFFFFFFFF7FFFFFULL;
+
+    for (std::size_t offset = std::max(begin, PROGRAM_START_OFFSET); offset < end; ++offset) {
+        if ((offset - PROGRAM_START_OFFSET) % sched_period == 0)
+            continue;
+        const u64 instruction = program[offset];
+        if ((instruction & self_jumping_branch_mask) == self_jumping_branch || instruction == 0)
+            return offset;
+    }
+    return end;
+}
+
+std::size_t CalculateProgramSize(const GLShader::ProgramCode& program) {
+    const std::size_t offset = FindProgramEnd(program, 0, program.size());
+    // The terminating instruction is part of the program
+    return std::min(offset + 1, program.size()) * sizeof(u64);
+}
 
-    GLShader::ProgramResult program_result;
-    GLenum gl_type{};
+GLShader::ProgramCode GetShaderCode(VAddr addr) {
+    // Most programs are a few hundred instructions long, far from the maximum length.
+    constexpr std::size_t chunk_size = 0x100;
 
+    GLShader::ProgramCode program_code(GLShader::MAX_PROGRAM_CODE_LENGTH);
+    std::size_t words_read = 0;
+    while (words_read < program_code.size()) {
+        const std::size_t count = std::min(chunk_size, program_code.size() - words_read);
+        Memory::ReadBlock(addr + words_read * sizeof(u64), program_code.data() + words_read,
+                          count * sizeof(u64));
+        const std::size_t begin = words_read;
+        words_read += count;
+        if (FindProgramEnd(program_code, begin, words_read) != words_read) {
+            break;
+        }
+    }
+    return program_code;
+}
+
+/**
+ * Returns a hash of the code of a program and of the state it's decompiled with. Only the words
+ * making up the program are hashed, the code after it is whatever is next in guest memory.
+ */
+static u64 GetUniqueIdentifier(Maxwell::ShaderProgram program_type,
+                               const GLShader::ShaderSetup& setup) {
+    const auto& code = setup.program.code;
+    u64 hash = Common::CityHash64WithSeed(reinterpret_cast<const char*>(code.data()),
+                                          CalculateProgramSize(code),
+                                          static_cast<u64>(program_type));
+    if (setup.IsDualProgram()) {
+        const auto& code_b = setup.program.code_b;
+        hash = Common::CityHash64WithSeed(reinterpret_cast<const char*>(code_b.data()),
+                                          CalculateProgramSize(code_b), hash);
+    }
+    return hash;
+}
+
+static GLShader::ProgramResult DecompileProgram(Maxwell::ShaderProgram program_type,
+                                                const GLShader::ShaderSetup& setup) {
     switch (program_type) {
     case Maxwell::ShaderProgram::VertexA:
-        // VertexB is always enabled, so when VertexA is enabled, we have two vertex shaders.
-        // Conventional HW does not support this, so we combine VertexA and VertexB into one
-        // stage here.
-        setup.SetProgramB(GetShaderCode(GetShaderAddress(Maxwell::ShaderProgram::VertexB)));
     case Maxwell::ShaderProgram::VertexB:
-        program_result = GLShader::GenerateVertexShader(setup);
-        gl_type = GL_VERTEX_SHADER;
-        break;
+        return GLShader::GenerateVertexShader(setup);
     case Maxwell::ShaderProgram::Geometry:
-        program_result = GLShader::GenerateGeometryShader(setup);
-        gl_type = GL_GEOMETRY_SHADER;
-        break;
+        return GLShader::GenerateGeometryShader(setup);
     case Maxwell::ShaderProgram::Fragment:
-        program_result = GLShader::GenerateFragmentShader(setup);
-        gl_type = GL_FRAGMENT_SHADER;
-        break;
+        return GLShader::GenerateFragmentShader(setup);
     default:
         LOG_CRITICAL(HW_GPU, "Unimplemented program_type={}", static_cast<u32>(program_type));
         UNREACHABLE();
+        return {};
+    }
+}
+
+/// Links the program of a decompiled shader, geometry shaders are linked once they're used
+static void LinkProgram(CachedProgram& program, Maxwell::ShaderProgram program_type,
+                        bool hint_retrievable) {
+    if (program_type == Maxwell::ShaderProgram::Geometry)
         return;
+
+    const GLenum gl_type =
+        program_type == Maxwell::ShaderProgram::Fragment ? GL_FRAGMENT_SHADER : GL_VERTEX_SHADER;
+    OGLShader shader;
+    shader.Create(program.code.c_str(), gl_type);
+    program.program.Create(true, hint_retrievable, shader.handle);
+    SetShaderUniformBlockBindings(program.program.handle);
+}
+
+/// Loads the program of a decompiled shader from a binary, which fails if the driver rejects it
+static bool LoadProgramBinary(CachedProgram& program, const ShaderDiskCacheBinary& binary) {
+    program.program.handle = glCreateProgram();
+    glProgramParameteri(program.program.handle, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    glProgramBinary(program.program.handle, binary.format, binary.binary.data(),
+                    static_cast<GLsizei>(binary.binary.size()));
+
+    GLint link_status{};
+    glGetProgramiv(program.program.handle, GL_LINK_STATUS, &link_status);
+    if (link_status != GL_TRUE) {
+        program.program.Release();
+        return false;
+    }
+    SetShaderUniformBlockBindings(program.program.handle);
+    return true;
+}
+
+/**
+ * Links programs on a GL context shared with the one of the rasterizer, so that the driver
+ * compiles them while the GPU thread keeps drawing. The future of each program is made ready
+ * once the driver is done with it.
+ */
+class ShaderLinkThread {
+public:
+    explicit ShaderLinkThread(std::unique_ptr<Core::Frontend::GraphicsContext> context)
+        : context{std::move(context)}, thread{&ShaderLinkThread::ThreadLoop, this} {}
+
+    /**
+     * Stops the thread once it's done with the program it's linking. The futures of the programs
+     * still queued hold an exception, as they're never linked.
+     */
+    ~ShaderLinkThread() {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stopping = true;
+        }
+        job_available.notify_one();
+        thread.join();
+
+        for (auto& job : jobs) {
+            job.linked.set_exception(std::make_exception_ptr(
+                std::runtime_error("the link thread was stopped before linking it")));
+        }
     }
 
-    entries = program_result.second;
+    /// Queues a decompiled program to be linked, the returned future is ready once it's linked
+    std::future<void> QueueLink(std::shared_ptr<CachedProgram> program,
+                                Maxwell::ShaderProgram program_type, bool hint_retrievable) {
+        LinkJob job{std::move(program), program_type, hint_retrievable};
+        auto linked = job.linked.get_future();
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            jobs.push_back(std::move(job));
+        }
+        job_available.notify_one();
+        return linked;
+    }
 
-    if (program_type != Maxwell::ShaderProgram::Geometry) {
-        OGLShader shader;
-        shader.Create(program_result.first.c_str(), gl_type);
-        program.Create(true, shader.handle);
-        SetShaderUniformBlockBindings(program.handle);
-        VideoCore::LabelGLObject(GL_PROGRAM, program.handle, addr);
-    } else {
-        // Store shader's code to lazily build it on draw
-        geometry_programs.code = program_result.first;
+private:
+    struct LinkJob {
+        std::shared_ptr<CachedProgram> program;
+        Maxwell::ShaderProgram program_type;
+        bool hint_retrievable;
+        std::promise<void> linked;
+    };
+
+    void ThreadLoop() {
+        context->MakeCurrent();
+        while (true) {
+            LinkJob job;
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                job_available.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping) {
+                    break;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            LinkProgram(*job.program, job.program_type, job.hint_retrievable);
+            // Objects of a shared context may only be used by the other one once they're complete
+            glFinish();
+            job.linked.set_value();
+        }
+        context->DoneCurrent();
+    }
+
+    std::unique_ptr<Core::Frontend::GraphicsContext> context;
+
+    std::mutex mutex;
+    std::condition_variable job_available;
+    std::deque<LinkJob> jobs;
+    bool stopping{};
+
+    std::thread thread;
+};
+
+CachedShader::CachedShader(VAddr addr, std::size_t size, Maxwell::ShaderProgram program_type,
+                           std::shared_ptr<const CachedProgram> cached_program,
+                           ProgramB program_b)
+    : addr{addr}, size{size}, program_type{program_type},
+      cached_program{std::move(cached_program)}, program_b{std::move(program_b)} {
+    if (program_type != Maxwell::ShaderProgram::Geometry && IsBuilt()) {
+        VideoCore::LabelGLObject(GL_PROGRAM, this->cached_program->program.handle, addr);
     }
 }
 
 GLuint CachedShader::GetProgramResourceIndex(const GLShader::ConstBufferEntry& buffer) {
     const auto search{resource_cache.find(buffer.GetHash())};
     if (search == resource_cache.end()) {
-        const GLuint index{
-            glGetProgramResourceIndex(program.handle, GL_UNIFORM_BLOCK, buffer.GetName().c_str())};
+        const GLuint index{glGetProgramResourceIndex(cached_program->program.handle,
+                                                     GL_UNIFORM_BLOCK, buffer.GetName().c_str())};
         resource_cache[buffer.GetHash()] = index;
         return index;
     }
@@ -111,7 +279,8 @@ GLuint CachedShader::GetProgramResourceIndex(const GLShader::ConstBufferEntry& b
 GLint CachedShader::GetUniformLocation(const GLShader::SamplerEntry& sampler) {
     const auto search{uniform_cache.find(sampler.GetHash())};
     if (search == uniform_cache.end()) {
-        const GLint index{glGetUniformLocation(program.handle, sampler.GetName().c_str())};
+        const GLint index{
+            glGetUniformLocation(cached_program->program.handle, sampler.GetName().c_str())};
         uniform_cache[sampler.GetHash()] = index;
         return index;
     }
@@ -125,28 +294,280 @@ GLuint CachedShader::LazyGeometryProgram(OGLProgram& target_program,
     if (target_program.handle != 0) {
         return target_program.handle;
     }
-    const std::string source{geometry_programs.code + "layout (" + glsl_topology + ") in;\n"};
+    const std::string source{cached_program->code + "layout (" + glsl_topology + ") in;\n"};
     OGLShader shader;
     shader.Create(source.c_str(), GL_GEOMETRY_SHADER);
-    target_program.Create(true, shader.handle);
+    target_program.Create(true, false, shader.handle);
     SetShaderUniformBlockBindings(target_program.handle);
     VideoCore::LabelGLObject(GL_PROGRAM, target_program.handle, addr, debug_name);
     return target_program.handle;
 };
 
+ProgramBCache::ProgramBCache(VideoCore::RasterizerInterface& rasterizer)
+    : RasterizerCache{rasterizer} {}
+
+ProgramB ProgramBCache::Get(VAddr addr, std::size_t size) {
+    ProgramB program_b{TryGet(addr)};
+    if (!program_b) {
+        program_b = std::make_shared<CachedProgramB>(addr, size);
+        Register(program_b);
+    }
+    ++program_b->num_shaders;
+    return program_b;
+}
+
+void ProgramBCache::Release(const ProgramB& program_b) {
+    ASSERT(program_b->num_shaders > 0);
+    if (--program_b->num_shaders == 0 && program_b->IsRegistered()) {
+        Unregister(program_b);
+    }
+}
+
+ShaderCacheOpenGL::ShaderCacheOpenGL(VideoCore::RasterizerInterface& rasterizer,
+                                     Core::Frontend::EmuWindow& emu_window)
+    : RasterizerCache{rasterizer}, program_b_cache{rasterizer},
+      build_queue{[this](const std::shared_ptr<CachedProgram>& program,
+                         Maxwell::ShaderProgram program_type) {
+                      return StartLink(program, program_type);
+                  },
+                  [this](u64 unique_identifier, Maxwell::ShaderProgram program_type,
+                         const CachedProgram& program) {
+                      SaveBuiltProgram(unique_identifier, program_type, program);
+                  }},
+      asynchronous{Settings::values.use_asynchronous_shaders} {
+    if (!asynchronous) {
+        return;
+    }
+    if (auto context = emu_window.CreateSharedContext()) {
+        link_thread = std::make_unique<ShaderLinkThread>(std::move(context));
+    } else {
+        LOG_WARNING(Render_OpenGL, "Shared contexts aren't supported, linking shaders in the "
+                                   "rendering thread");
+    }
+}
+
+ShaderCacheOpenGL::~ShaderCacheOpenGL() {
+    link_thread.reset();
+
+    const ShaderBuildStatistics statistics = build_queue.GetStatistics();
+    if (statistics.programs_built == 0) {
+        return;
+    }
+    std::string histogram;
+    for (std::size_t bucket = 0; bucket < statistics.latency_histogram.size(); ++bucket) {
+        const u64 count = statistics.latency_histogram[bucket];
+        if (count == 0) {
+            continue;
+        }
+        if (bucket == statistics.latency_histogram.size() - 1) {
+            histogram += fmt::format(" >={}ms: {},", 1ULL << (bucket - 1), count);
+        } else {
+            histogram += fmt::format(" <{}ms: {},", 1ULL << bucket, count);
+        }
+    }
+    histogram.pop_back();
+    LOG_INFO(Render_OpenGL,
+             "Built {} shaders, at most {} at once, skipped {} draws waiting for them. Build "
+             "latency:{}",
+             statistics.programs_built, statistics.max_queue_depth, statistics.skipped_draws,
+             histogram);
+}
+
 Shader ShaderCacheOpenGL::GetStageProgram(Maxwell::ShaderProgram program) {
     const VAddr program_addr{GetShaderAddress(program)};
 
-    // Look up shader in the cache based on address
+    // VertexB is always enabled, so when VertexA is enabled, we have two vertex shaders.
+    // Conventional HW does not support this, so we combine VertexA and VertexB into one stage here.
+    std::optional<VAddr> program_b_addr;
+    if (program == Maxwell::ShaderProgram::VertexA) {
+        program_b_addr = GetShaderAddress(Maxwell::ShaderProgram::VertexB);
+    }
+
+    // Look up shader in the cache based on address. A combined shader also depends on its VertexB
+    // program, which may have been moved or written to since.
     Shader shader{TryGet(program_addr)};
+    if (shader && !shader->IsProgramBCurrent(program_b_addr)) {
+        Unregister(shader);
+        shader = nullptr;
+    }
 
     if (!shader) {
-        // No shader found - create a new one
-        shader = std::make_shared<CachedShader>(program_addr, program);
+        // No shader found - create a new one, reusing the program of any shader with the same code
+        GLShader::ShaderSetup setup{GetShaderCode(program_addr)};
+        ProgramB program_b;
+        if (program_b_addr) {
+            setup.SetProgramB(GetShaderCode(*program_b_addr));
+            program_b = program_b_cache.Get(*program_b_addr,
+                                            CalculateProgramSize(setup.program.code_b));
+        }
+
+        // Only the words of the program are registered, writes after it don't invalidate it
+        const std::size_t size{CalculateProgramSize(setup.program.code)};
+
+        const u64 unique_identifier{GetUniqueIdentifier(program, setup)};
+        auto& cached_program{programs[unique_identifier]};
+        if (!cached_program) {
+            cached_program = QueueProgram(unique_identifier, program, std::move(setup));
+        }
+
+        shader = std::make_shared<CachedShader>(program_addr, size, program, cached_program,
+                                                std::move(program_b));
         Register(shader);
     }
 
     return shader;
 }
 
+void ShaderCacheOpenGL::InvalidateRegion(VAddr addr, u64 size) {
+    RasterizerCache<Shader>::InvalidateRegion(addr, size);
+
+    // Shaders combining an invalidated VertexB program are dropped once they're looked up again
+    program_b_cache.InvalidateRegion(addr, size);
+}
+
+void ShaderCacheOpenGL::OnUnregister(const Shader& shader) {
+    if (const ProgramB& program_b = shader->GetProgramB()) {
+        program_b_cache.Release(program_b);
+    }
+}
+
+bool ShaderCacheOpenGL::PrepareStagePrograms() {
+    build_queue.Collect();
+
+    // Getting the shaders of all the stages first queues all their new programs at once
+    const auto& regs = Core::System::GetInstance().GPU().Maxwell3D().regs;
+    bool all_built = true;
+    for (std::size_t index = 0; index < Maxwell::MaxShaderProgram; ++index) {
+        if (!regs.IsShaderConfigEnabled(index)) {
+            continue;
+        }
+        const auto program = static_cast<Maxwell::ShaderProgram>(index);
+        all_built &= GetStageProgram(program)->IsBuilt();
+        if (program == Maxwell::ShaderProgram::VertexA) {
+            // VertexB was combined with VertexA
+            ++index;
+        }
+    }
+    if (all_built) {
+        return true;
+    }
+
+    if (asynchronous) {
+        build_queue.RecordSkippedDraw();
+        return false;
+    }
+    build_queue.WaitAll();
+    return true;
+}
+
+ShaderBuildStatistics ShaderCacheOpenGL::GetStatistics() const {
+    return build_queue.GetStatistics();
+}
+
+void ShaderCacheOpenGL::LoadDiskCache(u64 title_id,
+                                      const VideoCore::DiskResourceLoadCallback& callback) {
+    if (!Settings::values.use_disk_shader_cache || title_id == 0) {
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    if (callback) {
+        callback(VideoCore::LoadCallbackStage::Prepare, 0, 0);
+    }
+
+    const std::string cache_dir{FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) +
+                                "shader" DIR_SEP "opengl"};
+    disk_cache.emplace(cache_dir, title_id);
+    save_binaries = ShaderDiskCacheOpenGL::AreBinariesSupported();
+    const auto decompiled_shaders = disk_cache->LoadDecompiled();
+    const auto binaries = disk_cache->LoadBinaries();
+
+    // Binaries are kept as long as the driver accepts all of them. Otherwise, the binaries of every
+    // program are saved again once they've all been built.
+    bool binaries_rejected = false;
+    std::size_t num_from_binaries = 0;
+    for (std::size_t i = 0; i < decompiled_shaders.size(); ++i) {
+        if (callback) {
+            callback(VideoCore::LoadCallbackStage::Build, i, decompiled_shaders.size());
+        }
+
+        const auto& decompiled = decompiled_shaders[i];
+        auto program = std::make_shared<CachedProgram>();
+        program->code = decompiled.code;
+        program->entries = decompiled.entries;
+
+        if (decompiled.program_type != Maxwell::ShaderProgram::Geometry) {
+            const auto binary = binaries.find(decompiled.unique_identifier);
+            if (binary != binaries.end() && LoadProgramBinary(*program, binary->second)) {
+                ++num_from_binaries;
+            } else {
+                binaries_rejected |= binary != binaries.end();
+                LinkProgram(*program, decompiled.program_type, save_binaries);
+                if (save_binaries && !binaries_rejected) {
+                    disk_cache->SaveBinary(decompiled.unique_identifier, program->program.handle);
+                }
+            }
+        }
+        programs.emplace(decompiled.unique_identifier, std::move(program));
+    }
+
+    if (binaries_rejected) {
+        LOG_WARNING(Render_OpenGL, "The driver rejected cached program binaries, rebuilding them");
+        disk_cache->InvalidateBinaries();
+        for (const auto& [unique_identifier, program] : programs) {
+            if (program->program.handle != 0) {
+                disk_cache->SaveBinary(unique_identifier, program->program.handle);
+            }
+        }
+    }
+
+    if (callback) {
+        callback(VideoCore::LoadCallbackStage::Complete, decompiled_shaders.size(),
+                 decompiled_shaders.size());
+    }
+    LOG_INFO(Render_OpenGL, "Loaded {} shaders from the disk cache ({} from binaries) in {} ms",
+             decompiled_shaders.size(), num_from_binaries,
+             std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::steady_clock::now() - start)
+                 .count());
+}
+
+std::shared_ptr<const CachedProgram> ShaderCacheOpenGL::QueueProgram(
+    u64 unique_identifier, Maxwell::ShaderProgram program_type, GLShader::ShaderSetup setup) {
+    auto program = std::make_shared<CachedProgram>();
+    auto decompiled = Common::GetSharedThreadPool().Submit(
+        [program, program_type, setup = std::move(setup)] {
+            auto [code, entries] = DecompileProgram(program_type, setup);
+            program->code = std::move(code);
+            program->entries = std::move(entries);
+        });
+    build_queue.Queue(unique_identifier, program_type, program, std::move(decompiled));
+    return program;
+}
+
+std::future<void> ShaderCacheOpenGL::StartLink(const std::shared_ptr<CachedProgram>& program,
+                                               Maxwell::ShaderProgram program_type) {
+    const bool hint_retrievable = disk_cache && save_binaries;
+    if (link_thread && program_type != Maxwell::ShaderProgram::Geometry) {
+        return link_thread->QueueLink(program, program_type, hint_retrievable);
+    }
+
+    LinkProgram(*program, program_type, hint_retrievable);
+    std::promise<void> linked;
+    linked.set_value();
+    return linked.get_future();
+}
+
+void ShaderCacheOpenGL::SaveBuiltProgram(u64 unique_identifier,
+                                         Maxwell::ShaderProgram program_type,
+                                         const CachedProgram& program) {
+    if (!disk_cache) {
+        return;
+    }
+    disk_cache->SaveDecompiled({unique_identifier, program_type, program.code, program.entries});
+    if (save_binaries && program.program.handle != 0) {
+        disk_cache->SaveBinary(unique_identifier, program.program.handle);
+    }
+}
+
 } // namespace OpenGL
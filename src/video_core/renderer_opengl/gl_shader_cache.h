@@ -4,45 +4,137 @@
 
 #pragma once
 
+#include <future>
 #include <map>
 #include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "video_core/rasterizer_cache.h"
+#include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_shader_build_queue.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
 #include "video_core/renderer_opengl/gl_shader_gen.h"
 
+namespace Core::Frontend {
+class EmuWindow;
+}
+
 namespace OpenGL {
 
 class CachedShader;
+class ShaderLinkThread;
 using Shader = std::shared_ptr<CachedShader>;
 using Maxwell = Tegra::Engines::Maxwell3D::Regs;
 
+/**
+ * Returns the offset of the instruction terminating a program, which is the branch to itself that
+ * follows its last instruction or the first empty instruction, searching the words in [begin, end).
+ * @returns The terminating offset, or end if the program goes on.
+ */
+std::size_t FindProgramEnd(const GLShader::ProgramCode& program, std::size_t begin,
+                           std::size_t end);
+
+/// Returns the size in bytes of a program, up to the branch to itself that follows its last
+/// instruction, or up to the first empty instruction.
+std::size_t CalculateProgramSize(const GLShader::ProgramCode& program);
+
+/**
+ * Gets the shader program code from memory for the specified address. Memory is read in chunks
+ * until the end of the program is found, the words after it are left empty.
+ */
+GLShader::ProgramCode GetShaderCode(VAddr addr);
+
+/**
+ * Guest memory of a VertexB program combined into VertexA shaders. It is registered in a cache of
+ * its own, so that writes to it are seen without lookups of VertexB shaders ever finding it.
+ */
+class CachedProgramB final : public RasterizerCacheObject {
+    friend class ProgramBCache;
+
+public:
+    CachedProgramB(VAddr addr, std::size_t size) : addr{addr}, size{size} {}
+
+    VAddr GetAddr() const override {
+        return addr;
+    }
+
+    std::size_t GetSizeInBytes() const override {
+        return size;
+    }
+
+    // Programs are never modified by us.
+    void Flush() override {}
+
+private:
+    VAddr addr;
+    std::size_t size;
+    /// Number of registered shaders combining the program, see ProgramBCache
+    std::size_t num_shaders{};
+};
+using ProgramB = std::shared_ptr<CachedProgramB>;
+
 class CachedShader final : public RasterizerCacheObject {
 public:
-    CachedShader(VAddr addr, Maxwell::ShaderProgram program_type);
+    /**
+     * @param addr Address of the program in guest memory
+     * @param size Size in bytes of the program, up to its terminating instruction
+     * @param program_type Stage the program is used in
+     * @param cached_program Program built from the code, shared with all the shaders with the
+     *                       same code
+     * @param program_b VertexB program combined into the program of a VertexA shader
+     */
+    CachedShader(VAddr addr, std::size_t size, Maxwell::ShaderProgram program_type,
+                 std::shared_ptr<const CachedProgram> cached_program,
+                 ProgramB program_b = nullptr);
 
     VAddr GetAddr() const override {
         return addr;
     }
 
     std::size_t GetSizeInBytes() const override {
-        return GLShader::MAX_PROGRAM_CODE_LENGTH * sizeof(u64);
+        return size;
     }
 
     // We do not have to flush this cache as things in it are never modified by us.
     void Flush() override {}
 
+    /**
+     * Returns true if the shader combines the VertexB program at the given address, and it hasn't
+     * been written to since. Shaders without a VertexB program only match an empty address.
+     */
+    bool IsProgramBCurrent(std::optional<VAddr> program_b_addr) const {
+        if (!program_b) {
+            return !program_b_addr;
+        }
+        return program_b_addr && program_b->IsRegistered() &&
+               program_b->GetAddr() == *program_b_addr;
+    }
+
+    /// Gets the VertexB program combined into the shader, if any
+    const ProgramB& GetProgramB() const {
+        return program_b;
+    }
+
+    /// Returns true if the program of the shader can be used, it may still be built in background
+    bool IsBuilt() const {
+        return cached_program->is_built.load(std::memory_order_acquire);
+    }
+
     /// Gets the shader entries for the shader
     const GLShader::ShaderEntries& GetShaderEntries() const {
-        return entries;
+        return cached_program->entries;
     }
 
     /// Gets the GL program handle for the shader
     GLuint GetProgramHandle(GLenum primitive_mode) {
         if (program_type != Maxwell::ShaderProgram::Geometry) {
-            return program.handle;
+            return cached_program->program.handle;
         }
         switch (primitive_mode) {
         case GL_POINTS:
@@ -79,18 +171,15 @@ private:
                                const std::string& debug_name);
 
     VAddr addr;
+    std::size_t size;
     Maxwell::ShaderProgram program_type;
-    GLShader::ShaderSetup setup;
-    GLShader::ShaderEntries entries;
-
-    // Non-geometry program.
-    OGLProgram program;
+    std::shared_ptr<const CachedProgram> cached_program;
+    ProgramB program_b;
 
     // Geometry programs. These are needed because GLSL needs an input topology but it's not
     // declared by the hardware. Workaround this issue by generating a different shader per input
     // topology class.
     struct {
-        std::string code;
         OGLProgram points;
         OGLProgram lines;
         OGLProgram lines_adjacency;
@@ -102,10 +191,95 @@ private:
     std::map<u32, GLint> uniform_cache;
 };
 
+/// Cache of the VertexB programs combined into VertexA shaders
+class ProgramBCache final : public RasterizerCache<ProgramB> {
+public:
+    explicit ProgramBCache(VideoCore::RasterizerInterface& rasterizer);
+
+    /**
+     * Gets the VertexB program at the given address for a new shader combining it, registering it
+     * with the given size unless it is already registered. A registered program hasn't been written
+     * to, so its size still holds.
+     */
+    ProgramB Get(VAddr addr, std::size_t size);
+
+    /// Releases a program gotten for a shader that was unregistered since, the program is
+    /// unregistered once no shader combines it anymore
+    void Release(const ProgramB& program_b);
+};
+
 class ShaderCacheOpenGL final : public RasterizerCache<Shader> {
 public:
-    /// Gets the current specified shader stage program
+    /**
+     * Creates the cache, which requires the GL context of the window to be current. With
+     * asynchronous shaders, programs are linked on a context shared with it if the frontend
+     * supports it.
+     */
+    explicit ShaderCacheOpenGL(VideoCore::RasterizerInterface& rasterizer,
+                               Core::Frontend::EmuWindow& emu_window);
+    ~ShaderCacheOpenGL();
+
+    /// Gets the current specified shader stage program, its program may not be built yet
     Shader GetStageProgram(Maxwell::ShaderProgram program);
+
+    /**
+     * Invalidates the shaders in the region. Shaders combining a VertexB program in the region are
+     * dropped the next time they're looked up.
+     */
+    void InvalidateRegion(VAddr addr, u64 size);
+
+    /**
+     * Gets the programs of the enabled shader stages ready for a draw. New programs are decompiled
+     * in parallel on worker threads. With asynchronous shaders, this doesn't wait for them.
+     * @returns False if the draw has to be skipped because its programs are still being built
+     */
+    bool PrepareStagePrograms();
+
+    /// Returns the counters of the programs built since the title started
+    ShaderBuildStatistics GetStatistics() const;
+
+    /**
+     * Loads and builds the shaders the title used in previous runs, and saves the shaders it uses
+     * from now on to the disk cache. Does nothing if the disk cache is disabled.
+     */
+    void LoadDiskCache(u64 title_id, const VideoCore::DiskResourceLoadCallback& callback);
+
+private:
+    /// Releases the VertexB program of the unregistered shader
+    void OnUnregister(const Shader& shader) override;
+
+    /// Queues a program to be decompiled on a worker thread, it's built once it's collected
+    std::shared_ptr<const CachedProgram> QueueProgram(u64 unique_identifier,
+                                                      Maxwell::ShaderProgram program_type,
+                                                      GLShader::ShaderSetup setup);
+
+    /**
+     * Links a decompiled program, on the link thread if there's one and it can link it.
+     * @returns A future that is ready once the program is linked
+     */
+    std::future<void> StartLink(const std::shared_ptr<CachedProgram>& program,
+                                Maxwell::ShaderProgram program_type);
+
+    /// Saves a program built in the background to the disk cache
+    void SaveBuiltProgram(u64 unique_identifier, Maxwell::ShaderProgram program_type,
+                          const CachedProgram& program);
+
+    /// VertexB programs combined into VertexA shaders, which are invalidated along with them
+    ProgramBCache program_b_cache;
+
+    /// Programs by the hash of their code, see GetUniqueIdentifier
+    std::unordered_map<u64, std::shared_ptr<const CachedProgram>> programs;
+
+    /// Thread linking programs on a shared context, only with asynchronous shaders
+    std::unique_ptr<ShaderLinkThread> link_thread;
+
+    ShaderBuildQueue build_queue;
+    /// Whether draws are skipped instead of waiting for their programs to be built
+    bool asynchronous;
+
+    std::optional<ShaderDiskCacheOpenGL> disk_cache;
+    /// Whether the binaries of the programs built are saved to the disk cache
+    bool save_binaries{};
 };
 
 } // namespace OpenGL
@@ -2,10 +2,17 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cmath>
+#include <cstring>
 #include <map>
+#include <optional>
 #include <set>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <boost/optional.hpp>
 #include <fmt/format.h>
@@ -54,6 +61,134 @@ static std::string GetTopologyName(Tegra::Shader::OutputTopology topology) {
     }
 }
 
+/// Returns true if the character can be part of a GLSL identifier.
+static bool IsIdentifierCharacter(char character) {
+    return (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z') ||
+           (character >= '0' && character <= '9') || character == '_';
+}
+
+/// Removes the parentheses that enclose the whole expression, if any.
+static std::string_view StripParentheses(std::string_view expression) {
+    while (expression.size() >= 2 && expression.front() == '(' && expression.back() == ')') {
+        int depth = 0;
+        std::size_t close = 0;
+        for (; close < expression.size(); ++close) {
+            if (expression[close] == '(') {
+                ++depth;
+            } else if (expression[close] == ')' && --depth == 0) {
+                break;
+            }
+        }
+        if (close != expression.size() - 1) {
+            break;
+        }
+        expression = expression.substr(1, expression.size() - 2);
+    }
+    return expression;
+}
+
+/// Returns true if the expression can be operated on without enclosing it in parentheses.
+static bool IsSimpleExpression(std::string_view expression) {
+    if (StripParentheses(expression).size() != expression.size()) {
+        return true;
+    }
+    return std::all_of(expression.begin(), expression.end(), [](char character) {
+        return IsIdentifierCharacter(character) || character == '.';
+    });
+}
+
+/**
+ * Returns the GLSL literal of the float with the given bits, or an empty string if there's none
+ * that is bit exact (e.g. NaNs, infinities, denormals that drivers might flush, and -0).
+ */
+static std::string GetFloatLiteral(u32 bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    if (!std::isfinite(value) || (value != 0.0f && !std::isnormal(value)) ||
+        (value == 0.0f && std::signbit(value))) {
+        return {};
+    }
+
+    // Nine significant digits are always enough for a float to round trip.
+    std::string literal = fmt::format("{:.9g}", value);
+    if (literal.find_first_not_of("0123456789.e+-") != std::string::npos) {
+        // The decimal separator depends on the locale of the host.
+        return {};
+    }
+    if (literal.find_first_of(".e") == std::string::npos) {
+        literal += ".0";
+    }
+    // Callers negate operands with a leading '-', which can't be followed by another one.
+    return value < 0.0f ? '(' + literal + ')' : literal;
+}
+
+/**
+ * Generates code that reinterprets the bits of a value with one of the GLSL bitcast functions
+ * (e.g. floatBitsToInt). The bitcast cancels out with the one the value comes from, if any, and is
+ * folded into literals when possible.
+ * @param func Bitcast function to use.
+ * @param value Code of the value to reinterpret.
+ * @returns GLSL string corresponding to the reinterpreted value.
+ */
+static std::string Bitcast(std::string_view func, const std::string& value) {
+    enum class Kind { Float, Int, Uint };
+    struct BitcastFunction {
+        std::string_view name;
+        Kind from;
+        Kind to;
+    };
+    static constexpr std::array<BitcastFunction, 4> functions{{
+        {"floatBitsToInt", Kind::Float, Kind::Int},
+        {"floatBitsToUint", Kind::Float, Kind::Uint},
+        {"intBitsToFloat", Kind::Int, Kind::Float},
+        {"uintBitsToFloat", Kind::Uint, Kind::Float},
+    }};
+    const auto find_function = [](std::string_view name) {
+        return std::find_if(functions.begin(), functions.end(),
+                            [name](const auto& function) { return function.name == name; });
+    };
+    const auto outer = find_function(func);
+    ASSERT(outer != functions.end());
+
+    const std::string_view operand = StripParentheses(value);
+    const auto wrap = [](std::string_view expression) {
+        if (IsSimpleExpression(expression)) {
+            return std::string(expression);
+        }
+        return '(' + std::string(expression) + ')';
+    };
+
+    const std::size_t call = operand.find('(');
+    if (call != std::string_view::npos && operand.back() == ')' &&
+        StripParentheses(operand.substr(call)).size() == operand.size() - call - 2) {
+        const auto inner = find_function(operand.substr(0, call));
+        if (inner != functions.end() && inner->to == outer->from) {
+            const std::string_view argument = operand.substr(call + 1, operand.size() - call - 2);
+            if (inner->from == outer->to) {
+                return wrap(argument);
+            }
+            if (outer->to != Kind::Float && inner->from != Kind::Float) {
+                // Conversions between signed and unsigned integers keep the bits as they are
+                return std::string(outer->to == Kind::Int ? "int" : "uint") + '(' +
+                       std::string(argument) + ')';
+            }
+        }
+    }
+
+    if (outer->to == Kind::Float && !operand.empty() &&
+        operand.find_first_not_of("0123456789") == std::string_view::npos && operand.size() <= 10) {
+        const u64 bits = std::stoull(std::string(operand));
+        if (bits <= 0xFFFFFFFF) {
+            std::string literal = GetFloatLiteral(static_cast<u32>(bits));
+            if (!literal.empty()) {
+                return literal;
+            }
+        }
+    }
+
+    return std::string(func) + '(' + std::string(operand) + ')';
+}
+
 /// Describes the behaviour of code path of a given entry point and a return point.
 enum class ExitMethod {
     Undetermined, ///< Internal value. Only occur when analyzing JMP loop.
@@ -74,6 +209,7 @@ struct Subroutine {
     const std::string& suffix; ///< Suffix of the shader, used to make a unique subroutine name
     ExitMethod exit_method;    ///< Exit method of the subroutine.
     std::set<u32> labels;      ///< Addresses refereced by JMP instructions.
+    bool uses_flow_stack;      ///< Whether SYNC or BRK instructions jump to a SSY or PBK target.
 
     bool operator<(const Subroutine& rhs) const {
         return std::tie(begin, end) < std::tie(rhs.begin, rhs.end);
@@ -103,18 +239,25 @@ private:
 
     /// Adds and analyzes a new subroutine if it is not added yet.
     const Subroutine& AddSubroutine(u32 begin, u32 end, const std::string& suffix) {
-        Subroutine subroutine{begin, end, suffix, ExitMethod::Undetermined, {}};
+        Subroutine subroutine{begin, end, suffix, ExitMethod::Undetermined, {}, false};
 
         const auto iter = subroutines.find(subroutine);
         if (iter != subroutines.end()) {
             return *iter;
         }
 
-        subroutine.exit_method = Scan(begin, end, subroutine.labels);
+        std::set<u32> flow_stack_labels;
+        subroutine.exit_method = Scan(begin, end, subroutine, flow_stack_labels);
         if (subroutine.exit_method == ExitMethod::Undetermined) {
             throw DecompileFail("Recursive function detected");
         }
 
+        // SSY and PBK targets are only ever jumped to by popping them with SYNC or BRK. Without
+        // them, neither the flow stack nor the labels of its targets are needed.
+        if (subroutine.uses_flow_stack) {
+            subroutine.labels.insert(flow_stack_labels.begin(), flow_stack_labels.end());
+        }
+
         return *subroutines.insert(std::move(subroutine)).first;
     }
 
@@ -133,7 +276,7 @@ private:
     }
 
     /// Scans a range of code for labels and determines the exit method.
-    ExitMethod Scan(u32 begin, u32 end, std::set<u32>& labels) {
+    ExitMethod Scan(u32 begin, u32 end, Subroutine& subroutine, std::set<u32>& flow_stack_labels) {
         const auto [iter, inserted] =
             exit_method_map.emplace(std::make_pair(begin, end), ExitMethod::Undetermined);
         ExitMethod& exit_method = iter->second;
@@ -152,15 +295,16 @@ private:
                     if (instr.pred.pred_index == static_cast<u64>(Pred::UnusedIndex)) {
                         return exit_method = ExitMethod::AlwaysEnd;
                     } else {
-                        const ExitMethod not_met = Scan(offset + 1, end, labels);
+                        const ExitMethod not_met =
+                            Scan(offset + 1, end, subroutine, flow_stack_labels);
                         return exit_method = ParallelExit(ExitMethod::AlwaysEnd, not_met);
                     }
                 }
                 case OpCode::Id::BRA: {
                     const u32 target = offset + instr.bra.GetBranchTarget();
-                    labels.insert(target);
-                    const ExitMethod no_jmp = Scan(offset + 1, end, labels);
-                    const ExitMethod jmp = Scan(target, end, labels);
+                    subroutine.labels.insert(target);
+                    const ExitMethod no_jmp = Scan(offset + 1, end, subroutine, flow_stack_labels);
+                    const ExitMethod jmp = Scan(target, end, subroutine, flow_stack_labels);
                     return exit_method = ParallelExit(no_jmp, jmp);
                 }
                 case OpCode::Id::SSY:
@@ -169,10 +313,15 @@ private:
                     ASSERT_MSG(instr.bra.constant_buffer == 0,
                                "Constant buffer branching is not supported");
                     const u32 target = offset + instr.bra.GetBranchTarget();
-                    labels.insert(target);
+                    flow_stack_labels.insert(target);
                     // Continue scanning for an exit method.
                     break;
                 }
+                case OpCode::Id::SYNC:
+                case OpCode::Id::BRK: {
+                    subroutine.uses_flow_stack = true;
+                    break;
+                }
                 }
             }
         }
@@ -180,15 +329,169 @@ private:
     }
 };
 
+enum class InternalFlag : u64 {
+    ZeroFlag = 0,
+    CarryFlag = 1,
+    OverflowFlag = 2,
+    NaNFlag = 3,
+    Amount
+};
+
+/**
+ * Tracks how the variables of the generated code (registers, predicates and internal flags) are
+ * used, to leave out the writes to variables that are never read. The generator records the
+ * variables it reads as it gets them, and the variable each assignment writes, then all the dead
+ * assignments are found at once, chains of them included, before the code is output.
+ *
+ * The code of a read may be reused by several statements of the instruction it was generated for,
+ * so each statement is considered to read everything its instruction read before it was added.
+ *
+ * It also records whether registers are accessed as floats or as integers, so that the registers
+ * only ever accessed as integers can be declared as such in a second generation of the program.
+ */
+class ShaderUsage {
+public:
+    using VariableId = std::size_t;
+
+    static constexpr std::size_t NumPredicates = 8;
+    static constexpr std::size_t NumInternalFlags = static_cast<std::size_t>(InternalFlag::Amount);
+    static constexpr std::size_t NumVariables =
+        Register::NumRegisters + NumPredicates + NumInternalFlags;
+
+    static constexpr VariableId GetRegisterId(std::size_t index) {
+        return index;
+    }
+
+    static constexpr VariableId GetPredicateId(std::size_t index) {
+        return Register::NumRegisters + index;
+    }
+
+    static constexpr VariableId GetInternalFlagId(InternalFlag flag) {
+        return Register::NumRegisters + NumPredicates + static_cast<std::size_t>(flag);
+    }
+
+    /// Starts the code of a new instruction, the reads recorded until then no longer apply.
+    void BeginInstruction() {
+        instruction_begin = reads.size();
+    }
+
+    /// Records that the code of the current instruction reads a variable.
+    void RecordRead(VariableId variable) {
+        reads.push_back(variable);
+    }
+
+    /**
+     * Records a statement, which is an assignment when it writes a variable.
+     * @returns The index of the statement, to check whether it's live once resolved.
+     */
+    std::size_t RecordStatement(std::optional<VariableId> written_variable) {
+        statements.push_back({instruction_begin, reads.size(), written_variable});
+        return statements.size() - 1;
+    }
+
+    /// Records whether a register was accessed as a float or as an integer.
+    void RecordRegisterAccess(std::size_t index, bool as_integer) {
+        (as_integer ? integer_accesses : float_accesses).set(index);
+    }
+
+    /**
+     * Finds the live variables and statements: statements that aren't assignments are live, as
+     * well as assignments to variables read by live statements.
+     */
+    void Resolve() {
+        std::array<std::vector<std::size_t>, NumVariables> assignments;
+        std::vector<VariableId> pending_variables;
+        const auto mark_reads = [&](const Statement& statement) {
+            for (std::size_t read = statement.reads_begin; read < statement.reads_end; ++read) {
+                const VariableId variable = reads[read];
+                if (!live_variables.test(variable)) {
+                    live_variables.set(variable);
+                    pending_variables.push_back(variable);
+                }
+            }
+        };
+
+        live_statements.assign(statements.size(), false);
+        for (std::size_t index = 0; index < statements.size(); ++index) {
+            const Statement& statement = statements[index];
+            if (statement.written_variable) {
+                assignments[*statement.written_variable].push_back(index);
+            } else {
+                live_statements[index] = true;
+                mark_reads(statement);
+            }
+        }
+
+        while (!pending_variables.empty()) {
+            const VariableId variable = pending_variables.back();
+            pending_variables.pop_back();
+            for (const std::size_t index : assignments[variable]) {
+                if (!live_statements[index]) {
+                    live_statements[index] = true;
+                    mark_reads(statements[index]);
+                }
+            }
+        }
+    }
+
+    /// Returns true if the statement has to be kept, once resolved.
+    bool IsStatementLive(std::size_t index) const {
+        return live_statements[index];
+    }
+
+    /// Returns true if a live statement reads the variable, which then has to be declared.
+    bool IsVariableLive(VariableId variable) const {
+        return live_variables.test(variable);
+    }
+
+    /// Returns true if the register is only ever accessed as an integer.
+    bool IsIntegerRegister(std::size_t index) const {
+        return integer_accesses.test(index) && !float_accesses.test(index);
+    }
+
+    /// Returns true if some registers are only ever accessed as integers.
+    bool HasIntegerRegisters() const {
+        return (integer_accesses & ~float_accesses).any();
+    }
+
+private:
+    struct Statement {
+        std::size_t reads_begin;
+        std::size_t reads_end;
+        std::optional<VariableId> written_variable;
+    };
+
+    std::vector<VariableId> reads;
+    std::vector<Statement> statements;
+    std::size_t instruction_begin = 0;
+
+    std::bitset<NumVariables> live_variables;
+    std::vector<bool> live_statements;
+    std::bitset<Register::NumRegisters> float_accesses;
+    std::bitset<Register::NumRegisters> integer_accesses;
+};
+
 class ShaderWriter {
 public:
+    /// @param usage Optional, records the statements of the code, to leave out the dead ones.
+    explicit ShaderWriter(ShaderUsage* usage = nullptr) : usage{usage} {}
+
     void AddLine(std::string_view text) {
-        DEBUG_ASSERT(scope >= 0);
-        if (!text.empty()) {
-            AppendIndentation();
+        if (usage != nullptr) {
+            usage->RecordStatement({});
+        }
+        AppendLine(text);
+    }
+
+    /// Adds a line assigning a value to a variable, which is left out if the variable is never read.
+    void AddAssignment(ShaderUsage::VariableId variable_id, std::string_view variable,
+                       const std::string& value, std::string_view swizzle = {}) {
+        const std::size_t begin = shader_source.size();
+        AppendLine(std::string(variable) + std::string(swizzle) + " = " + value + ';');
+        if (usage != nullptr) {
+            assignments.push_back({usage->RecordStatement(variable_id), begin,
+                                   shader_source.size()});
         }
-        shader_source += text;
-        AddNewLine();
     }
 
     void AddLine(char character) {
@@ -203,18 +506,52 @@ public:
         shader_source += '\n';
     }
 
+    /// Returns the code, without the dead assignments once the usage has been resolved.
     std::string GetResult() {
-        return std::move(shader_source);
+        if (assignments.empty()) {
+            return std::move(shader_source);
+        }
+
+        std::string result;
+        result.reserve(shader_source.size());
+        std::size_t position = 0;
+        for (const Assignment& assignment : assignments) {
+            if (usage->IsStatementLive(assignment.statement)) {
+                continue;
+            }
+            result.append(shader_source, position, assignment.begin - position);
+            position = assignment.end;
+        }
+        result.append(shader_source, position, std::string::npos);
+        return result;
     }
 
     int scope = 0;
 
 private:
+    /// Location of the line of an assignment in the code
+    struct Assignment {
+        std::size_t statement;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    void AppendLine(std::string_view text) {
+        DEBUG_ASSERT(scope >= 0);
+        if (!text.empty()) {
+            AppendIndentation();
+        }
+        shader_source += text;
+        AddNewLine();
+    }
+
     void AppendIndentation() {
         shader_source.append(static_cast<std::size_t>(scope) * 4, ' ');
     }
 
+    ShaderUsage* usage;
     std::string shader_source;
+    std::vector<Assignment> assignments;
 };
 
 /**
@@ -232,9 +569,16 @@ public:
 
     GLSLRegister(std::size_t index, const std::string& suffix) : index{index}, suffix{suffix} {}
 
-    /// Gets the GLSL type string for a register
-    static std::string GetTypeString() {
-        return "float";
+    /// Gets the GLSL type string for a register holding values of the given type
+    static std::string GetTypeString(Type type) {
+        switch (type) {
+        case Type::Integer:
+            return "int";
+        case Type::UnsignedInteger:
+            return "uint";
+        default:
+            return "float";
+        }
     }
 
     /// Gets the GLSL register prefix string, used for declarations and referencing
@@ -257,14 +601,6 @@ private:
     const std::string& suffix;
 };
 
-enum class InternalFlag : u64 {
-    ZeroFlag = 0,
-    CarryFlag = 1,
-    OverflowFlag = 2,
-    NaNFlag = 3,
-    Amount
-};
-
 /**
  * Used to manage shader registers that are emulated with GLSL. This class keeps track of the state
  * of all registers (e.g. whether they are currently being used as Floats or Integers), and
@@ -273,10 +609,17 @@ enum class InternalFlag : u64 {
  */
 class GLSLRegisterManager {
 public:
+    /**
+     * @param usage Usage of the variables gathered while generating the code.
+     * @param previous_usage Optional, usage gathered by a previous generation of the program. The
+     * types of the registers are inferred from it.
+     */
     GLSLRegisterManager(ShaderWriter& shader, ShaderWriter& declarations,
                         const Maxwell3D::Regs::ShaderStage& stage, const std::string& suffix,
-                        const Tegra::Shader::Header& header)
-        : shader{shader}, declarations{declarations}, stage{stage}, suffix{suffix}, header{header} {
+                        const Tegra::Shader::Header& header, ShaderUsage& usage,
+                        const ShaderUsage* previous_usage)
+        : shader{shader}, declarations{declarations}, stage{stage}, suffix{suffix}, header{header},
+          usage{usage}, previous_usage{previous_usage} {
         BuildRegisterList();
         BuildInputList();
     }
@@ -309,7 +652,15 @@ public:
      * @returns GLSL string corresponding to the register as a float.
      */
     std::string GetRegisterAsFloat(const Register& reg, unsigned elem = 0) {
-        return GetRegister(reg, elem);
+        if (reg == Register::ZeroIndex) {
+            return "0";
+        }
+
+        const std::size_t index = reg.GetSwizzledIndex(elem);
+        usage.RecordRegisterAccess(index, false);
+        usage.RecordRead(ShaderUsage::GetRegisterId(index));
+        const std::string& name = regs[index].GetString();
+        return IsIntegerRegister(index) ? "intBitsToFloat(" + name + ')' : name;
     }
 
     /**
@@ -322,8 +673,20 @@ public:
      */
     std::string GetRegisterAsInteger(const Register& reg, unsigned elem = 0, bool is_signed = true,
                                      Register::Size size = Register::Size::Word) {
-        const std::string func{is_signed ? "floatBitsToInt" : "floatBitsToUint"};
-        const std::string value{func + '(' + GetRegister(reg, elem) + ')'};
+        if (reg == Register::ZeroIndex) {
+            return is_signed ? "0" : "0u";
+        }
+
+        const std::size_t index = reg.GetSwizzledIndex(elem);
+        usage.RecordRegisterAccess(index, true);
+        usage.RecordRead(ShaderUsage::GetRegisterId(index));
+        const std::string& name = regs[index].GetString();
+        std::string value;
+        if (IsIntegerRegister(index)) {
+            value = is_signed ? name : "uint(" + name + ')';
+        } else {
+            value = (is_signed ? "floatBitsToInt(" : "floatBitsToUint(") + name + ')';
+        }
         return ConvertIntegerSize(value, size);
     }
 
@@ -342,7 +705,8 @@ public:
                             bool is_saturated = false, u64 dest_elem = 0) {
 
         SetRegister(reg, elem, is_saturated ? "clamp(" + value + ", 0.0, 1.0)" : value,
-                    dest_num_components, value_num_components, dest_elem);
+                    GLSLRegister::Type::Float, dest_num_components, value_num_components,
+                    dest_elem);
     }
 
     /**
@@ -363,9 +727,8 @@ public:
                               bool sets_cc = false) {
         ASSERT_MSG(!is_saturated, "Unimplemented");
 
-        const std::string func{is_signed ? "intBitsToFloat" : "uintBitsToFloat"};
-
-        SetRegister(reg, elem, func + '(' + ConvertIntegerSize(value, size) + ')',
+        SetRegister(reg, elem, ConvertIntegerSize(value, size),
+                    is_signed ? GLSLRegister::Type::Integer : GLSLRegister::Type::UnsignedInteger,
                     dest_num_components, value_num_components, dest_elem);
 
         if (sets_cc) {
@@ -391,10 +754,15 @@ public:
                                 u64 dest_elem = 0) {
         ASSERT_MSG(!is_saturated, "Unimplemented");
 
+        if (merge == Tegra::Shader::HalfMerge::H0_H1) {
+            SetRegister(reg, elem, "packHalf2x16(" + value + ')',
+                        GLSLRegister::Type::UnsignedInteger, dest_num_components,
+                        value_num_components, dest_elem);
+            return;
+        }
+
         const std::string result = [&]() {
             switch (merge) {
-            case Tegra::Shader::HalfMerge::H0_H1:
-                return "uintBitsToFloat(packHalf2x16(" + value + "))";
             case Tegra::Shader::HalfMerge::F32:
                 // Half float instructions take the first component when doing a float cast.
                 return "float(" + value + ".x)";
@@ -414,7 +782,8 @@ public:
             }
         }();
 
-        SetRegister(reg, elem, result, dest_num_components, value_num_components, dest_elem);
+        SetRegister(reg, elem, result, GLSLRegister::Type::Float, dest_num_components,
+                    value_num_components, dest_elem);
     }
 
     /**
@@ -429,14 +798,14 @@ public:
     void SetRegisterToInputAttibute(const Register& reg, u64 elem, Attribute::Index attribute,
                                     const Tegra::Shader::IpaMode& input_mode,
                                     boost::optional<Register> vertex = {}) {
-        const std::string dest = GetRegisterAsFloat(reg);
         const std::string src = GetInputAttribute(attribute, input_mode, vertex) + GetSwizzle(elem);
-        shader.AddLine(dest + " = " + src + ';');
+        SetRegister(reg, 0, src, GLSLRegister::Type::Float, 1, 1, 0);
     }
 
     std::string GetControlCode(const Tegra::Shader::ControlCode cc) const {
         switch (cc) {
         case Tegra::Shader::ControlCode::NEU:
+            usage.RecordRead(ShaderUsage::GetInternalFlagId(InternalFlag::ZeroFlag));
             return "!(" + GetInternalFlag(InternalFlag::ZeroFlag) + ')';
         default:
             LOG_CRITICAL(HW_GPU, "Unimplemented Control Code {}", static_cast<u32>(cc));
@@ -451,7 +820,7 @@ public:
     }
 
     void SetInternalFlag(const InternalFlag ii, const std::string& value) const {
-        shader.AddLine(GetInternalFlag(ii) + " = " + value + ';');
+        shader.AddAssignment(ShaderUsage::GetInternalFlagId(ii), GetInternalFlag(ii), value);
     }
 
     /**
@@ -571,20 +940,27 @@ public:
     }
 
 private:
-    /// Generates declarations for registers.
+    /// Generates declarations for the registers read by the code.
     void GenerateRegisters(const std::string& suffix) {
         for (const auto& reg : regs) {
-            declarations.AddLine(GLSLRegister::GetTypeString() + ' ' + reg.GetPrefixString() +
+            if (!usage.IsVariableLive(ShaderUsage::GetRegisterId(reg.GetIndex()))) {
+                continue;
+            }
+            const auto type = IsIntegerRegister(reg.GetIndex()) ? GLSLRegister::Type::Integer
+                                                                 : GLSLRegister::Type::Float;
+            declarations.AddLine(GLSLRegister::GetTypeString(type) + ' ' + reg.GetPrefixString() +
                                  std::to_string(reg.GetIndex()) + '_' + suffix + " = 0;");
         }
         declarations.AddNewLine();
     }
 
-    /// Generates declarations for internal flags.
+    /// Generates declarations for the internal flags read by the code.
     void GenerateInternalFlags() {
         for (u32 ii = 0; ii < static_cast<u64>(InternalFlag::Amount); ii++) {
-            const InternalFlag code = static_cast<InternalFlag>(ii);
-            declarations.AddLine("bool " + GetInternalFlag(code) + " = false;");
+            const auto flag = static_cast<InternalFlag>(ii);
+            if (usage.IsVariableLive(ShaderUsage::GetInternalFlagId(flag))) {
+                declarations.AddLine("bool " + GetInternalFlag(flag) + " = false;");
+            }
         }
         declarations.AddNewLine();
     }
@@ -683,13 +1059,10 @@ private:
         declarations.AddNewLine();
     }
 
-    /// Generates code representing a temporary (GPR) register.
-    std::string GetRegister(const Register& reg, unsigned elem) {
-        if (reg == Register::ZeroIndex) {
-            return "0";
-        }
-
-        return regs[reg.GetSwizzledIndex(elem)].GetString();
+    /// Returns true if the register is declared as an integer, which the previous generation of
+    /// the program decides from how the register is accessed.
+    bool IsIntegerRegister(std::size_t index) const {
+        return previous_usage != nullptr && previous_usage->IsIntegerRegister(index);
     }
 
     /**
@@ -697,29 +1070,47 @@ private:
      * @param reg The destination register to use.
      * @param elem The element to use for the operation.
      * @param value The code representing the value to assign.
+     * @param type The type of the value, which is bitcasted to the type of the register.
      * @param dest_num_components Number of components in the destination.
      * @param value_num_components Number of components in the value.
      * @param dest_elem Optional, the destination element to use for the operation.
      */
     void SetRegister(const Register& reg, u64 elem, const std::string& value,
-                     u64 dest_num_components, u64 value_num_components, u64 dest_elem) {
+                     GLSLRegister::Type type, u64 dest_num_components, u64 value_num_components,
+                     u64 dest_elem) {
         if (reg == Register::ZeroIndex) {
             LOG_CRITICAL(HW_GPU, "Cannot set Register::ZeroIndex");
             UNREACHABLE();
             return;
         }
 
-        std::string dest = GetRegister(reg, static_cast<u32>(dest_elem));
-        if (dest_num_components > 1) {
-            dest += GetSwizzle(elem);
-        }
+        const std::size_t index = reg.GetSwizzledIndex(static_cast<u32>(dest_elem));
+        usage.RecordRegisterAccess(index, type != GLSLRegister::Type::Float);
+        const std::string& dest = regs[index].GetString();
 
-        std::string src = '(' + value + ')';
+        std::string src = IsSimpleExpression(value) ? value : '(' + value + ')';
         if (value_num_components > 1) {
             src += GetSwizzle(elem);
         }
 
-        shader.AddLine(dest + " = " + src + ';');
+        if (IsIntegerRegister(index)) {
+            if (type == GLSLRegister::Type::Float) {
+                src = Bitcast("floatBitsToInt", src);
+            } else if (type == GLSLRegister::Type::UnsignedInteger) {
+                src = "int(" + src + ')';
+            }
+        } else if (type == GLSLRegister::Type::Integer) {
+            src = Bitcast("intBitsToFloat", src);
+        } else if (type == GLSLRegister::Type::UnsignedInteger) {
+            src = Bitcast("uintBitsToFloat", src);
+        }
+
+        if (dest_num_components <= 1 && StripParentheses(src) == dest) {
+            // The register is assigned to itself
+            return;
+        }
+        shader.AddAssignment(ShaderUsage::GetRegisterId(index), dest, src,
+                             dest_num_components > 1 ? GetSwizzle(elem) : "");
     }
 
     /// Build the GLSL register list.
@@ -870,14 +1261,22 @@ private:
     const Maxwell3D::Regs::ShaderStage& stage;
     const std::string& suffix;
     const Tegra::Shader::Header& header;
+    ShaderUsage& usage;
+    const ShaderUsage* previous_usage;
 };
 
 class GLSLGenerator {
 public:
+    /**
+     * Generates the GLSL code of a program.
+     * @param previous_usage Optional, usage of the variables found by a previous generation of the
+     * program, to infer the types of the registers from.
+     */
     GLSLGenerator(const std::set<Subroutine>& subroutines, const ProgramCode& program_code,
-                  u32 main_offset, Maxwell3D::Regs::ShaderStage stage, const std::string& suffix)
+                  u32 main_offset, Maxwell3D::Regs::ShaderStage stage, const std::string& suffix,
+                  const ShaderUsage* previous_usage)
         : subroutines(subroutines), program_code(program_code), main_offset(main_offset),
-          stage(stage), suffix(suffix) {
+          stage(stage), suffix(suffix), previous_usage(previous_usage) {
         std::memcpy(&header, program_code.data(), sizeof(Tegra::Shader::Header));
         Generate(suffix);
     }
@@ -891,6 +1290,11 @@ public:
         return {regs.GetConstBuffersDeclarations(), regs.GetSamplers()};
     }
 
+    /// Returns how the generated code uses its variables
+    const ShaderUsage& GetUsage() const {
+        return usage;
+    }
+
 private:
     /// Gets the Subroutine object corresponding to the specified address.
     const Subroutine& GetSubroutine(u32 begin, u32 end) const {
@@ -901,12 +1305,12 @@ private:
 
     /// Generates code representing a 19-bit immediate value
     static std::string GetImmediate19(const Instruction& instr) {
-        return fmt::format("uintBitsToFloat({})", instr.alu.GetImm20_19());
+        return Bitcast("uintBitsToFloat", std::to_string(instr.alu.GetImm20_19()));
     }
 
     /// Generates code representing a 32-bit immediate value
     static std::string GetImmediate32(const Instruction& instr) {
-        return fmt::format("uintBitsToFloat({})", instr.alu.GetImm20_32());
+        return Bitcast("uintBitsToFloat", std::to_string(instr.alu.GetImm20_32()));
     }
 
     /// Generates code representing a vec2 pair unpacked from a half float immediate
@@ -953,9 +1357,12 @@ private:
         // Can't assign to the constant predicate.
         ASSERT(pred != static_cast<u64>(Pred::UnusedIndex));
 
-        std::string variable = 'p' + std::to_string(pred) + '_' + suffix;
-        shader.AddLine(variable + " = " + value + ';');
-        declr_predicates.insert(std::move(variable));
+        shader.AddAssignment(ShaderUsage::GetPredicateId(pred), GetPredicate(pred), value);
+    }
+
+    /// Returns the name of the variable of a predicate.
+    std::string GetPredicate(u64 index) const {
+        return 'p' + std::to_string(index) + '_' + suffix;
     }
 
     /*
@@ -971,8 +1378,8 @@ private:
         if (index == static_cast<u64>(Pred::UnusedIndex)) {
             variable = "true";
         } else {
-            variable = 'p' + std::to_string(index) + '_' + suffix;
-            declr_predicates.insert(variable);
+            usage.RecordRead(ShaderUsage::GetPredicateId(index));
+            variable = GetPredicate(index);
         }
         if (negate) {
             return "!(" + variable + ')';
@@ -1076,7 +1483,7 @@ private:
             case Tegra::Shader::HalfType::H0_H1:
                 return "unpackHalf2x16(" + operand + ')';
             case Tegra::Shader::HalfType::F32:
-                return "vec2(uintBitsToFloat(" + operand + "))";
+                return "vec2(" + Bitcast("uintBitsToFloat", operand) + ')';
             case Tegra::Shader::HalfType::H0_H0:
             case Tegra::Shader::HalfType::H1_H1: {
                 const bool high = type == Tegra::Shader::HalfType::H1_H1;
@@ -1238,6 +1645,10 @@ private:
      * top.
      */
     void EmitPushToFlowStack(u32 target) {
+        if (!current_subroutine->uses_flow_stack) {
+            // Nothing pops the target
+            return;
+        }
         shader.AddLine('{');
         ++shader.scope;
         shader.AddLine("flow_stack[flow_stack_top] = " + std::to_string(target) + "u;");
@@ -2266,7 +2677,7 @@ private:
 
                 // Add an extra scope and declare the index register inside to prevent
                 // overwriting it in case it is used as an output of the LD instruction.
-                shader.AddLine("{");
+                shader.AddLine('{');
                 ++shader.scope;
 
                 shader.AddLine("uint index = (" + regs.GetRegisterAsInteger(instr.gpr8, 0, false) +
@@ -2296,7 +2707,7 @@ private:
                 }
 
                 --shader.scope;
-                shader.AddLine("}");
+                shader.AddLine('}');
                 break;
             }
             case OpCode::Id::ST_A: {
@@ -2420,7 +2831,7 @@ private:
                 // Add an extra scope and declare the texture coords inside to prevent
                 // overwriting them in case they are used as outputs of the texs instruction.
 
-                shader.AddLine("{");
+                shader.AddLine('{');
                 ++shader.scope;
                 shader.AddLine(coord);
                 std::string texture;
@@ -2480,7 +2891,7 @@ private:
                     regs.SetRegisterToFloat(instr.gpr0, 0, texture, 1, 1, false);
                 }
                 --shader.scope;
-                shader.AddLine("}");
+                shader.AddLine('}');
                 break;
             }
             case OpCode::Id::TEXS: {
@@ -2682,7 +3093,7 @@ private:
                     GetSampler(instr.sampler, texture_type, false, depth_compare);
                 // Add an extra scope and declare the texture coords inside to prevent
                 // overwriting them in case they are used as outputs of the texs instruction.
-                shader.AddLine("{");
+                shader.AddLine('{');
                 ++shader.scope;
                 shader.AddLine(coord);
                 const std::string texture = "textureGather(" + sampler + ", coords, " +
@@ -2701,7 +3112,7 @@ private:
                     regs.SetRegisterToFloat(instr.gpr0, 0, texture, 1, 1, false);
                 }
                 --shader.scope;
-                shader.AddLine("}");
+                shader.AddLine('}');
                 break;
             }
             case OpCode::Id::TLD4S: {
@@ -3268,7 +3679,7 @@ private:
                 ++shader.scope;
                 shader.AddLine("discard;");
                 --shader.scope;
-                shader.AddLine("}");
+                shader.AddLine('}');
 
                 break;
             }
@@ -3452,8 +3863,10 @@ private:
     u32 CompileRange(u32 begin, u32 end) {
         u32 program_counter;
         for (program_counter = begin; program_counter < (begin > end ? PROGRAM_END : end);) {
+            usage.BeginInstruction();
             program_counter = CompileInstr(program_counter);
         }
+        usage.BeginInstruction();
         return program_counter;
     }
 
@@ -3474,6 +3887,7 @@ private:
         // Add definitions for all subroutines
         for (const auto& subroutine : subroutines) {
             std::set<u32> labels = subroutine.labels;
+            current_subroutine = &subroutine;
 
             shader.AddLine("bool " + subroutine.GetName() + "() {");
             ++shader.scope;
@@ -3486,11 +3900,13 @@ private:
                 labels.insert(subroutine.begin);
                 shader.AddLine("uint jmp_to = " + std::to_string(subroutine.begin) + "u;");
 
-                // TODO(Subv): Figure out the actual depth of the flow stack, for now it seems
-                // unlikely that shaders will use 20 nested SSYs and PBKs.
-                constexpr u32 FLOW_STACK_SIZE = 20;
-                shader.AddLine("uint flow_stack[" + std::to_string(FLOW_STACK_SIZE) + "];");
-                shader.AddLine("uint flow_stack_top = 0u;");
+                if (subroutine.uses_flow_stack) {
+                    // TODO(Subv): Figure out the actual depth of the flow stack, for now it seems
+                    // unlikely that shaders will use 20 nested SSYs and PBKs.
+                    constexpr u32 FLOW_STACK_SIZE = 20;
+                    shader.AddLine("uint flow_stack[" + std::to_string(FLOW_STACK_SIZE) + "];");
+                    shader.AddLine("uint flow_stack_top = 0u;");
+                }
 
                 shader.AddLine("while (true) {");
                 ++shader.scope;
@@ -3530,6 +3946,7 @@ private:
             DEBUG_ASSERT(shader.scope == 0);
         }
 
+        usage.Resolve();
         GenerateDeclarations();
     }
 
@@ -3537,8 +3954,10 @@ private:
     void GenerateDeclarations() {
         regs.GenerateDeclarations(suffix);
 
-        for (const auto& pred : declr_predicates) {
-            declarations.AddLine("bool " + pred + " = false;");
+        for (u64 pred = 0; pred < ShaderUsage::NumPredicates; ++pred) {
+            if (usage.IsVariableLive(ShaderUsage::GetPredicateId(pred))) {
+                declarations.AddLine("bool " + GetPredicate(pred) + " = false;");
+            }
         }
         declarations.AddNewLine();
     }
@@ -3550,13 +3969,13 @@ private:
     const u32 main_offset;
     Maxwell3D::Regs::ShaderStage stage;
     const std::string& suffix;
+    const ShaderUsage* previous_usage;
+    const Subroutine* current_subroutine = nullptr;
 
-    ShaderWriter shader;
+    ShaderUsage usage;
+    ShaderWriter shader{&usage};
     ShaderWriter declarations;
-    GLSLRegisterManager regs{shader, declarations, stage, suffix, header};
-
-    // Declarations
-    std::set<std::string> declr_predicates;
+    GLSLRegisterManager regs{shader, declarations, stage, suffix, header, usage, previous_usage};
 }; // namespace OpenGL::GLShader::Decompiler
 
 std::string GetCommonDeclarations() {
@@ -3570,8 +3989,19 @@ boost::optional<ProgramResult> DecompileProgram(const ProgramCode& program_code,
     try {
         const auto subroutines =
             ControlFlowAnalyzer(program_code, main_offset, suffix).GetSubroutines();
-        GLSLGenerator generator(subroutines, program_code, main_offset, stage, suffix);
-        return ProgramResult{generator.GetShaderCode(), generator.GetEntries()};
+
+        boost::optional<GLSLGenerator> generator;
+        generator.emplace(subroutines, program_code, main_offset, stage, suffix, nullptr);
+
+        // How registers are accessed is only known once the program is generated, the programs
+        // with registers only accessed as integers are generated again to declare them as such.
+        boost::optional<ShaderUsage> usage;
+        if (generator->GetUsage().HasIntegerRegisters()) {
+            usage = generator->GetUsage();
+            generator.emplace(subroutines, program_code, main_offset, stage, suffix,
+                              usage.get_ptr());
+        }
+        return ProgramResult{generator->GetShaderCode(), generator->GetEntries()};
     } catch (const DecompileFail& exception) {
         LOG_ERROR(HW_GPU, "Shader decompilation failed: {}", exception.what());
     }
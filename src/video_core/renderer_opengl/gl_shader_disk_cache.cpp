@@ -0,0 +1,323 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <fmt/format.h>
+
+#include "common/cityhash.h"
+#include "common/common_funcs.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
+
+namespace OpenGL {
+
+constexpr u32 DISK_CACHE_MAGIC = Common::MakeMagic('Y', 'S', 'H', 'C');
+
+/// Version of the cache files. This has to be bumped whenever their layout or the output of the
+/// decompiler changes, as older shaders would otherwise be loaded as they are.
+constexpr u32 DISK_CACHE_VERSION = 2;
+
+namespace {
+
+template <typename T>
+void WriteValue(std::vector<u8>& data, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>, "Value must be trivially copyable");
+    const std::size_t offset = data.size();
+    data.resize(offset + sizeof(T));
+    std::memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+template <typename Container>
+void WriteBytes(std::vector<u8>& data, const Container& bytes) {
+    WriteValue(data, static_cast<u32>(bytes.size()));
+    data.insert(data.end(), bytes.begin(), bytes.end());
+}
+
+/// Reads values back from a cache file, each read fails once the data is exhausted
+class CacheReader {
+public:
+    CacheReader(const u8* data, std::size_t size) : data(data), size(size) {}
+
+    template <typename T>
+    bool Read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Value must be trivially copyable");
+        if (size - offset < sizeof(T))
+            return false;
+        std::memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    template <typename Container>
+    bool ReadBytes(Container& bytes) {
+        u32 length;
+        if (!Read(length) || size - offset < length)
+            return false;
+        bytes.assign(data + offset, data + offset + length);
+        offset += length;
+        return true;
+    }
+
+    std::size_t GetOffset() const {
+        return offset;
+    }
+
+    bool IsAtEnd() const {
+        return offset == size;
+    }
+
+private:
+    const u8* data;
+    std::size_t size;
+    std::size_t offset = 0;
+};
+
+std::vector<u8> SerializeDecompiled(const ShaderDiskCacheDecompiled& decompiled) {
+    std::vector<u8> data;
+    WriteValue(data, decompiled.unique_identifier);
+    WriteValue(data, static_cast<u32>(decompiled.program_type));
+    WriteBytes(data, decompiled.code);
+
+    WriteValue(data, static_cast<u32>(decompiled.entries.const_buffer_entries.size()));
+    for (const auto& entry : decompiled.entries.const_buffer_entries) {
+        WriteValue(data, static_cast<u32>(entry.GetIndex()));
+        WriteValue(data, static_cast<u32>(entry.GetSize()));
+        WriteValue(data, static_cast<u32>(entry.GetStage()));
+        WriteValue(data, static_cast<u8>(entry.IsIndirect()));
+    }
+
+    WriteValue(data, static_cast<u32>(decompiled.entries.texture_samplers.size()));
+    for (const auto& sampler : decompiled.entries.texture_samplers) {
+        WriteValue(data, static_cast<u64>(sampler.GetOffset()));
+        WriteValue(data, static_cast<u64>(sampler.GetIndex()));
+        WriteValue(data, static_cast<u32>(sampler.GetStage()));
+        WriteValue(data, static_cast<u32>(sampler.GetType()));
+        WriteValue(data, static_cast<u8>(sampler.IsArray()));
+        WriteValue(data, static_cast<u8>(sampler.IsShadow()));
+    }
+    return data;
+}
+
+bool DeserializeDecompiled(CacheReader& reader, ShaderDiskCacheDecompiled& decompiled) {
+    u32 program_type;
+    u32 num_const_buffers;
+    if (!reader.Read(decompiled.unique_identifier) || !reader.Read(program_type) ||
+        !reader.ReadBytes(decompiled.code) || !reader.Read(num_const_buffers) ||
+        program_type >= Maxwell::MaxShaderProgram) {
+        return false;
+    }
+    decompiled.program_type = static_cast<Maxwell::ShaderProgram>(program_type);
+
+    for (u32 i = 0; i < num_const_buffers; ++i) {
+        u32 index;
+        u32 size;
+        u32 stage;
+        u8 is_indirect;
+        if (!reader.Read(index) || !reader.Read(size) || !reader.Read(stage) ||
+            !reader.Read(is_indirect) || size == 0 || stage >= Maxwell::MaxShaderStage) {
+            return false;
+        }
+
+        GLShader::ConstBufferEntry entry;
+        entry.MarkAsUsed(index, size - 1, static_cast<Maxwell::ShaderStage>(stage));
+        if (is_indirect != 0)
+            entry.MarkAsUsedIndirect(index, static_cast<Maxwell::ShaderStage>(stage));
+        decompiled.entries.const_buffer_entries.push_back(entry);
+    }
+
+    u32 num_samplers;
+    if (!reader.Read(num_samplers))
+        return false;
+    for (u32 i = 0; i < num_samplers; ++i) {
+        u64 offset;
+        u64 index;
+        u32 stage;
+        u32 type;
+        u8 is_array;
+        u8 is_shadow;
+        if (!reader.Read(offset) || !reader.Read(index) || !reader.Read(stage) ||
+            !reader.Read(type) || !reader.Read(is_array) || !reader.Read(is_shadow) ||
+            stage >= Maxwell::MaxShaderStage) {
+            return false;
+        }
+        decompiled.entries.texture_samplers.emplace_back(
+            static_cast<Maxwell::ShaderStage>(stage), static_cast<std::size_t>(offset),
+            static_cast<std::size_t>(index), static_cast<Tegra::Shader::TextureType>(type),
+            is_array != 0, is_shadow != 0);
+    }
+    return true;
+}
+
+/**
+ * Reads the records of a cache file. A file with another header is deleted. A record cut short,
+ * usually because the emulator was closed while writing it, is cut off the file.
+ * @returns The records, each of them being the data of a CacheReader
+ */
+std::vector<std::vector<u8>> ReadRecords(const std::string& path, u64 header_stamp) {
+    std::vector<u8> data;
+    {
+        FileUtil::IOFile file(path, "rb");
+        if (!file.IsOpen())
+            return {};
+        data.resize(file.GetSize());
+        if (file.ReadBytes(data.data(), data.size()) != data.size()) {
+            LOG_ERROR(Render_OpenGL, "Failed to read the shader cache {}", path);
+            return {};
+        }
+    }
+
+    CacheReader reader(data.data(), data.size());
+    u32 magic{};
+    u32 version{};
+    u64 stamp{};
+    if (!reader.Read(magic) || !reader.Read(version) || !reader.Read(stamp) ||
+        magic != DISK_CACHE_MAGIC || version != DISK_CACHE_VERSION || stamp != header_stamp) {
+        LOG_INFO(Render_OpenGL, "Shader cache {} is outdated, removing it", path);
+        FileUtil::Delete(path);
+        return {};
+    }
+
+    std::vector<std::vector<u8>> records;
+    std::size_t valid_size = reader.GetOffset();
+    while (!reader.IsAtEnd()) {
+        std::vector<u8> record;
+        if (!reader.ReadBytes(record))
+            break;
+        records.push_back(std::move(record));
+        valid_size = reader.GetOffset();
+    }
+
+    if (valid_size != data.size()) {
+        LOG_WARNING(Render_OpenGL, "Shader cache {} is truncated, dropping its last record", path);
+        FileUtil::IOFile file(path, "r+b");
+        if (!file.IsOpen() || !file.Resize(valid_size)) {
+            LOG_ERROR(Render_OpenGL, "Failed to truncate the shader cache {}", path);
+            FileUtil::Delete(path);
+            return {};
+        }
+    }
+    return records;
+}
+
+} // Anonymous namespace
+
+ShaderDiskCacheOpenGL::ShaderDiskCacheOpenGL(std::string cache_dir, u64 title_id)
+    : title_id{title_id} {
+    const std::string file_name = fmt::format("{:016X}.bin", title_id);
+    transferable_path = cache_dir + DIR_SEP "transferable" DIR_SEP + file_name;
+    precompiled_path = cache_dir + DIR_SEP "precompiled" DIR_SEP + file_name;
+}
+
+std::vector<ShaderDiskCacheDecompiled> ShaderDiskCacheOpenGL::LoadDecompiled() {
+    std::vector<ShaderDiskCacheDecompiled> shaders;
+    for (const auto& record : ReadRecords(transferable_path, title_id)) {
+        CacheReader reader(record.data(), record.size());
+        ShaderDiskCacheDecompiled decompiled{};
+        if (!DeserializeDecompiled(reader, decompiled) || !reader.IsAtEnd()) {
+            LOG_ERROR(Render_OpenGL, "Shader cache {} is corrupted, removing it",
+                      transferable_path);
+            FileUtil::Delete(transferable_path);
+            InvalidateBinaries();
+            return {};
+        }
+        shaders.push_back(std::move(decompiled));
+    }
+    return shaders;
+}
+
+std::unordered_map<u64, ShaderDiskCacheBinary> ShaderDiskCacheOpenGL::LoadBinaries() {
+    if (!AreBinariesSupported())
+        return {};
+
+    std::unordered_map<u64, ShaderDiskCacheBinary> binaries;
+    for (const auto& record : ReadRecords(precompiled_path, GetDriverStamp())) {
+        CacheReader reader(record.data(), record.size());
+        u64 unique_identifier;
+        ShaderDiskCacheBinary binary{};
+        if (!reader.Read(unique_identifier) || !reader.Read(binary.format) ||
+            !reader.ReadBytes(binary.binary) || !reader.IsAtEnd()) {
+            LOG_ERROR(Render_OpenGL, "Shader cache {} is corrupted, removing it",
+                      precompiled_path);
+            InvalidateBinaries();
+            return {};
+        }
+        binaries.insert_or_assign(unique_identifier, std::move(binary));
+    }
+    return binaries;
+}
+
+void ShaderDiskCacheOpenGL::SaveDecompiled(const ShaderDiskCacheDecompiled& decompiled) {
+    if (!AppendRecord(transferable_path, title_id, SerializeDecompiled(decompiled))) {
+        LOG_ERROR(Render_OpenGL, "Failed to save shader {:016X} to {}",
+                  decompiled.unique_identifier, transferable_path);
+    }
+}
+
+void ShaderDiskCacheOpenGL::SaveBinary(u64 unique_identifier, GLuint program) {
+    if (!AreBinariesSupported())
+        return;
+
+    GLint binary_length{};
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+    if (binary_length <= 0)
+        return;
+
+    ShaderDiskCacheBinary binary{};
+    binary.binary.resize(static_cast<std::size_t>(binary_length));
+    glGetProgramBinary(program, binary_length, nullptr, &binary.format, binary.binary.data());
+
+    std::vector<u8> record;
+    WriteValue(record, unique_identifier);
+    WriteValue(record, binary.format);
+    WriteBytes(record, binary.binary);
+    if (!AppendRecord(precompiled_path, GetDriverStamp(), record)) {
+        LOG_ERROR(Render_OpenGL, "Failed to save the binary of shader {:016X} to {}",
+                  unique_identifier, precompiled_path);
+    }
+}
+
+void ShaderDiskCacheOpenGL::InvalidateBinaries() {
+    if (FileUtil::Exists(precompiled_path))
+        FileUtil::Delete(precompiled_path);
+}
+
+bool ShaderDiskCacheOpenGL::AreBinariesSupported() {
+    if (!GLAD_GL_ARB_get_program_binary)
+        return false;
+    GLint num_formats{};
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+    return num_formats > 0;
+}
+
+bool ShaderDiskCacheOpenGL::AppendRecord(const std::string& path, u64 header_stamp,
+                                         const std::vector<u8>& record) {
+    std::vector<u8> data;
+    if (!FileUtil::Exists(path)) {
+        if (!FileUtil::CreateFullPath(path))
+            return false;
+        WriteValue(data, DISK_CACHE_MAGIC);
+        WriteValue(data, DISK_CACHE_VERSION);
+        WriteValue(data, header_stamp);
+    }
+    WriteBytes(data, record);
+
+    FileUtil::IOFile file(path, "ab");
+    return file.IsOpen() && file.WriteBytes(data.data(), data.size()) == data.size();
+}
+
+u64 ShaderDiskCacheOpenGL::GetDriverStamp() {
+    std::string driver;
+    for (const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        if (const auto string = reinterpret_cast<const char*>(glGetString(name)))
+            driver += string;
+        driver += '\n';
+    }
+    return Common::CityHash64(driver.data(), driver.size());
+}
+
+} // namespace OpenGL
@@ -0,0 +1,83 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+
+#include "common/common_types.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/renderer_opengl/gl_shader_gen.h"
+
+namespace OpenGL {
+
+using Maxwell = Tegra::Engines::Maxwell3D::Regs;
+
+/// A decompiled shader stage program, which can be built by any driver
+struct ShaderDiskCacheDecompiled {
+    /// Hash of the program code and of the state it was decompiled with
+    u64 unique_identifier;
+    Maxwell::ShaderProgram program_type;
+    std::string code;
+    GLShader::ShaderEntries entries;
+};
+
+/// A program binary built from a decompiled shader, only valid for the driver that built it
+struct ShaderDiskCacheBinary {
+    GLenum format;
+    std::vector<u8> binary;
+};
+
+/**
+ * Stores the shaders of a title on disk, so that they don't have to be decompiled and built again
+ * on the next boot. The decompiled GLSL is kept in one file, the GL program binaries in another one
+ * which is discarded whenever the driver changes. Both files are only ever appended to while the
+ * title runs, a shader is saved as soon as it has been built.
+ */
+class ShaderDiskCacheOpenGL {
+public:
+    /**
+     * @param cache_dir Directory the caches of all titles are stored in
+     * @param title_id Title the shaders belong to
+     */
+    ShaderDiskCacheOpenGL(std::string cache_dir, u64 title_id);
+
+    /// Loads the decompiled shaders, dropping the cache if it's from an incompatible version
+    std::vector<ShaderDiskCacheDecompiled> LoadDecompiled();
+
+    /**
+     * Loads the program binaries, which requires the GL context to be current.
+     * @returns The binaries by unique identifier, which is empty if they were built by a different
+     *          driver or if binaries aren't supported.
+     */
+    std::unordered_map<u64, ShaderDiskCacheBinary> LoadBinaries();
+
+    /// Appends a decompiled shader to the cache
+    void SaveDecompiled(const ShaderDiskCacheDecompiled& decompiled);
+
+    /// Appends the binary of a linked program to the cache, if binaries are supported
+    void SaveBinary(u64 unique_identifier, GLuint program);
+
+    /// Removes all the binaries, after one was rejected by the driver
+    void InvalidateBinaries();
+
+    /// Returns true if the driver can retrieve program binaries
+    static bool AreBinariesSupported();
+
+private:
+    /// Opens the file for appending, writing its header first if it doesn't exist yet
+    bool AppendRecord(const std::string& path, u64 header_stamp, const std::vector<u8>& record);
+
+    /// Returns a hash identifying the driver, binaries can only be loaded by the same one
+    static u64 GetDriverStamp();
+
+    u64 title_id;
+    std::string transferable_path;
+    std::string precompiled_path;
+};
+
+} // namespace OpenGL
@@ -52,6 +52,10 @@ public:
         return max_offset + 1;
     }
 
+    Maxwell::ShaderStage GetStage() const {
+        return stage;
+    }
+
     std::string GetName() const {
         return BufferBaseNames[static_cast<std::size_t>(stage)] + std::to_string(index);
     }
@@ -97,14 +97,19 @@ static std::array<GLfloat, 3 * 2> MakeOrthographicMatrix(const float width, cons
     return matrix;
 }
 
+/// The GPU thread, when enabled, keeps the context current for the whole emulation session
+static bool IsContextShared() {
+    return Settings::values.use_multi_core && !Settings::values.use_asynchronous_gpu_emulation;
+}
+
 ScopeAcquireGLContext::ScopeAcquireGLContext(Core::Frontend::EmuWindow& emu_window_)
     : emu_window{emu_window_} {
-    if (Settings::values.use_multi_core) {
+    if (IsContextShared()) {
         emu_window.MakeCurrent();
     }
 }
 ScopeAcquireGLContext::~ScopeAcquireGLContext() {
-    if (Settings::values.use_multi_core) {
+    if (IsContextShared()) {
         emu_window.DoneCurrent();
     }
 }
@@ -16,1110 +16,523 @@
 // <http://gamma.cs.unc.edu/FasTC/>
 
 #include <algorithm>
-#include <cassert>
-#include <cstdint>
+#include <array>
 #include <cstring>
+#include <map>
+#include <mutex>
+#include <utility>
 #include <vector>
-
+#include "common/common_types.h"
+#include "common/swap.h"
+#include "common/thread_pool.h"
 #include "video_core/textures/astc.h"
 
-class BitStream {
-public:
-    explicit BitStream(unsigned char* ptr, int nBits = 0, int start_offset = 0)
-        : m_NumBits(nBits), m_CurByte(ptr), m_NextBit(start_offset % 8) {}
-
-    ~BitStream() = default;
-
-    int GetBitsWritten() const {
-        return m_BitsWritten;
-    }
-
-    void WriteBitsR(unsigned int val, unsigned int nBits) {
-        for (unsigned int i = 0; i < nBits; i++) {
-            WriteBit((val >> (nBits - i - 1)) & 1);
-        }
-    }
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#include "common/x64/cpu_detect.h"
+#include "video_core/textures/astc_avx2.h"
+#endif
 
-    void WriteBits(unsigned int val, unsigned int nBits) {
-        for (unsigned int i = 0; i < nBits; i++) {
-            WriteBit((val >> i) & 1);
-        }
-    }
-
-    int GetBitsRead() const {
-        return m_BitsRead;
-    }
-
-    int ReadBit() {
-
-        int bit = *m_CurByte >> m_NextBit++;
-        while (m_NextBit >= 8) {
-            m_NextBit -= 8;
-            m_CurByte++;
-        }
+namespace Tegra::Texture::ASTC {
 
-        m_BitsRead++;
-        return bit & 1;
-    }
+namespace {
 
-    unsigned int ReadBits(unsigned int nBits) {
-        unsigned int ret = 0;
-        for (unsigned int i = 0; i < nBits; i++) {
-            ret |= (ReadBit() & 1) << i;
-        }
-        return ret;
-    }
+/// Blocks are at most 12x12 texels.
+constexpr std::size_t MaxBlockTexels = 144;
 
-private:
-    void WriteBit(int b) {
-
-        if (done)
-            return;
+/// Blocks have at most 64 weights. The weight grids are padded with zeroes for the infill, which
+/// reads the weights right and below of the last ones, four bytes at a time.
+constexpr std::size_t WeightGridSize = 64 + 12 + 4;
 
-        const unsigned int mask = 1 << m_NextBit++;
+/// Color of the texels of blocks that can't be decoded.
+constexpr u32 ErrorColor = 0xFFFF00FF;
 
-        // clear the bit
-        *m_CurByte &= ~mask;
+/// Textures with fewer texels than this are decoded by the calling thread alone.
+constexpr std::size_t ParallelDecodeThreshold = 128 * 128;
 
-        // Write the bit, if necessary
-        if (b)
-            *m_CurByte |= mask;
+/// A 128-bit block, as two little endian words.
+struct Block {
+    u64 low;
+    u64 high;
 
-        // Next byte?
-        if (m_NextBit >= 8) {
-            m_CurByte += 1;
-            m_NextBit = 0;
+    /// Returns `count` bits starting at `position`, at most 32. Bits past the block are zero.
+    u32 Bits(u32 position, u32 count) const {
+        u64 value;
+        if (position >= 128) {
+            return 0;
+        } else if (position >= 64) {
+            value = high >> (position - 64);
+        } else if (position == 0) {
+            value = low;
+        } else {
+            value = (low >> position) | (high << (64 - position));
         }
-
-        done = done || ++m_BitsWritten >= m_NumBits;
+        return static_cast<u32>(value & ((u64{1} << count) - 1));
     }
-
-    int m_BitsWritten = 0;
-    const int m_NumBits;
-    unsigned char* m_CurByte;
-    int m_NextBit = 0;
-    int m_BitsRead = 0;
-
-    bool done = false;
 };
 
-template <typename IntType>
-class Bits {
+/// Reads consecutive fields of a block, up to a given bit after which everything reads as zero.
+class BitReader {
 public:
-    explicit Bits(const IntType& v) : m_Bits(v) {}
-
-    Bits(const Bits&) = delete;
-    Bits& operator=(const Bits&) = delete;
-
-    uint8_t operator[](uint32_t bitPos) const {
-        return static_cast<uint8_t>((m_Bits >> bitPos) & 1);
-    }
+    BitReader(const Block& block, u32 position, u32 end)
+        : block(block), position(position), end(end) {}
 
-    IntType operator()(uint32_t start, uint32_t end) const {
-        if (start == end) {
-            return (*this)[start];
-        } else if (start > end) {
-            uint32_t t = start;
-            start = end;
-            end = t;
+    u32 Read(u32 count) {
+        u32 value = 0;
+        if (position < end) {
+            value = block.Bits(position, std::min(count, end - position));
         }
-
-        uint64_t mask = (1 << (end - start + 1)) - 1;
-        return (m_Bits >> start) & mask;
+        position += count;
+        return value;
     }
 
 private:
-    const IntType& m_Bits;
+    const Block& block;
+    u32 position;
+    u32 end;
 };
 
-enum EIntegerEncoding { eIntegerEncoding_JustBits, eIntegerEncoding_Quint, eIntegerEncoding_Trit };
-
-class IntegerEncodedValue {
-private:
-    const EIntegerEncoding m_Encoding;
-    const uint32_t m_NumBits;
-    uint32_t m_BitValue;
-    union {
-        uint32_t m_QuintValue;
-        uint32_t m_TritValue;
-    };
-
-public:
-    // Jank, but we're not doing any heavy lifting in this class, so it's
-    // probably OK. It allows us to use these in std::vectors...
-    IntegerEncodedValue& operator=(const IntegerEncodedValue& other) {
-        new (this) IntegerEncodedValue(other);
-        return *this;
-    }
-
-    IntegerEncodedValue(EIntegerEncoding encoding, uint32_t numBits)
-        : m_Encoding(encoding), m_NumBits(numBits) {}
-
-    EIntegerEncoding GetEncoding() const {
-        return m_Encoding;
-    }
-    uint32_t BaseBitLength() const {
-        return m_NumBits;
-    }
-
-    uint32_t GetBitValue() const {
-        return m_BitValue;
-    }
-    void SetBitValue(uint32_t val) {
-        m_BitValue = val;
-    }
-
-    uint32_t GetTritValue() const {
-        return m_TritValue;
-    }
-    void SetTritValue(uint32_t val) {
-        m_TritValue = val;
-    }
-
-    uint32_t GetQuintValue() const {
-        return m_QuintValue;
-    }
-    void SetQuintValue(uint32_t val) {
-        m_QuintValue = val;
-    }
-
-    bool MatchesEncoding(const IntegerEncodedValue& other) const {
-        return m_Encoding == other.m_Encoding && m_NumBits == other.m_NumBits;
-    }
-
-    // Returns the number of bits required to encode nVals values.
-    uint32_t GetBitLength(uint32_t nVals) const {
-        uint32_t totalBits = m_NumBits * nVals;
-        if (m_Encoding == eIntegerEncoding_Trit) {
-            totalBits += (nVals * 8 + 4) / 5;
-        } else if (m_Encoding == eIntegerEncoding_Quint) {
-            totalBits += (nVals * 7 + 2) / 3;
-        }
-        return totalBits;
-    }
-
-    // Count the number of bits set in a number.
-    static inline uint32_t Popcnt(uint32_t n) {
-        uint32_t c;
-        for (c = 0; n; c++) {
-            n &= n - 1;
-        }
-        return c;
-    }
-
-    // Returns a new instance of this struct that corresponds to the
-    // can take no more than maxval values
-    static IntegerEncodedValue CreateEncoding(uint32_t maxVal) {
-        while (maxVal > 0) {
-            uint32_t check = maxVal + 1;
-
-            // Is maxVal a power of two?
-            if (!(check & (check - 1))) {
-                return IntegerEncodedValue(eIntegerEncoding_JustBits, Popcnt(maxVal));
-            }
+u64 ReverseBits(u64 value) {
+    value = ((value >> 1) & 0x5555555555555555) | ((value & 0x5555555555555555) << 1);
+    value = ((value >> 2) & 0x3333333333333333) | ((value & 0x3333333333333333) << 2);
+    value = ((value >> 4) & 0x0F0F0F0F0F0F0F0F) | ((value & 0x0F0F0F0F0F0F0F0F) << 4);
+    return Common::swap64(value);
+}
 
-            // Is maxVal of the type 3*2^n - 1?
-            if ((check % 3 == 0) && !((check / 3) & ((check / 3) - 1))) {
-                return IntegerEncodedValue(eIntegerEncoding_Trit, Popcnt(check / 3 - 1));
-            }
+enum class IntegerEncoding : u8 { JustBits, Trit, Quint };
 
-            // Is maxVal of the type 5*2^n - 1?
-            if ((check % 5 == 0) && !((check / 5) & ((check / 5) - 1))) {
-                return IntegerEncodedValue(eIntegerEncoding_Quint, Popcnt(check / 5 - 1));
-            }
+struct IntegerEncodingFormat {
+    IntegerEncoding encoding;
+    u32 bits;
+};
 
-            // Apparently it can't be represented with a bounded integer sequence...
-            // just iterate.
-            maxVal--;
-        }
-        return IntegerEncodedValue(eIntegerEncoding_JustBits, 0);
+/// Every encoding of bounded integer sequences (section C.2.12), by increasing range.
+constexpr std::array<IntegerEncodingFormat, 21> IntegerEncodings{{
+    {IntegerEncoding::JustBits, 1}, {IntegerEncoding::Trit, 0},     {IntegerEncoding::JustBits, 2},
+    {IntegerEncoding::Quint, 0},    {IntegerEncoding::Trit, 1},     {IntegerEncoding::JustBits, 3},
+    {IntegerEncoding::Quint, 1},    {IntegerEncoding::Trit, 2},     {IntegerEncoding::JustBits, 4},
+    {IntegerEncoding::Quint, 2},    {IntegerEncoding::Trit, 3},     {IntegerEncoding::JustBits, 5},
+    {IntegerEncoding::Quint, 3},    {IntegerEncoding::Trit, 4},     {IntegerEncoding::JustBits, 6},
+    {IntegerEncoding::Quint, 4},    {IntegerEncoding::Trit, 5},     {IntegerEncoding::JustBits, 7},
+    {IntegerEncoding::Quint, 5},    {IntegerEncoding::Trit, 6},     {IntegerEncoding::JustBits, 8},
+}};
+
+/// Returns the number of bits taken by `count` integers of the given encoding.
+constexpr u32 SequenceBitLength(const IntegerEncodingFormat& format, u32 count) {
+    switch (format.encoding) {
+    case IntegerEncoding::Trit:
+        return format.bits * count + (count * 8 + 4) / 5;
+    case IntegerEncoding::Quint:
+        return format.bits * count + (count * 7 + 2) / 3;
+    default:
+        return format.bits * count;
     }
+}
 
-    // Fills result with the values that are encoded in the given
-    // bitstream. We must know beforehand what the maximum possible
-    // value is, and how many values we're decoding.
-    static void DecodeIntegerSequence(std::vector<IntegerEncodedValue>& result, BitStream& bits,
-                                      uint32_t maxRange, uint32_t nValues) {
-        // Determine encoding parameters
-        IntegerEncodedValue val = IntegerEncodedValue::CreateEncoding(maxRange);
-
-        // Start decoding
-        uint32_t nValsDecoded = 0;
-        while (nValsDecoded < nValues) {
-            switch (val.GetEncoding()) {
-            case eIntegerEncoding_Quint:
-                DecodeQuintBlock(bits, result, val.BaseBitLength());
-                nValsDecoded += 3;
-                break;
-
-            case eIntegerEncoding_Trit:
-                DecodeTritBlock(bits, result, val.BaseBitLength());
-                nValsDecoded += 5;
-                break;
+constexpr u32 Bit(u32 value, u32 bit) {
+    return (value >> bit) & 1;
+}
 
-            case eIntegerEncoding_JustBits:
-                val.SetBitValue(bits.ReadBits(val.BaseBitLength()));
-                result.push_back(val);
-                nValsDecoded++;
-                break;
-            }
-        }
-    }
+constexpr u32 BitRange(u32 value, u32 first, u32 last) {
+    return (value >> first) & ((1U << (last - first + 1)) - 1);
+}
 
-private:
-    static void DecodeTritBlock(BitStream& bits, std::vector<IntegerEncodedValue>& result,
-                                uint32_t nBitsPerValue) {
-        // Implement the algorithm in section C.2.12
-        uint32_t m[5];
-        uint32_t t[5];
-        uint32_t T;
-
-        // Read the trit encoded block according to
-        // table C.2.14
-        m[0] = bits.ReadBits(nBitsPerValue);
-        T = bits.ReadBits(2);
-        m[1] = bits.ReadBits(nBitsPerValue);
-        T |= bits.ReadBits(2) << 2;
-        m[2] = bits.ReadBits(nBitsPerValue);
-        T |= bits.ReadBit() << 4;
-        m[3] = bits.ReadBits(nBitsPerValue);
-        T |= bits.ReadBits(2) << 5;
-        m[4] = bits.ReadBits(nBitsPerValue);
-        T |= bits.ReadBit() << 7;
-
-        uint32_t C = 0;
-
-        Bits<uint32_t> Tb(T);
-        if (Tb(2, 4) == 7) {
-            C = (Tb(5, 7) << 2) | Tb(0, 1);
-            t[4] = t[3] = 2;
+/// Trits of a block of five integers, indexed by the eight bits spread over the block.
+constexpr std::array<std::array<u8, 5>, 256> TritTable = [] {
+    std::array<std::array<u8, 5>, 256> table{};
+    for (u32 t = 0; t < 256; ++t) {
+        std::array<u32, 5> trits{};
+        u32 c = 0;
+        if (BitRange(t, 2, 4) == 7) {
+            c = (BitRange(t, 5, 7) << 2) | BitRange(t, 0, 1);
+            trits[4] = trits[3] = 2;
         } else {
-            C = Tb(0, 4);
-            if (Tb(5, 6) == 3) {
-                t[4] = 2;
-                t[3] = Tb[7];
+            c = BitRange(t, 0, 4);
+            if (BitRange(t, 5, 6) == 3) {
+                trits[4] = 2;
+                trits[3] = Bit(t, 7);
             } else {
-                t[4] = Tb[7];
-                t[3] = Tb(5, 6);
+                trits[4] = Bit(t, 7);
+                trits[3] = BitRange(t, 5, 6);
             }
         }
-
-        Bits<uint32_t> Cb(C);
-        if (Cb(0, 1) == 3) {
-            t[2] = 2;
-            t[1] = Cb[4];
-            t[0] = (Cb[3] << 1) | (Cb[2] & ~Cb[3]);
-        } else if (Cb(2, 3) == 3) {
-            t[2] = 2;
-            t[1] = 2;
-            t[0] = Cb(0, 1);
+        if (BitRange(c, 0, 1) == 3) {
+            trits[2] = 2;
+            trits[1] = Bit(c, 4);
+            trits[0] = (Bit(c, 3) << 1) | (Bit(c, 2) & ~Bit(c, 3));
+        } else if (BitRange(c, 2, 3) == 3) {
+            trits[2] = 2;
+            trits[1] = 2;
+            trits[0] = BitRange(c, 0, 1);
         } else {
-            t[2] = Cb[4];
-            t[1] = Cb(2, 3);
-            t[0] = (Cb[1] << 1) | (Cb[0] & ~Cb[1]);
+            trits[2] = Bit(c, 4);
+            trits[1] = BitRange(c, 2, 3);
+            trits[0] = (Bit(c, 1) << 1) | (Bit(c, 0) & ~Bit(c, 1));
         }
-
-        for (uint32_t i = 0; i < 5; i++) {
-            IntegerEncodedValue val(eIntegerEncoding_Trit, nBitsPerValue);
-            val.SetBitValue(m[i]);
-            val.SetTritValue(t[i]);
-            result.push_back(val);
+        for (u32 i = 0; i < 5; ++i) {
+            table[t][i] = static_cast<u8>(trits[i]);
         }
     }
-
-    static void DecodeQuintBlock(BitStream& bits, std::vector<IntegerEncodedValue>& result,
-                                 uint32_t nBitsPerValue) {
-        // Implement the algorithm in section C.2.12
-        uint32_t m[3];
-        uint32_t q[3];
-        uint32_t Q;
-
-        // Read the trit encoded block according to
-        // table C.2.15
-        m[0] = bits.ReadBits(nBitsPerValue);
-        Q = bits.ReadBits(3);
-        m[1] = bits.ReadBits(nBitsPerValue);
-        Q |= bits.ReadBits(2) << 3;
-        m[2] = bits.ReadBits(nBitsPerValue);
-        Q |= bits.ReadBits(2) << 5;
-
-        Bits<uint32_t> Qb(Q);
-        if (Qb(1, 2) == 3 && Qb(5, 6) == 0) {
-            q[0] = q[1] = 4;
-            q[2] = (Qb[0] << 2) | ((Qb[4] & ~Qb[0]) << 1) | (Qb[3] & ~Qb[0]);
+    return table;
+}();
+
+/// Quints of a block of three integers, indexed by the seven bits spread over the block.
+constexpr std::array<std::array<u8, 3>, 128> QuintTable = [] {
+    std::array<std::array<u8, 3>, 128> table{};
+    for (u32 q = 0; q < 128; ++q) {
+        std::array<u32, 3> quints{};
+        if (BitRange(q, 1, 2) == 3 && BitRange(q, 5, 6) == 0) {
+            quints[0] = quints[1] = 4;
+            quints[2] = (Bit(q, 0) << 2) | ((Bit(q, 4) & ~Bit(q, 0)) << 1) |
+                        (Bit(q, 3) & ~Bit(q, 0));
         } else {
-            uint32_t C = 0;
-            if (Qb(1, 2) == 3) {
-                q[2] = 4;
-                C = (Qb(3, 4) << 3) | ((~Qb(5, 6) & 3) << 1) | Qb[0];
+            u32 c = 0;
+            if (BitRange(q, 1, 2) == 3) {
+                quints[2] = 4;
+                c = (BitRange(q, 3, 4) << 3) | ((~BitRange(q, 5, 6) & 3) << 1) | Bit(q, 0);
             } else {
-                q[2] = Qb(5, 6);
-                C = Qb(0, 4);
+                quints[2] = BitRange(q, 5, 6);
+                c = BitRange(q, 0, 4);
             }
-
-            Bits<uint32_t> Cb(C);
-            if (Cb(0, 2) == 5) {
-                q[1] = 4;
-                q[0] = Cb(3, 4);
+            if (BitRange(c, 0, 2) == 5) {
+                quints[1] = 4;
+                quints[0] = BitRange(c, 3, 4);
             } else {
-                q[1] = Cb(3, 4);
-                q[0] = Cb(0, 2);
+                quints[1] = BitRange(c, 3, 4);
+                quints[0] = BitRange(c, 0, 2);
             }
         }
-
-        for (uint32_t i = 0; i < 3; i++) {
-            IntegerEncodedValue val(eIntegerEncoding_Quint, nBitsPerValue);
-            val.m_BitValue = m[i];
-            val.m_QuintValue = q[i];
-            result.push_back(val);
+        for (u32 i = 0; i < 3; ++i) {
+            table[q][i] = static_cast<u8>(quints[i]);
         }
     }
-};
+    return table;
+}();
 
-namespace ASTCC {
-
-struct TexelWeightParams {
-    uint32_t m_Width = 0;
-    uint32_t m_Height = 0;
-    bool m_bDualPlane = false;
-    uint32_t m_MaxWeight = 0;
-    bool m_bError = false;
-    bool m_bVoidExtentLDR = false;
-    bool m_bVoidExtentHDR = false;
-
-    uint32_t GetPackedBitSize() const {
-        // How many indices do we have?
-        uint32_t nIdxs = m_Height * m_Width;
-        if (m_bDualPlane) {
-            nIdxs *= 2;
-        }
-
-        return IntegerEncodedValue::CreateEncoding(m_MaxWeight).GetBitLength(nIdxs);
+/// Repeats the low `num_bits` bits of a value until it is `to_bit` bits wide.
+u32 Replicate(u32 value, u32 num_bits, u32 to_bit) {
+    if (num_bits == 0 || to_bit == 0) {
+        return 0;
     }
-
-    uint32_t GetNumWeightValues() const {
-        uint32_t ret = m_Width * m_Height;
-        if (m_bDualPlane) {
-            ret *= 2;
+    const u32 bits = value & ((1U << num_bits) - 1);
+    u32 result = bits;
+    u32 length = num_bits;
+    while (length < to_bit) {
+        u32 shift = 0;
+        if (num_bits > to_bit - length) {
+            const u32 new_bits = to_bit - length;
+            shift = num_bits - new_bits;
+            num_bits = new_bits;
         }
-        return ret;
+        result = (result << num_bits) | (bits >> shift);
+        length += num_bits;
     }
-};
-
-static TexelWeightParams DecodeBlockInfo(BitStream& strm) {
-    TexelWeightParams params;
+    return result;
+}
 
-    // Read the entire block mode all at once
-    uint16_t modeBits = strm.ReadBits(11);
+/// Unquantizes a color endpoint value to [0, 255], section C.2.13.
+u32 UnquantizeColorValue(const IntegerEncodingFormat& format, u32 digit, u32 bits) {
+    if (format.encoding == IntegerEncoding::JustBits) {
+        return Replicate(bits, format.bits, 8);
+    }
 
-    // Does this match the void extent block mode?
-    if ((modeBits & 0x01FF) == 0x1FC) {
-        if (modeBits & 0x200) {
-            params.m_bVoidExtentHDR = true;
-        } else {
-            params.m_bVoidExtentLDR = true;
+    const u32 a = (bits & 1) != 0 ? 0x1FF : 0;
+    u32 b = 0;
+    u32 c = 0;
+    if (format.encoding == IntegerEncoding::Trit) {
+        switch (format.bits) {
+        case 1:
+            c = 204;
+            break;
+        case 2: {
+            c = 93;
+            const u32 x = Bit(bits, 1);
+            b = (x << 8) | (x << 4) | (x << 2) | (x << 1);
+            break;
         }
-
-        // Next two bits must be one.
-        if (!(modeBits & 0x400) || !strm.ReadBit()) {
-            params.m_bError = true;
+        case 3: {
+            c = 44;
+            const u32 x = BitRange(bits, 1, 2);
+            b = (x << 7) | (x << 2) | x;
+            break;
         }
-
-        return params;
-    }
-
-    // First check if the last four bits are zero
-    if ((modeBits & 0xF) == 0) {
-        params.m_bError = true;
-        return params;
-    }
-
-    // If the last two bits are zero, then if bits
-    // [6-8] are all ones, this is also reserved.
-    if ((modeBits & 0x3) == 0 && (modeBits & 0x1C0) == 0x1C0) {
-        params.m_bError = true;
-        return params;
-    }
-
-    // Otherwise, there is no error... Figure out the layout
-    // of the block mode. Layout is determined by a number
-    // between 0 and 9 corresponding to table C.2.8 of the
-    // ASTC spec.
-    uint32_t layout = 0;
-
-    if ((modeBits & 0x1) || (modeBits & 0x2)) {
-        // layout is in [0-4]
-        if (modeBits & 0x8) {
-            // layout is in [2-4]
-            if (modeBits & 0x4) {
-                // layout is in [3-4]
-                if (modeBits & 0x100) {
-                    layout = 4;
-                } else {
-                    layout = 3;
-                }
-            } else {
-                layout = 2;
-            }
-        } else {
-            // layout is in [0-1]
-            if (modeBits & 0x4) {
-                layout = 1;
-            } else {
-                layout = 0;
-            }
+        case 4: {
+            c = 22;
+            const u32 x = BitRange(bits, 1, 3);
+            b = (x << 6) | x;
+            break;
+        }
+        case 5: {
+            c = 11;
+            const u32 x = BitRange(bits, 1, 4);
+            b = (x << 5) | (x >> 2);
+            break;
+        }
+        case 6: {
+            c = 5;
+            const u32 x = BitRange(bits, 1, 5);
+            b = (x << 4) | (x >> 4);
+            break;
         }
-    } else {
-        // layout is in [5-9]
-        if (modeBits & 0x100) {
-            // layout is in [7-9]
-            if (modeBits & 0x80) {
-                // layout is in [7-8]
-                assert((modeBits & 0x40) == 0U);
-                if (modeBits & 0x20) {
-                    layout = 8;
-                } else {
-                    layout = 7;
-                }
-            } else {
-                layout = 9;
-            }
-        } else {
-            // layout is in [5-6]
-            if (modeBits & 0x80) {
-                layout = 6;
-            } else {
-                layout = 5;
-            }
         }
-    }
-
-    assert(layout < 10);
-
-    // Determine R
-    uint32_t R = !!(modeBits & 0x10);
-    if (layout < 5) {
-        R |= (modeBits & 0x3) << 1;
-    } else {
-        R |= (modeBits & 0xC) >> 1;
-    }
-    assert(2 <= R && R <= 7);
-
-    // Determine width & height
-    switch (layout) {
-    case 0: {
-        uint32_t A = (modeBits >> 5) & 0x3;
-        uint32_t B = (modeBits >> 7) & 0x3;
-        params.m_Width = B + 4;
-        params.m_Height = A + 2;
-        break;
-    }
-
-    case 1: {
-        uint32_t A = (modeBits >> 5) & 0x3;
-        uint32_t B = (modeBits >> 7) & 0x3;
-        params.m_Width = B + 8;
-        params.m_Height = A + 2;
-        break;
-    }
-
-    case 2: {
-        uint32_t A = (modeBits >> 5) & 0x3;
-        uint32_t B = (modeBits >> 7) & 0x3;
-        params.m_Width = A + 2;
-        params.m_Height = B + 8;
-        break;
-    }
-
-    case 3: {
-        uint32_t A = (modeBits >> 5) & 0x3;
-        uint32_t B = (modeBits >> 7) & 0x1;
-        params.m_Width = A + 2;
-        params.m_Height = B + 6;
-        break;
-    }
-
-    case 4: {
-        uint32_t A = (modeBits >> 5) & 0x3;
-        uint32_t B = (modeBits >> 7) & 0x1;
-        params.m_Width = B + 2;
-        params.m_Height = A + 2;
-        break;
-    }
-
-    case 5: {
-        uint32_t A = (modeBits >> 5) & 0x3;
-        params.m_Width = 12;
-        params.m_Height = A + 2;
-        break;
-    }
-
-    case 6: {
-        uint32_t A = (modeBits >> 5) & 0x3;
-        params.m_Width = A + 2;
-        params.m_Height = 12;
-        break;
-    }
-
-    case 7: {
-        params.m_Width = 6;
-        params.m_Height = 10;
-        break;
-    }
-
-    case 8: {
-        params.m_Width = 10;
-        params.m_Height = 6;
-        break;
-    }
-
-    case 9: {
-        uint32_t A = (modeBits >> 5) & 0x3;
-        uint32_t B = (modeBits >> 9) & 0x3;
-        params.m_Width = A + 6;
-        params.m_Height = B + 6;
-        break;
-    }
-
-    default:
-        assert(!"Don't know this layout...");
-        params.m_bError = true;
-        break;
-    }
-
-    // Determine whether or not we're using dual planes
-    // and/or high precision layouts.
-    bool D = (layout != 9) && (modeBits & 0x400);
-    bool H = (layout != 9) && (modeBits & 0x200);
-
-    if (H) {
-        const uint32_t maxWeights[6] = {9, 11, 15, 19, 23, 31};
-        params.m_MaxWeight = maxWeights[R - 2];
     } else {
-        const uint32_t maxWeights[6] = {1, 2, 3, 4, 5, 7};
-        params.m_MaxWeight = maxWeights[R - 2];
-    }
-
-    params.m_bDualPlane = D;
-
-    return params;
-}
-
-static void FillVoidExtentLDR(BitStream& strm, uint32_t* const outBuf, uint32_t blockWidth,
-                              uint32_t blockHeight) {
-    // Don't actually care about the void extent, just read the bits...
-    for (int i = 0; i < 4; ++i) {
-        strm.ReadBits(13);
-    }
-
-    // Decode the RGBA components and renormalize them to the range [0, 255]
-    uint16_t r = strm.ReadBits(16);
-    uint16_t g = strm.ReadBits(16);
-    uint16_t b = strm.ReadBits(16);
-    uint16_t a = strm.ReadBits(16);
-
-    uint32_t rgba = (r >> 8) | (g & 0xFF00) | (static_cast<uint32_t>(b) & 0xFF00) << 8 |
-                    (static_cast<uint32_t>(a) & 0xFF00) << 16;
-
-    for (uint32_t j = 0; j < blockHeight; j++) {
-        for (uint32_t i = 0; i < blockWidth; i++) {
-            outBuf[j * blockWidth + i] = rgba;
+        switch (format.bits) {
+        case 1:
+            c = 113;
+            break;
+        case 2: {
+            c = 54;
+            const u32 x = Bit(bits, 1);
+            b = (x << 8) | (x << 3) | (x << 2);
+            break;
         }
-    }
-}
-
-static void FillError(uint32_t* outBuf, uint32_t blockWidth, uint32_t blockHeight) {
-    for (uint32_t j = 0; j < blockHeight; j++) {
-        for (uint32_t i = 0; i < blockWidth; i++) {
-            outBuf[j * blockWidth + i] = 0xFFFF00FF;
+        case 3: {
+            c = 26;
+            const u32 x = BitRange(bits, 1, 2);
+            b = (x << 7) | (x << 1) | (x >> 1);
+            break;
         }
-    }
-}
-
-// Replicates low numBits such that [(toBit - 1):(toBit - 1 - fromBit)]
-// is the same as [(numBits - 1):0] and repeats all the way down.
-template <typename IntType>
-static IntType Replicate(const IntType& val, uint32_t numBits, uint32_t toBit) {
-    if (numBits == 0)
-        return 0;
-    if (toBit == 0)
-        return 0;
-    IntType v = val & ((1 << numBits) - 1);
-    IntType res = v;
-    uint32_t reslen = numBits;
-    while (reslen < toBit) {
-        uint32_t comp = 0;
-        if (numBits > toBit - reslen) {
-            uint32_t newshift = toBit - reslen;
-            comp = numBits - newshift;
-            numBits = newshift;
+        case 4: {
+            c = 13;
+            const u32 x = BitRange(bits, 1, 3);
+            b = (x << 6) | (x >> 1);
+            break;
+        }
+        case 5: {
+            c = 6;
+            const u32 x = BitRange(bits, 1, 4);
+            b = (x << 5) | (x >> 3);
+            break;
         }
-        res <<= numBits;
-        res |= v >> comp;
-        reslen += numBits;
-    }
-    return res;
-}
-
-class Pixel {
-protected:
-    using ChannelType = int16_t;
-    uint8_t m_BitDepth[4] = {8, 8, 8, 8};
-    int16_t color[4] = {};
-
-public:
-    Pixel() = default;
-    Pixel(ChannelType a, ChannelType r, ChannelType g, ChannelType b, unsigned bitDepth = 8)
-        : m_BitDepth{uint8_t(bitDepth), uint8_t(bitDepth), uint8_t(bitDepth), uint8_t(bitDepth)},
-          color{a, r, g, b} {}
-
-    // Changes the depth of each pixel. This scales the values to
-    // the appropriate bit depth by either truncating the least
-    // significant bits when going from larger to smaller bit depth
-    // or by repeating the most significant bits when going from
-    // smaller to larger bit depths.
-    void ChangeBitDepth(const uint8_t (&depth)[4]) {
-        for (uint32_t i = 0; i < 4; i++) {
-            Component(i) = ChangeBitDepth(Component(i), m_BitDepth[i], depth[i]);
-            m_BitDepth[i] = depth[i];
         }
     }
+    const u32 t = (digit * c + b) ^ a;
+    return (a & 0x80) | (t >> 2);
+}
 
-    template <typename IntType>
-    static float ConvertChannelToFloat(IntType channel, uint8_t bitDepth) {
-        float denominator = static_cast<float>((1 << bitDepth) - 1);
-        return static_cast<float>(channel) / denominator;
-    }
-
-    // Changes the bit depth of a single component. See the comment
-    // above for how we do this.
-    static ChannelType ChangeBitDepth(Pixel::ChannelType val, uint8_t oldDepth, uint8_t newDepth) {
-        assert(newDepth <= 8);
-        assert(oldDepth <= 8);
-
-        if (oldDepth == newDepth) {
-            // Do nothing
-            return val;
-        } else if (oldDepth == 0 && newDepth != 0) {
-            return (1 << newDepth) - 1;
-        } else if (newDepth > oldDepth) {
-            return Replicate(val, oldDepth, newDepth);
+/// Unquantizes a texel weight to [0, 64], section C.2.17.
+u32 UnquantizeWeight(const IntegerEncodingFormat& format, u32 digit, u32 bits) {
+    u32 result = 0;
+    if (format.encoding == IntegerEncoding::JustBits) {
+        result = Replicate(bits, format.bits, 6);
+    } else if (format.bits == 0) {
+        static constexpr std::array<u32, 3> trit_weights{0, 32, 63};
+        static constexpr std::array<u32, 5> quint_weights{0, 16, 32, 47, 63};
+        result = format.encoding == IntegerEncoding::Trit ? trit_weights[digit]
+                                                          : quint_weights[digit];
+    } else {
+        const u32 a = (bits & 1) != 0 ? 0x7F : 0;
+        u32 b = 0;
+        u32 c = 0;
+        if (format.encoding == IntegerEncoding::Trit) {
+            switch (format.bits) {
+            case 1:
+                c = 50;
+                break;
+            case 2: {
+                c = 23;
+                const u32 x = Bit(bits, 1);
+                b = (x << 6) | (x << 2) | x;
+                break;
+            }
+            case 3: {
+                c = 11;
+                const u32 x = BitRange(bits, 1, 2);
+                b = (x << 5) | x;
+                break;
+            }
+            }
         } else {
-            // oldDepth > newDepth
-            if (newDepth == 0) {
-                return 0xFF;
-            } else {
-                uint8_t bitsWasted = oldDepth - newDepth;
-                uint16_t v = static_cast<uint16_t>(val);
-                v = (v + (1 << (bitsWasted - 1))) >> bitsWasted;
-                v = ::std::min<uint16_t>(::std::max<uint16_t>(0, v), (1 << newDepth) - 1);
-                return static_cast<uint8_t>(v);
+            switch (format.bits) {
+            case 1:
+                c = 28;
+                break;
+            case 2: {
+                c = 13;
+                const u32 x = Bit(bits, 1);
+                b = (x << 6) | (x << 1);
+                break;
+            }
             }
         }
-
-        assert(!"We shouldn't get here.");
-        return 0;
-    }
-
-    const ChannelType& A() const {
-        return color[0];
-    }
-    ChannelType& A() {
-        return color[0];
-    }
-    const ChannelType& R() const {
-        return color[1];
-    }
-    ChannelType& R() {
-        return color[1];
-    }
-    const ChannelType& G() const {
-        return color[2];
-    }
-    ChannelType& G() {
-        return color[2];
-    }
-    const ChannelType& B() const {
-        return color[3];
-    }
-    ChannelType& B() {
-        return color[3];
-    }
-    const ChannelType& Component(uint32_t idx) const {
-        return color[idx];
-    }
-    ChannelType& Component(uint32_t idx) {
-        return color[idx];
-    }
-
-    void GetBitDepth(uint8_t (&outDepth)[4]) const {
-        for (int i = 0; i < 4; i++) {
-            outDepth[i] = m_BitDepth[i];
-        }
-    }
-
-    // Take all of the components, transform them to their 8-bit variants,
-    // and then pack each channel into an R8G8B8A8 32-bit integer. We assume
-    // that the architecture is little-endian, so the alpha channel will end
-    // up in the most-significant byte.
-    uint32_t Pack() const {
-        Pixel eightBit(*this);
-        const uint8_t eightBitDepth[4] = {8, 8, 8, 8};
-        eightBit.ChangeBitDepth(eightBitDepth);
-
-        uint32_t r = 0;
-        r |= eightBit.A();
-        r <<= 8;
-        r |= eightBit.B();
-        r <<= 8;
-        r |= eightBit.G();
-        r <<= 8;
-        r |= eightBit.R();
-        return r;
+        result = (a & 0x20) | (((digit * c + b) ^ a) >> 2);
     }
+    return result > 32 ? result + 1 : result;
+}
 
-    // Clamps the pixel to the range [0,255]
-    void ClampByte() {
-        for (uint32_t i = 0; i < 4; i++) {
-            color[i] = (color[i] < 0) ? 0 : ((color[i] > 255) ? 255 : color[i]);
-        }
-    }
+using UnquantizationTable = std::array<u8, 256>;
 
-    void MakeOpaque() {
-        A() = 255;
-    }
+/**
+ * Unquantized values of every integer encoding, indexed by the trit or quint of an integer above
+ * its bits. Texel weights only use the first 12 encodings.
+ */
+struct UnquantizationTables {
+    std::array<UnquantizationTable, IntegerEncodings.size()> color;
+    std::array<UnquantizationTable, 12> weight;
 };
 
-static void DecodeColorValues(uint32_t* out, uint8_t* data, const uint32_t* modes,
-                              const uint32_t nPartitions, const uint32_t nBitsForColorData) {
-    // First figure out how many color values we have
-    uint32_t nValues = 0;
-    for (uint32_t i = 0; i < nPartitions; i++) {
-        nValues += ((modes[i] >> 2) + 1) << 1;
-    }
-
-    // Then based on the number of values and the remaining number of bits,
-    // figure out the max value for each of them...
-    uint32_t range = 256;
-    while (--range > 0) {
-        IntegerEncodedValue val = IntegerEncodedValue::CreateEncoding(range);
-        uint32_t bitLength = val.GetBitLength(nValues);
-        if (bitLength <= nBitsForColorData) {
-            // Find the smallest possible range that matches the given encoding
-            while (--range > 0) {
-                IntegerEncodedValue newval = IntegerEncodedValue::CreateEncoding(range);
-                if (!newval.MatchesEncoding(val)) {
-                    break;
+const UnquantizationTables& GetUnquantizationTables() {
+    static const UnquantizationTables tables = [] {
+        UnquantizationTables tables{};
+        for (std::size_t index = 0; index < IntegerEncodings.size(); ++index) {
+            const IntegerEncodingFormat& format = IntegerEncodings[index];
+            const u32 num_digits = format.encoding == IntegerEncoding::Trit
+                                       ? 3
+                                       : format.encoding == IntegerEncoding::Quint ? 5 : 1;
+            for (u32 digit = 0; digit < num_digits; ++digit) {
+                for (u32 bits = 0; bits < (1U << format.bits); ++bits) {
+                    const u32 value = (digit << format.bits) | bits;
+                    tables.color[index][value] =
+                        static_cast<u8>(UnquantizeColorValue(format, digit, bits));
+                    if (index < tables.weight.size()) {
+                        tables.weight[index][value] =
+                            static_cast<u8>(UnquantizeWeight(format, digit, bits));
+                    }
                 }
             }
-
-            // Return to last matching range.
-            range++;
-            break;
         }
-    }
+        return tables;
+    }();
+    return tables;
+}
 
-    // We now have enough to decode our integer sequence.
-    std::vector<IntegerEncodedValue> decodedColorValues;
-    BitStream colorStream(data);
-    IntegerEncodedValue::DecodeIntegerSequence(decodedColorValues, colorStream, range, nValues);
-
-    // Once we have the decoded values, we need to dequantize them to the 0-255 range
-    // This procedure is outlined in ASTC spec C.2.13
-    uint32_t outIdx = 0;
-    for (auto itr = decodedColorValues.begin(); itr != decodedColorValues.end(); ++itr) {
-        // Have we already decoded all that we need?
-        if (outIdx >= nValues) {
-            break;
+/**
+ * Decodes `count` integers of a bounded integer sequence, section C.2.12, and unquantizes them
+ * with the given table. Trits and quints are decoded in whole blocks, so up to four values past
+ * `count` are written.
+ */
+void DecodeIntegerSequence(u8* out, BitReader& reader, const IntegerEncodingFormat& format,
+                           const UnquantizationTable& table, u32 count) {
+    const u32 bits = format.bits;
+    switch (format.encoding) {
+    case IntegerEncoding::JustBits:
+        for (u32 i = 0; i < count; ++i) {
+            out[i] = table[reader.Read(bits)];
         }
-
-        const IntegerEncodedValue& val = *itr;
-        uint32_t bitlen = val.BaseBitLength();
-        uint32_t bitval = val.GetBitValue();
-
-        assert(bitlen >= 1);
-
-        uint32_t A = 0, B = 0, C = 0, D = 0;
-        // A is just the lsb replicated 9 times.
-        A = Replicate(bitval & 1, 1, 9);
-
-        switch (val.GetEncoding()) {
-        // Replicate bits
-        case eIntegerEncoding_JustBits:
-            out[outIdx++] = Replicate(bitval, bitlen, 8);
-            break;
-
-        // Use algorithm in C.2.13
-        case eIntegerEncoding_Trit: {
-
-            D = val.GetTritValue();
-
-            switch (bitlen) {
-            case 1: {
-                C = 204;
-            } break;
-
-            case 2: {
-                C = 93;
-                // B = b000b0bb0
-                uint32_t b = (bitval >> 1) & 1;
-                B = (b << 8) | (b << 4) | (b << 2) | (b << 1);
-            } break;
-
-            case 3: {
-                C = 44;
-                // B = cb000cbcb
-                uint32_t cb = (bitval >> 1) & 3;
-                B = (cb << 7) | (cb << 2) | cb;
-            } break;
-
-            case 4: {
-                C = 22;
-                // B = dcb000dcb
-                uint32_t dcb = (bitval >> 1) & 7;
-                B = (dcb << 6) | dcb;
-            } break;
-
-            case 5: {
-                C = 11;
-                // B = edcb000ed
-                uint32_t edcb = (bitval >> 1) & 0xF;
-                B = (edcb << 5) | (edcb >> 2);
-            } break;
-
-            case 6: {
-                C = 5;
-                // B = fedcb000f
-                uint32_t fedcb = (bitval >> 1) & 0x1F;
-                B = (fedcb << 4) | (fedcb >> 4);
-            } break;
-
-            default:
-                assert(!"Unsupported trit encoding for color values!");
-                break;
-            } // switch(bitlen)
-        }     // case eIntegerEncoding_Trit
         break;
-
-        case eIntegerEncoding_Quint: {
-
-            D = val.GetQuintValue();
-
-            switch (bitlen) {
-            case 1: {
-                C = 113;
-            } break;
-
-            case 2: {
-                C = 54;
-                // B = b0000bb00
-                uint32_t b = (bitval >> 1) & 1;
-                B = (b << 8) | (b << 3) | (b << 2);
-            } break;
-
-            case 3: {
-                C = 26;
-                // B = cb0000cbc
-                uint32_t cb = (bitval >> 1) & 3;
-                B = (cb << 7) | (cb << 1) | (cb >> 1);
-            } break;
-
-            case 4: {
-                C = 13;
-                // B = dcb0000dc
-                uint32_t dcb = (bitval >> 1) & 7;
-                B = (dcb << 6) | (dcb >> 1);
-            } break;
-
-            case 5: {
-                C = 6;
-                // B = edcb0000e
-                uint32_t edcb = (bitval >> 1) & 0xF;
-                B = (edcb << 5) | (edcb >> 3);
-            } break;
-
-            default:
-                assert(!"Unsupported quint encoding for color values!");
-                break;
-            } // switch(bitlen)
-        }     // case eIntegerEncoding_Quint
+    case IntegerEncoding::Trit:
+        for (u32 i = 0; i < count; i += 5) {
+            std::array<u32, 5> m;
+            m[0] = reader.Read(bits);
+            u32 t = reader.Read(2);
+            m[1] = reader.Read(bits);
+            t |= reader.Read(2) << 2;
+            m[2] = reader.Read(bits);
+            t |= reader.Read(1) << 4;
+            m[3] = reader.Read(bits);
+            t |= reader.Read(2) << 5;
+            m[4] = reader.Read(bits);
+            t |= reader.Read(1) << 7;
+            for (u32 j = 0; j < 5; ++j) {
+                out[i + j] = table[(TritTable[t][j] << bits) | m[j]];
+            }
+        }
         break;
-        } // switch(val.GetEncoding())
-
-        if (val.GetEncoding() != eIntegerEncoding_JustBits) {
-            uint32_t T = D * C + B;
-            T ^= A;
-            T = (A & 0x80) | (T >> 2);
-            out[outIdx++] = T;
+    case IntegerEncoding::Quint:
+        for (u32 i = 0; i < count; i += 3) {
+            std::array<u32, 3> m;
+            m[0] = reader.Read(bits);
+            u32 q = reader.Read(3);
+            m[1] = reader.Read(bits);
+            q |= reader.Read(2) << 3;
+            m[2] = reader.Read(bits);
+            q |= reader.Read(2) << 5;
+            for (u32 j = 0; j < 3; ++j) {
+                out[i + j] = table[(QuintTable[q][j] << bits) | m[j]];
+            }
         }
-    }
-
-    // Make sure that each of our values is in the proper range...
-    for (uint32_t i = 0; i < nValues; i++) {
-        assert(out[i] <= 255);
+        break;
     }
 }
 
-static uint32_t UnquantizeTexelWeight(const IntegerEncodedValue& val) {
-    uint32_t bitval = val.GetBitValue();
-    uint32_t bitlen = val.BaseBitLength();
-
-    uint32_t A = Replicate(bitval & 1, 1, 7);
-    uint32_t B = 0, C = 0, D = 0;
-
-    uint32_t result = 0;
-    switch (val.GetEncoding()) {
-    case eIntegerEncoding_JustBits:
-        result = Replicate(bitval, bitlen, 6);
-        break;
-
-    case eIntegerEncoding_Trit: {
-        D = val.GetTritValue();
-        assert(D < 3);
-
-        switch (bitlen) {
-        case 0: {
-            uint32_t results[3] = {0, 32, 63};
-            result = results[D];
-        } break;
-
-        case 1: {
-            C = 50;
-        } break;
-
-        case 2: {
-            C = 23;
-            uint32_t b = (bitval >> 1) & 1;
-            B = (b << 6) | (b << 2) | b;
-        } break;
-
-        case 3: {
-            C = 11;
-            uint32_t cb = (bitval >> 1) & 3;
-            B = (cb << 5) | cb;
-        } break;
+struct BlockMode {
+    u32 grid_width = 0;
+    u32 grid_height = 0;
+    bool dual_plane = false;
+    /// Index of the encoding of the weights in IntegerEncodings
+    u32 weight_encoding = 0;
+    bool is_void_extent = false;
+    bool is_error = false;
+};
 
+/// Decodes the block mode from the 11 lowest bits of a block, section C.2.10.
+BlockMode DecodeBlockMode(const Block& block) {
+    BlockMode mode;
+    const u32 bits = block.Bits(0, 11);
+
+    if ((bits & 0x1FF) == 0x1FC) {
+        // Only LDR void extent blocks are supported, they have the next two bits set.
+        mode.is_void_extent = true;
+        mode.is_error = (bits & 0x200) != 0 || (bits & 0x400) == 0 || block.Bits(11, 1) == 0;
+        return mode;
+    }
+
+    // Reserved modes
+    if ((bits & 0xF) == 0 || ((bits & 0x3) == 0 && (bits & 0x1C0) == 0x1C0)) {
+        mode.is_error = true;
+        return mode;
+    }
+
+    const u32 a = BitRange(bits, 5, 6);
+    const u32 b = BitRange(bits, 7, 8);
+    u32 r = Bit(bits, 4);
+    bool is_layout_9 = false;
+    if ((bits & 0x3) != 0) {
+        r |= (bits & 0x3) << 1;
+        switch (BitRange(bits, 2, 3)) {
+        case 0:
+            mode.grid_width = b + 4;
+            mode.grid_height = a + 2;
+            break;
+        case 1:
+            mode.grid_width = b + 8;
+            mode.grid_height = a + 2;
+            break;
+        case 2:
+            mode.grid_width = a + 2;
+            mode.grid_height = b + 8;
+            break;
         default:
-            assert(!"Invalid trit encoding for texel weight");
+            if ((bits & 0x100) != 0) {
+                mode.grid_width = (b & 1) + 2;
+                mode.grid_height = a + 2;
+            } else {
+                mode.grid_width = a + 2;
+                mode.grid_height = (b & 1) + 6;
+            }
             break;
         }
-    } break;
-
-    case eIntegerEncoding_Quint: {
-        D = val.GetQuintValue();
-        assert(D < 5);
-
-        switch (bitlen) {
-        case 0: {
-            uint32_t results[5] = {0, 16, 32, 47, 63};
-            result = results[D];
-        } break;
-
-        case 1: {
-            C = 28;
-        } break;
-
-        case 2: {
-            C = 13;
-            uint32_t b = (bitval >> 1) & 1;
-            B = (b << 6) | (b << 1);
-        } break;
-
+    } else {
+        r |= (bits & 0xC) >> 1;
+        switch (b) {
+        case 0:
+            mode.grid_width = 12;
+            mode.grid_height = a + 2;
+            break;
+        case 1:
+            mode.grid_width = a + 2;
+            mode.grid_height = 12;
+            break;
+        case 2:
+            mode.grid_width = a + 6;
+            mode.grid_height = BitRange(bits, 9, 10) + 6;
+            is_layout_9 = true;
+            break;
         default:
-            assert(!"Invalid quint encoding for texel weight");
+            mode.grid_width = (bits & 0x20) != 0 ? 10 : 6;
+            mode.grid_height = (bits & 0x20) != 0 ? 6 : 10;
             break;
         }
-    } break;
     }
 
-    if (val.GetEncoding() != eIntegerEncoding_JustBits && bitlen > 0) {
-        // Decode the value...
-        result = D * C + B;
-        result ^= A;
-        result = (A & 0x20) | (result >> 2);
-    }
-
-    assert(result < 64);
-
-    // Change from [0,63] to [0,64]
-    if (result > 32) {
-        result += 1;
-    }
-
-    return result;
-}
-
-static void UnquantizeTexelWeights(uint32_t out[2][144],
-                                   const std::vector<IntegerEncodedValue>& weights,
-                                   const TexelWeightParams& params, const uint32_t blockWidth,
-                                   const uint32_t blockHeight) {
-    uint32_t weightIdx = 0;
-    uint32_t unquantized[2][144];
-
-    for (auto itr = weights.begin(); itr != weights.end(); ++itr) {
-        unquantized[0][weightIdx] = UnquantizeTexelWeight(*itr);
-
-        if (params.m_bDualPlane) {
-            ++itr;
-            unquantized[1][weightIdx] = UnquantizeTexelWeight(*itr);
-            if (itr == weights.end()) {
-                break;
-            }
-        }
-
-        if (++weightIdx >= (params.m_Width * params.m_Height))
-            break;
-    }
-
-    // Do infill if necessary (Section C.2.18) ...
-    uint32_t Ds = (1024 + (blockWidth / 2)) / (blockWidth - 1);
-    uint32_t Dt = (1024 + (blockHeight / 2)) / (blockHeight - 1);
-
-    const uint32_t kPlaneScale = params.m_bDualPlane ? 2U : 1U;
-    for (uint32_t plane = 0; plane < kPlaneScale; plane++)
-        for (uint32_t t = 0; t < blockHeight; t++)
-            for (uint32_t s = 0; s < blockWidth; s++) {
-                uint32_t cs = Ds * s;
-                uint32_t ct = Dt * t;
-
-                uint32_t gs = (cs * (params.m_Width - 1) + 32) >> 6;
-                uint32_t gt = (ct * (params.m_Height - 1) + 32) >> 6;
-
-                uint32_t js = gs >> 4;
-                uint32_t fs = gs & 0xF;
-
-                uint32_t jt = gt >> 4;
-                uint32_t ft = gt & 0x0F;
-
-                uint32_t w11 = (fs * ft + 8) >> 4;
-                uint32_t w10 = ft - w11;
-                uint32_t w01 = fs - w11;
-                uint32_t w00 = 16 - fs - ft + w11;
-
-                uint32_t v0 = js + jt * params.m_Width;
-
-#define FIND_TEXEL(tidx, bidx)                                                                     \
-    uint32_t p##bidx = 0;                                                                          \
-    do {                                                                                           \
-        if ((tidx) < (params.m_Width * params.m_Height)) {                                         \
-            p##bidx = unquantized[plane][(tidx)];                                                  \
-        }                                                                                          \
-    } while (0)
-
-                FIND_TEXEL(v0, 00);
-                FIND_TEXEL(v0 + 1, 01);
-                FIND_TEXEL(v0 + params.m_Width, 10);
-                FIND_TEXEL(v0 + params.m_Width + 1, 11);
-
-#undef FIND_TEXEL
-
-                out[plane][t * blockWidth + s] =
-                    (p00 * w00 + p01 * w01 + p10 * w10 + p11 * w11 + 8) >> 4;
-            }
+    const bool high_precision = !is_layout_9 && (bits & 0x200) != 0;
+    mode.dual_plane = !is_layout_9 && (bits & 0x400) != 0;
+    mode.weight_encoding = (high_precision ? 6 : 0) + r - 2;
+    return mode;
 }
 
 // Transfers a bit as described in C.2.14
-static inline void BitTransferSigned(int32_t& a, int32_t& b) {
+void BitTransferSigned(s32& a, s32& b) {
     b >>= 1;
     b |= a & 0x80;
     a >>= 1;
@@ -1128,501 +541,574 @@ static inline void BitTransferSigned(int32_t& a, int32_t& b) {
         a -= 0x40;
 }
 
-// Adds more precision to the blue channel as described
-// in C.2.14
-static inline Pixel BlueContract(int32_t a, int32_t r, int32_t g, int32_t b) {
-    return Pixel(static_cast<int16_t>(a), static_cast<int16_t>((r + b) >> 1),
-                 static_cast<int16_t>((g + b) >> 1), static_cast<int16_t>(b));
-}
+using Endpoint = std::array<s32, 4>;
 
-// Partition selection functions as specified in
-// C.2.21
-static inline uint32_t hash52(uint32_t p) {
-    p ^= p >> 15;
-    p -= p << 17;
-    p += p << 7;
-    p += p << 4;
-    p ^= p >> 5;
-    p += p << 16;
-    p ^= p >> 7;
-    p ^= p >> 3;
-    p ^= p << 6;
-    p ^= p >> 17;
-    return p;
+/// Adds more precision to the blue channel as described in C.2.14
+Endpoint BlueContract(s32 r, s32 g, s32 b, s32 a) {
+    return {(r + b) >> 1, (g + b) >> 1, b, a};
 }
 
-static uint32_t SelectPartition(int32_t seed, int32_t x, int32_t y, int32_t z,
-                                int32_t partitionCount, int32_t smallBlock) {
-    if (1 == partitionCount)
-        return 0;
-
-    if (smallBlock) {
-        x <<= 1;
-        y <<= 1;
-        z <<= 1;
-    }
-
-    seed += (partitionCount - 1) * 1024;
-
-    uint32_t rnum = hash52(static_cast<uint32_t>(seed));
-    uint8_t seed1 = static_cast<uint8_t>(rnum & 0xF);
-    uint8_t seed2 = static_cast<uint8_t>((rnum >> 4) & 0xF);
-    uint8_t seed3 = static_cast<uint8_t>((rnum >> 8) & 0xF);
-    uint8_t seed4 = static_cast<uint8_t>((rnum >> 12) & 0xF);
-    uint8_t seed5 = static_cast<uint8_t>((rnum >> 16) & 0xF);
-    uint8_t seed6 = static_cast<uint8_t>((rnum >> 20) & 0xF);
-    uint8_t seed7 = static_cast<uint8_t>((rnum >> 24) & 0xF);
-    uint8_t seed8 = static_cast<uint8_t>((rnum >> 28) & 0xF);
-    uint8_t seed9 = static_cast<uint8_t>((rnum >> 18) & 0xF);
-    uint8_t seed10 = static_cast<uint8_t>((rnum >> 22) & 0xF);
-    uint8_t seed11 = static_cast<uint8_t>((rnum >> 26) & 0xF);
-    uint8_t seed12 = static_cast<uint8_t>(((rnum >> 30) | (rnum << 2)) & 0xF);
-
-    seed1 *= seed1;
-    seed2 *= seed2;
-    seed3 *= seed3;
-    seed4 *= seed4;
-    seed5 *= seed5;
-    seed6 *= seed6;
-    seed7 *= seed7;
-    seed8 *= seed8;
-    seed9 *= seed9;
-    seed10 *= seed10;
-    seed11 *= seed11;
-    seed12 *= seed12;
-
-    int32_t sh1, sh2, sh3;
-    if (seed & 1) {
-        sh1 = (seed & 2) ? 4 : 5;
-        sh2 = (partitionCount == 3) ? 6 : 5;
-    } else {
-        sh1 = (partitionCount == 3) ? 6 : 5;
-        sh2 = (seed & 2) ? 4 : 5;
+void ClampByte(Endpoint& endpoint) {
+    for (s32& channel : endpoint) {
+        channel = std::clamp(channel, 0, 255);
     }
-    sh3 = (seed & 0x10) ? sh1 : sh2;
-
-    seed1 >>= sh1;
-    seed2 >>= sh2;
-    seed3 >>= sh1;
-    seed4 >>= sh2;
-    seed5 >>= sh1;
-    seed6 >>= sh2;
-    seed7 >>= sh1;
-    seed8 >>= sh2;
-    seed9 >>= sh3;
-    seed10 >>= sh3;
-    seed11 >>= sh3;
-    seed12 >>= sh3;
-
-    int32_t a = seed1 * x + seed2 * y + seed11 * z + (rnum >> 14);
-    int32_t b = seed3 * x + seed4 * y + seed12 * z + (rnum >> 10);
-    int32_t c = seed5 * x + seed6 * y + seed9 * z + (rnum >> 6);
-    int32_t d = seed7 * x + seed8 * y + seed10 * z + (rnum >> 2);
-
-    a &= 0x3F;
-    b &= 0x3F;
-    c &= 0x3F;
-    d &= 0x3F;
-
-    if (partitionCount < 4)
-        d = 0;
-    if (partitionCount < 3)
-        c = 0;
-
-    if (a >= b && a >= c && a >= d)
-        return 0;
-    else if (b >= c && b >= d)
-        return 1;
-    else if (c >= d)
-        return 2;
-    return 3;
-}
-
-static inline uint32_t Select2DPartition(int32_t seed, int32_t x, int32_t y, int32_t partitionCount,
-                                         int32_t smallBlock) {
-    return SelectPartition(seed, x, y, 0, partitionCount, smallBlock);
 }
 
-// Section C.2.14
-static void ComputeEndpoints(Pixel& ep1, Pixel& ep2, const uint32_t*& colorValues,
-                             uint32_t colorEndpointMode) {
-#define READ_UINT_VALUES(N)                                                                        \
-    uint32_t v[N];                                                                                 \
-    for (uint32_t i = 0; i < N; i++) {                                                             \
-        v[i] = *(colorValues++);                                                                   \
-    }
-
-#define READ_INT_VALUES(N)                                                                         \
-    int32_t v[N];                                                                                  \
-    for (uint32_t i = 0; i < N; i++) {                                                             \
-        v[i] = static_cast<int32_t>(*(colorValues++));                                             \
-    }
-
-    switch (colorEndpointMode) {
-    case 0: {
-        READ_UINT_VALUES(2)
-        ep1 = Pixel(0xFF, v[0], v[0], v[0]);
-        ep2 = Pixel(0xFF, v[1], v[1], v[1]);
-    } break;
+/**
+ * Computes the RGBA endpoints of a partition from its color values, section C.2.14, and stores
+ * them as pairs of the low and high value of each channel.
+ * @returns The color values following the ones of the partition.
+ */
+const u8* DecodeEndpoints(std::array<u16, 8>& pairs, const u8* values, u32 endpoint_mode) {
+    std::array<s32, 8> v;
+    const auto read = [&](std::size_t count) {
+        std::copy_n(values, count, v.begin());
+        values += count;
+    };
 
+    Endpoint low{};
+    Endpoint high{};
+    switch (endpoint_mode) {
+    case 0:
+        read(2);
+        low = {v[0], v[0], v[0], 0xFF};
+        high = {v[1], v[1], v[1], 0xFF};
+        break;
     case 1: {
-        READ_UINT_VALUES(2)
-        uint32_t L0 = (v[0] >> 2) | (v[1] & 0xC0);
-        uint32_t L1 = std::max(L0 + (v[1] & 0x3F), 0xFFU);
-        ep1 = Pixel(0xFF, L0, L0, L0);
-        ep2 = Pixel(0xFF, L1, L1, L1);
-    } break;
-
-    case 4: {
-        READ_UINT_VALUES(4)
-        ep1 = Pixel(v[2], v[0], v[0], v[0]);
-        ep2 = Pixel(v[3], v[1], v[1], v[1]);
-    } break;
-
-    case 5: {
-        READ_INT_VALUES(4)
+        read(2);
+        const s32 l0 = (v[0] >> 2) | (v[1] & 0xC0);
+        const s32 l1 = std::min(l0 + (v[1] & 0x3F), 0xFF);
+        low = {l0, l0, l0, 0xFF};
+        high = {l1, l1, l1, 0xFF};
+        break;
+    }
+    case 4:
+        read(4);
+        low = {v[0], v[0], v[0], v[2]};
+        high = {v[1], v[1], v[1], v[3]};
+        break;
+    case 5:
+        read(4);
         BitTransferSigned(v[1], v[0]);
         BitTransferSigned(v[3], v[2]);
-        ep1 = Pixel(v[2], v[0], v[0], v[0]);
-        ep2 = Pixel(v[2] + v[3], v[0] + v[1], v[0] + v[1], v[0] + v[1]);
-        ep1.ClampByte();
-        ep2.ClampByte();
-    } break;
-
-    case 6: {
-        READ_UINT_VALUES(4)
-        ep1 = Pixel(0xFF, v[0] * v[3] >> 8, v[1] * v[3] >> 8, v[2] * v[3] >> 8);
-        ep2 = Pixel(0xFF, v[0], v[1], v[2]);
-    } break;
-
-    case 8: {
-        READ_UINT_VALUES(6)
+        low = {v[0], v[0], v[0], v[2]};
+        high = {v[0] + v[1], v[0] + v[1], v[0] + v[1], v[2] + v[3]};
+        ClampByte(low);
+        ClampByte(high);
+        break;
+    case 6:
+        read(4);
+        low = {v[0] * v[3] >> 8, v[1] * v[3] >> 8, v[2] * v[3] >> 8, 0xFF};
+        high = {v[0], v[1], v[2], 0xFF};
+        break;
+    case 8:
+        read(6);
         if (v[1] + v[3] + v[5] >= v[0] + v[2] + v[4]) {
-            ep1 = Pixel(0xFF, v[0], v[2], v[4]);
-            ep2 = Pixel(0xFF, v[1], v[3], v[5]);
+            low = {v[0], v[2], v[4], 0xFF};
+            high = {v[1], v[3], v[5], 0xFF};
         } else {
-            ep1 = BlueContract(0xFF, v[1], v[3], v[5]);
-            ep2 = BlueContract(0xFF, v[0], v[2], v[4]);
+            low = BlueContract(v[1], v[3], v[5], 0xFF);
+            high = BlueContract(v[0], v[2], v[4], 0xFF);
         }
-    } break;
-
-    case 9: {
-        READ_INT_VALUES(6)
+        break;
+    case 9:
+        read(6);
         BitTransferSigned(v[1], v[0]);
         BitTransferSigned(v[3], v[2]);
         BitTransferSigned(v[5], v[4]);
         if (v[1] + v[3] + v[5] >= 0) {
-            ep1 = Pixel(0xFF, v[0], v[2], v[4]);
-            ep2 = Pixel(0xFF, v[0] + v[1], v[2] + v[3], v[4] + v[5]);
+            low = {v[0], v[2], v[4], 0xFF};
+            high = {v[0] + v[1], v[2] + v[3], v[4] + v[5], 0xFF};
         } else {
-            ep1 = BlueContract(0xFF, v[0] + v[1], v[2] + v[3], v[4] + v[5]);
-            ep2 = BlueContract(0xFF, v[0], v[2], v[4]);
+            low = BlueContract(v[0] + v[1], v[2] + v[3], v[4] + v[5], 0xFF);
+            high = BlueContract(v[0], v[2], v[4], 0xFF);
         }
-        ep1.ClampByte();
-        ep2.ClampByte();
-    } break;
-
-    case 10: {
-        READ_UINT_VALUES(6)
-        ep1 = Pixel(v[4], v[0] * v[3] >> 8, v[1] * v[3] >> 8, v[2] * v[3] >> 8);
-        ep2 = Pixel(v[5], v[0], v[1], v[2]);
-    } break;
-
-    case 12: {
-        READ_UINT_VALUES(8)
+        ClampByte(low);
+        ClampByte(high);
+        break;
+    case 10:
+        read(6);
+        low = {v[0] * v[3] >> 8, v[1] * v[3] >> 8, v[2] * v[3] >> 8, v[4]};
+        high = {v[0], v[1], v[2], v[5]};
+        break;
+    case 12:
+        read(8);
         if (v[1] + v[3] + v[5] >= v[0] + v[2] + v[4]) {
-            ep1 = Pixel(v[6], v[0], v[2], v[4]);
-            ep2 = Pixel(v[7], v[1], v[3], v[5]);
+            low = {v[0], v[2], v[4], v[6]};
+            high = {v[1], v[3], v[5], v[7]};
         } else {
-            ep1 = BlueContract(v[7], v[1], v[3], v[5]);
-            ep2 = BlueContract(v[6], v[0], v[2], v[4]);
+            low = BlueContract(v[1], v[3], v[5], v[7]);
+            high = BlueContract(v[0], v[2], v[4], v[6]);
         }
-    } break;
-
-    case 13: {
-        READ_INT_VALUES(8)
+        break;
+    case 13:
+        read(8);
         BitTransferSigned(v[1], v[0]);
         BitTransferSigned(v[3], v[2]);
         BitTransferSigned(v[5], v[4]);
         BitTransferSigned(v[7], v[6]);
         if (v[1] + v[3] + v[5] >= 0) {
-            ep1 = Pixel(v[6], v[0], v[2], v[4]);
-            ep2 = Pixel(v[7] + v[6], v[0] + v[1], v[2] + v[3], v[4] + v[5]);
+            low = {v[0], v[2], v[4], v[6]};
+            high = {v[0] + v[1], v[2] + v[3], v[4] + v[5], v[6] + v[7]};
         } else {
-            ep1 = BlueContract(v[6] + v[7], v[0] + v[1], v[2] + v[3], v[4] + v[5]);
-            ep2 = BlueContract(v[6], v[0], v[2], v[4]);
+            low = BlueContract(v[0] + v[1], v[2] + v[3], v[4] + v[5], v[6] + v[7]);
+            high = BlueContract(v[0], v[2], v[4], v[6]);
         }
-        ep1.ClampByte();
-        ep2.ClampByte();
-    } break;
-
+        ClampByte(low);
+        ClampByte(high);
+        break;
     default:
-        assert(!"Unsupported color endpoint mode (is it HDR?)");
+        // HDR modes are unsupported, their partitions are left transparent black.
         break;
     }
 
-#undef READ_UINT_VALUES
-#undef READ_INT_VALUES
+    for (std::size_t channel = 0; channel < 4; ++channel) {
+        pairs[channel * 2] = static_cast<u16>(low[channel] & 0xFF);
+        pairs[channel * 2 + 1] = static_cast<u16>(high[channel] & 0xFF);
+    }
+    return values;
+}
+
+// Partition selection functions as specified in C.2.21
+u32 Hash52(u32 p) {
+    p ^= p >> 15;
+    p -= p << 17;
+    p += p << 7;
+    p += p << 4;
+    p ^= p >> 5;
+    p += p << 16;
+    p ^= p >> 7;
+    p ^= p >> 3;
+    p ^= p << 6;
+    p ^= p >> 17;
+    return p;
 }
 
-static void DecompressBlock(uint8_t inBuf[16], const uint32_t blockWidth,
-                            const uint32_t blockHeight, uint32_t* outBuf) {
-    BitStream strm(inBuf);
-    TexelWeightParams weightParams = DecodeBlockInfo(strm);
+/// Selects the partition of every texel of a 2D block. The hash of the seed is shared by them all.
+void SelectPartitions(u8* partitions, u32 seed, u32 count, u32 block_width, u32 block_height) {
+    const u32 scale = block_width * block_height < 32 ? 2 : 1;
+    seed += (count - 1) * 1024;
 
-    // Was there an error?
-    if (weightParams.m_bError) {
-        assert(!"Invalid block mode");
-        FillError(outBuf, blockWidth, blockHeight);
-        return;
+    const u32 rnum = Hash52(seed);
+    std::array<u32, 8> seeds;
+    for (u32 i = 0; i < 8; ++i) {
+        seeds[i] = (rnum >> (i * 4)) & 0xF;
+        seeds[i] *= seeds[i];
     }
 
-    if (weightParams.m_bVoidExtentLDR) {
-        FillVoidExtentLDR(strm, outBuf, blockWidth, blockHeight);
-        return;
+    u32 sh1;
+    u32 sh2;
+    if (seed & 1) {
+        sh1 = (seed & 2) ? 4 : 5;
+        sh2 = count == 3 ? 6 : 5;
+    } else {
+        sh1 = count == 3 ? 6 : 5;
+        sh2 = (seed & 2) ? 4 : 5;
     }
-
-    if (weightParams.m_bVoidExtentHDR) {
-        assert(!"HDR void extent blocks are unsupported!");
-        FillError(outBuf, blockWidth, blockHeight);
-        return;
+    for (u32 i = 0; i < 8; i += 2) {
+        seeds[i] >>= sh1;
+        seeds[i + 1] >>= sh2;
+    }
+
+    for (u32 y = 0; y < block_height; ++y) {
+        for (u32 x = 0; x < block_width; ++x) {
+            const u32 sx = x * scale;
+            const u32 sy = y * scale;
+            const u32 a = (seeds[0] * sx + seeds[1] * sy + (rnum >> 14)) & 0x3F;
+            const u32 b = (seeds[2] * sx + seeds[3] * sy + (rnum >> 10)) & 0x3F;
+            const u32 c = count < 3 ? 0 : (seeds[4] * sx + seeds[5] * sy + (rnum >> 6)) & 0x3F;
+            const u32 d = count < 4 ? 0 : (seeds[6] * sx + seeds[7] * sy + (rnum >> 2)) & 0x3F;
+
+            u8 partition = 3;
+            if (a >= b && a >= c && a >= d) {
+                partition = 0;
+            } else if (b >= c && b >= d) {
+                partition = 1;
+            } else if (c >= d) {
+                partition = 2;
+            }
+            *partitions++ = partition;
+        }
     }
+}
 
-    if (weightParams.m_Width > blockWidth) {
-        assert(!"Texel weight grid width should be smaller than block width");
-        FillError(outBuf, blockWidth, blockHeight);
-        return;
-    }
+/**
+ * Positions of the texels of a block in a weight grid, section C.2.18. Each texel takes its
+ * weight from four of the grid, the one at its index, the next one and the two below them.
+ */
+struct InfillTable {
+    std::array<s32, MaxBlockTexels> indices;
+    /// Factors of the first two weights, in the low and high 16 bits
+    std::array<u32, MaxBlockTexels> top_factors;
+    /// Factors of the two weights below them
+    std::array<u32, MaxBlockTexels> bottom_factors;
+};
 
-    if (weightParams.m_Height > blockHeight) {
-        assert(!"Texel weight grid height should be smaller than block height");
-        FillError(outBuf, blockWidth, blockHeight);
-        return;
+InfillTable MakeInfillTable(u32 block_width, u32 block_height, u32 grid_width,
+                            u32 grid_height) {
+    InfillTable table{};
+    const u32 ds = (1024 + block_width / 2) / (block_width - 1);
+    const u32 dt = (1024 + block_height / 2) / (block_height - 1);
+    for (u32 t = 0; t < block_height; ++t) {
+        for (u32 s = 0; s < block_width; ++s) {
+            const u32 gs = (ds * s * (grid_width - 1) + 32) >> 6;
+            const u32 gt = (dt * t * (grid_height - 1) + 32) >> 6;
+            const u32 fs = gs & 0xF;
+            const u32 ft = gt & 0xF;
+
+            const u32 w11 = (fs * ft + 8) >> 4;
+            const u32 w10 = ft - w11;
+            const u32 w01 = fs - w11;
+            const u32 w00 = 16 - fs - ft + w11;
+
+            const u32 texel = t * block_width + s;
+            table.indices[texel] = static_cast<s32>((gs >> 4) + (gt >> 4) * grid_width);
+            table.top_factors[texel] = w00 | (w01 << 16);
+            table.bottom_factors[texel] = w10 | (w11 << 16);
+        }
     }
+    return table;
+}
 
-    // Read num partitions
-    uint32_t nPartitions = strm.ReadBits(2) + 1;
-    assert(nPartitions <= 4);
+/**
+ * Returns the infill tables of every weight grid size of a block size, by rows of grids of the
+ * same height. They're built the first time a block size is decoded, as there are up to 121 of
+ * them.
+ */
+const std::vector<InfillTable>& GetInfillTables(u32 block_width, u32 block_height) {
+    static std::mutex mutex;
+    static std::map<std::pair<u32, u32>, std::vector<InfillTable>> tables_by_block_size;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& tables = tables_by_block_size[{block_width, block_height}];
+    if (tables.empty()) {
+        // Weight grids have at least 2x2 weights and can't be larger than the block.
+        for (u32 grid_height = 2; grid_height <= block_height; ++grid_height) {
+            for (u32 grid_width = 2; grid_width <= block_width; ++grid_width) {
+                tables.push_back(
+                    MakeInfillTable(block_width, block_height, grid_width, grid_height));
+            }
+        }
+    }
+    return tables;
+}
 
-    if (nPartitions == 4 && weightParams.m_bDualPlane) {
-        assert(!"Dual plane mode is incompatible with four partition blocks");
-        FillError(outBuf, blockWidth, blockHeight);
-        return;
+void InfillWeightsGeneric(u8* weights, const u8* grid, u32 grid_width, const s32* indices,
+                          const u32* top_factors, const u32* bottom_factors,
+                          std::size_t num_texels) {
+    for (std::size_t i = 0; i < num_texels; ++i) {
+        const u8* const top = grid + indices[i];
+        const u8* const bottom = top + grid_width;
+        const u32 sum = top[0] * (top_factors[i] & 0xFFFF) + top[1] * (top_factors[i] >> 16) +
+                        bottom[0] * (bottom_factors[i] & 0xFFFF) +
+                        bottom[1] * (bottom_factors[i] >> 16);
+        weights[i] = static_cast<u8>((sum + 8) >> 4);
     }
+}
 
-    // Based on the number of partitions, read the color endpoint mode for
-    // each partition.
+#ifdef ARCHITECTURE_x86_64
+/// Returns the factors of the low and high endpoints for a weight, in the low and high 16 bits.
+u32 WeightFactors(u32 weight) {
+    return (64 - weight) | (weight << 16);
+}
 
-    // Determine partitions, partition index, and color endpoint modes
-    int32_t planeIdx = -1;
-    uint32_t partitionIndex;
-    uint32_t colorEndpointMode[4] = {0, 0, 0, 0};
+/// Converts the interpolation of 8-bit endpoints expanded to 16 bits back to 8 bits.
+__m128i ScaleToByteSSE2(__m128i value) {
+    value = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(value, 8), value), _mm_set1_epi32(32));
+    value = _mm_srli_epi32(value, 6);
+    value = _mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(value, 8), value), _mm_set1_epi32(32768));
+    return _mm_srli_epi32(value, 16);
+}
 
-    // Define color data.
-    uint8_t colorEndpointData[16];
-    memset(colorEndpointData, 0, sizeof(colorEndpointData));
-    BitStream colorEndpointStream(colorEndpointData, 16 * 8, 0);
+template <bool dual_plane>
+void InterpolateTexelsSSE2(u32* texels, const std::array<u16, 8>* endpoints, const u8* partitions,
+                           const u8* weights, const u8* plane_weights, u32 plane_channel,
+                           std::size_t num_texels) {
+    const __m128i plane_mask = _mm_cmpeq_epi32(_mm_setr_epi32(0, 1, 2, 3),
+                                               _mm_set1_epi32(static_cast<int>(plane_channel)));
+    // Each 32-bit lane holds the pair of endpoints of a channel, multiplied and added to their
+    // factors at once.
+    const auto interpolate = [&](std::size_t i) {
+        const __m128i pairs =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(endpoints[partitions[i]].data()));
+        __m128i factors = _mm_set1_epi32(static_cast<int>(WeightFactors(weights[i])));
+        if (dual_plane) {
+            const __m128i plane_factors =
+                _mm_set1_epi32(static_cast<int>(WeightFactors(plane_weights[i])));
+            factors = _mm_or_si128(_mm_andnot_si128(plane_mask, factors),
+                                   _mm_and_si128(plane_mask, plane_factors));
+        }
+        return ScaleToByteSSE2(_mm_madd_epi16(pairs, factors));
+    };
 
-    // Read extra config data...
-    uint32_t baseCEM = 0;
-    if (nPartitions == 1) {
-        colorEndpointMode[0] = strm.ReadBits(4);
-        partitionIndex = 0;
-    } else {
-        partitionIndex = strm.ReadBits(10);
-        baseCEM = strm.ReadBits(6);
+    std::size_t i = 0;
+    for (; i + 4 <= num_texels; i += 4) {
+        const __m128i low = _mm_packs_epi32(interpolate(i), interpolate(i + 1));
+        const __m128i high = _mm_packs_epi32(interpolate(i + 2), interpolate(i + 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(texels + i), _mm_packus_epi16(low, high));
     }
-    uint32_t baseMode = (baseCEM & 3);
-
-    // Remaining bits are color endpoint data...
-    uint32_t nWeightBits = weightParams.GetPackedBitSize();
-    int32_t remainingBits = 128 - nWeightBits - strm.GetBitsRead();
-
-    // Consider extra bits prior to texel data...
-    uint32_t extraCEMbits = 0;
-    if (baseMode) {
-        switch (nPartitions) {
-        case 2:
-            extraCEMbits += 2;
-            break;
-        case 3:
-            extraCEMbits += 5;
-            break;
-        case 4:
-            extraCEMbits += 8;
-            break;
-        default:
-            assert(false);
-            break;
-        }
+    for (; i < num_texels; ++i) {
+        const __m128i words = _mm_packs_epi32(interpolate(i), _mm_setzero_si128());
+        texels[i] =
+            static_cast<u32>(_mm_cvtsi128_si32(_mm_packus_epi16(words, _mm_setzero_si128())));
     }
-    remainingBits -= extraCEMbits;
+}
 
-    // Do we have a dual plane situation?
-    uint32_t planeSelectorBits = 0;
-    if (weightParams.m_bDualPlane) {
-        planeSelectorBits = 2;
+void InterpolateTexelsSSE2(u32* texels, const std::array<u16, 8>* endpoints, const u8* partitions,
+                           const u8* weights, const u8* plane_weights, u32 plane_channel,
+                           std::size_t num_texels) {
+    if (plane_weights != nullptr) {
+        InterpolateTexelsSSE2<true>(texels, endpoints, partitions, weights, plane_weights,
+                                    plane_channel, num_texels);
+    } else {
+        InterpolateTexelsSSE2<false>(texels, endpoints, partitions, weights, nullptr, 0,
+                                     num_texels);
     }
-    remainingBits -= planeSelectorBits;
-
-    // Read color data...
-    uint32_t colorDataBits = remainingBits;
-    while (remainingBits > 0) {
-        uint32_t nb = std::min(remainingBits, 8);
-        uint32_t b = strm.ReadBits(nb);
-        colorEndpointStream.WriteBits(b, nb);
-        remainingBits -= 8;
+}
+#else
+void InterpolateTexelsGeneric(u32* texels, const std::array<u16, 8>* endpoints,
+                              const u8* partitions, const u8* weights, const u8* plane_weights,
+                              u32 plane_channel, std::size_t num_texels) {
+    for (std::size_t i = 0; i < num_texels; ++i) {
+        const std::array<u16, 8>& pairs = endpoints[partitions[i]];
+        u32 texel = 0;
+        for (u32 channel = 0; channel < 4; ++channel) {
+            const u32 weight = plane_weights != nullptr && channel == plane_channel
+                                   ? plane_weights[i]
+                                   : weights[i];
+            // Endpoints are expanded to 16 bits for the interpolation, then converted back to 8.
+            const u32 value =
+                ((pairs[channel * 2] * (64 - weight) + pairs[channel * 2 + 1] * weight) * 257 +
+                 32) >>
+                6;
+            texel |= ((value * 255 + 32768) >> 16) << (channel * 8);
+        }
+        texels[i] = texel;
     }
+}
+#endif
+
+struct Kernels {
+    /// Interpolates the weight of every texel from the four closest ones of a weight grid.
+    void (*infill_weights)(u8* weights, const u8* grid, u32 grid_width, const s32* indices,
+                           const u32* top_factors, const u32* bottom_factors,
+                           std::size_t num_texels);
+    /**
+     * Interpolates the endpoints of the partition of every texel by its weight. When there are
+     * two planes of weights, the channel `plane_channel` (0 to 3 for RGBA) takes its weights from
+     * `plane_weights` and the other ones from `weights`. Single plane blocks pass nullptr.
+     */
+    void (*interpolate_texels)(u32* texels, const std::array<u16, 8>* endpoints,
+                               const u8* partitions, const u8* weights, const u8* plane_weights,
+                               u32 plane_channel, std::size_t num_texels);
+};
 
-    // Read the plane selection bits
-    planeIdx = strm.ReadBits(planeSelectorBits);
-
-    // Read the rest of the CEM
-    if (baseMode) {
-        uint32_t extraCEM = strm.ReadBits(extraCEMbits);
-        uint32_t CEM = (extraCEM << 6) | baseCEM;
-        CEM >>= 2;
+/// Returns the fastest kernels supported by the host CPU.
+const Kernels& GetKernels() {
+    static const Kernels kernels = [] {
+#ifdef ARCHITECTURE_x86_64
+        if (Common::GetCPUCaps().avx2) {
+            return Kernels{InfillWeightsAVX2, InterpolateTexelsAVX2};
+        }
+        return Kernels{InfillWeightsGeneric, InterpolateTexelsSSE2};
+#else
+        return Kernels{InfillWeightsGeneric, InterpolateTexelsGeneric};
+#endif
+    }();
+    return kernels;
+}
 
-        bool C[4] = {0};
-        for (uint32_t i = 0; i < nPartitions; i++) {
-            C[i] = CEM & 1;
-            CEM >>= 1;
+/// Decodes the blocks of a texture, all of the same size.
+class BlockDecoder {
+public:
+    BlockDecoder(u32 block_width, u32 block_height)
+        : block_width(block_width), block_height(block_height),
+          num_texels(block_width * block_height), kernels(GetKernels()),
+          tables(GetUnquantizationTables()),
+          infill_tables(GetInfillTables(block_width, block_height)) {}
+
+    /// Decodes a 16 byte block into block_width * block_height RGBA8 texels.
+    void Decode(const u8* data, u32* texels) const {
+        Block block;
+        std::memcpy(&block.low, data, sizeof(block.low));
+        std::memcpy(&block.high, data + sizeof(block.low), sizeof(block.high));
+
+        const BlockMode mode = DecodeBlockMode(block);
+        if (mode.is_error) {
+            std::fill_n(texels, num_texels, ErrorColor);
+            return;
+        }
+        if (mode.is_void_extent) {
+            // Only the high byte of each 16-bit channel is kept
+            const u32 color = static_cast<u32>((block.high >> 8) & 0xFF) |
+                              static_cast<u32>((block.high >> 16) & 0xFF00) |
+                              static_cast<u32>((block.high >> 24) & 0xFF0000) |
+                              static_cast<u32>((block.high >> 32) & 0xFF000000);
+            std::fill_n(texels, num_texels, color);
+            return;
         }
 
-        uint8_t M[4] = {0};
-        for (uint32_t i = 0; i < nPartitions; i++) {
-            M[i] = CEM & 3;
-            CEM >>= 2;
-            assert(M[i] <= 3);
+        // Illegal encodings are listed in section C.2.24
+        const IntegerEncodingFormat& weight_format = IntegerEncodings[mode.weight_encoding];
+        const u32 num_grid_weights = mode.grid_width * mode.grid_height;
+        const u32 num_weights = num_grid_weights * (mode.dual_plane ? 2 : 1);
+        const u32 weight_bits = SequenceBitLength(weight_format, num_weights);
+        const u32 num_partitions = block.Bits(11, 2) + 1;
+        if (mode.grid_width > block_width || mode.grid_height > block_height ||
+            num_weights > 64 || weight_bits < 24 || weight_bits > 96 ||
+            (num_partitions == 4 && mode.dual_plane)) {
+            std::fill_n(texels, num_texels, ErrorColor);
+            return;
         }
 
-        for (uint32_t i = 0; i < nPartitions; i++) {
-            colorEndpointMode[i] = baseMode;
-            if (!(C[i]))
-                colorEndpointMode[i] -= 1;
-            colorEndpointMode[i] <<= 2;
-            colorEndpointMode[i] |= M[i];
+        // Color endpoint modes, section C.2.11
+        std::array<u32, 4> endpoint_modes{};
+        u32 partition_index = 0;
+        u32 base_cem = 0;
+        u32 config_bits = 17;
+        if (num_partitions == 1) {
+            endpoint_modes[0] = block.Bits(13, 4);
+        } else {
+            partition_index = block.Bits(13, 10);
+            base_cem = block.Bits(23, 6);
+            config_bits = 29;
         }
-    } else if (nPartitions > 1) {
-        uint32_t CEM = baseCEM >> 2;
-        for (uint32_t i = 0; i < nPartitions; i++) {
-            colorEndpointMode[i] = CEM;
+        const u32 base_mode = base_cem & 3;
+        static constexpr std::array<u32, 5> extra_cem_bits_table{0, 0, 2, 5, 8};
+        const u32 extra_cem_bits = base_mode != 0 ? extra_cem_bits_table[num_partitions] : 0;
+        const u32 plane_selector_bits = mode.dual_plane ? 2 : 0;
+
+        // The extra bits of the endpoint modes are right below the weights, the plane selector is
+        // right below them.
+        const u32 extra_cem_position = 128 - weight_bits - extra_cem_bits;
+        const u32 plane_selector_position = extra_cem_position - plane_selector_bits;
+        if (base_mode != 0) {
+            u32 cem = ((block.Bits(extra_cem_position, extra_cem_bits) << 6) | base_cem) >> 2;
+            const u32 classes = cem;
+            cem >>= num_partitions;
+            for (u32 i = 0; i < num_partitions; ++i) {
+                const u32 endpoint_class = base_mode - 1 + Bit(classes, i);
+                endpoint_modes[i] = (endpoint_class << 2) | (cem & 3);
+                cem >>= 2;
+            }
+        } else if (num_partitions > 1) {
+            endpoint_modes.fill(base_cem >> 2);
         }
-    }
 
-    // Make sure everything up till here is sane.
-    for (uint32_t i = 0; i < nPartitions; i++) {
-        assert(colorEndpointMode[i] < 16);
-    }
-    assert(strm.GetBitsRead() + weightParams.GetPackedBitSize() == 128);
+        u32 num_color_values = 0;
+        for (u32 i = 0; i < num_partitions; ++i) {
+            num_color_values += ((endpoint_modes[i] >> 2) + 1) * 2;
+        }
+        const s32 color_bits =
+            static_cast<s32>(plane_selector_position) - static_cast<s32>(config_bits);
+        if (num_color_values > 18 ||
+            color_bits < static_cast<s32>((num_color_values * 13 + 4) / 5)) {
+            std::fill_n(texels, num_texels, ErrorColor);
+            return;
+        }
 
-    // Decode both color data and texel weight data
-    uint32_t colorValues[32]; // Four values, two endpoints, four maximum paritions
-    DecodeColorValues(colorValues, colorEndpointData, colorEndpointMode, nPartitions,
-                      colorDataBits);
+        // Color values use the largest range that fits in their bits.
+        std::size_t color_encoding = IntegerEncodings.size() - 1;
+        while (SequenceBitLength(IntegerEncodings[color_encoding], num_color_values) >
+               static_cast<u32>(color_bits)) {
+            --color_encoding;
+        }
+        std::array<u8, 32> color_values;
+        BitReader color_reader(block, config_bits, plane_selector_position);
+        DecodeIntegerSequence(color_values.data(), color_reader, IntegerEncodings[color_encoding],
+                              tables.color[color_encoding], num_color_values);
+
+        std::array<std::array<u16, 8>, 4> endpoints{};
+        const u8* values = color_values.data();
+        for (u32 i = 0; i < num_partitions; ++i) {
+            values = DecodeEndpoints(endpoints[i], values, endpoint_modes[i]);
+        }
 
-    Pixel endpoints[4][2];
-    const uint32_t* colorValuesPtr = colorValues;
-    for (uint32_t i = 0; i < nPartitions; i++) {
-        ComputeEndpoints(endpoints[i][0], endpoints[i][1], colorValuesPtr, colorEndpointMode[i]);
-    }
+        // Weights are stored from the highest bit of the block down
+        const Block reversed{ReverseBits(block.high), ReverseBits(block.low)};
+        BitReader weight_reader(reversed, 0, weight_bits);
+        std::array<u8, 64 + 4> weight_values;
+        DecodeIntegerSequence(weight_values.data(), weight_reader, weight_format,
+                              tables.weight[mode.weight_encoding], num_weights);
+
+        std::array<std::array<u8, WeightGridSize>, 2> grids;
+        const u32 num_planes = mode.dual_plane ? 2 : 1;
+        for (u32 plane = 0; plane < num_planes; ++plane) {
+            for (u32 i = 0; i < num_grid_weights; ++i) {
+                grids[plane][i] = weight_values[i * num_planes + plane];
+            }
+            std::fill(grids[plane].begin() + num_grid_weights, grids[plane].end(), 0);
+        }
 
-    // Read the texel weight data..
-    uint8_t texelWeightData[16];
-    memcpy(texelWeightData, inBuf, sizeof(texelWeightData));
+        const InfillTable& infill =
+            infill_tables[(mode.grid_height - 2) * (block_width - 1) + mode.grid_width - 2];
+        std::array<std::array<u8, MaxBlockTexels>, 2> weights;
+        for (u32 plane = 0; plane < num_planes; ++plane) {
+            kernels.infill_weights(weights[plane].data(), grids[plane].data(), mode.grid_width,
+                                   infill.indices.data(), infill.top_factors.data(),
+                                   infill.bottom_factors.data(), num_texels);
+        }
 
-    // Reverse everything
-    for (uint32_t i = 0; i < 8; i++) {
-// Taken from http://graphics.stanford.edu/~seander/bithacks.html#ReverseByteWith64Bits
-#define REVERSE_BYTE(b) (((b)*0x80200802ULL) & 0x0884422110ULL) * 0x0101010101ULL >> 32
-        unsigned char a = static_cast<unsigned char>(REVERSE_BYTE(texelWeightData[i]));
-        unsigned char b = static_cast<unsigned char>(REVERSE_BYTE(texelWeightData[15 - i]));
-#undef REVERSE_BYTE
+        std::array<u8, MaxBlockTexels> partitions;
+        if (num_partitions == 1) {
+            std::fill_n(partitions.begin(), num_texels, 0);
+        } else {
+            SelectPartitions(partitions.data(), partition_index, num_partitions, block_width,
+                             block_height);
+        }
 
-        texelWeightData[i] = b;
-        texelWeightData[15 - i] = a;
+        const u32 plane_channel = block.Bits(plane_selector_position, plane_selector_bits);
+        kernels.interpolate_texels(texels, endpoints.data(), partitions.data(), weights[0].data(),
+                                   mode.dual_plane ? weights[1].data() : nullptr, plane_channel,
+                                   num_texels);
     }
 
-    // Make sure that higher non-texel bits are set to zero
-    const uint32_t clearByteStart = (weightParams.GetPackedBitSize() >> 3) + 1;
-    texelWeightData[clearByteStart - 1] &= (1 << (weightParams.GetPackedBitSize() % 8)) - 1;
-    memset(texelWeightData + clearByteStart, 0, 16 - clearByteStart);
-
-    std::vector<IntegerEncodedValue> texelWeightValues;
-    BitStream weightStream(texelWeightData);
-
-    IntegerEncodedValue::DecodeIntegerSequence(texelWeightValues, weightStream,
-                                               weightParams.m_MaxWeight,
-                                               weightParams.GetNumWeightValues());
-
-    // Blocks can be at most 12x12, so we can have as many as 144 weights
-    uint32_t weights[2][144];
-    UnquantizeTexelWeights(weights, texelWeightValues, weightParams, blockWidth, blockHeight);
-
-    // Now that we have endpoints and weights, we can interpolate and generate
-    // the proper decoding...
-    for (uint32_t j = 0; j < blockHeight; j++)
-        for (uint32_t i = 0; i < blockWidth; i++) {
-            uint32_t partition = Select2DPartition(partitionIndex, i, j, nPartitions,
-                                                   (blockHeight * blockWidth) < 32);
-            assert(partition < nPartitions);
-
-            Pixel p;
-            for (uint32_t c = 0; c < 4; c++) {
-                uint32_t C0 = endpoints[partition][0].Component(c);
-                C0 = Replicate(C0, 8, 16);
-                uint32_t C1 = endpoints[partition][1].Component(c);
-                C1 = Replicate(C1, 8, 16);
-
-                uint32_t plane = 0;
-                if (weightParams.m_bDualPlane && (((planeIdx + 1) & 3) == c)) {
-                    plane = 1;
-                }
-
-                uint32_t weight = weights[plane][j * blockWidth + i];
-                uint32_t C = (C0 * (64 - weight) + C1 * weight + 32) / 64;
-                if (C == 65535) {
-                    p.Component(c) = 255;
-                } else {
-                    double Cf = static_cast<double>(C);
-                    p.Component(c) = static_cast<uint16_t>(255.0 * (Cf / 65536.0) + 0.5);
-                }
-            }
-
-            outBuf[j * blockWidth + i] = p.Pack();
-        }
-}
-
-} // namespace ASTCC
+private:
+    u32 block_width;
+    u32 block_height;
+    u32 num_texels;
+    const Kernels& kernels;
+    const UnquantizationTables& tables;
+    /// Infill tables of every weight grid size, see GetInfillTables
+    const std::vector<InfillTable>& infill_tables;
+};
 
-namespace Tegra::Texture::ASTC {
+} // Anonymous namespace
 
 std::vector<uint8_t> Decompress(std::vector<uint8_t>& data, uint32_t width, uint32_t height,
                                 uint32_t block_width, uint32_t block_height) {
-    uint32_t blockIdx = 0;
-    std::vector<uint8_t> outData(height * width * 4);
-    for (uint32_t j = 0; j < height; j += block_height) {
-        for (uint32_t i = 0; i < width; i += block_width) {
-
-            uint8_t* blockPtr = data.data() + blockIdx * 16;
-
-            // Blocks can be at most 12x12
-            uint32_t uncompData[144];
-            ASTCC::DecompressBlock(blockPtr, block_width, block_height, uncompData);
-
-            uint32_t decompWidth = std::min(block_width, width - i);
-            uint32_t decompHeight = std::min(block_height, height - j);
-
-            uint8_t* outRow = outData.data() + (j * width + i) * 4;
-            for (uint32_t jj = 0; jj < decompHeight; jj++) {
-                memcpy(outRow + jj * width * 4, uncompData + jj * block_width, decompWidth * 4);
+    std::vector<uint8_t> out_data(static_cast<std::size_t>(width) * height * 4);
+    const u32 blocks_on_x = (width + block_width - 1) / block_width;
+    const u32 blocks_on_y = (height + block_height - 1) / block_height;
+    const BlockDecoder decoder(block_width, block_height);
+
+    // Every row of blocks is written to its own rows of texels, so they can be decoded in any
+    // order.
+    const auto decode_block_row = [&](std::size_t block_y) {
+        const u32 y = static_cast<u32>(block_y) * block_height;
+        const u32 rows = std::min(block_height, height - y);
+        const u8* block = data.data() + block_y * blocks_on_x * 16;
+        std::array<u32, MaxBlockTexels> texels;
+        for (u32 x = 0; x < width; x += block_width, block += 16) {
+            decoder.Decode(block, texels.data());
+
+            const u32 columns = std::min(block_width, width - x);
+            u8* const out_row = out_data.data() + (static_cast<std::size_t>(y) * width + x) * 4;
+            for (u32 row = 0; row < rows; ++row) {
+                std::memcpy(out_row + static_cast<std::size_t>(row) * width * 4,
+                            texels.data() + row * block_width, columns * 4);
             }
+        }
+    };
 
-            blockIdx++;
+    if (static_cast<std::size_t>(width) * height < ParallelDecodeThreshold) {
+        for (u32 block_y = 0; block_y < blocks_on_y; ++block_y) {
+            decode_block_row(block_y);
         }
+    } else {
+        Common::GetSharedThreadPool().ParallelFor(blocks_on_y, decode_block_row);
     }
-
-    return outData;
+    return out_data;
 }
 
 } // namespace Tegra::Texture::ASTC
@@ -0,0 +1,146 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <immintrin.h>
+#include "video_core/textures/astc_avx2.h"
+
+namespace Tegra::Texture::ASTC {
+
+namespace {
+
+/// Moves the second byte of every 32-bit lane to its high 16 bits, above the first one.
+__m256i SpreadBytePairs(__m256i value) {
+    const __m256i first = _mm256_and_si256(value, _mm256_set1_epi32(0xFF));
+    const __m256i second = _mm256_and_si256(value, _mm256_set1_epi32(0xFF00));
+    return _mm256_or_si256(first, _mm256_slli_epi32(second, 8));
+}
+
+/// Converts the interpolation of 8-bit endpoints expanded to 16 bits back to 8 bits.
+__m256i ScaleToByte(__m256i value) {
+    value = _mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(value, 8), value),
+                             _mm256_set1_epi32(32));
+    value = _mm256_srli_epi32(value, 6);
+    value = _mm256_add_epi32(_mm256_sub_epi32(_mm256_slli_epi32(value, 8), value),
+                             _mm256_set1_epi32(32768));
+    return _mm256_srli_epi32(value, 16);
+}
+
+__m128i ScaleToByte(__m128i value) {
+    value = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(value, 8), value), _mm_set1_epi32(32));
+    value = _mm_srli_epi32(value, 6);
+    value = _mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(value, 8), value), _mm_set1_epi32(32768));
+    return _mm_srli_epi32(value, 16);
+}
+
+/// Returns the factors of the low and high endpoints for a weight, in the low and high 16 bits.
+int WeightFactors(u32 weight) {
+    return static_cast<int>((64 - weight) | (weight << 16));
+}
+
+template <bool dual_plane>
+void InterpolateTexels(u32* texels, const std::array<u16, 8>* endpoints, const u8* partitions,
+                       const u8* weights, const u8* plane_weights, u32 plane_channel,
+                       std::size_t num_texels) {
+    const __m128i channels = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i plane_mask =
+        _mm_cmpeq_epi32(channels, _mm_set1_epi32(static_cast<int>(plane_channel)));
+    const __m256i wide_plane_mask = _mm256_broadcastsi128_si256(plane_mask);
+
+    // Each 32-bit lane holds the pair of endpoints of a channel, which are multiplied by their
+    // factors and added at once.
+    const auto load_endpoints = [&](std::size_t i) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(endpoints[partitions[i]].data()));
+    };
+    const auto factors = [&](std::size_t i) {
+        const __m128i weight_factors = _mm_set1_epi32(WeightFactors(weights[i]));
+        if (!dual_plane) {
+            return weight_factors;
+        }
+        return _mm_blendv_epi8(weight_factors, _mm_set1_epi32(WeightFactors(plane_weights[i])),
+                               plane_mask);
+    };
+    const auto interpolate_pair = [&](std::size_t i) {
+        const __m256i pairs = _mm256_inserti128_si256(_mm256_castsi128_si256(load_endpoints(i)),
+                                                      load_endpoints(i + 1), 1);
+        __m256i pair_factors = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_set1_epi32(WeightFactors(weights[i]))),
+            _mm_set1_epi32(WeightFactors(weights[i + 1])), 1);
+        if (dual_plane) {
+            const __m256i plane_factors = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_set1_epi32(WeightFactors(plane_weights[i]))),
+                _mm_set1_epi32(WeightFactors(plane_weights[i + 1])), 1);
+            pair_factors = _mm256_blendv_epi8(pair_factors, plane_factors, wide_plane_mask);
+        }
+        return ScaleToByte(_mm256_madd_epi16(pairs, pair_factors));
+    };
+
+    // Packing works within 128-bit lanes, leaving the texels in the order 0 2 4 6 1 3 5 7.
+    const __m256i texel_order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    std::size_t i = 0;
+    for (; i + 8 <= num_texels; i += 8) {
+        const __m256i low = _mm256_packs_epi32(interpolate_pair(i), interpolate_pair(i + 2));
+        const __m256i high = _mm256_packs_epi32(interpolate_pair(i + 4), interpolate_pair(i + 6));
+        const __m256i bytes = _mm256_packus_epi16(low, high);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(texels + i),
+                            _mm256_permutevar8x32_epi32(bytes, texel_order));
+    }
+    for (; i < num_texels; ++i) {
+        const __m128i channel_values = ScaleToByte(_mm_madd_epi16(load_endpoints(i), factors(i)));
+        const __m128i words = _mm_packs_epi32(channel_values, _mm_setzero_si128());
+        texels[i] =
+            static_cast<u32>(_mm_cvtsi128_si32(_mm_packus_epi16(words, _mm_setzero_si128())));
+    }
+}
+
+} // Anonymous namespace
+
+void InfillWeightsAVX2(u8* weights, const u8* grid, u32 grid_width, const s32* indices,
+                       const u32* top_factors, const u32* bottom_factors, std::size_t num_texels) {
+    // A 32-bit gather at the index of a texel loads its top left and top right weights in its two
+    // lowest bytes, another one a row below loads the bottom ones.
+    const __m256i row = _mm256_set1_epi32(static_cast<int>(grid_width));
+    const int* const grid_words = reinterpret_cast<const int*>(grid);
+    std::size_t i = 0;
+    for (; i + 8 <= num_texels; i += 8) {
+        const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+        const __m256i top = SpreadBytePairs(_mm256_i32gather_epi32(grid_words, index, 1));
+        const __m256i bottom =
+            SpreadBytePairs(_mm256_i32gather_epi32(grid_words, _mm256_add_epi32(index, row), 1));
+        const __m256i top_factor =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(top_factors + i));
+        const __m256i bottom_factor =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bottom_factors + i));
+        const __m256i sum = _mm256_add_epi32(_mm256_madd_epi16(top, top_factor),
+                                             _mm256_madd_epi16(bottom, bottom_factor));
+        const __m256i result = _mm256_srli_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(8)), 4);
+
+        // Narrow the eight results to bytes, the first four end up in the low 128-bit lane.
+        const __m256i words = _mm256_packus_epi32(result, result);
+        const __m256i bytes = _mm256_packus_epi16(words, words);
+        const __m128i packed = _mm_unpacklo_epi32(_mm256_castsi256_si128(bytes),
+                                                  _mm256_extracti128_si256(bytes, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(weights + i), packed);
+    }
+    for (; i < num_texels; ++i) {
+        const u8* const top = grid + indices[i];
+        const u8* const bottom = top + grid_width;
+        const u32 sum = top[0] * (top_factors[i] & 0xFFFF) + top[1] * (top_factors[i] >> 16) +
+                        bottom[0] * (bottom_factors[i] & 0xFFFF) +
+                        bottom[1] * (bottom_factors[i] >> 16);
+        weights[i] = static_cast<u8>((sum + 8) >> 4);
+    }
+}
+
+void InterpolateTexelsAVX2(u32* texels, const std::array<u16, 8>* endpoints, const u8* partitions,
+                           const u8* weights, const u8* plane_weights, u32 plane_channel,
+                           std::size_t num_texels) {
+    if (plane_weights != nullptr) {
+        InterpolateTexels<true>(texels, endpoints, partitions, weights, plane_weights,
+                                plane_channel, num_texels);
+    } else {
+        InterpolateTexels<false>(texels, endpoints, partitions, weights, nullptr, 0, num_texels);
+    }
+}
+
+} // namespace Tegra::Texture::ASTC
@@ -0,0 +1,40 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Tegra::Texture::ASTC {
+
+/**
+ * Interpolates the weight of every texel of a block from the four closest ones of its weight
+ * grid. Requires AVX2, this file is built with it enabled and callers have to check for it at
+ * runtime.
+ * @param weights Weights of the texels, from 0 to 64
+ * @param grid Weights of the grid, followed by zeroes up to three bytes past the weights right
+ *             below the last one
+ * @param grid_width Number of weights in a row of the grid
+ * @param indices Index in the grid of the top left weight of every texel
+ * @param top_factors Factors of the top left and top right weights, in the low and high 16 bits
+ * @param bottom_factors Factors of the bottom left and bottom right weights
+ * @param num_texels Number of texels of the block
+ */
+void InfillWeightsAVX2(u8* weights, const u8* grid, u32 grid_width, const s32* indices,
+                       const u32* top_factors, const u32* bottom_factors, std::size_t num_texels);
+
+/**
+ * Interpolates the RGBA8 color of every texel of a block between the endpoints of its partition.
+ * Requires AVX2.
+ * @param endpoints Low and high endpoint of each RGBA channel, for every partition
+ * @param plane_weights Weights of the channel `plane_channel` for blocks with two planes of
+ *                      weights, nullptr otherwise
+ */
+void InterpolateTexelsAVX2(u32* texels, const std::array<u16, 8>* endpoints, const u8* partitions,
+                           const u8* weights, const u8* plane_weights, u32 plane_channel,
+                           std::size_t num_texels);
+
+} // namespace Tegra::Texture::ASTC
@@ -2,15 +2,25 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstring>
+#include <vector>
 #include "common/alignment.h"
 #include "common/assert.h"
+#include "common/thread_pool.h"
 #include "core/memory.h"
 #include "video_core/gpu.h"
 #include "video_core/textures/decoders.h"
 #include "video_core/textures/texture.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#include "common/x64/cpu_detect.h"
+#include "video_core/textures/swizzle_avx2.h"
+#endif
+
 namespace Tegra::Texture {
 
 /**
@@ -38,7 +48,6 @@ struct alignas(64) SwizzleTable {
 };
 
 constexpr auto legacy_swizzle_table = SwizzleTable<8, 64, 1>();
-constexpr auto fast_swizzle_table = SwizzleTable<8, 4, 16>();
 
 /**
  * This function manages ALL the GOBs(Group of Bytes) Inside a single block.
@@ -76,46 +85,6 @@ void PreciseProcessBlock(u8* swizzled_data, u8* unswizzled_data, const bool unsw
     }
 }
 
-/**
- * This function manages ALL the GOBs(Group of Bytes) Inside a single block.
- * Instead of going gob by gob, we map the coordinates inside a block and manage from
- * those. Block_Width is assumed to be 1.
- */
-void FastProcessBlock(u8* swizzled_data, u8* unswizzled_data, const bool unswizzle,
-                      const u32 x_start, const u32 y_start, const u32 z_start, const u32 x_end,
-                      const u32 y_end, const u32 z_end, const u32 tile_offset,
-                      const u32 xy_block_size, const u32 layer_z, const u32 stride_x,
-                      const u32 bytes_per_pixel, const u32 out_bytes_per_pixel) {
-    std::array<u8*, 2> data_ptrs;
-    u32 z_address = tile_offset;
-    const u32 x_startb = x_start * bytes_per_pixel;
-    const u32 x_endb = x_end * bytes_per_pixel;
-    const u32 copy_size = 16;
-    const u32 gob_size_x = 64;
-    const u32 gob_size_y = 8;
-    const u32 gob_size_z = 1;
-    const u32 gob_size = gob_size_x * gob_size_y * gob_size_z;
-    for (u32 z = z_start; z < z_end; z++) {
-        u32 y_address = z_address;
-        u32 pixel_base = layer_z * z + y_start * stride_x;
-        for (u32 y = y_start; y < y_end; y++) {
-            const auto& table = fast_swizzle_table[y % gob_size_y];
-            for (u32 xb = x_startb; xb < x_endb; xb += copy_size) {
-                const u32 swizzle_offset{y_address + table[(xb / copy_size) % 4]};
-                const u32 out_x = xb * out_bytes_per_pixel / bytes_per_pixel;
-                const u32 pixel_index{out_x + pixel_base};
-                data_ptrs[unswizzle] = swizzled_data + swizzle_offset;
-                data_ptrs[!unswizzle] = unswizzled_data + pixel_index;
-                std::memcpy(data_ptrs[0], data_ptrs[1], copy_size);
-            }
-            pixel_base += stride_x;
-            if ((y + 1) % gob_size_y == 0)
-                y_address += gob_size;
-        }
-        z_address += xy_block_size;
-    }
-}
-
 /**
  * This function unswizzles or swizzles a texture by mapping Linear to BlockLinear Textue.
  * The body of this function takes care of splitting the swizzled texture into blocks,
@@ -125,7 +94,6 @@ void FastProcessBlock(u8* swizzled_data, u8* unswizzled_data, const bool unswizz
  * Documentation for the memory layout and decoding can be found at:
  *  https://envytools.readthedocs.io/en/latest/hw/memory/g80-surface.html#blocklinear-surfaces
  */
-template <bool fast>
 void SwizzledData(u8* swizzled_data, u8* unswizzled_data, const bool unswizzle, const u32 width,
                   const u32 height, const u32 depth, const u32 bytes_per_pixel,
                   const u32 out_bytes_per_pixel, const u32 block_height, const u32 block_depth) {
@@ -156,30 +124,233 @@ void SwizzledData(u8* swizzled_data, u8* unswizzled_data, const bool unswizzle,
             for (u32 xb = 0; xb < blocks_on_x; xb++) {
                 const u32 x_start = xb * block_x_elements;
                 const u32 x_end = std::min(width, x_start + block_x_elements);
-                if (fast) {
-                    FastProcessBlock(swizzled_data, unswizzled_data, unswizzle, x_start, y_start,
-                                     z_start, x_end, y_end, z_end, tile_offset, xy_block_size,
-                                     layer_z, stride_x, bytes_per_pixel, out_bytes_per_pixel);
-                } else {
-                    PreciseProcessBlock(swizzled_data, unswizzled_data, unswizzle, x_start, y_start,
-                                        z_start, x_end, y_end, z_end, tile_offset, xy_block_size,
-                                        layer_z, stride_x, bytes_per_pixel, out_bytes_per_pixel);
-                }
+                PreciseProcessBlock(swizzled_data, unswizzled_data, unswizzle, x_start, y_start,
+                                    z_start, x_end, y_end, z_end, tile_offset, xy_block_size,
+                                    layer_z, stride_x, bytes_per_pixel, out_bytes_per_pixel);
                 tile_offset += block_size;
             }
         }
     }
 }
 
+constexpr u32 GobSizeX = 64;
+constexpr u32 GobSizeY = 8;
+constexpr u32 GobSize = GobSizeX * GobSizeY;
+
+/// Offsets of the four 16 byte sectors of a GOB row, relative to the first sector of the row.
+constexpr std::array<u32, 4> gob_sector_offsets{0, 32, 256, 288};
+
+/// Returns the offset of the first sector of a row within its GOB.
+constexpr u32 GobRowOffset(u32 y) {
+    return ((y % GobSizeY) / 2) * 64 + (y % 2) * 16;
+}
+
+/// Copies the 8 rows of 64 bytes of a linear buffer from or into a whole GOB.
+using GobKernel = void (*)(u8* gob, u8* linear, u32 pitch);
+
+template <bool unswizzle>
+void CopyGobGeneric(u8* gob, u8* linear, u32 pitch) {
+    for (u32 y = 0; y < GobSizeY; ++y) {
+        u8* const gob_row = gob + GobRowOffset(y);
+        u8* const linear_row = linear + y * pitch;
+        for (u32 sector = 0; sector < gob_sector_offsets.size(); ++sector) {
+            u8* const swizzled = gob_row + gob_sector_offsets[sector];
+            if (unswizzle) {
+                std::memcpy(linear_row + sector * 16, swizzled, 16);
+            } else {
+                std::memcpy(swizzled, linear_row + sector * 16, 16);
+            }
+        }
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+template <bool unswizzle>
+void CopyGobSSE2(u8* gob, u8* linear, u32 pitch) {
+    for (u32 y = 0; y < GobSizeY; ++y) {
+        u8* const gob_row = gob + GobRowOffset(y);
+        u8* const linear_row = linear + y * pitch;
+        for (u32 sector = 0; sector < gob_sector_offsets.size(); ++sector) {
+            auto* const swizzled = reinterpret_cast<__m128i*>(gob_row + gob_sector_offsets[sector]);
+            auto* const linear_sector = reinterpret_cast<__m128i*>(linear_row + sector * 16);
+            if (unswizzle) {
+                _mm_storeu_si128(linear_sector, _mm_loadu_si128(swizzled));
+            } else {
+                _mm_storeu_si128(swizzled, _mm_loadu_si128(linear_sector));
+            }
+        }
+    }
+}
+#endif
+
+struct GobKernels {
+    GobKernel swizzle;
+    GobKernel unswizzle;
+};
+
+/// Returns the fastest GOB kernels supported by the host CPU.
+const GobKernels& GetGobKernels() {
+    static const GobKernels kernels = [] {
+#ifdef ARCHITECTURE_x86_64
+        if (Common::GetCPUCaps().avx2) {
+            return GobKernels{SwizzleGobAVX2, UnswizzleGobAVX2};
+        }
+        return GobKernels{CopyGobSSE2<false>, CopyGobSSE2<true>};
+#else
+        return GobKernels{CopyGobGeneric<false>, CopyGobGeneric<true>};
+#endif
+    }();
+    return kernels;
+}
+
+/// Copies `size` bytes of a GOB row starting at byte `x`, sector by sector.
+template <bool unswizzle>
+void CopyGobRowPart(u8* gob_row, u32 x, u32 size, u8* linear) {
+    while (size != 0) {
+        const u32 offset_in_sector = x % 16;
+        const u32 copy_size = std::min(16 - offset_in_sector, size);
+        u8* const swizzled = gob_row + gob_sector_offsets[x / 16] + offset_in_sector;
+        if (unswizzle) {
+            std::memcpy(linear, swizzled, copy_size);
+        } else {
+            std::memcpy(swizzled, linear, copy_size);
+        }
+        x += copy_size;
+        linear += copy_size;
+        size -= copy_size;
+    }
+}
+
+/**
+ * Copies a rectangle between a block linear surface and a linear buffer. Positions and sizes on the
+ * X axis are in bytes: the block linear layout only depends on byte addresses, so every bytes per
+ * pixel is handled the same way. GOBs entirely covered by the rectangle are copied by the
+ * vectorized kernels, the edges are copied sector by sector.
+ * @param swizzled_data Start of the block linear surface
+ * @param linear_data Start of the rectangle in the linear buffer
+ * @param linear_pitch Distance in bytes between rows of the linear buffer
+ * @param linear_layer_size Distance in bytes between layers of the linear buffer
+ * @param surface_width Width in bytes of the block linear surface
+ * @param surface_height Height of the block linear surface, only used for 3D surfaces
+ * @param origin_x Position in bytes of the rectangle within the block linear surface
+ * @param origin_y Row of the rectangle within the block linear surface
+ * @param rect_width Width in bytes of the rectangle
+ * @param rect_height Height of the rectangle
+ * @param depth Number of layers to copy
+ */
+template <bool unswizzle>
+void CopyBlockLinearRect(u8* swizzled_data, u8* linear_data, u32 linear_pitch,
+                         std::size_t linear_layer_size, u32 surface_width, u32 surface_height,
+                         u32 origin_x, u32 origin_y, u32 rect_width, u32 rect_height, u32 depth,
+                         u32 block_height, u32 block_depth) {
+    const GobKernel kernel = unswizzle ? GetGobKernels().unswizzle : GetGobKernels().swizzle;
+    const std::size_t gobs_in_x = (surface_width + GobSizeX - 1) / GobSizeX;
+    const std::size_t blocks_on_y =
+        (surface_height + GobSizeY * block_height - 1) / (GobSizeY * block_height);
+    const std::size_t block_size = static_cast<std::size_t>(GobSize) * block_height * block_depth;
+    const u32 x_end = origin_x + rect_width;
+    const u32 y_end = origin_y + rect_height;
+
+    for (u32 z = 0; z < depth; ++z) {
+        const std::size_t layer_offset =
+            (z / block_depth) * blocks_on_y * gobs_in_x * block_size +
+            (z % block_depth) * GobSize * block_height;
+        u8* const linear_layer = linear_data + z * linear_layer_size;
+
+        for (u32 gob_y = origin_y - origin_y % GobSizeY; gob_y < y_end; gob_y += GobSizeY) {
+            const u32 gob_index_y = gob_y / GobSizeY;
+            const std::size_t row_offset = layer_offset +
+                                           (gob_index_y / block_height) * gobs_in_x * block_size +
+                                           (gob_index_y % block_height) * GobSize;
+            const u32 row_begin = std::max(gob_y, origin_y);
+            const u32 row_end = std::min(gob_y + GobSizeY, y_end);
+            const bool whole_rows = row_begin == gob_y && row_end == gob_y + GobSizeY;
+
+            for (u32 gob_x = origin_x - origin_x % GobSizeX; gob_x < x_end; gob_x += GobSizeX) {
+                const u32 column_begin = std::max(gob_x, origin_x);
+                const u32 column_end = std::min(gob_x + GobSizeX, x_end);
+                u8* const gob = swizzled_data + row_offset + (gob_x / GobSizeX) * block_size;
+                u8* const linear = linear_layer + (row_begin - origin_y) * linear_pitch +
+                                   (column_begin - origin_x);
+
+                if (whole_rows && column_end - column_begin == GobSizeX) {
+                    kernel(gob, linear, linear_pitch);
+                    continue;
+                }
+                for (u32 y = row_begin; y < row_end; ++y) {
+                    CopyGobRowPart<unswizzle>(gob + GobRowOffset(y), column_begin - gob_x,
+                                              column_end - column_begin,
+                                              linear + (y - row_begin) * linear_pitch);
+                }
+            }
+        }
+    }
+}
+
+/// Returns the size of the block linear memory spanned by the given number of rows.
+std::size_t BlockLinearRowsSize(u32 width_in_bytes, u32 rows, u32 block_height) {
+    const std::size_t gobs_in_x = (width_in_bytes + GobSizeX - 1) / GobSizeX;
+    const std::size_t block_rows =
+        (rows + GobSizeY * block_height - 1) / (GobSizeY * block_height);
+    return block_rows * gobs_in_x * GobSize * block_height;
+}
+
+/// Surfaces smaller than this are copied by the calling thread alone.
+constexpr std::size_t ParallelCopyThreshold = 256 * 1024;
+
+/**
+ * Copies a whole surface between its block linear and linear layouts. Every layer of every row of
+ * blocks covers its own bytes on both sides, so large surfaces are split along those and copied in
+ * parallel, producing the same result as a serial copy.
+ */
+template <bool unswizzle>
+void CopyBlockLinearSurface(u8* swizzled_data, u8* linear_data, u32 pitch, u32 height, u32 depth,
+                            u32 block_height, u32 block_depth) {
+    const u32 rows_per_block = GobSizeY * block_height;
+    const u32 blocks_on_y = (height + rows_per_block - 1) / rows_per_block;
+    const std::size_t gobs_in_x = (pitch + GobSizeX - 1) / GobSizeX;
+    const std::size_t block_size = static_cast<std::size_t>(GobSize) * block_height * block_depth;
+    const std::size_t layer_size = static_cast<std::size_t>(pitch) * height;
+
+    const auto copy_block_row = [&](std::size_t index) {
+        const u32 z = static_cast<u32>(index / blocks_on_y);
+        const u32 y = static_cast<u32>(index % blocks_on_y) * rows_per_block;
+        u8* const swizzled_layer = swizzled_data +
+                                   (z / block_depth) * blocks_on_y * gobs_in_x * block_size +
+                                   (z % block_depth) * GobSize * block_height;
+        u8* const linear = linear_data + z * layer_size + static_cast<std::size_t>(y) * pitch;
+        CopyBlockLinearRect<unswizzle>(swizzled_layer, linear, pitch, 0, pitch, height, 0, y,
+                                       pitch, std::min(rows_per_block, height - y), 1,
+                                       block_height, block_depth);
+    };
+
+    const std::size_t num_block_rows = static_cast<std::size_t>(blocks_on_y) * depth;
+    if (layer_size * depth < ParallelCopyThreshold) {
+        for (std::size_t index = 0; index < num_block_rows; ++index) {
+            copy_block_row(index);
+        }
+        return;
+    }
+    Common::GetSharedThreadPool().ParallelFor(num_block_rows, copy_block_row);
+}
+
 void CopySwizzledData(u32 width, u32 height, u32 depth, u32 bytes_per_pixel,
                       u32 out_bytes_per_pixel, u8* swizzled_data, u8* unswizzled_data,
                       bool unswizzle, u32 block_height, u32 block_depth) {
-    if (bytes_per_pixel % 3 != 0 && (width * bytes_per_pixel) % 16 == 0) {
-        SwizzledData<true>(swizzled_data, unswizzled_data, unswizzle, width, height, depth,
-                           bytes_per_pixel, out_bytes_per_pixel, block_height, block_depth);
+    if (bytes_per_pixel != out_bytes_per_pixel) {
+        // Pixels are laid out differently on both sides, they have to be copied one by one.
+        SwizzledData(swizzled_data, unswizzled_data, unswizzle, width, height, depth,
+                     bytes_per_pixel, out_bytes_per_pixel, block_height, block_depth);
+        return;
+    }
+
+    const u32 pitch = width * bytes_per_pixel;
+    if (unswizzle) {
+        CopyBlockLinearSurface<true>(swizzled_data, unswizzled_data, pitch, height, depth,
+                                     block_height, block_depth);
     } else {
-        SwizzledData<false>(swizzled_data, unswizzled_data, unswizzle, width, height, depth,
-                            bytes_per_pixel, out_bytes_per_pixel, block_height, block_depth);
+        CopyBlockLinearSurface<false>(swizzled_data, unswizzled_data, pitch, height, depth,
+                                      block_height, block_depth);
     }
 }
 
@@ -240,40 +411,81 @@ std::vector<u8> UnswizzleTexture(VAddr address, u32 tile_size, u32 bytes_per_pix
 void SwizzleSubrect(u32 subrect_width, u32 subrect_height, u32 source_pitch, u32 swizzled_width,
                     u32 bytes_per_pixel, VAddr swizzled_data, VAddr unswizzled_data,
                     u32 block_height) {
-    const u32 image_width_in_gobs{(swizzled_width * bytes_per_pixel + 63) / 64};
-    for (u32 line = 0; line < subrect_height; ++line) {
-        const u32 gob_address_y =
-            (line / (8 * block_height)) * 512 * block_height * image_width_in_gobs +
-            (line % (8 * block_height) / 8) * 512;
-        const auto& table = legacy_swizzle_table[line % 8];
-        for (u32 x = 0; x < subrect_width; ++x) {
-            const u32 gob_address = gob_address_y + (x * bytes_per_pixel / 64) * 512 * block_height;
-            const u32 swizzled_offset = gob_address + table[(x * bytes_per_pixel) % 64];
-            const VAddr source_line = unswizzled_data + line * source_pitch + x * bytes_per_pixel;
-            const VAddr dest_addr = swizzled_data + swizzled_offset;
-
-            Memory::CopyBlock(dest_addr, source_line, bytes_per_pixel);
-        }
+    if (subrect_width == 0 || subrect_height == 0) {
+        return;
+    }
+
+    const u32 line_size = subrect_width * bytes_per_pixel;
+    const u32 swizzled_pitch = swizzled_width * bytes_per_pixel;
+    const std::size_t swizzled_size =
+        BlockLinearRowsSize(swizzled_pitch, subrect_height, block_height);
+    const std::size_t unswizzled_size =
+        static_cast<std::size_t>(source_pitch) * (subrect_height - 1) + line_size;
+
+    u8* swizzled = Memory::GetContiguousPointer(swizzled_data, swizzled_size);
+    u8* unswizzled = Memory::GetContiguousPointer(unswizzled_data, unswizzled_size);
+
+    // Regions that are not directly accessible go through copies, the rectangle may cover GOBs
+    // only partially so the swizzled side has to be read as well.
+    std::vector<u8> swizzled_copy;
+    std::vector<u8> unswizzled_copy;
+    if (swizzled == nullptr) {
+        swizzled_copy.resize(swizzled_size);
+        Memory::ReadBlock(swizzled_data, swizzled_copy.data(), swizzled_size);
+        swizzled = swizzled_copy.data();
+    }
+    if (unswizzled == nullptr) {
+        unswizzled_copy.resize(unswizzled_size);
+        Memory::ReadBlock(unswizzled_data, unswizzled_copy.data(), unswizzled_size);
+        unswizzled = unswizzled_copy.data();
+    }
+
+    CopyBlockLinearRect<false>(swizzled, unswizzled, source_pitch, 0, swizzled_pitch, 0, 0, 0,
+                               line_size, subrect_height, 1, block_height, 1);
+
+    if (!swizzled_copy.empty()) {
+        Memory::WriteBlock(swizzled_data, swizzled_copy.data(), swizzled_size);
     }
 }
 
 void UnswizzleSubrect(u32 subrect_width, u32 subrect_height, u32 dest_pitch, u32 swizzled_width,
                       u32 bytes_per_pixel, VAddr swizzled_data, VAddr unswizzled_data,
                       u32 block_height, u32 offset_x, u32 offset_y) {
-    for (u32 line = 0; line < subrect_height; ++line) {
-        const u32 y2 = line + offset_y;
-        const u32 gob_address_y =
-            (y2 / (8 * block_height)) * 512 * block_height + (y2 % (8 * block_height) / 8) * 512;
-        const auto& table = legacy_swizzle_table[y2 % 8];
-        for (u32 x = 0; x < subrect_width; ++x) {
-            const u32 x2 = (x + offset_x) * bytes_per_pixel;
-            const u32 gob_address = gob_address_y + (x2 / 64) * 512 * block_height;
-            const u32 swizzled_offset = gob_address + table[x2 % 64];
-            const VAddr dest_line = unswizzled_data + line * dest_pitch + x * bytes_per_pixel;
-            const VAddr source_addr = swizzled_data + swizzled_offset;
-
-            Memory::CopyBlock(dest_line, source_addr, bytes_per_pixel);
-        }
+    if (subrect_width == 0 || subrect_height == 0) {
+        return;
+    }
+
+    const u32 line_size = subrect_width * bytes_per_pixel;
+    const u32 swizzled_pitch = swizzled_width * bytes_per_pixel;
+    const std::size_t swizzled_size =
+        BlockLinearRowsSize(swizzled_pitch, offset_y + subrect_height, block_height);
+    const std::size_t unswizzled_size =
+        static_cast<std::size_t>(dest_pitch) * (subrect_height - 1) + line_size;
+
+    u8* swizzled = Memory::GetContiguousPointer(swizzled_data, swizzled_size);
+    u8* unswizzled = Memory::GetContiguousPointer(unswizzled_data, unswizzled_size);
+
+    // Regions that are not directly accessible go through copies. Lines are written partially
+    // when the pitch is larger than the rectangle, so the linear side has to be read as well.
+    std::vector<u8> swizzled_copy;
+    std::vector<u8> unswizzled_copy;
+    if (swizzled == nullptr) {
+        swizzled_copy.resize(swizzled_size);
+        Memory::ReadBlock(swizzled_data, swizzled_copy.data(), swizzled_size);
+        swizzled = swizzled_copy.data();
+    }
+    if (unswizzled == nullptr) {
+        unswizzled_copy.resize(unswizzled_size);
+        Memory::ReadBlock(unswizzled_data, unswizzled_copy.data(), unswizzled_size);
+        unswizzled = unswizzled_copy.data();
+    }
+
+    CopyBlockLinearRect<true>(swizzled, unswizzled, dest_pitch, 0, swizzled_pitch, 0,
+                              offset_x * bytes_per_pixel, offset_y, line_size, subrect_height, 1,
+                              block_height, 1);
+
+    if (!unswizzled_copy.empty()) {
+        Memory::WriteBlock(unswizzled_data, unswizzled_copy.data(), unswizzled_size);
     }
 }
 
@@ -320,13 +532,14 @@ std::vector<u8> DecodeTexture(const std::vector<u8>& texture_data, TextureFormat
 std::size_t CalculateSize(bool tiled, u32 bytes_per_pixel, u32 width, u32 height, u32 depth,
                           u32 block_height, u32 block_depth) {
     if (tiled) {
-        const u32 gobs_in_x = 64 / bytes_per_pixel;
+        // GOBs are 64 bytes wide regardless of the size of the pixels.
+        const u32 gob_size_x = 64;
         const u32 gobs_in_y = 8;
         const u32 gobs_in_z = 1;
-        const u32 aligned_width = Common::AlignUp(width, gobs_in_x);
+        const u32 aligned_width = Common::AlignUp(width * bytes_per_pixel, gob_size_x);
         const u32 aligned_height = Common::AlignUp(height, gobs_in_y * block_height);
         const u32 aligned_depth = Common::AlignUp(depth, gobs_in_z * block_depth);
-        return aligned_width * aligned_height * aligned_depth * bytes_per_pixel;
+        return aligned_width * aligned_height * aligned_depth;
     } else {
         return width * height * depth * bytes_per_pixel;
     }
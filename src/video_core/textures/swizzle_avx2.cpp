@@ -0,0 +1,62 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <immintrin.h>
+#include "video_core/textures/swizzle_avx2.h"
+
+namespace Tegra::Texture {
+
+// A GOB stores each pair of rows as 32 byte blocks, the 16 byte sector of the even row followed
+// by the same sector of the odd row. Sectors 0 and 1 of a row pair are at the start of its 64
+// bytes, sectors 2 and 3 are 256 bytes after them. Loading 32 bytes of each row and exchanging
+// their 128 bit halves builds two of those blocks at once.
+
+void SwizzleGobAVX2(u8* gob, u8* linear, u32 pitch) {
+    for (u32 y = 0; y < 8; y += 2) {
+        const u8* const even_row = linear + y * pitch;
+        const u8* const odd_row = even_row + pitch;
+        const __m256i even_low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(even_row));
+        const __m256i odd_low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(odd_row));
+        const __m256i even_high =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(even_row + 32));
+        const __m256i odd_high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(odd_row + 32));
+
+        u8* const row_pair = gob + (y / 2) * 64;
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(row_pair),
+                            _mm256_permute2x128_si256(even_low, odd_low, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(row_pair + 32),
+                            _mm256_permute2x128_si256(even_low, odd_low, 0x31));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(row_pair + 256),
+                            _mm256_permute2x128_si256(even_high, odd_high, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(row_pair + 288),
+                            _mm256_permute2x128_si256(even_high, odd_high, 0x31));
+    }
+}
+
+void UnswizzleGobAVX2(u8* gob, u8* linear, u32 pitch) {
+    for (u32 y = 0; y < 8; y += 2) {
+        const u8* const row_pair = gob + (y / 2) * 64;
+        const __m256i sector_0_pair =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row_pair));
+        const __m256i sector_1_pair =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row_pair + 32));
+        const __m256i sector_2_pair =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row_pair + 256));
+        const __m256i sector_3_pair =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row_pair + 288));
+
+        u8* const even_row = linear + y * pitch;
+        u8* const odd_row = even_row + pitch;
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(even_row),
+                            _mm256_permute2x128_si256(sector_0_pair, sector_1_pair, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(odd_row),
+                            _mm256_permute2x128_si256(sector_0_pair, sector_1_pair, 0x31));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(even_row + 32),
+                            _mm256_permute2x128_si256(sector_2_pair, sector_3_pair, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(odd_row + 32),
+                            _mm256_permute2x128_si256(sector_2_pair, sector_3_pair, 0x31));
+    }
+}
+
+} // namespace Tegra::Texture
@@ -0,0 +1,23 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+
+namespace Tegra::Texture {
+
+/**
+ * Copies the 8 rows of 64 bytes of a linear buffer into a GOB. Requires AVX2, this file is built
+ * with it enabled and callers have to check for it at runtime.
+ * @param gob First byte of the GOB
+ * @param linear First byte of the linear data
+ * @param pitch Distance in bytes between rows of the linear data
+ */
+void SwizzleGobAVX2(u8* gob, u8* linear, u32 pitch);
+
+/// Copies a GOB into 8 rows of 64 bytes of a linear buffer. Requires AVX2.
+void UnswizzleGobAVX2(u8* gob, u8* linear, u32 pitch);
+
+} // namespace Tegra::Texture
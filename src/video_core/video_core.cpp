@@ -3,13 +3,18 @@
 // Refer to the license.txt file included.
 
 #include <memory>
+#include "core/settings.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_null/renderer_null.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/video_core.h"
 
 namespace VideoCore {
 
 std::unique_ptr<RendererBase> CreateRenderer(Core::Frontend::EmuWindow& emu_window) {
+    if (Settings::values.use_null_renderer) {
+        return std::make_unique<Null::RendererNull>(emu_window);
+    }
     return std::make_unique<OpenGL::RendererOpenGL>(emu_window);
 }
 
@@ -4,24 +4,19 @@
 
 #pragma once
 
-#include <atomic>
-#include <map>
 #include <memory>
-#include <string>
-#include <unordered_map>
 
 #include <QList>
 #include <QObject>
 #include <QRunnable>
 #include <QString>
 
-#include "common/common_types.h"
+#include "core/game_scanner.h"
 #include "yuzu/compatibility_list.h"
 
 class QStandardItem;
 
 namespace FileSys {
-class NCA;
 class VfsFilesystem;
 } // namespace FileSys
 
@@ -58,15 +53,11 @@ signals:
     void Finished(QStringList watch_list);
 
 private:
-    void AddInstalledTitlesToGameList();
-    void FillControlMap(const std::string& dir_path);
-    void AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion = 0);
+    void AddEntry(Core::ScannedGame game);
 
-    std::shared_ptr<FileSys::VfsFilesystem> vfs;
-    std::map<u64, std::unique_ptr<FileSys::NCA>> nca_control_map;
+    Core::GameScanner scanner;
     QStringList watch_list;
     QString dir_path;
     bool deep_scan;
     const CompatibilityList& compatibility_list;
-    std::atomic_bool stop_processing;
 };
@@ -114,6 +114,28 @@ frame_limit =
 # 0 (default): Off (fast), 1 : On (slow)
 use_accurate_gpu_emulation =
 
+# Whether to process GPU commands on a separate thread, in parallel to the emulated CPU
+# 0 (default): Off, 1 : On (fast)
+use_asynchronous_gpu_emulation =
+
+# Whether to use a renderer that discards everything, to measure the emulation overhead headless
+# 0 (default): Off, 1 : On
+use_null_renderer =
+
+# Whether to use the Just-In-Time (JIT) compiler for GPU macros
+# 0: Interpreter (slow), 1 (default): JIT (fast)
+use_macro_jit =
+
+# Whether to store the shaders of each game on disk, so that they're loaded on boot instead of being
+# built again while playing
+# 0: Off, 1 (default): On
+use_disk_shader_cache =
+
+# Whether to build new shaders in the background, skipping the draws that use them until they're
+# built, instead of stalling until they're ready. Avoids stutter at the cost of missing geometry.
+# 0 (default): Off, 1 : On
+use_asynchronous_shaders =
+
 # The clear color for the renderer. What shows up on the sides of the bottom screen.
 # Must be in range of 0.0-1.0. Defaults to 1.0 for all.
 bg_red =
@@ -201,6 +223,9 @@ log_filter = *:Trace
 # Port for listening to GDB connections.
 use_gdbstub=false
 gdbstub_port=24689
+# Whether to run every GPU macro with both the JIT and the interpreter and log any difference
+# 0 (default): Off, 1: On (slow)
+verify_macro_jit =
 
 [WebService]
 # Whether or not to enable telemetry
@@ -19,6 +19,32 @@
 #include "input_common/sdl/sdl.h"
 #include "yuzu_cmd/emu_window/emu_window_sdl2.h"
 
+namespace {
+
+/// A GL context made current on the window, which shares its objects with the one of the window
+class SDLGLContext final : public Core::Frontend::GraphicsContext {
+public:
+    SDLGLContext(SDL_Window* window, SDL_GLContext context) : window{window}, context{context} {}
+
+    ~SDLGLContext() override {
+        SDL_GL_DeleteContext(context);
+    }
+
+    void MakeCurrent() override {
+        SDL_GL_MakeCurrent(window, context);
+    }
+
+    void DoneCurrent() override {
+        SDL_GL_MakeCurrent(window, nullptr);
+    }
+
+private:
+    SDL_Window* window;
+    SDL_GLContext context;
+};
+
+} // Anonymous namespace
+
 void EmuWindow_SDL2::OnMouseMotion(s32 x, s32 y) {
     TouchMoved((unsigned)std::max(x, 0), (unsigned)std::max(y, 0));
     InputCommon::GetMotionEmu()->Tilt(x, y);
@@ -287,6 +313,20 @@ void EmuWindow_SDL2::DoneCurrent() {
     SDL_GL_MakeCurrent(render_window, nullptr);
 }
 
+std::unique_ptr<Core::Frontend::GraphicsContext> EmuWindow_SDL2::CreateSharedContext() const {
+    // Creating a context makes it current, the context of the window is restored right after.
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+    SDL_GLContext shared_context = SDL_GL_CreateContext(render_window);
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+    SDL_GL_MakeCurrent(render_window, gl_context);
+
+    if (shared_context == nullptr) {
+        LOG_ERROR(Frontend, "Failed to create shared SDL2 GL context! {}", SDL_GetError());
+        return nullptr;
+    }
+    return std::make_unique<SDLGLContext>(render_window, shared_context);
+}
+
 void EmuWindow_SDL2::OnMinimalClientAreaChangeRequest(
     const std::pair<unsigned, unsigned>& minimal_size) {
 
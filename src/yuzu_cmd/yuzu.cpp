@@ -23,6 +23,7 @@
 #include "core/core.h"
 #include "core/crypto/key_manager.h"
 #include "core/file_sys/vfs_real.h"
+#include "core/game_scanner.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/service/filesystem/filesystem.h"
 #include "core/loader/loader.h"
@@ -57,6 +58,7 @@ static void PrintHelp(const char* argv0) {
               << " [options] <filename>\n"
                  "-g, --gdbport=NUMBER  Enable gdb stub on port NUMBER\n"
                  "-f, --fullscreen      Start in fullscreen mode\n"
+                 "-l, --list=DIRECTORY  List the installed games and the games in DIRECTORY\n"
                  "-h, --help            Display this help and exit\n"
                  "-v, --version         Output version information and exit\n"
                  "-p, --program         Pass following string as arguments to executable\n";
@@ -66,6 +68,18 @@ static void PrintVersion() {
     std::cout << "yuzu " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
 }
 
+static void ListGames(const std::string& directory) {
+    const auto vfs = std::make_shared<FileSys::RealVfsFilesystem>();
+    Service::FileSystem::CreateFactories(*vfs);
+
+    const auto print_game = [](Core::ScannedGame game) {
+        fmt::print("{:016X} {} ({})\n", game.metadata.program_id, game.metadata.name, game.path);
+    };
+    Core::GameScanner scanner(vfs);
+    scanner.ScanInstalledTitles(print_game);
+    scanner.ScanDirectory(directory, 256, print_game);
+}
+
 static void InitializeLogging() {
     Log::Filter log_filter(Log::Level::Debug);
     log_filter.ParseFilterString(Settings::values.log_filter);
@@ -100,17 +114,19 @@ int main(int argc, char** argv) {
     }
 #endif
     std::string filepath;
+    std::string list_directory;
 
     bool fullscreen = false;
 
     static struct option long_options[] = {
         {"gdbport", required_argument, 0, 'g'}, {"fullscreen", no_argument, 0, 'f'},
-        {"help", no_argument, 0, 'h'},          {"version", no_argument, 0, 'v'},
-        {"program", optional_argument, 0, 'p'}, {0, 0, 0, 0},
+        {"help", no_argument, 0, 'h'},          {"list", required_argument, 0, 'l'},
+        {"version", no_argument, 0, 'v'},       {"program", optional_argument, 0, 'p'},
+        {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        char arg = getopt_long(argc, argv, "g:fhvp::", long_options, &option_index);
+        char arg = getopt_long(argc, argv, "g:fhl:vp::", long_options, &option_index);
         if (arg != -1) {
             switch (arg) {
             case 'g':
@@ -131,6 +147,9 @@ int main(int argc, char** argv) {
             case 'h':
                 PrintHelp(argv[0]);
                 return 0;
+            case 'l':
+                list_directory = optarg;
+                break;
             case 'v':
                 PrintVersion();
                 return 0;
@@ -153,6 +172,11 @@ int main(int argc, char** argv) {
     LocalFree(argv_w);
 #endif
 
+    if (!list_directory.empty()) {
+        ListGames(list_directory);
+        return 0;
+    }
+
     MicroProfileOnThreadCreate("EmuThread");
     SCOPE_EXIT({ MicroProfileShutdown(); });
 